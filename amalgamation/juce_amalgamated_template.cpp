@@ -192,6 +192,7 @@
  #include "../src/audio/audio_sources/juce_ReverbAudioSource.cpp"
  #include "../src/audio/audio_sources/juce_MixerAudioSource.cpp"
  #include "../src/audio/audio_sources/juce_ResamplingAudioSource.cpp"
+ #include "../src/audio/audio_sources/juce_SincResamplingAudioSource.cpp"
  #include "../src/audio/audio_sources/juce_ToneGeneratorAudioSource.cpp"
  #include "../src/audio/devices/juce_AudioDeviceManager.cpp"
  #include "../src/audio/devices/juce_AudioIODevice.cpp"
@@ -199,13 +200,18 @@
  #include "../src/audio/dsp/juce_AudioDataConverters.cpp"
  #include "../src/audio/dsp/juce_AudioSampleBuffer.cpp"
  #include "../src/audio/dsp/juce_IIRFilter.cpp"
+ #include "../src/audio/dsp/juce_IIRFilterBank.cpp"
+ #include "../src/audio/dsp/juce_PolyphaseResampler.cpp"
+ #include "../src/audio/dsp/juce_SIMDReverb.cpp"
  #include "../src/audio/midi/juce_MidiOutput.cpp"
  #include "../src/audio/midi/juce_MidiBuffer.cpp"
+ #include "../src/audio/midi/juce_MidiEventPipeline.cpp"
  #include "../src/audio/midi/juce_MidiFile.cpp"
  #include "../src/audio/midi/juce_MidiKeyboardState.cpp"
  #include "../src/audio/midi/juce_MidiMessage.cpp"
  #include "../src/audio/midi/juce_MidiMessageCollector.cpp"
  #include "../src/audio/midi/juce_MidiMessageSequence.cpp"
+ #include "../src/audio/midi/juce_MidiVoiceTracker.cpp"
  #include "../src/audio/plugin_host/juce_AudioPluginFormat.cpp"
  #include "../src/audio/plugin_host/juce_AudioPluginFormatManager.cpp"
  #include "../src/audio/plugin_host/juce_KnownPluginList.cpp"
@@ -354,6 +360,8 @@
  #include "../src/gui/graphics/contexts/juce_Justification.cpp"
  #include "../src/gui/graphics/contexts/juce_LowLevelGraphicsPostScriptRenderer.cpp"
  #include "../src/gui/graphics/contexts/juce_LowLevelGraphicsSoftwareRenderer.cpp"
+ #include "../src/gui/graphics/contexts/juce_LowLevelGraphicsTiledRenderer.cpp"
+ #include "../src/gui/graphics/contexts/juce_PixelSpanKernels.cpp"
  #include "../src/gui/graphics/contexts/juce_RectanglePlacement.cpp"
  #include "../src/gui/graphics/drawables/juce_Drawable.cpp"
  #include "../src/gui/graphics/drawables/juce_DrawableShape.cpp"
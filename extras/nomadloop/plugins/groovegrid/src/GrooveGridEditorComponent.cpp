@@ -26,24 +26,49 @@
 #include "includes.h"
 #include "GrooveGridEditorComponent.h"
 
+// Click to turn a cell on or off.  Dragging up or down on a cell that's on
+// changes its velocity, or with shift its probability, with alt its length,
+// or with command its swing.
 class GrooveGridCell : public Component
 {
 	Colour colour;
 	int instrumentNumber;
 	int step;
+	bool isCurrentStep;
+	GrooveGridPattern::Cell cellAtDragStart;
+
+	GrooveGridFilter* getFilter() const
+	{
+		return static_cast<GrooveGridEditorComponent*>(getParentComponent())->getFilter();
+	}
 
 public:
 	GrooveGridCell(int instrumentNumber, int step)
 		:	colour((step/4)%2==0?Colours::lightgrey:Colours::grey),
 			instrumentNumber(instrumentNumber),
-			step(step)
+			step(step),
+			isCurrentStep(false)
 	{
 	}
 
-	void setColour(const Colour &c)
+	void update(const GrooveGridPattern::Cell& cell, bool currentStep)
 	{
-		colour = c;
-		repaint();
+		isCurrentStep = currentStep;
+
+		Colour c((step/4)%2==0?Colours::lightgrey:Colours::grey);
+
+		if (cell.active)
+			c = Colours::orange.withMultipliedAlpha(0.3f + 0.7f * cell.velocity / 127.0f)
+				.withMultipliedSaturation(0.4f + 0.6f * cell.probability);
+
+		if (isCurrentStep)
+			c = c.brighter(0.4f);
+
+		if (c != colour)
+		{
+			colour = c;
+			repaint();
+		}
 	}
 
 	void paint(Graphics &g)
@@ -51,11 +76,42 @@ public:
 		this->getLookAndFeel().drawGlassLozenge(g, 0.f, 0.f, static_cast<float>(getWidth()), static_cast<float>(getHeight()), colour, 1.0f, 8.0f, false, false, false, false);
 	}
 
-	void mouseDown(const MouseEvent &m)
+	void mouseDown(const MouseEvent &)
+	{
+		cellAtDragStart = getFilter()->getCell(step, instrumentNumber);
+	}
+
+	void mouseDrag(const MouseEvent &m)
+	{
+		if (!cellAtDragStart.active || m.mouseWasClicked())
+			return;
+
+		GrooveGridPattern::Cell cell(cellAtDragStart);
+		const float delta = -m.getDistanceFromDragStartY() / 100.0f;
+
+		if (m.mods.isShiftDown())
+			cell.probability = jlimit(0.0f, 1.0f, cellAtDragStart.probability + delta);
+		else if (m.mods.isAltDown())
+			cell.length = jlimit(0.05f, 1.0f, cellAtDragStart.length + delta);
+		else if (m.mods.isCommandDown())
+			cell.swing = jlimit(0.0f, 1.0f, cellAtDragStart.swing + delta);
+		else
+			cell.velocity = (uint8) jlimit(1, 127, cellAtDragStart.velocity + roundFloatToInt(delta * 127.0f));
+
+		getFilter()->setCell(step, instrumentNumber, cell);
+		update(cell, isCurrentStep);
+	}
+
+	void mouseUp(const MouseEvent &m)
 	{
-		GrooveGridFilter* filter = static_cast<GrooveGridEditorComponent*>(getParentComponent())->getFilter();
-		filter->grid[step][instrumentNumber] = !filter->grid[step][instrumentNumber];
-		setColour(filter->grid[step][instrumentNumber]?Colours::orange:((step/4)%2==0?Colours::lightgrey:Colours::grey));
+		if (m.mouseWasClicked())
+		{
+			GrooveGridPattern::Cell cell(cellAtDragStart);
+			cell.active = !cell.active;
+
+			getFilter()->setCell(step, instrumentNumber, cell);
+			update(cell, isCurrentStep);
+		}
 	}
 };
 
@@ -121,14 +177,16 @@ GrooveGridEditorComponent::GrooveGridEditorComponent (GrooveGridFilter* const ow
     // set our component's initial size to be the last one that was stored in the filter's settings
     setSize (800, 400);
 
-	for (int i=0; i<16; ++i)
-	for (int j=0; j<8; ++j)
+	currentStep = -1;
+
+	for (int i=0; i<GrooveGridPattern::numSteps; ++i)
+	for (int j=0; j<GrooveGridPattern::numRows; ++j)
 	{
 		GrooveGridCell* ggc = new GrooveGridCell(j, i);
 		ggc->setBounds(i*48+8, j*48+8, 40, 40);
-		//ggc->setColour((i/4)%2==0?Colours::lightgrey:Colours::grey);
-		ggc->setColour(ownerFilter->grid[i][j]?Colours::orange:((i/4)%2==0?Colours::lightgrey:Colours::grey));
+		ggc->update(ownerFilter->getCell(i, j), false);
 		addAndMakeVisible(ggc);
+		cells.add(ggc);
 	}
 
     // register ourselves with the filter - it will use its ChangeBroadcaster base
@@ -186,20 +244,33 @@ void GrooveGridEditorComponent::updateParametersFromFilter()
 {
     GrooveGridFilter* const filter = getFilter();
 
-    // we use this lock to make sure the processBlock() method isn't writing to the
-    // lastMidiMessage variable while we're trying to read it, but be extra-careful to
-    // only hold the lock for a minimum amount of time..
-    filter->getCallbackLock().enter();
+    // the pattern may have been changed by loading some new state
+    for (int i = 0; i < cells.size(); ++i)
+    {
+        const int step = i / GrooveGridPattern::numRows;
+        cells.getUnchecked(i)->update (filter->getCell (step, i % GrooveGridPattern::numRows), step == currentStep);
+    }
+
+    // the audio thread hands over its position without any locking, and it'll
+    // send another change message when there's something new to show
+    GrooveGridFilter::DisplayState displayState;
+
+    if (! filter->getLatestDisplayState (displayState))
+        return;
 
-    // take a local copy of the info we need while we've got the lock..
-    const AudioPlayHead::CurrentPositionInfo positionInfo (filter->lastPosInfo);
-    const float newGain = filter->getParameter (0);
+    const AudioPlayHead::CurrentPositionInfo& positionInfo = displayState.positionInfo;
 
-    // ..release the lock ASAP
-    filter->getCallbackLock().exit();
+    if (displayState.currentStep != currentStep)
+    {
+        currentStep = displayState.currentStep;
 
+        for (int i = 0; i < cells.size(); ++i)
+        {
+            const int step = i / GrooveGridPattern::numRows;
+            cells.getUnchecked(i)->update (filter->getCell (step, i % GrooveGridPattern::numRows), step == currentStep);
+        }
+    }
 
-    // ..and after releasing the lock, we're free to do the time-consuming UI stuff..
     String infoText;
     infoText << String (positionInfo.bpm, 2) << T(" bpm, ")
              << positionInfo.timeSigNumerator << T("/") << positionInfo.timeSigDenominator
@@ -28,6 +28,8 @@
 
 #include "GrooveGridFilter.h"
 
+class GrooveGridCell;
+
 
 //==============================================================================
 /**
@@ -87,6 +89,9 @@ private:
     ComponentBoundsConstrainer resizeLimits;
     TooltipWindow tooltipWindow;
 
+    Array<GrooveGridCell*> cells;
+    int currentStep;
+
     void updateParametersFromFilter();
 
 };
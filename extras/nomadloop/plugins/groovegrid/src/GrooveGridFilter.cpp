@@ -39,26 +39,65 @@ AudioProcessor* JUCE_CALLTYPE createPluginFilter()
     return new GrooveGridFilter();
 }
 
+//==============================================================================
+namespace
+{
+    // each step is a sixteenth note
+    const double stepLength = 0.25;
+
+    const int midiChannel = 10;
+    const int lowestNote = 32;
+
+    int ppqToSample (double ppq, double blockStartPpq, double samplesPerPpq, int numSamples)
+    {
+        return jlimit (0, jmax (0, numSamples - 1), roundDoubleToInt ((ppq - blockStartPpq) * samplesPerPpq));
+    }
+
+    void resetPositionInfo (AudioPlayHead::CurrentPositionInfo& info)
+    {
+        zeromem (&info, sizeof (info));
+        info.timeSigNumerator = 4;
+        info.timeSigDenominator = 4;
+        info.bpm = 120;
+    }
+}
+
+GrooveGridPattern::GrooveGridPattern()
+{
+    for (int i = 0; i < numSteps; ++i)
+    {
+        for (int j = 0; j < numRows; ++j)
+        {
+            Cell& cell = cells[i][j];
+            cell.active = false;
+            cell.velocity = 90;
+            cell.probability = 1.0f;
+            cell.length = 0.5f;
+            cell.swing = 0.0f;
+        }
+    }
+}
+
 //==============================================================================
 GrooveGridFilter::GrooveGridFilter()
-	: editorComp(0)
+	: sampleRate (44100.0),
+      expectedPpq (0),
+      positionValid (false),
+      editorComp(0)
 {
     gain = 1.0f;
     lastUIWidth = 400;
     lastUIHeight = 140;
 
-	lastStep = 0;
+    resetPositionInfo (lastDisplayState.positionInfo);
+    lastDisplayState.currentStep = -1;
+    displayNeedsPosting = true;
 
-	for (int i=0; i<16; ++i)
-	for (int j=0; j<8; ++j)
-	{
-		grid[i][j] = 0;
-	}
-
-    zeromem (&lastPosInfo, sizeof (lastPosInfo));
-    lastPosInfo.timeSigNumerator = 4;
-    lastPosInfo.timeSigDenominator = 4;
-    lastPosInfo.bpm = 120;
+    for (int i = 0; i < GrooveGridPattern::numRows; ++i)
+    {
+        rowNoteIsOn[i] = false;
+        rowNoteOffPpq[i] = 0;
+    }
 
 	setPlayConfigDetails(1, 1, 0, 0);
 }
@@ -156,9 +195,14 @@ bool GrooveGridFilter::producesMidi() const
 }
 
 //==============================================================================
-void GrooveGridFilter::prepareToPlay (double sampleRate, int samplesPerBlock)
+void GrooveGridFilter::prepareToPlay (double sampleRate_, int samplesPerBlock)
 {
-    // do your pre-playback setup stuff here..    
+    sampleRate = sampleRate_;
+    outputBuffer.ensureSize (2048);
+    positionValid = false;
+
+    for (int i = 0; i < GrooveGridPattern::numRows; ++i)
+        rowNoteIsOn[i] = false;
 }
 
 void GrooveGridFilter::releaseResources()
@@ -185,58 +229,156 @@ void GrooveGridFilter::processBlock (AudioSampleBuffer& buffer,
         buffer.clear (i, 0, buffer.getNumSamples());
     }
 
-	// TODO: extract any needed info from the MIDI stream before clearing the buffer
-midiMessages.clear();
+    // incoming MIDI isn't used, so the sequencer's own notes replace it
+    outputBuffer.clear();
+
+    // pick up the editor's latest changes, if there are any
+    patternMailbox.collect (audioPattern);
 
-    // have a go at getting the current time from the host, and if it's changed, tell
-    // our UI to update itself.
+    const int numSamples = buffer.getNumSamples();
     AudioPlayHead::CurrentPositionInfo pos;
+    int currentStep = -1;
 
     if (getPlayHead() != 0 && getPlayHead()->getCurrentPosition (pos))
     {
-        if (memcmp (&pos, &lastPosInfo, sizeof (pos)) != 0)
+        if (pos.isPlaying && pos.bpm > 0)
         {
-            lastPosInfo = pos;
-            sendChangeMessage (this);
+            const double samplesPerPpq = sampleRate * 60.0 / pos.bpm;
+            const double blockEndPpq = pos.ppqPosition + numSamples / samplesPerPpq;
+
+            // if the play head has jumped, the notes' end times don't mean anything any more
+            if (! positionValid || fabs (pos.ppqPosition - expectedPpq) > 2.0 / samplesPerPpq)
+                endAllNotes (0);
+
+            renderSteps (pos.ppqPosition, blockEndPpq, samplesPerPpq, numSamples);
 
-			const int ppqPerBar = (pos.timeSigNumerator * 4 / pos.timeSigDenominator);
-		    const double beats  = (fmod (pos.ppqPosition, ppqPerBar) / ppqPerBar) * pos.timeSigNumerator;
-
-			//const int bar       = ((int) pos.ppqPosition) / ppqPerBar + 1;
-			const int beat      = ((int) beats) + 1;
-			const int sixteenths = ((int)beats)*4 + ((int) (fmod (beats, 1.0) * 4.0));
-		    const int ticks     = ((int) (fmod (beats, 1.0) * 960.0));
-
-			// if we've arrived at the next sixteenth note in the sequence yet
-			if (sixteenths == (lastStep+1)%16)
-			{
-				// output the MIDI notes
-				lastStep = sixteenths;				
-				MidiBuffer buffer;
-
-				buffer.addEvent(MidiMessage::allNotesOff(10),0);
-				
-				for (int i=0; i<8; ++i)
-				{
-					if (grid[sixteenths%16][i])
-					{
-						buffer.addEvent(MidiMessage::noteOn(10, 32+i, (uint8)90), 1);
-					}
-				}
-
-				midiMessages.swapWith(buffer);
-			}
+            expectedPpq = blockEndPpq;
+            positionValid = true;
+
+            const int64 step = (int64) floor (pos.ppqPosition / stepLength);
+            currentStep = (int) (((step % GrooveGridPattern::numSteps) + GrooveGridPattern::numSteps) % GrooveGridPattern::numSteps);
+        }
+        else
+        {
+            endAllNotes (0);
+            positionValid = false;
         }
     }
     else
     {
-        zeromem (&lastPosInfo, sizeof (lastPosInfo));
-        lastPosInfo.timeSigNumerator = 4;
-        lastPosInfo.timeSigDenominator = 4;
-        lastPosInfo.bpm = 120;
+        endAllNotes (0);
+        positionValid = false;
+        resetPositionInfo (pos);
+    }
+
+    // have the editor show the new position, if it's changed
+    if (memcmp (&pos, &lastDisplayState.positionInfo, sizeof (pos)) != 0
+         || currentStep != lastDisplayState.currentStep)
+    {
+        lastDisplayState.positionInfo = pos;
+        lastDisplayState.currentStep = currentStep;
+        displayNeedsPosting = true;
+    }
+
+    if (displayNeedsPosting)
+    {
+        displayMailbox.post (lastDisplayState);
+        displayNeedsPosting = false;
+        sendChangeMessage (this);
+    }
+
+    midiMessages.swapWith (outputBuffer);
+}
+
+void GrooveGridFilter::renderSteps (double blockStartPpq, double blockEndPpq, double samplesPerPpq, int numSamples)
+{
+    // anything that would round to the first sample of the next block is left for that block
+    const double halfSample = 0.5 / samplesPerPpq;
+    const double fromPpq = blockStartPpq - halfSample;
+    const double toPpq = blockEndPpq - halfSample;
+
+    // swing can push a note up to half a step late, so start from the step before that
+    for (int64 step = (int64) floor ((fromPpq - 0.5 * stepLength) / stepLength);; ++step)
+    {
+        const double stepPpq = step * stepLength;
+
+        if (stepPpq >= toPpq)
+            break;
+
+        const int patternStep = (int) (((step % GrooveGridPattern::numSteps) + GrooveGridPattern::numSteps) % GrooveGridPattern::numSteps);
+
+        for (int row = 0; row < GrooveGridPattern::numRows; ++row)
+        {
+            const GrooveGridPattern::Cell& cell = audioPattern.cells[patternStep][row];
+
+            if (! cell.active)
+                continue;
+
+            const double notePpq = stepPpq + jlimit (0.0f, 1.0f, cell.swing) * 0.5 * stepLength;
+
+            if (notePpq < fromPpq || notePpq >= toPpq)
+                continue;
+
+            if (cell.probability < 1.0f && random.nextFloat() >= cell.probability)
+                continue;
+
+            const int note = lowestNote + row;
+
+            // a retriggered note ends when it was due to, or when the new one starts if that's sooner
+            if (rowNoteIsOn[row])
+            {
+                outputBuffer.addEvent (MidiMessage::noteOff (midiChannel, note),
+                                       ppqToSample (jmin (rowNoteOffPpq[row], notePpq), blockStartPpq, samplesPerPpq, numSamples));
+            }
+
+            outputBuffer.addEvent (MidiMessage::noteOn (midiChannel, note, cell.velocity),
+                                   ppqToSample (notePpq, blockStartPpq, samplesPerPpq, numSamples));
+
+            rowNoteIsOn[row] = true;
+            rowNoteOffPpq[row] = notePpq + jmax (0.01f, cell.length) * stepLength;
+        }
+    }
+
+    endNotesBefore (toPpq, blockStartPpq, samplesPerPpq, numSamples);
+}
+
+void GrooveGridFilter::endNotesBefore (double ppq, double blockStartPpq, double samplesPerPpq, int numSamples)
+{
+    for (int row = 0; row < GrooveGridPattern::numRows; ++row)
+    {
+        if (rowNoteIsOn[row] && rowNoteOffPpq[row] < ppq)
+        {
+            outputBuffer.addEvent (MidiMessage::noteOff (midiChannel, lowestNote + row),
+                                   ppqToSample (rowNoteOffPpq[row], blockStartPpq, samplesPerPpq, numSamples));
+            rowNoteIsOn[row] = false;
+        }
+    }
+}
+
+void GrooveGridFilter::endAllNotes (int samplePosition)
+{
+    for (int row = 0; row < GrooveGridPattern::numRows; ++row)
+    {
+        if (rowNoteIsOn[row])
+        {
+            outputBuffer.addEvent (MidiMessage::noteOff (midiChannel, lowestNote + row), samplePosition);
+            rowNoteIsOn[row] = false;
+        }
     }
 }
 
+//==============================================================================
+void GrooveGridFilter::setCell (int step, int row, const GrooveGridPattern::Cell& newCell)
+{
+    editorPattern.cells[step][row] = newCell;
+    postPattern();
+}
+
+void GrooveGridFilter::postPattern()
+{
+    patternMailbox.post (editorPattern);
+}
+
 //==============================================================================
 AudioProcessorEditor* GrooveGridFilter::createEditor()
 {
@@ -262,9 +404,25 @@ void GrooveGridFilter::getStateInformation (MemoryBlock& destData)
     xmlState.setAttribute (T("gainLevel"), gain);
     xmlState.setAttribute (T("uiWidth"), lastUIWidth);
     xmlState.setAttribute (T("uiHeight"), lastUIHeight);
-	
-    // you could also add as many child elements as you need to here..
 
+    for (int i = 0; i < GrooveGridPattern::numSteps; ++i)
+    {
+        for (int j = 0; j < GrooveGridPattern::numRows; ++j)
+        {
+            const GrooveGridPattern::Cell& cell = editorPattern.cells[i][j];
+
+            if (cell.active)
+            {
+                XmlElement* const e = xmlState.createNewChildElement (T("CELL"));
+                e->setAttribute (T("step"), i);
+                e->setAttribute (T("row"), j);
+                e->setAttribute (T("velocity"), (int) cell.velocity);
+                e->setAttribute (T("probability"), cell.probability);
+                e->setAttribute (T("length"), cell.length);
+                e->setAttribute (T("swing"), cell.swing);
+            }
+        }
+    }
 
     // then use this helper function to stuff it into the binary blob and return it..
     copyXmlToBinary (xmlState, destData);
@@ -286,6 +444,26 @@ void GrooveGridFilter::setStateInformation (const void* data, int sizeInBytes)
             lastUIWidth = xmlState->getIntAttribute (T("uiWidth"), lastUIWidth);
             lastUIHeight = xmlState->getIntAttribute (T("uiHeight"), lastUIHeight);
 
+            editorPattern = GrooveGridPattern();
+
+            forEachXmlChildElementWithTagName (*xmlState, e, T("CELL"))
+            {
+                const int step = e->getIntAttribute (T("step"), -1);
+                const int row = e->getIntAttribute (T("row"), -1);
+
+                if (step >= 0 && step < GrooveGridPattern::numSteps && row >= 0 && row < GrooveGridPattern::numRows)
+                {
+                    GrooveGridPattern::Cell& cell = editorPattern.cells[step][row];
+                    cell.active = true;
+                    cell.velocity = (uint8) jlimit (1, 127, e->getIntAttribute (T("velocity"), cell.velocity));
+                    cell.probability = jlimit (0.0f, 1.0f, (float) e->getDoubleAttribute (T("probability"), cell.probability));
+                    cell.length = jlimit (0.0f, 1.0f, (float) e->getDoubleAttribute (T("length"), cell.length));
+                    cell.swing = jlimit (0.0f, 1.0f, (float) e->getDoubleAttribute (T("swing"), cell.swing));
+                }
+            }
+
+            postPattern();
+
             sendChangeMessage (this);
         }
 
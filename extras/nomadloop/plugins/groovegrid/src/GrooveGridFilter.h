@@ -29,9 +29,90 @@
 
 //==============================================================================
 /**
-    A simple plugin filter that just applies a gain change to the audio
-    passing through it.
+    The contents of the grid: a bar of sixteenth-note steps for each of the
+    drum rows, with the settings for every cell.
+*/
+struct GrooveGridPattern
+{
+    enum
+    {
+        numSteps = 16,
+        numRows = 8
+    };
+
+    struct Cell
+    {
+        bool active;
+        uint8 velocity;
+
+        // the chance of the cell playing each time round, from 0 to 1
+        float probability;
+
+        // how long the note lasts, as a proportion of a step
+        float length;
+
+        // how late the note is pushed, from 0 (on the step) to 1 (half a step late)
+        float swing;
+    };
+
+    GrooveGridPattern();
+
+    Cell cells[numSteps][numRows];
+};
+
+//==============================================================================
+/**
+    Hands copies of an object from one thread to another without either side
+    ever having to wait for the other.
+
+    There are three copies of the object: one that the writer fills in, one that
+    the reader copies out of, and a spare in the middle.  Posting swaps the
+    writer's copy with the spare and marks it as new, and collecting swaps the
+    spare with the reader's copy if there's something new in it - each swap is
+    a single atomic exchange, so neither side ever spins or fails, and neither
+    ever touches the copy the other one is using.  Anything the reader hasn't
+    picked up yet just gets replaced by the next post.
+*/
+template <typename ObjectType>
+class GrooveGridMailbox
+{
+public:
+    GrooveGridMailbox() : writeIndex (0), readIndex (1), spare (2) {}
 
+    void post (const ObjectType& newObject)
+    {
+        objects[writeIndex] = newObject;
+        writeIndex = spare.exchange (writeIndex | newFlag) & indexMask;
+    }
+
+    // returns false if nothing new has been posted since the last call
+    bool collect (ObjectType& result)
+    {
+        if ((spare.get() & newFlag) == 0)
+            return false;
+
+        readIndex = spare.exchange (readIndex) & indexMask;
+        result = objects[readIndex];
+        return true;
+    }
+
+private:
+    enum { indexMask = 3, newFlag = 4 };
+
+    ObjectType objects[3];
+    int writeIndex, readIndex;
+    Atomic<int> spare;
+};
+
+//==============================================================================
+/**
+    A drum step sequencer.
+
+    The editor works on its own copy of the pattern and posts it to the audio
+    thread whenever it changes, and the audio thread posts the play position
+    back for the editor to display, so neither one touches the other's data.
+    Each block, every step that falls inside it is played at its exact sample
+    position, worked out from the host's ppq position.
 */
 class GrooveGridFilter  : public AudioPluginInstance,
                         public ChangeBroadcaster
@@ -99,22 +180,25 @@ public:
     void setStateInformation (const void* data, int sizeInBytes);
 
     //==============================================================================
-    // These properties are public so that our editor component can access them
-    //  - a bit of a hacky way to do it, but it's only a demo!
+    // The editor's copy of the pattern, which should only be used on the message thread
+    const GrooveGridPattern::Cell& getCell (int step, int row) const     { return editorPattern.cells[step][row]; }
+    void setCell (int step, int row, const GrooveGridPattern::Cell& newCell);
 
-    // this keeps a copy of the last set of time info that was acquired during an audio
-    // callback - the UI component will read this and display it.
-    AudioPlayHead::CurrentPositionInfo lastPosInfo;
+    // What the audio thread was last up to, for the editor to display
+    struct DisplayState
+    {
+        AudioPlayHead::CurrentPositionInfo positionInfo;
+        int currentStep;
+    };
+
+    // returns false if nothing new has arrived since the last call
+    bool getLatestDisplayState (DisplayState& result)            { return displayMailbox.collect (result); }
 
     // these are used to persist the UI's size - the values are stored along with the
     // filter's other parameters, and the UI component will update them when it gets
     // resized.
     int lastUIWidth, lastUIHeight;
 
-	// hackish but who cares, right?
-	// exposed variables for the pulses	
-	bool grid[16][8];
-
     //==============================================================================
     juce_UseDebuggingNewOperator
 
@@ -122,10 +206,29 @@ private:
     // this is our gain - the UI and the host can access this by getting/setting
     // parameter 0.
     float gain;
-	int lastStep;
+
+    GrooveGridPattern editorPattern, audioPattern;
+    GrooveGridMailbox<GrooveGridPattern> patternMailbox;
+
+    DisplayState lastDisplayState;
+    GrooveGridMailbox<DisplayState> displayMailbox;
+    bool displayNeedsPosting;
+
+    // the audio thread's position, and the notes it has left playing
+    double sampleRate;
+    double expectedPpq;
+    bool positionValid;
+    bool rowNoteIsOn[GrooveGridPattern::numRows];
+    double rowNoteOffPpq[GrooveGridPattern::numRows];
+    Random random;
+    MidiBuffer outputBuffer;
 
 	AudioProcessorEditor* editorComp;
 
+    void postPattern();
+    void endAllNotes (int samplePosition);
+    void renderSteps (double blockStartPpq, double blockEndPpq, double samplesPerPpq, int numSamples);
+    void endNotesBefore (double ppq, double blockStartPpq, double samplesPerPpq, int numSamples);
 };
 
 
@@ -56,6 +56,17 @@ HarmScaleFilter::HarmScaleFilter()
 
 	recalculateScaleTables();
 
+	midiPipeline.addProcessor (this);
+
+	// the input is expected to come from a MIDI guitar, which bends a whole octave either way
+	inputVoices.setPitchBendRangeForAllChannels (12.0f);
+
+	for (int i=0; i<16; ++i)
+		lastOutputNote[i] = -1;
+
+	midiBlockStartTime = 0;
+	midiBlockLength = 0;
+
     zeromem (&lastPosInfo, sizeof (lastPosInfo));
     lastPosInfo.timeSigNumerator = 4;
     lastPosInfo.timeSigDenominator = 4;
@@ -213,6 +224,11 @@ bool HarmScaleFilter::producesMidi() const
 void HarmScaleFilter::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     // do your pre-playback setup stuff here..    
+	midiPipeline.prepare();
+
+	inputVoices.reset();
+	midiBlockStartTime = 0;
+	midiBlockLength = 0;
 }
 
 void HarmScaleFilter::releaseResources()
@@ -259,50 +275,65 @@ void HarmScaleFilter::processBlock (AudioSampleBuffer& buffer,
         lastPosInfo.bpm = 120;
     }
 
-	// here's the meat - modify the incoming MIDI stream
-	MidiBuffer processedMidiMessages;
-	MidiBuffer::Iterator midiItor(midiMessages);
-	MidiMessage message(0x80, 60, 0);
-	int samplePos;
+	// here's the meat - modify the incoming MIDI stream, in place
+	midiPipeline.process (midiMessages, buffer.getNumSamples());
+}
 
-	while (midiItor.getNextEvent(message, samplePos))
-	{
-		int channel = message.getChannel();	
-		if (message.isNoteOn())
-		{
-			int pitch = channelData[channel].lastInputNote = message.getNoteNumber();
+void HarmScaleFilter::beginMidiBlock (MidiEventPipeline::Output&, int numSamples)
+{
+	midiBlockStartTime += midiBlockLength;
+	midiBlockLength = numSamples;
+}
 
-			// add semitones, then count down till a valid pitch is reached
-			pitch += transposeSemitones;
+bool HarmScaleFilter::processMidiEvent (uint8* data, int numBytes, int samplePosition,
+                                        MidiEventPipeline::Output& output)
+{
+	const int channel = getChannel (data);
+	if (channel == 0)
+		return true;
 
-			pitch = scaleFloorMap[pitch%12] + 12*(pitch/12);
+	inputVoices.processEvent (data, numBytes, midiBlockStartTime + samplePosition);
 
-			channelData[channel].lastOutputNote = pitch;
+	int& outputNote = lastOutputNote[channel - 1];
+	const int type = data[0] & 0xf0;
 
-			// reset pitch bend			
-			processedMidiMessages.addEvent(MidiMessage::pitchWheel(channel,
-				calculatePitchbendForNote(channelData[channel].lastInputNote,
-				channelData[channel].lastInputPitchbend,
-				channelData[channel].lastOutputNote)), samplePos);			
+	if (type == 0x90 && data[2] > 0)
+	{
+		// add semitones, then count down till a valid pitch is reached
+		const int pitch = getScaleFloor (data[1] + transposeSemitones);
 
-			message.setNoteNumber(pitch);
-		}
-		else if (message.isNoteOff())
+		if (pitch < 0 || pitch > 127)
 		{
-			message.setNoteNumber(channelData[channel].lastOutputNote);			
+			// the note-off that goes with this will be dropped too
+			outputNote = -1;
+			return false;
 		}
-		else if (message.isPitchWheel())
-		{		
-			int pitchWheel = message.getPitchWheelValue();
 
-			int newPitchWheel = calculatePitchbendForNote(channelData[channel].lastInputNote, pitchWheel, channelData[channel].lastOutputNote);
-			channelData[channel].lastOutputPitchbend = newPitchWheel;
-			message = MidiMessage::pitchWheel(channel, newPitchWheel);
-		}
-		processedMidiMessages.addEvent(message, samplePos);		
+		outputNote = pitch;
+
+		// reset pitch bend, ahead of the note
+		const int pitchWheel = calculatePitchbendForNote (inputVoices.getBentPitch (channel, data[1]), outputNote);
+		const uint8 bend[3] = { (uint8) (0xe0 | (channel - 1)), (uint8) (pitchWheel & 127), (uint8) ((pitchWheel >> 7) & 127) };
+		output.insertEvent (bend, 3);
+
+		data[1] = (uint8) pitch;
+	}
+	else if (type == 0x80 || type == 0x90)
+	{
+		if (outputNote < 0)
+			return false;
+
+		data[1] = (uint8) outputNote;
+	}
+	else if (type == 0xe0 && outputNote >= 0)
+	{
+		const int lastInputNote = jmax (0, inputVoices.getLastNote (channel));
+		const int newPitchWheel = calculatePitchbendForNote (inputVoices.getBentPitch (channel, lastInputNote), outputNote);
+		data[1] = (uint8) (newPitchWheel & 127);
+		data[2] = (uint8) ((newPitchWheel >> 7) & 127);
 	}
 
-	midiMessages.swap(processedMidiMessages);	
+	return true;
 }
 
 //==============================================================================
@@ -429,30 +460,122 @@ void HarmScaleFilter::recalculateScaleTables()
 		scaleStepRunLength[6], scaleStepRunLength[7], scaleStepRunLength[8], scaleStepRunLength[9], scaleStepRunLength[10], scaleStepRunLength[11]);	
 }
 
-int HarmScaleFilter::calculatePitchbendForNote(int inputNote, int inputPitchWheel, int lastOutputNote)
+int HarmScaleFilter::getPitchClass (int pitch)
+{
+	return ((pitch % 12) + 12) % 12;
+}
+
+int HarmScaleFilter::getScaleFloor (int pitch) const
+{
+	// the scale tables only cover one octave, so split the pitch into an octave
+	// and a pitch-class, rounding down for pitches below zero too
+	const int pitchClass = getPitchClass (pitch);
+	return scaleFloorMap[pitchClass] + (pitch - pitchClass);
+}
+
+int HarmScaleFilter::calculatePitchbendForNote(float inputShiftedPitch, int lastOutputNote)
 {
 	// remap value based on shift
-	float semitoneModByPitchWheel = (inputPitchWheel-8192)/(8192.0f/12);
-	float inputShiftedPitch = semitoneModByPitchWheel + inputNote;
 	int intShiftedPitch = static_cast<int>(std::floor(inputShiftedPitch));
 
 	// calculate percent of sweep through the pitch-run block
-	float sweep = (inputShiftedPitch-(scaleFloorMap[intShiftedPitch % 12] + 12*(intShiftedPitch/12)))/scaleStepRunLength[scaleFloorMap[intShiftedPitch%12]%12];
+	const int floorNote = getScaleFloor (intShiftedPitch);
+	float sweep = (inputShiftedPitch - floorNote) / scaleStepRunLength[getPitchClass (floorNote)];
 
 	float harmonyScaledPitch = inputShiftedPitch + transposeSemitones;
 	int scaledRoundedPitch = static_cast<int>(std::floor(harmonyScaledPitch/* + 0.5f*/));
-	int pitchBin = scaleFloorMap[scaledRoundedPitch % 12];
-	float targetPitch = pitchBin + 12*(scaledRoundedPitch/12) + sweep*0.5f*scaleStepRunLength[pitchBin];
+	const int scaledFloorNote = getScaleFloor (scaledRoundedPitch);
+	float targetPitch = scaledFloorNote + sweep*0.5f*scaleStepRunLength[getPitchClass (scaledFloorNote)];
 
 	// recalculate pitch bend value to map last output note to targetPitch
 	float semitoneOffsetFromOutputNote = targetPitch-lastOutputNote;
 	int newPitchWheel = 8192+static_cast<int>(8192*semitoneOffsetFromOutputNote/12);
 
-	//juce::Logger::outputDebugPrintf(T("Pitch bend in: %i, making input note a %i, swept %f, and out note: %i, and outwheel: %i"), pitchWheel, static_cast<int>(inputShiftedPitch+0.5f), sweep, 12*(scaledRoundedPitch/12) + pitchBin, newPitchWheel);
-	juce::Logger::outputDebugPrintf(T("IN: %i/%i/%f, sweep: %f, OUT: %i/%i/%f"),
-		inputNote, inputPitchWheel, inputShiftedPitch,
-		sweep,
-		lastOutputNote, newPitchWheel, targetPitch);
-
 	return jmin(16383, jmax(0, newPitchWheel));
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class HarmScaleFilterTests : public UnitTest
+{
+public:
+	HarmScaleFilterTests() : UnitTest ("HarmScaleFilter") {}
+
+	// the notes that come out of a block, as "on" or "off" followed by the note number
+	static const String playBlock (HarmScaleFilter& filter, MidiBuffer& midi)
+	{
+		AudioSampleBuffer audio (1, 64);
+		filter.processBlock (audio, midi);
+
+		String s;
+		MidiBuffer::Iterator i (midi);
+		MidiMessage m (0xf8);
+		int position;
+
+		while (i.getNextEvent (m, position))
+		{
+			if (m.isNoteOn())
+				s << "on" << m.getNoteNumber() << ' ';
+			else if (m.isNoteOff())
+				s << "off" << m.getNoteNumber() << ' ';
+		}
+
+		return s.trimEnd();
+	}
+
+	void runTest()
+	{
+		HarmScaleFilter filter;
+		filter.prepareToPlay (44100.0, 64);
+		MidiBuffer midi;
+
+		beginTest ("Mapping onto the scale");
+		{
+			// a major third up, in C major: E goes to G#, which comes down to G
+			midi.clear();
+			midi.addEvent (MidiMessage::noteOn (1, 64, 1.0f), 0);
+			expectEquals (playBlock (filter, midi), String ("on67"));
+
+			midi.clear();
+			midi.addEvent (MidiMessage::noteOff (1, 64), 0);
+			expectEquals (playBlock (filter, midi), String ("off67"));
+		}
+
+		beginTest ("Notes below the range");
+		{
+			// an octave down takes the lowest notes below zero, where they're dropped,
+			// along with their note-offs, rather than being sent as the last note
+			filter.setParameter (13, 0.0f);
+
+			midi.clear();
+			midi.addEvent (MidiMessage::noteOn (2, 60, 1.0f), 0);
+			midi.addEvent (MidiMessage::noteOff (2, 60), 10);
+			expectEquals (playBlock (filter, midi), String ("on48 off48"));
+
+			midi.clear();
+			midi.addEvent (MidiMessage::noteOn (2, 5, 1.0f), 0);
+			midi.addEvent (MidiMessage::noteOff (2, 5), 10);
+			expectEquals (playBlock (filter, midi), String::empty);
+
+			// and the note after that is mapped as usual
+			midi.clear();
+			midi.addEvent (MidiMessage::noteOn (2, 13, 1.0f), 0);
+			midi.addEvent (MidiMessage::noteOff (2, 13), 10);
+			expectEquals (playBlock (filter, midi), String ("on0 off0"));
+		}
+
+		beginTest ("Bending below the range");
+		{
+			// a bend that takes the pitch below zero mustn't look outside the scale tables
+			midi.clear();
+			midi.addEvent (MidiMessage::noteOn (3, 12, 1.0f), 0);
+			midi.addEvent (MidiMessage::pitchWheel (3, 0), 10);
+			expectEquals (playBlock (filter, midi), String ("on0"));
+		}
+	}
+};
+
+static HarmScaleFilterTests harmScaleFilterTests;
+
+#endif
@@ -34,7 +34,8 @@
 
 */
 class HarmScaleFilter  : public AudioProcessor,
-                        public ChangeBroadcaster
+                        public ChangeBroadcaster,
+                        public MidiEventProcessor
 {
 public:
     //==============================================================================
@@ -48,6 +49,10 @@ public:
 	void processBlock (AudioSampleBuffer& buffer,
                        MidiBuffer& midiMessages);
 
+    void beginMidiBlock (MidiEventPipeline::Output& output, int numSamples);
+    bool processMidiEvent (uint8* data, int numBytes, int samplePosition,
+                           MidiEventPipeline::Output& output);
+
     //==============================================================================
     AudioProcessorEditor* createEditor();
 
@@ -116,22 +121,22 @@ private:
 	int scaleStepRunLength[12];
 	void recalculateScaleTables();
 
-	int calculatePitchbendForNote(int inputNote, int inputPitchWheel, int lastOutputNote);
-
-	struct PerChannelData
-	{
-		PerChannelData()
-			: lastInputNote(0), lastInputPitchbend(8192), lastOutputNote(0)
-		{
-		}
-
-		int lastInputNote;
-		int lastInputPitchbend;
-		int lastOutputNote;
-		int lastOutputPitchbend;
-	};
-	
-	PerChannelData channelData[16];
+	// maps a pitch down onto the scale, for any pitch, including ones outside the MIDI range
+	static int getPitchClass (int pitch);
+	int getScaleFloor (int pitch) const;
+
+	int calculatePitchbendForNote(float inputPitch, int lastOutputNote);
+
+	// the incoming notes and bends, and the note each channel was last mapped to,
+	// or -1 if its last note was dropped
+	MidiVoiceTracker inputVoices;
+	int lastOutputNote[16];
+
+	// the time of the current block's first sample, in samples since playback started
+	double midiBlockStartTime;
+	int midiBlockLength;
+
+	MidiEventPipeline midiPipeline;
 };
 
 
@@ -26,6 +26,8 @@
 #include "includes.h"
 #include "host/MainHostWindow.h"
 #include "host/InternalFilters.h"
+#include "host/PluginScanner.h"
+#include "host/PluginSandbox.h"
 
 #if ! JUCE_PLUGINHOST_VST
 // #error "If you're building the audio plugin host, you probably want to enable VST support in juce_Config.h"
@@ -52,7 +54,7 @@ public:
     {
     }
 
-    void initialise (const String& /*commandLine*/)
+    void initialise (const String& commandLine)
     {
         // initialise our settings file..
 	PropertiesFile::Options options;
@@ -67,6 +69,32 @@ public:
 
         AudioPluginFormatManager::getInstance()->addDefaultFormats();
         AudioPluginFormatManager::getInstance()->addFormat (new InternalPluginFormat());
+        AudioPluginFormatManager::getInstance()->addFormat (new SandboxedPluginFormat());
+
+       #if JUCE_UNIT_TESTS
+        AudioPluginFormatManager::getInstance()->addFormat (new SandboxStandInFormat());
+       #endif
+
+        // if we've been launched to scan or run a plugin on behalf of the host, don't open any windows
+        if (OutOfProcessPluginScanner::startChildProcessIfRequested (commandLine)
+             || SandboxedPluginFormat::startChildProcessIfRequested (commandLine))
+            return;
+
+       #if JUCE_UNIT_TESTS
+        if (commandLine.contains ("--run-unit-tests"))
+        {
+            UnitTestRunner runner;
+            runner.runAllTests (false);
+
+            int numFailures = 0;
+            for (int i = 0; i < runner.getNumResults(); ++i)
+                numFailures += runner.getResult (i)->failures;
+
+            setApplicationReturnValue (numFailures > 0 ? 1 : 0);
+            quit();
+            return;
+        }
+       #endif
 
         mainWindow = new MainHostWindow();		
         //mainWindow->setUsingNativeTitleBar (true);
@@ -1,203 +1,632 @@
-#include "Arpeggiator.h"
-#include <cmath>
-
-Arpeggiator::Arpeggiator() : rate(0), outputIndex(0)
-{
-	setPlayConfigDetails (0, 0, 0, 0);
-}
-
-void Arpeggiator::fillInPluginDescription(PluginDescription &desc) const
-{
-	desc.name = "Arpeggiator";
-	desc.pluginFormatName = "Internal";
-	desc.category = "Midi Effects";
-	desc.manufacturerName = "Monkey Fairness Productions";
-	desc.version = "0.1";
-	desc.fileOrIdentifier = "";
-	desc.lastFileModTime = Time();
-	desc.uid = 4;
-	desc.isInstrument = false;
-	desc.numInputChannels = 0;
-	desc.numOutputChannels = 0;
-}
-
-const String Arpeggiator::getName() const
-{
-	return T("Arpeggiator");
-}
-
-void Arpeggiator::prepareToPlay(double sampleRate, int estimatedSamplesPerBlock)
-{
-	this->sampleRate = sampleRate;
-}
-
-void Arpeggiator::releaseResources()
-{
-}
-
-void Arpeggiator::processBlock(AudioSampleBuffer &sampleBuffer, MidiBuffer &midiBuffer)
-{
-	MidiBuffer::Iterator itor(midiBuffer);
-	MidiMessage message(0x80, 1, 1);
-	int samplePos;
-
-	while (itor.getNextEvent(message, samplePos))
-	{
-		if (message.isNoteOn())
-		{
-			activeInputNotes.addIfNotAlreadyThere(message.getNoteNumber());
-		}
-		else if (message.isNoteOff())
-		{
-			activeInputNotes.removeValue(message.getNoteNumber());
-		}
-	}
-	
-	AudioPlayHead* playHead = getPlayHead();
-
-	if (activeInputNotes.size() > 0 && playHead != 0)
-	{
-		midiBuffer.clear();
-		AudioPlayHead::CurrentPositionInfo pos;
-
-		playHead->getCurrentPosition(pos);
-
-		int samplesPerArpIncrement = (sampleRate * 60) / (16*pos.bpm);
-
-		double samplesLeftInBuffer = sampleBuffer.getNumSamples();
-
-		// sixteenth notes
-		double ppqPerArpNote = 1.0/4.0;
-
-		// calculate the sample position for the first playing note at this edge
-		double ppqOfNextArpNote = std::ceil(pos.ppqPosition / ppqPerArpNote) * ppqPerArpNote;
-		int samplePosition = 0.5 + (sampleRate * 60/pos.bpm)*(ppqOfNextArpNote - pos.ppqPosition);
-
-		if (activeOutputNoteCount > 0 && activeInputNotes.size() == 0)
-		{
-			// some notes were still playing last frame, so turn them off now			
-			midiBuffer.addEvent(MidiMessage::allNotesOff(1), samplePosition);
-		}
-		else while (samplePosition < sampleBuffer.getNumSamples())
-		{
-			// turn off old notes			
-			//midiBuffer.addEvent(MidiMessage::noteOff(1, activeInputNotes.getUnchecked(outputIndex)), samplePosition);
-			midiBuffer.addEvent(MidiMessage::allNotesOff(1), samplePosition);
-
-			outputIndex = (outputIndex + 1) % (activeInputNotes.size());
-
-			// move to next piece in the pattern, turn on those notes
-			midiBuffer.addEvent(MidiMessage::noteOn(1, activeInputNotes.getUnchecked(outputIndex), 90.0f), samplePosition);
-
-			//NomadJuce::Logger::outputDebugPrintf(T("Played note %i at %i"), outputIndex, samplePosition);
-
-			samplePosition += samplesPerArpIncrement;
-		}
-
-		//NomadJuce::Logger::outputDebugPrintf(T("step samples: %i\t\tbuffersize: %i\tovershot buffer by: %i"), samplesPerArpIncrement, sampleBuffer.getNumSamples(), (samplePosition - sampleBuffer.getNumSamples()));		
-	}
-
-	activeOutputNoteCount = activeInputNotes.size();
-
-}
-
-const String Arpeggiator::getInputChannelName(const int) const
-{
-	return T("Input");
-}
-
-const String Arpeggiator::getOutputChannelName(const int) const
-{
-	return T("Output");
-}
-
-bool Arpeggiator::isInputChannelStereoPair(int) const
-{
-	return false;
-}
-
-bool Arpeggiator::isOutputChannelStereoPair(int) const
-{
-	return false;
-}
-
-bool Arpeggiator::acceptsMidi() const
-{
-	return true;
-}
-
-bool Arpeggiator::producesMidi() const
-{
-	return true;
-}
-
-bool Arpeggiator::hasEditor() const { return false; }
-
-AudioProcessorEditor* Arpeggiator::createEditor()
-{
-	return 0;
-}
-
-int Arpeggiator::getNumParameters()
-{
-	return 1;
-}
-
-const String Arpeggiator::getParameterName(int)
-{
-	return T("Rate");
-}
-
-float Arpeggiator::getParameter(int)
-{
-	return rate;
-}
-
-const String Arpeggiator::getParameterText(int)
-{
-	if (rate < 0.25f)
-		return T("1/4");
-	else if (rate < 0.5f)
-		return T("1/8");
-	else if (rate < 0.75f)
-		return T("1/16");
-	else
-		return T("1/32");
-	
-}
-
-void Arpeggiator::setParameter(int index, float value)
-{
-	rate = value;
-}
-
-int Arpeggiator::getNumPrograms()
-{
-	return 0;
-}
-
-int Arpeggiator::getCurrentProgram()
-{
-	return 0;
-}
-
-void Arpeggiator::setCurrentProgram(int)
-{
-}
-const String Arpeggiator::getProgramName(int)
-{
-	return String::empty;
-}
-
-void Arpeggiator::changeProgramName(int, const String&)
-{
-}
-
-void Arpeggiator::getStateInformation(MemoryBlock&)
-{
-}
-
-void Arpeggiator::setStateInformation(const void *, int)
-{
-}
-
+#include "Arpeggiator.h"
+#include <cmath>
+
+namespace
+{
+	const int numRates = 6;
+	const double rateLengths[numRates] = { 1.0, 0.5, 1.0/3.0, 0.25, 1.0/6.0, 0.125 };
+	const char* const rateNames[numRates] = { "1/4", "1/8", "1/8T", "1/16", "1/16T", "1/32" };
+
+	const char* const patternNames[Arpeggiator::numPatterns] = { "Up", "Down", "Up/Down", "As Played", "Random" };
+
+	// turns a 0-1 parameter value into one of a number of choices
+	int getChoice(float value, int numChoices)
+	{
+		return jlimit(0, numChoices - 1, (int) (value * numChoices));
+	}
+
+	void addNoteMessage(MidiEventPipeline::Output& output, int type, int channel, int note, int velocity, int samplePosition)
+	{
+		const uint8 data[3] = { (uint8) (type | (channel - 1)), (uint8) note, (uint8) velocity };
+		output.insertEventAt(data, 3, samplePosition);
+	}
+}
+
+Arpeggiator::Arpeggiator()
+: numHeldNotes(0), numSoundingNotes(0), sampleRate(44100.0), lastBpm(120.0),
+  expectedPpq(0), positionValid(false), blockStartPpq(0), samplesPerPpq(1), blockLength(0),
+  nextStep(0), currentStepLength(0), patternIndex(0)
+{
+	setPlayConfigDetails (0, 0, 0, 0);
+	midiPipeline.addProcessor(this);
+
+	parameters[rateParam] = 0.5f;
+	parameters[patternParam] = 0;
+	parameters[octavesParam] = 0;
+	parameters[gateParam] = 0.5f;
+	parameters[swingParam] = 0;
+}
+
+void Arpeggiator::fillInPluginDescription(PluginDescription &desc) const
+{
+	desc.name = "Arpeggiator";
+	desc.pluginFormatName = "Internal";
+	desc.category = "Midi Effects";
+	desc.manufacturerName = "Monkey Fairness Productions";
+	desc.version = "0.2";
+	desc.fileOrIdentifier = "";
+	desc.lastFileModTime = Time();
+	desc.uid = 4;
+	desc.isInstrument = false;
+	desc.numInputChannels = 0;
+	desc.numOutputChannels = 0;
+}
+
+const String Arpeggiator::getName() const
+{
+	return T("Arpeggiator");
+}
+
+void Arpeggiator::prepareToPlay(double sampleRate, int)
+{
+	this->sampleRate = sampleRate;
+	midiPipeline.prepare();
+	reset();
+}
+
+void Arpeggiator::releaseResources()
+{
+	reset();
+}
+
+void Arpeggiator::reset()
+{
+	numHeldNotes = 0;
+	numSoundingNotes = 0;
+	positionValid = false;
+	expectedPpq = 0;
+	nextStep = 0;
+	patternIndex = 0;
+}
+
+// ==========================
+
+double Arpeggiator::getStepLength() const
+{
+	return rateLengths[getChoice(parameters[rateParam], numRates)];
+}
+
+double Arpeggiator::getStepPpq(int64 step, double stepLength) const
+{
+	// swing pushes every other step late, by up to half a step
+	const double swingDelay = (step & 1) != 0 ? parameters[swingParam] * 0.5 * stepLength : 0.0;
+	return step * stepLength + swingDelay;
+}
+
+int64 Arpeggiator::findFirstStepAtOrAfter(double ppq, double stepLength) const
+{
+	// swing only ever delays a step by less than a whole one, so it's this one or the next
+	const int64 step = (int64) std::floor(ppq / stepLength);
+	return getStepPpq(step, stepLength) >= ppq ? step : step + 1;
+}
+
+int Arpeggiator::ppqToSample(double ppq) const
+{
+	return jlimit(0, jmax(0, blockLength - 1), roundToInt((ppq - blockStartPpq) * samplesPerPpq));
+}
+
+// ==========================
+
+void Arpeggiator::addHeldNote(const HeldNote& held)
+{
+	int insertAt = numHeldNotes;
+
+	for (int i = 0; i < numHeldNotes; ++i)
+	{
+		const HeldNote& n = notesByPitch[i];
+
+		if (n.note == held.note && n.channel == held.channel)
+			return;
+
+		if (insertAt == numHeldNotes && (n.note > held.note || (n.note == held.note && n.channel > held.channel)))
+			insertAt = i;
+	}
+
+	// once the set is full, extra notes are ignored rather than making room
+	if (numHeldNotes >= maxHeldNotes)
+		return;
+
+	for (int i = numHeldNotes; i > insertAt; --i)
+		notesByPitch[i] = notesByPitch[i - 1];
+
+	notesByPitch[insertAt] = held;
+	notesByArrival[numHeldNotes] = held;
+	++numHeldNotes;
+}
+
+void Arpeggiator::removeHeldNote(int channel, int note)
+{
+	int found = -1;
+
+	for (int i = 0; i < numHeldNotes; ++i)
+	{
+		if (notesByPitch[i].note == note && notesByPitch[i].channel == channel)
+		{
+			found = i;
+			break;
+		}
+	}
+
+	if (found < 0)
+		return;
+
+	for (int i = found; i < numHeldNotes - 1; ++i)
+		notesByPitch[i] = notesByPitch[i + 1];
+
+	for (int i = 0, j = 0; i < numHeldNotes; ++i)
+	{
+		if (notesByArrival[i].note != note || notesByArrival[i].channel != channel)
+			notesByArrival[j++] = notesByArrival[i];
+	}
+
+	// start the pattern from the top again for the next chord
+	if (--numHeldNotes == 0)
+		patternIndex = 0;
+}
+
+int Arpeggiator::findSoundingNote(int channel, int note) const
+{
+	for (int i = 0; i < numSoundingNotes; ++i)
+	{
+		if (soundingNotes[i].note == note && soundingNotes[i].channel == channel)
+			return i;
+	}
+
+	return -1;
+}
+
+void Arpeggiator::addSoundingNote(int channel, int note, double endPpq)
+{
+	jassert(numSoundingNotes < maxSoundingNotes);
+
+	SoundingNote& s = soundingNotes[numSoundingNotes++];
+	s.channel = (uint8) channel;
+	s.note = (uint8) note;
+	s.endPpq = endPpq;
+}
+
+void Arpeggiator::endSoundingNotesBefore(double ppq, MidiEventPipeline::Output& output)
+{
+	// the pipeline needs its events in time order, so the earliest goes first
+	for (;;)
+	{
+		int earliest = -1;
+
+		for (int i = 0; i < numSoundingNotes; ++i)
+		{
+			if (soundingNotes[i].endPpq <= ppq && (earliest < 0 || soundingNotes[i].endPpq < soundingNotes[earliest].endPpq))
+				earliest = i;
+		}
+
+		if (earliest < 0)
+			break;
+
+		const SoundingNote& s = soundingNotes[earliest];
+		addNoteMessage(output, 0x80, s.channel, s.note, 0, ppqToSample(s.endPpq));
+
+		soundingNotes[earliest] = soundingNotes[--numSoundingNotes];
+	}
+}
+
+void Arpeggiator::endAllSoundingNotes(MidiEventPipeline::Output& output)
+{
+	for (int i = 0; i < numSoundingNotes; ++i)
+		output.insertEvent(MidiMessage::noteOff(soundingNotes[i].channel, soundingNotes[i].note));
+
+	numSoundingNotes = 0;
+}
+
+// ==========================
+
+int Arpeggiator::getPatternLength(int pattern, int octaves) const
+{
+	const int numSteps = numHeldNotes * octaves;
+
+	// up/down doesn't repeat the top and bottom notes
+	if (pattern == patternUpDown)
+		return jmax(1, 2 * numSteps - 2);
+
+	return numSteps;
+}
+
+bool Arpeggiator::getPatternNote(int pattern, int octaves, HeldNote& result)
+{
+	if (numHeldNotes == 0)
+		return false;
+
+	const int numSteps = numHeldNotes * octaves;
+	const int length = getPatternLength(pattern, octaves);
+
+	// the set may have shrunk since the last step
+	if (patternIndex >= length)
+		patternIndex = 0;
+
+	int position;
+
+	switch (pattern)
+	{
+	case patternDown:
+		position = numSteps - 1 - patternIndex;
+		break;
+	case patternUpDown:
+		position = patternIndex < numSteps ? patternIndex : 2 * numSteps - 2 - patternIndex;
+		break;
+	case patternRandom:
+		position = random.nextInt(numSteps);
+		break;
+	default:
+		position = patternIndex;
+		break;
+	}
+
+	patternIndex = (patternIndex + 1) % length;
+
+	const HeldNote* const source = pattern == patternAsPlayed ? notesByArrival : notesByPitch;
+	result = source[position % numHeldNotes];
+
+	int note = result.note + 12 * (position / numHeldNotes);
+	while (note > 127)
+		note -= 12;
+
+	result.note = (uint8) note;
+	return true;
+}
+
+void Arpeggiator::renderSteps(double toPpq, MidiEventPipeline::Output& output)
+{
+	const int pattern = getChoice(parameters[patternParam], numPatterns);
+	const int octaves = getChoice(parameters[octavesParam], maxOctaves) + 1;
+	const double gate = jlimit(0.05, 1.0, (double) parameters[gateParam]);
+
+	for (;;)
+	{
+		const double stepPpq = getStepPpq(nextStep, currentStepLength);
+
+		if (stepPpq >= toPpq)
+			break;
+
+		++nextStep;
+
+		endSoundingNotesBefore(stepPpq, output);
+
+		HeldNote held;
+
+		if (getPatternNote(pattern, octaves, held))
+		{
+			const int samplePosition = ppqToSample(stepPpq);
+
+			// retriggering a note that's still going ends it first
+			const int existing = findSoundingNote(held.channel, held.note);
+			if (existing >= 0)
+			{
+				addNoteMessage(output, 0x80, held.channel, held.note, 0, samplePosition);
+				soundingNotes[existing] = soundingNotes[--numSoundingNotes];
+			}
+
+			if (numSoundingNotes < maxSoundingNotes)
+			{
+				addNoteMessage(output, 0x90, held.channel, held.note, held.velocity, samplePosition);
+				addSoundingNote(held.channel, held.note, stepPpq + gate * currentStepLength);
+			}
+		}
+	}
+
+	endSoundingNotesBefore(toPpq, output);
+}
+
+void Arpeggiator::processBlock(AudioSampleBuffer &sampleBuffer, MidiBuffer &midiBuffer)
+{
+	midiPipeline.process(midiBuffer, sampleBuffer.getNumSamples());
+}
+
+void Arpeggiator::beginMidiBlock(MidiEventPipeline::Output& output, int numSamples)
+{
+	// follow the host while its transport runs, otherwise carry on from where we were
+	AudioPlayHead::CurrentPositionInfo pos;
+	AudioPlayHead* const playHead = getPlayHead();
+	blockStartPpq = positionValid ? expectedPpq : 0.0;
+
+	if (playHead != 0 && playHead->getCurrentPosition(pos) && pos.isPlaying && pos.bpm > 0)
+	{
+		lastBpm = pos.bpm;
+		blockStartPpq = pos.ppqPosition;
+	}
+
+	samplesPerPpq = sampleRate * 60.0 / lastBpm;
+	blockLength = numSamples;
+
+	const double stepLength = getStepLength();
+
+	if (!positionValid || std::fabs(blockStartPpq - expectedPpq) > 2.0 / samplesPerPpq)
+	{
+		// the play head jumped, so the notes' end times mean nothing any more
+		endAllSoundingNotes(output);
+		currentStepLength = stepLength;
+		nextStep = findFirstStepAtOrAfter(blockStartPpq, stepLength);
+	}
+	else if (stepLength != currentStepLength)
+	{
+		currentStepLength = stepLength;
+		nextStep = findFirstStepAtOrAfter(blockStartPpq, stepLength);
+	}
+
+	expectedPpq = blockStartPpq + numSamples / samplesPerPpq;
+	positionValid = true;
+}
+
+void Arpeggiator::renderMidiUpTo(int samplePosition, MidiEventPipeline::Output& output)
+{
+	// anything that would round to the sample being rendered to is left until after it,
+	// which at the end of the block means leaving it for the next block
+	renderSteps(blockStartPpq + (samplePosition - 0.5) / samplesPerPpq, output);
+}
+
+bool Arpeggiator::processMidiEvent(uint8* data, int numBytes, int, MidiEventPipeline::Output&)
+{
+	// held notes change at the exact point in the block where they're played
+	const int type = data[0] & 0xf0;
+	const int channel = getChannel(data);
+
+	if (type == 0x90 && numBytes >= 3 && data[2] != 0)
+	{
+		HeldNote held;
+		held.channel = (uint8) channel;
+		held.note = data[1];
+		held.velocity = data[2];
+		addHeldNote(held);
+		return false;
+	}
+
+	if ((type == 0x80 || type == 0x90) && numBytes >= 3)
+	{
+		removeHeldNote(channel, data[1]);
+		return false;
+	}
+
+	return true;
+}
+
+const String Arpeggiator::getInputChannelName(const int) const
+{
+	return T("Input");
+}
+
+const String Arpeggiator::getOutputChannelName(const int) const
+{
+	return T("Output");
+}
+
+bool Arpeggiator::isInputChannelStereoPair(int) const
+{
+	return false;
+}
+
+bool Arpeggiator::isOutputChannelStereoPair(int) const
+{
+	return false;
+}
+
+bool Arpeggiator::acceptsMidi() const
+{
+	return true;
+}
+
+bool Arpeggiator::producesMidi() const
+{
+	return true;
+}
+
+bool Arpeggiator::hasEditor() const { return false; }
+
+AudioProcessorEditor* Arpeggiator::createEditor()
+{
+	return 0;
+}
+
+int Arpeggiator::getNumParameters()
+{
+	return numParameters;
+}
+
+const String Arpeggiator::getParameterName(int index)
+{
+	switch (index)
+	{
+	case rateParam:
+		return T("Rate");
+	case patternParam:
+		return T("Pattern");
+	case octavesParam:
+		return T("Octaves");
+	case gateParam:
+		return T("Gate");
+	case swingParam:
+		return T("Swing");
+	}
+
+	return String::empty;
+}
+
+float Arpeggiator::getParameter(int index)
+{
+	return isPositiveAndBelow(index, (int) numParameters) ? parameters[index] : 0.0f;
+}
+
+const String Arpeggiator::getParameterText(int index)
+{
+	switch (index)
+	{
+	case rateParam:
+		return rateNames[getChoice(parameters[rateParam], numRates)];
+	case patternParam:
+		return patternNames[getChoice(parameters[patternParam], numPatterns)];
+	case octavesParam:
+		return String(getChoice(parameters[octavesParam], maxOctaves) + 1);
+	case gateParam:
+		return String(roundToInt(jlimit(0.05f, 1.0f, parameters[gateParam]) * 100.0f)) + "%";
+	case swingParam:
+		return String(roundToInt(parameters[swingParam] * 100.0f)) + "%";
+	}
+
+	return String::empty;
+}
+
+void Arpeggiator::setParameter(int index, float value)
+{
+	if (isPositiveAndBelow(index, (int) numParameters))
+		parameters[index] = jlimit(0.0f, 1.0f, value);
+}
+
+int Arpeggiator::getNumPrograms()
+{
+	return 0;
+}
+
+int Arpeggiator::getCurrentProgram()
+{
+	return 0;
+}
+
+void Arpeggiator::setCurrentProgram(int)
+{
+}
+const String Arpeggiator::getProgramName(int)
+{
+	return String::empty;
+}
+
+void Arpeggiator::changeProgramName(int, const String&)
+{
+}
+
+void Arpeggiator::getStateInformation(MemoryBlock& memBlock)
+{
+	memBlock.setSize(0);
+	memBlock.append(parameters, sizeof(parameters));
+}
+
+void Arpeggiator::setStateInformation(const void *block, int size)
+{
+	if (size != (int) sizeof(parameters))
+		return;
+
+	memcpy(parameters, block, sizeof(parameters));
+	updateHostDisplay();
+}
+
+
+// ==========================
+
+#if JUCE_UNIT_TESTS
+
+class ArpeggiatorTests : public UnitTest
+{
+public:
+	ArpeggiatorTests() : UnitTest("Arpeggiator") {}
+
+	// plays a number of blocks, returning what comes out as "<time>:on<note>" and so on,
+	// with the times counted from the start of the first block
+	static const String play(Arpeggiator& arp, MidiBuffer& firstBlock, int numBlocks, int blockSize)
+	{
+		AudioSampleBuffer audio(1, blockSize);
+		String s;
+		int lastTime = 0;
+
+		for (int block = 0; block < numBlocks; ++block)
+		{
+			MidiBuffer midi;
+			if (block == 0)
+				midi = firstBlock;
+
+			arp.processBlock(audio, midi);
+
+			MidiBuffer::Iterator i(midi);
+			MidiMessage m(0xf8);
+			int position;
+
+			while (i.getNextEvent(m, position))
+			{
+				const int time = block * blockSize + position;
+
+				// the pipeline only appends, so anything out of order would be a bug
+				if (time < lastTime)
+					s << "(out of order) ";
+
+				lastTime = time;
+				s << time << ':';
+
+				if (m.isNoteOn())			s << "on" << m.getNoteNumber();
+				else if (m.isNoteOff())		s << "off" << m.getNoteNumber();
+				else if (m.isController())	s << "cc" << m.getControllerNumber();
+				else						s << '?';
+
+				s << ' ';
+			}
+		}
+
+		return s.trimEnd();
+	}
+
+	void runTest()
+	{
+		// with no play head it runs at 120bpm, so a sixteenth is 5512.5 samples
+		const int blockSize = 512;
+
+		beginTest("Steps between events");
+		{
+			Arpeggiator arp;
+			arp.prepareToPlay(44100.0, blockSize);
+			arp.setParameter(Arpeggiator::rateParam, 0.5f);
+
+			MidiBuffer midi;
+			midi.addEvent(MidiMessage::noteOn(1, 60, 1.0f), 0);
+			midi.addEvent(MidiMessage::noteOn(1, 64, 1.0f), 0);
+			midi.addEvent(MidiMessage::controllerEvent(1, 1, 64), 100);
+
+			// the controller goes straight through, and the notes are stepped through upwards
+			expectEquals(play(arp, midi, 24, blockSize),
+				String("0:on60 100:cc1 2756:off60 5512:on64 8269:off64 11025:on60"));
+		}
+
+		beginTest("Releasing the notes");
+		{
+			Arpeggiator arp;
+			arp.prepareToPlay(44100.0, blockSize);
+			arp.setParameter(Arpeggiator::rateParam, 0.5f);
+
+			MidiBuffer midi;
+			midi.addEvent(MidiMessage::noteOn(1, 60, 1.0f), 0);
+			midi.addEvent(MidiMessage::noteOff(1, 60), 300);
+
+			// the note that's sounding still gets its note-off, and nothing plays after it
+			expectEquals(play(arp, midi, 24, blockSize), String("0:on60 2756:off60"));
+		}
+
+		beginTest("State");
+		{
+			Arpeggiator arp;
+			arp.setParameter(Arpeggiator::rateParam, 0.1f);
+			arp.setParameter(Arpeggiator::patternParam, 0.3f);
+			arp.setParameter(Arpeggiator::octavesParam, 0.6f);
+			arp.setParameter(Arpeggiator::gateParam, 0.8f);
+			arp.setParameter(Arpeggiator::swingParam, 0.25f);
+
+			MemoryBlock state;
+			arp.getStateInformation(state);
+
+			Arpeggiator restored;
+			restored.setStateInformation(state.getData(), (int) state.getSize());
+
+			for (int i = 0; i < Arpeggiator::numParameters; ++i)
+				expectEquals(restored.getParameter(i), arp.getParameter(i));
+
+			// anything that isn't the right size is ignored
+			restored.setStateInformation(state.getData(), 3);
+			expectEquals(restored.getParameter(Arpeggiator::swingParam), 0.25f);
+		}
+	}
+};
+
+static ArpeggiatorTests arpeggiatorTests;
+
+#endif
@@ -1,49 +1,137 @@
-#ifndef ADLER_ARPEGGIATOR
-#define ADLER_ARPEGGIATOR
-
-#include "../includes.h"
-
-class Arpeggiator : public AudioPluginInstance
-{
-	float lastPpqPosition;
-
-	double sampleRate;
-
-	float rate;
-	
-	Array<int> activeInputNotes;
-	int activeOutputNoteCount;
-	int outputIndex;
-
-public:
-	Arpeggiator();
-	
-	void fillInPluginDescription(PluginDescription &desc) const;
-
-	const String getName() const;
-	void prepareToPlay(double sampleRate, int estimatedSamplesPerBlock);
-	void releaseResources();
-	void processBlock(AudioSampleBuffer &, MidiBuffer &);
-	const String getInputChannelName(const int) const;
-	const String getOutputChannelName(const int) const;	
-	bool isInputChannelStereoPair(int) const;
-	bool isOutputChannelStereoPair(int) const;
-	bool acceptsMidi() const;
-	bool producesMidi() const;
-	bool hasEditor() const;
-	AudioProcessorEditor* createEditor();
-	int getNumParameters();
-	const String getParameterName(int);
-	float getParameter(int);
-	const String getParameterText(int);
-	void setParameter(int, float);
-	int getNumPrograms();
-	int getCurrentProgram();
-	void setCurrentProgram(int);
-	const String getProgramName(int);
-	void changeProgramName(int, const String&);
-	void getStateInformation(MemoryBlock&);
-	void setStateInformation(const void *, int);
-};
-
-#endif
+#ifndef ADLER_ARPEGGIATOR
+#define ADLER_ARPEGGIATOR
+
+#include "../includes.h"
+
+// Steps through the held notes in time with the host's play head.  Steps are
+// placed on exact ppq positions rather than by counting samples, so they stay
+// locked to the host's tempo however the blocks fall, and when the transport
+// isn't running the arpeggiator keeps its own clock going at the last tempo.
+// All the note bookkeeping lives in fixed-size arrays, so processBlock never
+// allocates.  It works as a MidiEventProcessor, generating its steps in between
+// the incoming events, so the graph can run it in one pass with other MIDI nodes.
+class Arpeggiator : public AudioPluginInstance, public MidiEventProcessor
+{
+public:
+	enum Parameters
+	{
+		rateParam = 0,
+		patternParam,
+		octavesParam,
+		gateParam,
+		swingParam,
+		numParameters
+	};
+
+	enum Pattern
+	{
+		patternUp = 0,
+		patternDown,
+		patternUpDown,
+		patternAsPlayed,
+		patternRandom,
+		numPatterns
+	};
+
+private:
+	enum
+	{
+		maxHeldNotes = 32,
+		maxSoundingNotes = 32,
+		maxOctaves = 4
+	};
+
+	struct HeldNote
+	{
+		uint8 channel, note, velocity;
+	};
+
+	struct SoundingNote
+	{
+		uint8 channel, note;
+		double endPpq;
+	};
+
+	// held notes sorted by pitch, and the same notes in the order they arrived
+	HeldNote notesByPitch[maxHeldNotes];
+	HeldNote notesByArrival[maxHeldNotes];
+	int numHeldNotes;
+
+	SoundingNote soundingNotes[maxSoundingNotes];
+	int numSoundingNotes;
+
+	float parameters[numParameters];
+
+	double sampleRate;
+	double lastBpm;
+
+	// where the next block is expected to start, so that jumps can be spotted
+	double expectedPpq;
+	bool positionValid;
+
+	// the timing of the block that's being processed
+	double blockStartPpq;
+	double samplesPerPpq;
+	int blockLength;
+
+	int64 nextStep;
+	double currentStepLength;
+	int patternIndex;
+	Random random;
+
+	MidiEventPipeline midiPipeline;
+
+	double getStepLength() const;
+	double getStepPpq(int64 step, double stepLength) const;
+	int64 findFirstStepAtOrAfter(double ppq, double stepLength) const;
+	int getPatternLength(int pattern, int octaves) const;
+	bool getPatternNote(int pattern, int octaves, HeldNote& result);
+
+	void addHeldNote(const HeldNote& held);
+	void removeHeldNote(int channel, int note);
+	void addSoundingNote(int channel, int note, double endPpq);
+	int findSoundingNote(int channel, int note) const;
+
+	void endSoundingNotesBefore(double ppq, MidiEventPipeline::Output& output);
+	void endAllSoundingNotes(MidiEventPipeline::Output& output);
+	void renderSteps(double toPpq, MidiEventPipeline::Output& output);
+	void reset();
+
+	int ppqToSample(double ppq) const;
+
+public:
+	Arpeggiator();
+
+	void beginMidiBlock(MidiEventPipeline::Output& output, int numSamples);
+	void renderMidiUpTo(int samplePosition, MidiEventPipeline::Output& output);
+	bool processMidiEvent(uint8* data, int numBytes, int samplePosition, MidiEventPipeline::Output& output);
+
+	void fillInPluginDescription(PluginDescription &desc) const;
+
+	const String getName() const;
+	void prepareToPlay(double sampleRate, int estimatedSamplesPerBlock);
+	void releaseResources();
+	void processBlock(AudioSampleBuffer &, MidiBuffer &);
+	const String getInputChannelName(const int) const;
+	const String getOutputChannelName(const int) const;
+	bool isInputChannelStereoPair(int) const;
+	bool isOutputChannelStereoPair(int) const;
+	bool acceptsMidi() const;
+	bool producesMidi() const;
+	bool hasEditor() const;
+	AudioProcessorEditor* createEditor();
+	int getNumParameters();
+	const String getParameterName(int);
+	float getParameter(int);
+	const String getParameterText(int);
+	void setParameter(int, float);
+	int getNumPrograms();
+	int getCurrentProgram();
+	void setCurrentProgram(int);
+	const String getProgramName(int);
+	void changeProgramName(int, const String&);
+	void getStateInformation(MemoryBlock&);
+	void setStateInformation(const void *, int);
+};
+
+#endif
@@ -0,0 +1,401 @@
+#include "EqualiserFilters.h"
+
+// the parameters are 0 to 1; frequencies go from 20Hz to 20KHz logarithmically,
+// and gains from -18dB to +18dB with 0dB in the middle
+static double parameterToFrequency(float value, double sampleRate)
+{
+	return jmin(20.0 * pow(1000.0, (double) value), sampleRate * 0.45);
+}
+
+static float parameterToDecibels(float value)
+{
+	return (value - 0.5f) * 36.0f;
+}
+
+static float parameterToGain(float value)
+{
+	return Decibels::decibelsToGain(parameterToDecibels(value));
+}
+
+static const String frequencyToText(double frequency)
+{
+	if (frequency >= 1000.0)
+		return String(frequency / 1000.0, 2) + T(" kHz");
+
+	return String((int) frequency) + T(" Hz");
+}
+
+// how long a change of parameter takes to glide to its new value
+static const double smoothingTime = 0.01;
+
+static const double lowShelfFrequency = 100.0;
+static const double highShelfFrequency = 8000.0;
+static const double shelfQ = 0.7071;
+static const double peakQ = 1.0;
+
+// ==============================================
+
+Equaliser::Equaliser() : filters(2, 4), sampleRate(0)
+{
+	setPlayConfigDetails (2, 2, 0, 0);
+
+	for (int i=0; i<numParams; ++i)
+		parameters[i] = 0.5f;
+
+	// spread the peaks out to start with
+	parameters[mid1FrequencyParam] = 0.35f;
+	parameters[mid2FrequencyParam] = 0.7f;
+}
+
+void Equaliser::fillInPluginDescription(PluginDescription &desc) const
+{
+	desc.name = "Equaliser";
+	desc.pluginFormatName = "Internal";
+	desc.category = "Mixing";
+	desc.manufacturerName = "Monkey Fairness Productions";
+	desc.version = "0.1";
+	desc.fileOrIdentifier = "";
+	desc.lastFileModTime = Time();
+	desc.uid = 4;
+	desc.isInstrument = false;
+	desc.numInputChannels = 2;
+	desc.numOutputChannels = 2;
+}
+
+const String Equaliser::getName() const
+{
+	return T("Equaliser");
+}
+
+void Equaliser::prepareToPlay(double sampleRate, int)
+{
+	this->sampleRate = sampleRate;
+	filters.setSmoothingLength(roundToInt(sampleRate * smoothingTime));
+	updateStages();
+	filters.reset();
+}
+
+void Equaliser::releaseResources()
+{
+}
+
+void Equaliser::processBlock(AudioSampleBuffer &buffer, MidiBuffer &)
+{
+	filters.processSamples(buffer.getArrayOfChannels(), jmin(2, buffer.getNumChannels()), buffer.getNumSamples());
+}
+
+void Equaliser::updateStages()
+{
+	if (sampleRate <= 0)
+		return;
+
+	filters.setStage(0, IIRCoefficients::makeLowShelf(sampleRate, lowShelfFrequency, shelfQ,
+		parameterToGain(parameters[lowGainParam])));
+	filters.setStage(1, IIRCoefficients::makeBandPass(sampleRate,
+		parameterToFrequency(parameters[mid1FrequencyParam], sampleRate), peakQ,
+		parameterToGain(parameters[mid1GainParam])));
+	filters.setStage(2, IIRCoefficients::makeBandPass(sampleRate,
+		parameterToFrequency(parameters[mid2FrequencyParam], sampleRate), peakQ,
+		parameterToGain(parameters[mid2GainParam])));
+	filters.setStage(3, IIRCoefficients::makeHighShelf(sampleRate, highShelfFrequency, shelfQ,
+		parameterToGain(parameters[highGainParam])));
+}
+
+const String Equaliser::getInputChannelName(const int channel) const
+{
+	return channel == 0 ? T("Left") : T("Right");
+}
+
+const String Equaliser::getOutputChannelName(const int channel) const
+{
+	return channel == 0 ? T("Left") : T("Right");
+}
+
+bool Equaliser::isInputChannelStereoPair(int) const
+{
+	return true;
+}
+
+bool Equaliser::isOutputChannelStereoPair(int) const
+{
+	return true;
+}
+
+bool Equaliser::acceptsMidi() const
+{
+	return false;
+}
+
+bool Equaliser::producesMidi() const
+{
+	return false;
+}
+
+bool Equaliser::hasEditor() const { return false; }
+
+AudioProcessorEditor* Equaliser::createEditor()
+{
+	return 0;
+}
+
+int Equaliser::getNumParameters()
+{
+	return numParams;
+}
+
+const String Equaliser::getParameterName(int index)
+{
+	switch (index)
+	{
+	case lowGainParam:			return T("Low Gain");
+	case mid1FrequencyParam:	return T("Mid 1 Frequency");
+	case mid1GainParam:			return T("Mid 1 Gain");
+	case mid2FrequencyParam:	return T("Mid 2 Frequency");
+	case mid2GainParam:			return T("Mid 2 Gain");
+	case highGainParam:			return T("High Gain");
+	}
+
+	return String::empty;
+}
+
+float Equaliser::getParameter(int index)
+{
+	if (index < 0 || index >= numParams)
+		return 0.f;
+
+	return parameters[index];
+}
+
+const String Equaliser::getParameterText(int index)
+{
+	if (index == mid1FrequencyParam || index == mid2FrequencyParam)
+		return frequencyToText(parameterToFrequency(parameters[index], sampleRate > 0 ? sampleRate : 44100.0));
+
+	if (index >= 0 && index < numParams)
+		return String(parameterToDecibels(parameters[index]), 1) + T(" dB");
+
+	return String::empty;
+}
+
+void Equaliser::setParameter(int index, float value)
+{
+	if (index < 0 || index >= numParams)
+		return;
+
+	parameters[index] = jlimit(0.0f, 1.0f, value);
+	updateStages();
+}
+
+int Equaliser::getNumPrograms()
+{
+	return 0;
+}
+
+int Equaliser::getCurrentProgram()
+{
+	return 0;
+}
+
+void Equaliser::setCurrentProgram(int)
+{
+}
+const String Equaliser::getProgramName(int)
+{
+	return String::empty;
+}
+void Equaliser::changeProgramName(int, const String&)
+{
+}
+void Equaliser::getStateInformation(MemoryBlock& memBlock)
+{
+	memBlock.setSize(0);
+	memBlock.append(parameters, sizeof(parameters));
+}
+void Equaliser::setStateInformation(const void *block, int size)
+{
+	if (size != (int) sizeof(parameters))
+		return;
+
+	memcpy(parameters, block, sizeof(parameters));
+	updateStages();
+	updateHostDisplay();
+}
+
+// ==============================================
+
+Crossover::Crossover() : lowBand(2, 2), highBand(2, 2), sampleRate(0), frequency(0.5f)
+{
+	setPlayConfigDetails (2, 4, 0, 0);
+}
+
+void Crossover::fillInPluginDescription(PluginDescription &desc) const
+{
+	desc.name = "Crossover";
+	desc.pluginFormatName = "Internal";
+	desc.category = "Mixing";
+	desc.manufacturerName = "Monkey Fairness Productions";
+	desc.version = "0.1";
+	desc.fileOrIdentifier = "";
+	desc.lastFileModTime = Time();
+	desc.uid = 4;
+	desc.isInstrument = false;
+	desc.numInputChannels = 2;
+	desc.numOutputChannels = 4;
+}
+
+const String Crossover::getName() const
+{
+	return T("Crossover");
+}
+
+void Crossover::prepareToPlay(double sampleRate, int)
+{
+	this->sampleRate = sampleRate;
+	lowBand.setSmoothingLength(roundToInt(sampleRate * smoothingTime));
+	highBand.setSmoothingLength(roundToInt(sampleRate * smoothingTime));
+	updateStages();
+	lowBand.reset();
+	highBand.reset();
+}
+
+void Crossover::releaseResources()
+{
+}
+
+void Crossover::processBlock(AudioSampleBuffer &buffer, MidiBuffer &)
+{
+	if (buffer.getNumChannels() < 4)
+		return;
+
+	const int numSamples = buffer.getNumSamples();
+
+	// the high band starts as a copy of the input, and the low band is filtered in place
+	buffer.copyFrom(2, 0, buffer, 0, 0, numSamples);
+	buffer.copyFrom(3, 0, buffer, 1, 0, numSamples);
+
+	float** channels = buffer.getArrayOfChannels();
+	lowBand.processSamples(channels, 2, numSamples);
+	highBand.processSamples(channels + 2, 2, numSamples);
+}
+
+void Crossover::updateStages()
+{
+	if (sampleRate <= 0)
+		return;
+
+	const double hz = parameterToFrequency(frequency, sampleRate);
+	const IIRCoefficients lowPass(IIRCoefficients::makeLowPass(sampleRate, hz));
+	const IIRCoefficients highPass(IIRCoefficients::makeHighPass(sampleRate, hz));
+
+	for (int stage=0; stage<2; ++stage)
+	{
+		lowBand.setStage(stage, lowPass);
+		highBand.setStage(stage, highPass);
+	}
+}
+
+const String Crossover::getInputChannelName(const int channel) const
+{
+	return channel == 0 ? T("Left") : T("Right");
+}
+
+const String Crossover::getOutputChannelName(const int channel) const
+{
+	switch (channel)
+	{
+	case 0:		return T("Low Left");
+	case 1:		return T("Low Right");
+	case 2:		return T("High Left");
+	case 3:		return T("High Right");
+	}
+
+	return String::empty;
+}
+
+bool Crossover::isInputChannelStereoPair(int) const
+{
+	return true;
+}
+
+bool Crossover::isOutputChannelStereoPair(int) const
+{
+	return true;
+}
+
+bool Crossover::acceptsMidi() const
+{
+	return false;
+}
+
+bool Crossover::producesMidi() const
+{
+	return false;
+}
+
+bool Crossover::hasEditor() const { return false; }
+
+AudioProcessorEditor* Crossover::createEditor()
+{
+	return 0;
+}
+
+int Crossover::getNumParameters()
+{
+	return 1;
+}
+
+const String Crossover::getParameterName(int)
+{
+	return T("Frequency");
+}
+
+float Crossover::getParameter(int)
+{
+	return frequency;
+}
+
+const String Crossover::getParameterText(int)
+{
+	return frequencyToText(parameterToFrequency(frequency, sampleRate > 0 ? sampleRate : 44100.0));
+}
+
+void Crossover::setParameter(int, float value)
+{
+	frequency = jlimit(0.0f, 1.0f, value);
+	updateStages();
+}
+
+int Crossover::getNumPrograms()
+{
+	return 0;
+}
+
+int Crossover::getCurrentProgram()
+{
+	return 0;
+}
+
+void Crossover::setCurrentProgram(int)
+{
+}
+const String Crossover::getProgramName(int)
+{
+	return String::empty;
+}
+void Crossover::changeProgramName(int, const String&)
+{
+}
+void Crossover::getStateInformation(MemoryBlock& memBlock)
+{
+	memBlock.setSize(0);
+	memBlock.append(&frequency, sizeof(frequency));
+}
+void Crossover::setStateInformation(const void *block, int size)
+{
+	if (size != (int) sizeof(frequency))
+		return;
+
+	memcpy(&frequency, block, sizeof(frequency));
+	updateStages();
+	updateHostDisplay();
+}
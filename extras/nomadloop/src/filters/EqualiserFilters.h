@@ -0,0 +1,103 @@
+#ifndef ADLER_EQUALISERFILTERS
+#define ADLER_EQUALISERFILTERS
+
+#include "../includes.h"
+
+// A stereo four-band equaliser: a low shelf, two peaks and a high shelf, run as
+// the stages of one IIRFilterBank so that both channels are filtered together.
+// Parameter changes glide over a few milliseconds instead of clicking.
+class Equaliser : public AudioPluginInstance
+{
+public:
+	enum Parameters
+	{
+		lowGainParam = 0,
+		mid1FrequencyParam,
+		mid1GainParam,
+		mid2FrequencyParam,
+		mid2GainParam,
+		highGainParam,
+		numParams
+	};
+
+	Equaliser();
+
+	void fillInPluginDescription(PluginDescription &desc) const;
+
+	const String getName() const;
+	void prepareToPlay(double sampleRate, int estimatedSamplesPerBlock);
+	void releaseResources();
+	void processBlock(AudioSampleBuffer &, MidiBuffer &);
+	const String getInputChannelName(const int) const;
+	const String getOutputChannelName(const int) const;
+	bool isInputChannelStereoPair(int) const;
+	bool isOutputChannelStereoPair(int) const;
+	bool acceptsMidi() const;
+	bool producesMidi() const;
+	bool hasEditor() const;
+	AudioProcessorEditor* createEditor();
+	int getNumParameters();
+	const String getParameterName(int);
+	float getParameter(int);
+	const String getParameterText(int);
+	void setParameter(int, float);
+	int getNumPrograms();
+	int getCurrentProgram();
+	void setCurrentProgram(int);
+	const String getProgramName(int);
+	void changeProgramName(int, const String&);
+	void getStateInformation(MemoryBlock&);
+	void setStateInformation(const void *, int);
+
+private:
+	IIRFilterBank filters;
+	double sampleRate;
+	float parameters[numParams];
+
+	void updateStages();
+};
+
+// Splits a stereo signal into a low band on outputs 1 and 2 and a high band on
+// outputs 3 and 4, with Linkwitz-Riley crossovers: each band is two Butterworth
+// sections in series, so the bands add back up to a flat response.
+class Crossover : public AudioPluginInstance
+{
+public:
+	Crossover();
+
+	void fillInPluginDescription(PluginDescription &desc) const;
+
+	const String getName() const;
+	void prepareToPlay(double sampleRate, int estimatedSamplesPerBlock);
+	void releaseResources();
+	void processBlock(AudioSampleBuffer &, MidiBuffer &);
+	const String getInputChannelName(const int) const;
+	const String getOutputChannelName(const int) const;
+	bool isInputChannelStereoPair(int) const;
+	bool isOutputChannelStereoPair(int) const;
+	bool acceptsMidi() const;
+	bool producesMidi() const;
+	bool hasEditor() const;
+	AudioProcessorEditor* createEditor();
+	int getNumParameters();
+	const String getParameterName(int);
+	float getParameter(int);
+	const String getParameterText(int);
+	void setParameter(int, float);
+	int getNumPrograms();
+	int getCurrentProgram();
+	void setCurrentProgram(int);
+	const String getProgramName(int);
+	void changeProgramName(int, const String&);
+	void getStateInformation(MemoryBlock&);
+	void setStateInformation(const void *, int);
+
+private:
+	IIRFilterBank lowBand, highBand;
+	double sampleRate;
+	float frequency;
+
+	void updateStages();
+};
+
+#endif
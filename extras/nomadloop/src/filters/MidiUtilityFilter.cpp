@@ -5,6 +5,7 @@ MidiUtilityFilter::MidiUtilityFilter()
 : pitchBendRange(1), octaveShift(0), triggerSend(true)
 {
 	setPlayConfigDetails (1, 1, 0, 0);
+	midiPipeline.addProcessor(this);
 }
 
 void MidiUtilityFilter::fillInPluginDescription(PluginDescription &desc) const
@@ -31,6 +32,7 @@ void MidiUtilityFilter::prepareToPlay(double sampleRate, int estimatedSamplesPer
 {
 	//this->sampleRate = sampleRate;
 	setPlayConfigDetails(0, 0, sampleRate, estimatedSamplesPerBlock);
+	midiPipeline.prepare();
 }
 
 void MidiUtilityFilter::releaseResources()
@@ -39,47 +41,45 @@ void MidiUtilityFilter::releaseResources()
 
 void MidiUtilityFilter::processBlock(AudioSampleBuffer &sampleBuffer, MidiBuffer &midiBuffer)
 {
-	MidiBuffer::Iterator itor(midiBuffer);
-	MidiMessage message(0x80, 1, 1);
-	int samplePos;
-	
-	MidiBuffer outputBuffer;
-	outputBuffer.ensureSize(midiBuffer.getNumEvents());
+	midiPipeline.process(midiBuffer, sampleBuffer.getNumSamples());
+}
 
-	while (itor.getNextEvent(message, samplePos))
-	{
-		if (message.isNoteOnOrOff())
-		{
-			message.setNoteNumber(message.getNoteNumber() + 12*octaveShift);
-		}
-		outputBuffer.addEvent(message, samplePos);
-	}
-	
-	midiBuffer.swapWith(outputBuffer);
-	
+void MidiUtilityFilter::beginMidiBlock(MidiEventPipeline::Output& output, int)
+{
 	if (triggerSend)
 	{
 		for (int c=1; c<=16; ++c)
 		{
 			// program change
-			midiBuffer.addEvent(MidiMessage::programChange(c, currentProgram), 0);
+			output.insertEvent(MidiMessage::programChange(c, currentProgram));
 			
 			// Update pitch bend range
-			midiBuffer.addEvent(MidiMessage::controllerEvent(c, 101, 0), 0);
-			midiBuffer.addEvent(MidiMessage::controllerEvent(c, 100, 0), 0);
-			midiBuffer.addEvent(MidiMessage::controllerEvent(c, 6, (int)(pitchBendRange*12.5)), 0);
-			midiBuffer.addEvent(MidiMessage::controllerEvent(c, 38, 0), 0);
-			midiBuffer.addEvent(MidiMessage::controllerEvent(c, 101, 127), 0);
-			midiBuffer.addEvent(MidiMessage::controllerEvent(c, 100, 127), 0);
+			output.insertEvent(MidiMessage::controllerEvent(c, 101, 0));
+			output.insertEvent(MidiMessage::controllerEvent(c, 100, 0));
+			output.insertEvent(MidiMessage::controllerEvent(c, 6, (int)(pitchBendRange*12.5)));
+			output.insertEvent(MidiMessage::controllerEvent(c, 38, 0));
+			output.insertEvent(MidiMessage::controllerEvent(c, 101, 127));
+			output.insertEvent(MidiMessage::controllerEvent(c, 100, 127));
 			
 			// turn off any older notes
-			midiBuffer.addEvent(MidiMessage::allNotesOff(c), 0);
+			output.insertEvent(MidiMessage::allNotesOff(c));
 		}
 		
 		triggerSend = false;
 	}
 }
 
+bool MidiUtilityFilter::processMidiEvent(uint8* data, int, int, MidiEventPipeline::Output&)
+{
+	const int type = data[0] & 0xf0;
+
+	// notes shifted out of range are dropped
+	if (type == 0x80 || type == 0x90)
+		return transposeNote(data, 12*octaveShift);
+
+	return true;
+}
+
 const String MidiUtilityFilter::getInputChannelName(const int) const
 {
 	return T("Input");
@@ -11,15 +11,20 @@
 
 #include "../includes.h"
 
-class MidiUtilityFilter : public AudioPluginInstance
+class MidiUtilityFilter : public AudioPluginInstance, public MidiEventProcessor
 	{
 		float pitchBendRange;		
 		int octaveShift;
 		int currentProgram;
 		bool triggerSend;
+
+		MidiEventPipeline midiPipeline;
 		
 	public:
 		MidiUtilityFilter();
+
+		void beginMidiBlock(MidiEventPipeline::Output& output, int numSamples);
+		bool processMidiEvent(uint8* data, int numBytes, int samplePosition, MidiEventPipeline::Output& output);
 		
 		void fillInPluginDescription(PluginDescription &desc) const;
 		
@@ -0,0 +1,183 @@
+#include "ReverbFilter.h"
+
+ReverbFilter::ReverbFilter()
+{
+	setPlayConfigDetails (2, 2, 0, 0);
+
+	const Reverb::Parameters defaults;
+	parameters[roomSizeParam] = defaults.roomSize;
+	parameters[dampingParam] = defaults.damping;
+	parameters[wetLevelParam] = defaults.wetLevel;
+	parameters[dryLevelParam] = defaults.dryLevel;
+	parameters[widthParam] = defaults.width;
+	parameters[freezeParam] = defaults.freezeMode;
+}
+
+void ReverbFilter::fillInPluginDescription(PluginDescription &desc) const
+{
+	desc.name = "Reverb";
+	desc.pluginFormatName = "Internal";
+	desc.category = "Mixing";
+	desc.manufacturerName = "Monkey Fairness Productions";
+	desc.version = "0.1";
+	desc.fileOrIdentifier = "";
+	desc.lastFileModTime = Time();
+	desc.uid = 4;
+	desc.isInstrument = false;
+	desc.numInputChannels = 2;
+	desc.numOutputChannels = 2;
+}
+
+const String ReverbFilter::getName() const
+{
+	return T("Reverb");
+}
+
+void ReverbFilter::prepareToPlay(double sampleRate, int)
+{
+	reverb.setSampleRate(sampleRate);
+}
+
+void ReverbFilter::releaseResources()
+{
+}
+
+void ReverbFilter::processBlock(AudioSampleBuffer &buffer, MidiBuffer &)
+{
+	if (buffer.getNumChannels() > 1)
+		reverb.processStereo(buffer.getSampleData(0), buffer.getSampleData(1), buffer.getNumSamples());
+	else if (buffer.getNumChannels() > 0)
+		reverb.processMono(buffer.getSampleData(0), buffer.getNumSamples());
+}
+
+void ReverbFilter::updateReverb()
+{
+	Reverb::Parameters p;
+	p.roomSize = parameters[roomSizeParam];
+	p.damping = parameters[dampingParam];
+	p.wetLevel = parameters[wetLevelParam];
+	p.dryLevel = parameters[dryLevelParam];
+	p.width = parameters[widthParam];
+	p.freezeMode = parameters[freezeParam];
+	reverb.setParameters(p);
+}
+
+const String ReverbFilter::getInputChannelName(const int channel) const
+{
+	return channel == 0 ? T("Left") : T("Right");
+}
+
+const String ReverbFilter::getOutputChannelName(const int channel) const
+{
+	return channel == 0 ? T("Left") : T("Right");
+}
+
+bool ReverbFilter::isInputChannelStereoPair(int) const
+{
+	return true;
+}
+
+bool ReverbFilter::isOutputChannelStereoPair(int) const
+{
+	return true;
+}
+
+bool ReverbFilter::acceptsMidi() const
+{
+	return false;
+}
+
+bool ReverbFilter::producesMidi() const
+{
+	return false;
+}
+
+bool ReverbFilter::hasEditor() const { return false; }
+
+AudioProcessorEditor* ReverbFilter::createEditor()
+{
+	return 0;
+}
+
+int ReverbFilter::getNumParameters()
+{
+	return numParams;
+}
+
+const String ReverbFilter::getParameterName(int index)
+{
+	switch (index)
+	{
+	case roomSizeParam:		return T("Room Size");
+	case dampingParam:		return T("Damping");
+	case wetLevelParam:		return T("Wet Level");
+	case dryLevelParam:		return T("Dry Level");
+	case widthParam:		return T("Width");
+	case freezeParam:		return T("Freeze");
+	}
+
+	return String::empty;
+}
+
+float ReverbFilter::getParameter(int index)
+{
+	if (index < 0 || index >= numParams)
+		return 0.f;
+
+	return parameters[index];
+}
+
+const String ReverbFilter::getParameterText(int index)
+{
+	if (index == freezeParam)
+		return parameters[index] >= 0.5f ? T("On") : T("Off");
+
+	if (index >= 0 && index < numParams)
+		return String(parameters[index], 2);
+
+	return String::empty;
+}
+
+void ReverbFilter::setParameter(int index, float value)
+{
+	if (index < 0 || index >= numParams)
+		return;
+
+	parameters[index] = jlimit(0.0f, 1.0f, value);
+	updateReverb();
+}
+
+int ReverbFilter::getNumPrograms()
+{
+	return 0;
+}
+
+int ReverbFilter::getCurrentProgram()
+{
+	return 0;
+}
+
+void ReverbFilter::setCurrentProgram(int)
+{
+}
+const String ReverbFilter::getProgramName(int)
+{
+	return String::empty;
+}
+void ReverbFilter::changeProgramName(int, const String&)
+{
+}
+void ReverbFilter::getStateInformation(MemoryBlock& memBlock)
+{
+	memBlock.setSize(0);
+	memBlock.append(parameters, sizeof(parameters));
+}
+void ReverbFilter::setStateInformation(const void *block, int size)
+{
+	if (size != (int) sizeof(parameters))
+		return;
+
+	memcpy(parameters, block, sizeof(parameters));
+	updateReverb();
+	updateHostDisplay();
+}
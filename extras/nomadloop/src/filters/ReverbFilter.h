@@ -0,0 +1,59 @@
+#ifndef ADLER_REVERBFILTER
+#define ADLER_REVERBFILTER
+
+#include "../includes.h"
+
+// A stereo reverb for using as a send effect, built on SIMDReverb. Its parameters
+// are the reverb's own, which all go from 0 to 1, and changing them glides rather
+// than clicks.
+class ReverbFilter : public AudioPluginInstance
+{
+public:
+	enum Parameters
+	{
+		roomSizeParam = 0,
+		dampingParam,
+		wetLevelParam,
+		dryLevelParam,
+		widthParam,
+		freezeParam,
+		numParams
+	};
+
+	ReverbFilter();
+
+	void fillInPluginDescription(PluginDescription &desc) const;
+
+	const String getName() const;
+	void prepareToPlay(double sampleRate, int estimatedSamplesPerBlock);
+	void releaseResources();
+	void processBlock(AudioSampleBuffer &, MidiBuffer &);
+	const String getInputChannelName(const int) const;
+	const String getOutputChannelName(const int) const;
+	bool isInputChannelStereoPair(int) const;
+	bool isOutputChannelStereoPair(int) const;
+	bool acceptsMidi() const;
+	bool producesMidi() const;
+	bool hasEditor() const;
+	AudioProcessorEditor* createEditor();
+	int getNumParameters();
+	const String getParameterName(int);
+	float getParameter(int);
+	const String getParameterText(int);
+	void setParameter(int, float);
+	int getNumPrograms();
+	int getCurrentProgram();
+	void setCurrentProgram(int);
+	const String getProgramName(int);
+	void changeProgramName(int, const String&);
+	void getStateInformation(MemoryBlock&);
+	void setStateInformation(const void *, int);
+
+private:
+	SIMDReverb reverb;
+	float parameters[numParams];
+
+	void updateReverb();
+};
+
+#endif
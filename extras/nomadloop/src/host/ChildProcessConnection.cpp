@@ -0,0 +1,149 @@
+#include "ChildProcessConnection.h"
+
+const uint32 ChildProcessConnection::magicNumber = 0x6e6c7363;
+const char* const ChildProcessConnection::readyMessage = "ready";
+
+ChildProcessConnection::ChildProcessConnection()
+: InterprocessConnection(false, magicNumber), lost(false), lastRequestId(0)
+{
+}
+
+ChildProcessConnection::~ChildProcessConnection()
+{
+	disconnect();
+}
+
+bool ChildProcessConnection::launchChild(const String& commandLineFlag, const String& extraArguments, int timeoutMs)
+{
+	// the pipe name goes through the shell, so keep it to plain characters
+	const String pipeName("nomadloop_" + String::toHexString(Random::getSystemRandom().nextInt64()));
+	const File executable(File::getSpecialLocation(File::currentExecutableFile));
+
+	if (!createPipe(pipeName))
+		return false;
+
+	if (!executable.startAsProcess(commandLineFlag + " " + pipeName + " " + extraArguments))
+		return false;
+
+	String reply;
+	return waitForMessage(timeoutMs, reply) && reply == readyMessage;
+}
+
+bool ChildProcessConnection::sendString(const String& message)
+{
+	return !lost && sendMessage(messageFromString(message));
+}
+
+bool ChildProcessConnection::waitForMessage(int timeoutMs, String& message)
+{
+	const uint32 deadline = Time::getMillisecondCounter() + (uint32) jmax(0, timeoutMs);
+	const ScopedLock sl(lock);
+
+	// the event may have been left signalled by a message that was taken
+	// without waiting, so it's only a hint to look at the queue again
+	while (messages.size() == 0 && !lost)
+	{
+		const int msLeft = (int) (deadline - Time::getMillisecondCounter());
+
+		if (msLeft <= 0)
+			return false;
+
+		const ScopedUnlock su(lock);
+		messageArrived.wait(msLeft);
+	}
+
+	if (messages.size() == 0)
+		return false;
+
+	message = messages[0];
+	messages.remove(0);
+	return true;
+}
+
+bool ChildProcessConnection::sendCommand(const String& message)
+{
+	return sendString("0\n" + message);
+}
+
+bool ChildProcessConnection::request(const String& message, String& reply, int timeoutMs)
+{
+	const int requestId = ++lastRequestId;
+
+	if (!sendString(String(requestId) + "\n" + message))
+		return false;
+
+	const uint32 deadline = Time::getMillisecondCounter() + (uint32) jmax(0, timeoutMs);
+
+	for (;;)
+	{
+		String taggedReply;
+
+		if (!waitForMessage(jmax(0, (int) (deadline - Time::getMillisecondCounter())), taggedReply))
+			return false;
+
+		int replyId;
+		splitRequest(taggedReply, replyId, reply);
+
+		if (replyId == requestId)
+			return true;
+	}
+}
+
+void ChildProcessConnection::connectionMade()
+{
+}
+
+void ChildProcessConnection::connectionLost()
+{
+	lost = true;
+	messageArrived.signal();
+}
+
+void ChildProcessConnection::messageReceived(const MemoryBlock& message)
+{
+	const String text(message.toString());
+
+	if (handleUnsolicitedMessage(text))
+		return;
+
+	{
+		const ScopedLock sl(lock);
+		messages.add(text);
+	}
+	messageArrived.signal();
+}
+
+MemoryBlock ChildProcessConnection::messageFromString(const String& text)
+{
+	return MemoryBlock(text.toUTF8().getAddress(), text.getNumBytesAsUTF8() + 1);
+}
+
+void ChildProcessConnection::splitRequest(const String& request, int& requestId, String& message)
+{
+	requestId = request.upToFirstOccurrenceOf("\n", false, false).getIntValue();
+	message = request.fromFirstOccurrenceOf("\n", false, false);
+}
+
+MemoryBlock ChildProcessConnection::replyTo(int requestId, const String& reply)
+{
+	return messageFromString(String(requestId) + "\n" + reply);
+}
+
+bool ChildProcessConnection::parseCommandLine(const String& commandLine, const String& commandLineFlag, StringArray& arguments)
+{
+	StringArray tokens;
+	tokens.addTokens(commandLine, true);
+	tokens.removeEmptyStrings();
+
+	const int flagIndex = tokens.indexOf(commandLineFlag);
+
+	if (flagIndex < 0 || flagIndex + 1 >= tokens.size())
+		return false;
+
+	arguments.clear();
+
+	for (int i = flagIndex + 1; i < tokens.size(); ++i)
+		arguments.add(tokens[i]);
+
+	return true;
+}
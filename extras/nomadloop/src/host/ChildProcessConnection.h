@@ -0,0 +1,65 @@
+#ifndef ADLER_CHILDPROCESSCONNECTION
+#define ADLER_CHILDPROCESSCONNECTION
+
+#include "../includes.h"
+
+// The host's end of a pipe to a helper copy of itself, started with a
+// command-line flag that tells it what job to do.  Messages are plain
+// strings; replies are queued as they arrive so that a thread can wait
+// for them with a timeout, and a dropped connection wakes up any waiting
+// thread so that a crashed child doesn't have to time out.
+class ChildProcessConnection : public InterprocessConnection
+{
+	CriticalSection lock;
+	StringArray messages;
+	WaitableEvent messageArrived;
+	bool lost;
+	int lastRequestId;
+
+public:
+	ChildProcessConnection();
+	~ChildProcessConnection();
+
+	// Creates the pipe, launches the child and waits for it to say it's ready
+	bool launchChild(const String& commandLineFlag, const String& extraArguments, int timeoutMs);
+
+	bool sendString(const String& message);
+
+	// returns false if nothing arrived in time, or if the child went away
+	bool waitForMessage(int timeoutMs, String& message);
+
+	// Sends a command that the child doesn't answer
+	bool sendCommand(const String& message);
+
+	// Sends a request and waits for the child's answer to it.  Each request has
+	// an id that the child puts at the start of its reply, so that a late reply
+	// to an earlier request that timed out isn't taken for this one's.
+	bool request(const String& message, String& reply, int timeoutMs);
+
+	bool hasLostConnection() const { return lost; }
+
+	void connectionMade();
+	void connectionLost();
+	void messageReceived(const MemoryBlock& message);
+
+	// Messages the child sends of its own accord, rather than in reply to a
+	// request, can be picked off here before they reach the queue.  Called
+	// on the connection's thread.
+	virtual bool handleUnsolicitedMessage(const String&) { return false; }
+
+	// Helpers shared with the child side
+	static const uint32 magicNumber;
+	static const char* const readyMessage;
+	static MemoryBlock messageFromString(const String& text);
+
+	// Splits a request into its id and the message itself, for the child to
+	// answer with replyTo()
+	static void splitRequest(const String& request, int& requestId, String& message);
+	static MemoryBlock replyTo(int requestId, const String& reply);
+
+	// If the command line starts a child with this flag, returns the pipe name
+	// followed by any extra arguments the host passed to launchChild()
+	static bool parseCommandLine(const String& commandLine, const String& commandLineFlag, StringArray& arguments);
+};
+
+#endif
@@ -2,6 +2,7 @@
 #include "ControlSurface.h"
 
 ControlAction::ControlAction()
+	: owner(0)
 {
 }
 
@@ -27,11 +28,297 @@ const String ControlAction::getText() const
 
 // ==================================================
 
+MidiRemoteControlDispatcher::MidiRemoteControlDispatcher()
+	: numActionsLearned(0), lastLearned(-1), lastLearnedTime(0), passThrough(0)
+{
+	unknownSource.input = 0;
+	unknownSource.sourceId = 0;
+	unknownSource.reset();
+}
+
+MidiRemoteControlDispatcher::~MidiRemoteControlDispatcher()
+{
+	clearSingletonInstance();
+}
+
+int MidiRemoteControlDispatcher::makeKey(int sourceId, int type, int channel, int number) noexcept
+{
+	// the control number goes in the low bits, so that neighbouring controls
+	// land in different slots
+	return (sourceId << 22) | (type << 18) | ((channel - 1) << 14) | number;
+}
+
+int MidiRemoteControlDispatcher::getSourceId(const String& sourceName)
+{
+	// 0 matches any device
+	if (sourceName.isEmpty())
+		return 0;
+
+	int index = sourceNames.indexOf(sourceName);
+
+	if (index < 0)
+	{
+		index = sourceNames.size();
+		sourceNames.add(sourceName);
+	}
+
+	return index + 1;
+}
+
+void MidiRemoteControlDispatcher::SourceState::reset()
+{
+	for (int i = 0; i < 16; ++i)
+	{
+		channels[i].nrpnNumber = -1;
+		channels[i].nrpnDataCoarse = 0;
+		zeromem(channels[i].coarseControllerValues, sizeof(channels[i].coarseControllerValues));
+	}
+}
+
+void MidiRemoteControlDispatcher::addSource(const String& deviceName)
+{
+	const ScopedLock sl(lock);
+
+	for (int i = sourceStates.size(); --i >= 0;)
+		if (sourceStates.getUnchecked(i)->name == deviceName)
+			return;
+
+	SourceState* const state = new SourceState();
+	state->input = 0;
+	state->name = deviceName;
+	state->sourceId = getSourceId(deviceName);
+	state->reset();
+	sourceStates.add(state);
+}
+
+MidiRemoteControlDispatcher::SourceState& MidiRemoteControlDispatcher::getSourceState(const MidiInput* source)
+{
+	if (source == 0)
+		return unknownSource;
+
+	for (int i = sourceStates.size(); --i >= 0;)
+		if (sourceStates.getUnchecked(i)->input == source)
+			return *sourceStates.getUnchecked(i);
+
+	// the first message from a device finds its state by name, and after that by
+	// its MidiInput, without anything needing to be allocated
+	for (int i = sourceStates.size(); --i >= 0;)
+	{
+		SourceState* const state = sourceStates.getUnchecked(i);
+
+		if (state->input == 0 && state->name == source->getName())
+		{
+			state->input = source;
+			return *state;
+		}
+	}
+
+	return unknownSource;
+}
+
+void MidiRemoteControlDispatcher::bind(MidiControlAction* action)
+{
+	action->sourceId = getSourceId(action->sourceName);
+	action->nextWithSameBinding = 0;
+
+	if (action->number < 0)
+		return;
+
+	const int key = makeKey(action->sourceId, action->type, action->channel, action->number);
+	action->nextWithSameBinding = bindings[key];
+	bindings.set(key, action);
+}
+
+void MidiRemoteControlDispatcher::unbind(MidiControlAction* action)
+{
+	if (action->number < 0)
+		return;
+
+	const int key = makeKey(action->sourceId, action->type, action->channel, action->number);
+	MidiControlAction* const first = bindings[key];
+
+	if (first == action)
+	{
+		if (action->nextWithSameBinding != 0)
+			bindings.set(key, action->nextWithSameBinding);
+		else
+			bindings.remove(key);
+	}
+	else
+	{
+		for (MidiControlAction* a = first; a != 0; a = a->nextWithSameBinding)
+		{
+			if (a->nextWithSameBinding == action)
+			{
+				a->nextWithSameBinding = action->nextWithSameBinding;
+				break;
+			}
+		}
+	}
+
+	action->nextWithSameBinding = 0;
+}
+
+void MidiRemoteControlDispatcher::addMidiControlAction(MidiControlAction* midiControlAction)
+{
+	const ScopedLock sl(lock);
+	bind(midiControlAction);
+}
+
+void MidiRemoteControlDispatcher::removeMidiControlAction(MidiControlAction* midiControlAction)
+{
+	const ScopedLock sl(lock);
+	unbind(midiControlAction);
+
+	const int index = learningActions.indexOf(midiControlAction);
+
+	if (index >= 0)
+	{
+		learningActions.remove(index);
+
+		if (index < numActionsLearned)
+			--numActionsLearned;
+	}
+
+	for (int i = learnedBindings.size(); --i >= 0;)
+	{
+		if (learnedBindings.getReference(i).action == midiControlAction)
+		{
+			learnedBindings.remove(i);
+
+			if (lastLearned == i)
+				lastLearned = -1;
+			else if (lastLearned > i)
+				--lastLearned;
+		}
+	}
+}
+
+void MidiRemoteControlDispatcher::learn(const Array<MidiControlAction*>& actionsToLearn)
+{
+	const ScopedLock sl(lock);
+	bindLearnedActions();
+
+	learningActions.removeRange(0, numActionsLearned);
+	numActionsLearned = 0;
+	learningActions.addArray(actionsToLearn);
+
+	learnedBindings.clearQuick();
+	learnedBindings.ensureStorageAllocated(learningActions.size());
+	lastLearned = -1;
+}
+
+void MidiRemoteControlDispatcher::cancelLearning()
+{
+	const ScopedLock sl(lock);
+
+	// whatever's been learned so far stays learned
+	bindLearnedActions();
+
+	learningActions.clear();
+	numActionsLearned = 0;
+	learnedBindings.clear();
+	lastLearned = -1;
+}
+
+bool MidiRemoteControlDispatcher::isLearning() const
+{
+	const ScopedLock sl(lock);
+	return numActionsLearned < learningActions.size();
+}
+
+// ==================================================
+
 void MidiRemoteControlDispatcher::handleIncomingMidiMessage(MidiInput* source, const MidiMessage& message)
 {
 	bool handled = false;
-	for (int i=midiControlActions.size(); --i >= 0; )
-		handled = midiControlActions.getUnchecked(i)->processIncomingMessage(message) || handled;
+	const uint8* const data = message.getRawData();
+	const int status = data[0] & 0xf0;
+
+	if (message.getRawDataSize() >= 3 && (status == 0x80 || status == 0x90 || status == 0xb0))
+	{
+		const ScopedLock sl(lock);
+
+		SourceState& sourceState = getSourceState(source);
+		ChannelState& state = sourceState.channels[data[0] & 0x0f];
+		const int sourceId = sourceState.sourceId;
+		const int channel = (data[0] & 0x0f) + 1;
+		const int number = data[1] & 0x7f;
+		const int value = data[2] & 0x7f;
+		const bool learning = numActionsLearned < learningActions.size();
+
+		if (status == 0x90 && value > 0)
+		{
+			if (learning)
+				handled = learnControl(sourceState, MidiControlAction::noteToggle, channel, number);
+			else
+				handled = dispatch(sourceId, MidiControlAction::noteToggle, channel, number, value, 127);
+		}
+		else if (status != 0xb0)
+		{
+			// a note-off is swallowed if its note-on was
+			handled = learning || dispatch(sourceId, MidiControlAction::noteToggle, channel, number, 0, 127);
+		}
+		else
+		{
+			int nrpnValue = -1;
+
+			switch (number)
+			{
+				case 99:	state.nrpnNumber = value << 7; break;
+				case 98:	state.nrpnNumber = (state.nrpnNumber >= 0 ? (state.nrpnNumber & 0x3f80) : 0) | value; break;
+				case 100:
+				case 101:	state.nrpnNumber = -1; break;	// an RPN has been selected instead
+
+				case 6:
+					state.nrpnDataCoarse = value;
+					nrpnValue = value << 7;
+					break;
+
+				case 38:
+					nrpnValue = (state.nrpnDataCoarse << 7) | value;
+					break;
+
+				default:
+					break;
+			}
+
+			// 0x3fff is the "null" NRPN, which deselects it
+			if (state.nrpnNumber == 0x3fff)
+				state.nrpnNumber = -1;
+
+			if (number < 32)
+				state.coarseControllerValues[number] = (uint8) value;
+
+			if (learning)
+			{
+				if (nrpnValue >= 0 && state.nrpnNumber >= 0)
+					handled = learnControl(sourceState, MidiControlAction::nrpn, channel, state.nrpnNumber);
+				else if (number < 98 || number > 101)
+					handled = learnControl(sourceState, MidiControlAction::controller, channel, number);
+				else
+					handled = true;
+			}
+			else
+			{
+				// once it's bound as a 14-bit controller, this message goes to it as normal
+				learnFineController(sourceId, channel, number);
+
+				if (nrpnValue >= 0 && state.nrpnNumber >= 0)
+					handled = dispatch(sourceId, MidiControlAction::nrpn, channel, state.nrpnNumber, nrpnValue, 16383);
+
+				// a coarse value on its own resets the fine part
+				if (number < 32)
+					handled = dispatch(sourceId, MidiControlAction::controller14Bit, channel, number, value << 7, 16383) || handled;
+				else if (number < 64)
+					handled = dispatch(sourceId, MidiControlAction::controller14Bit, channel, number - 32,
+									   (state.coarseControllerValues[number - 32] << 7) | value, 16383) || handled;
+
+				handled = dispatch(sourceId, MidiControlAction::controller, channel, number, value, 127) || handled;
+			}
+		}
+	}
+
 	if (!handled && passThrough != 0)
 		passThrough->handleIncomingMidiMessage(source, message);
 }
@@ -41,20 +328,129 @@ void MidiRemoteControlDispatcher::handlePartialSysexMessage(MidiInput* source, c
 {
 }
 
-void MidiRemoteControlDispatcher::addMidiControlAction(MidiControlAction* midiControlAction)
+bool MidiRemoteControlDispatcher::dispatch(int sourceId, int type, int channel, int number, int value, int maxValue)
 {
-	midiControlActions.addIfNotAlreadyThere(midiControlAction);
+	bool found = false;
+
+	// bindings for this particular device, then ones for any device
+	for (int id = sourceId;; id = 0)
+	{
+		for (MidiControlAction* a = bindings[makeKey(id, type, channel, number)]; a != 0; a = a->nextWithSameBinding)
+		{
+			found = true;
+
+			if (type != MidiControlAction::noteToggle)
+				a->handleControllerValue(value, maxValue);
+			else if (value > 0)
+				a->handleNoteOn();
+		}
+
+		if (id == 0)
+			break;
+	}
+
+	return found;
 }
 
-void MidiRemoteControlDispatcher::removeMidiControlAction(MidiControlAction* midiControlAction)
+bool MidiRemoteControlDispatcher::wasJustLearned(int sourceId, int type, int channel, int number) const
+{
+	if (lastLearned < 0)
+		return false;
+
+	const LearnedBinding& b = learnedBindings.getReference(lastLearned);
+
+	if (b.sourceId != sourceId || b.channel != channel)
+		return false;
+
+	if (b.type == MidiControlAction::controller14Bit && type == MidiControlAction::controller)
+		return number == b.number || number == b.number + 32;
+
+	return b.type == type && b.number == number;
+}
+
+bool MidiRemoteControlDispatcher::learnFineController(int sourceId, int channel, int number)
+{
+	// the fine half of a 14-bit controller follows straight after its coarse half
+	if (number < 32 || number >= 64
+		 || ! wasJustLearned(sourceId, MidiControlAction::controller, channel, number - 32)
+		 || learnedBindings.getReference(lastLearned).type != MidiControlAction::controller
+		 || Time::getMillisecondCounter() - lastLearnedTime > (uint32) fineControllerWindowMs)
+		return false;
+
+	LearnedBinding& b = learnedBindings.getReference(lastLearned);
+	b.type = MidiControlAction::controller14Bit;
+	b.needsBinding = true;
+	triggerAsyncUpdate();
+	return true;
+}
+
+bool MidiRemoteControlDispatcher::learnControl(const SourceState& source, int type, int channel, int number)
+{
+	// a control that's just been learned will usually still be moving, so it
+	// mustn't get assigned to the next action as well
+	if (wasJustLearned(source.sourceId, type, channel, number))
+		return true;
+
+	if (type == MidiControlAction::controller && learnFineController(source.sourceId, channel, number))
+		return true;
+
+	LearnedBinding learned;
+	learned.action = learningActions.getUnchecked(numActionsLearned++);
+	learned.sourceName = source.name;
+	learned.sourceId = source.sourceId;
+	learned.type = type;
+	learned.channel = channel;
+	learned.number = number;
+	learned.needsBinding = true;
+
+	// learn() left room for this, so adding it doesn't allocate
+	lastLearned = learnedBindings.size();
+	learnedBindings.add(learned);
+	lastLearnedTime = Time::getMillisecondCounter();
+
+	triggerAsyncUpdate();
+	return true;
+}
+
+void MidiRemoteControlDispatcher::bindLearnedActions()
+{
+	for (int i = 0; i < learnedBindings.size(); ++i)
+	{
+		LearnedBinding& b = learnedBindings.getReference(i);
+
+		if (b.needsBinding)
+		{
+			MidiControlAction* const action = b.action;
+
+			unbind(action);
+			action->sourceName = b.sourceName;
+			action->type = (MidiControlAction::ControlType) b.type;
+			action->channel = b.channel;
+			action->number = b.number;
+			bind(action);
+
+			b.needsBinding = false;
+		}
+	}
+}
+
+void MidiRemoteControlDispatcher::handleAsyncUpdate()
 {
-	midiControlActions.removeValue(midiControlAction);
+	const ScopedLock sl(lock);
+	bindLearnedActions();
 }
 
 juce_ImplementSingleton (MidiRemoteControlDispatcher);
 
+// ==================================================
+
 MidiControlAction::MidiControlAction(/*AudioProcessorGraph::Node::Ptr node,*/ MidiInput* source, const MidiMessage& message)
-: /*node(node),*/ source(source), messageTemplate(message), followInput(false), sendOutput(false), isLearning(false)
+: /*node(node),*/ sourceName(source != 0 ? source->getName() : String::empty),
+  type(message.isNoteOnOrOff() ? noteToggle : controller),
+  channel(jlimit(1, 16, message.getChannel())),
+  number(message.isNoteOnOrOff() ? message.getNoteNumber() : (message.isController() ? message.getControllerNumber() : -1)),
+  encoderMode(absolute), relativeStep(1.0f / 127.0f), minimum(0.f), maximum(1.f), skew(1.f),
+  followInput(false), sendOutput(false), sourceId(0), nextWithSameBinding(0)
 {
 	MidiRemoteControlDispatcher::getInstance()->addMidiControlAction(this);
 }
@@ -66,44 +462,128 @@ MidiControlAction::~MidiControlAction()
 
 void MidiControlAction::learn()
 {
-	isLearning = true;
+	Array<MidiControlAction*> actions;
+	actions.add(this);
+	MidiRemoteControlDispatcher::getInstance()->learn(actions);
+}
+
+void MidiControlAction::setBinding(const String& sourceDeviceName, ControlType newType, int newChannel, int newNumber)
+{
+	MidiRemoteControlDispatcher* const dispatcher = MidiRemoteControlDispatcher::getInstance();
+	const ScopedLock sl(dispatcher->lock);
+
+	dispatcher->unbind(this);
+	sourceName = sourceDeviceName;
+	type = newType;
+	channel = jlimit(1, 16, newChannel);
+	number = newNumber < (type == nrpn ? 16384 : 128) ? newNumber : -1;
+	dispatcher->bind(this);
+}
+
+void MidiControlAction::setEncoderMode(EncoderMode newMode, float stepPerTick)
+{
+	const ScopedLock sl(MidiRemoteControlDispatcher::getInstance()->lock);
+	encoderMode = newMode;
+	relativeStep = stepPerTick;
+}
+
+void MidiControlAction::setCurve(float newMinimum, float newMaximum, float newSkew)
+{
+	jassert(newSkew > 0);
+
+	const ScopedLock sl(MidiRemoteControlDispatcher::getInstance()->lock);
+	minimum = newMinimum;
+	maximum = newMaximum;
+	skew = newSkew;
 }
 
-bool MidiControlAction::processIncomingMessage(const MidiMessage& message)
+float MidiControlAction::positionToValue(float position) const
 {
-	if (isLearning)
+	if (skew != 1.0f)
+		position = powf(position, skew);
+
+	return minimum + (maximum - minimum) * position;
+}
+
+float MidiControlAction::valueToPosition(float value) const
+{
+	if (maximum == minimum)
+		return 0.f;
+
+	const float position = jlimit(0.f, 1.f, (value - minimum) / (maximum - minimum));
+	return skew != 1.0f ? powf(position, 1.0f / skew) : position;
+}
+
+void MidiControlAction::handleNoteOn()
+{
+	ControlSurfaceMappableComponent* const c = getMappedComponent();
+
+	if (c != 0)
+		c->postValueFromAction(positionToValue(valueToPosition(c->getLatestValue()) >= 0.5f ? 0.f : 1.f), this);
+}
+
+void MidiControlAction::handleControllerValue(int value, int maxValue)
+{
+	ControlSurfaceMappableComponent* const c = getMappedComponent();
+
+	if (c == 0)
+		return;
+
+	float position;
+
+	if (encoderMode == absolute || maxValue != 127)
 	{
-		isLearning = false;
-		messageTemplate = message;
-		return true;
+		position = value / static_cast<float>(maxValue);
 	}
-	else if (message.isForChannel(messageTemplate.getChannel()))
+	else
 	{
-		if (messageTemplate.isNoteOnOrOff() && message.isNoteOnOrOff() && message.getNoteNumber() == messageTemplate.getNoteNumber())
-		{
-			// toggle!
-			if (message.isNoteOn() && message.getNoteNumber() == messageTemplate.getNoteNumber())
-			{
-				getMappedComponent()->setValue(getMappedComponent()->getValue() >= 0.5f?0.f:1.f);
-				getMappedComponent()->triggerAsyncUpdate();
-			}
-			return true;
-		}
-		else if (messageTemplate.isController() && message.isController() && messageTemplate.getControllerNumber() == message.getControllerNumber())
+		int delta;
+
+		switch (encoderMode)
 		{
-			//setValue(message.getControllerValue() / 127.0f);
-			getMappedComponent()->setValue(message.getControllerValue() / 127.0f);		
-			getMappedComponent()->triggerAsyncUpdate();
-			return true;
+			case relativeTwosComplement:	delta = value < 64 ? value : value - 128; break;
+			case relativeBinaryOffset:		delta = value - 64; break;
+			default:						delta = (value & 0x40) != 0 ? -(value & 0x3f) : value; break;
 		}
+
+		// encoders carry on from wherever the control has got to, even if
+		// it's been moved some other way since
+		position = jlimit(0.f, 1.f, valueToPosition(c->getLatestValue()) + delta * relativeStep);
 	}
-	return false;
+
+	c->postValueFromAction(positionToValue(position), this);
 }
 
 void MidiControlAction::setValue(float value)
 {
 }
 
+void MidiControlAction::writeToXml(XmlElement& xml) const
+{
+	xml.setAttribute(T("device"), sourceName);
+	xml.setAttribute(T("type"), (int) type);
+	xml.setAttribute(T("channel"), channel);
+	xml.setAttribute(T("number"), number);
+	xml.setAttribute(T("encoder"), (int) encoderMode);
+	xml.setAttribute(T("step"), relativeStep);
+	xml.setAttribute(T("min"), minimum);
+	xml.setAttribute(T("max"), maximum);
+	xml.setAttribute(T("skew"), skew);
+}
+
+void MidiControlAction::restoreFromXml(const XmlElement& xml)
+{
+	setEncoderMode((EncoderMode) xml.getIntAttribute(T("encoder"), absolute),
+				   (float) xml.getDoubleAttribute(T("step"), 1.0 / 127.0));
+	setCurve((float) xml.getDoubleAttribute(T("min"), 0.0),
+			 (float) xml.getDoubleAttribute(T("max"), 1.0),
+			 jmax(0.01f, (float) xml.getDoubleAttribute(T("skew"), 1.0)));
+	setBinding(xml.getStringAttribute(T("device")),
+			   (ControlType) jlimit((int) noteToggle, (int) nrpn, xml.getIntAttribute(T("type"), controller)),
+			   xml.getIntAttribute(T("channel"), 1),
+			   xml.getIntAttribute(T("number"), -1));
+}
+
 
 // ==================================================
 
@@ -135,13 +615,164 @@ const String PluginParameterControlAction::getText() const
 void PluginParameterControlAction::audioProcessorParameterChanged(AudioProcessor *processor, int parameterIndex, float value)
 {
 	//Logger::outputDebugString(String(T("got update: new value ")) << value);
-	if (parameterIndex == boundParameterIndex)
+	ControlSurfaceMappableComponent* const c = getMappedComponent();
+
+	// an action whose mapping has been undone isn't attached to anything
+	if (parameterIndex == boundParameterIndex && c != 0)
 	{
-		getMappedComponent()->setValue(value);		
-		getMappedComponent()->triggerAsyncUpdate();
+		c->postValueFromAction(value, this);
 	}
 }
 
 void PluginParameterControlAction::audioProcessorChanged(AudioProcessor *processor)
 {
 }
+
+// ==================================================
+
+#if JUCE_UNIT_TESTS
+
+class MidiRemoteControlDispatcherTests : public UnitTest
+{
+public:
+	MidiRemoteControlDispatcherTests() : UnitTest("MidiRemoteControlDispatcher") {}
+
+	// counts the messages that weren't meant for any of the actions
+	struct PassThroughCounter : public MidiInputCallback
+	{
+		PassThroughCounter() : numMessages(0) {}
+
+		void handleIncomingMidiMessage(MidiInput*, const MidiMessage&)	{ ++numMessages; }
+
+		int numMessages;
+	};
+
+	static void send(const MidiMessage& message)
+	{
+		// messages with no device only reach actions that are bound to any device
+		MidiInputCallback* const callback = MidiRemoteControlDispatcher::getInstance();
+		callback->handleIncomingMidiMessage(0, message);
+	}
+
+	// learned controls get bound on the message thread, which is this one
+	static void bindLearnedControls()
+	{
+		MidiRemoteControlDispatcher::getInstance()->handleUpdateNowIfNeeded();
+	}
+
+	void runTest()
+	{
+		MidiRemoteControlDispatcher* const dispatcher = MidiRemoteControlDispatcher::getInstance();
+		PassThroughCounter counter;
+		dispatcher->setPassThrough(&counter);
+
+		beginTest("Learning");
+		{
+			MidiControlAction first(0, MidiMessage(0xf0)), second(0, MidiMessage(0xf0));
+			Array<MidiControlAction*> actions;
+			actions.add(&first);
+			actions.add(&second);
+			dispatcher->learn(actions);
+
+			// a control that keeps moving only goes to the first action
+			send(MidiMessage::controllerEvent(1, 7, 10));
+			send(MidiMessage::controllerEvent(1, 7, 11));
+			send(MidiMessage::noteOn(2, 60, 1.0f));
+			expect(! dispatcher->isLearning());
+
+			// nothing's bound on the MIDI thread itself
+			expectEquals(first.getNumber(), -1);
+			bindLearnedControls();
+
+			expect(first.getControlType() == MidiControlAction::controller);
+			expectEquals(first.getNumber(), 7);
+			expect(second.getControlType() == MidiControlAction::noteToggle);
+			expectEquals(second.getChannel(), 2);
+			expectEquals(second.getNumber(), 60);
+
+			// and once they're bound, their messages don't go any further
+			send(MidiMessage::controllerEvent(1, 7, 12));
+			send(MidiMessage::controllerEvent(1, 8, 12));
+			expectEquals(counter.numMessages, 1);
+		}
+
+		beginTest("14-bit controllers");
+		{
+			MidiControlAction action(0, MidiMessage(0xf0));
+			action.learn();
+
+			// the fine half arrives after the queue has emptied, but still upgrades the binding
+			send(MidiMessage::controllerEvent(3, 1, 64));
+			expect(! dispatcher->isLearning());
+			bindLearnedControls();
+			send(MidiMessage::controllerEvent(3, 33, 5));
+			bindLearnedControls();
+
+			expect(action.getControlType() == MidiControlAction::controller14Bit);
+			expectEquals(action.getNumber(), 1);
+
+			counter.numMessages = 0;
+			send(MidiMessage::controllerEvent(3, 1, 65));
+			send(MidiMessage::controllerEvent(3, 33, 6));
+			expectEquals(counter.numMessages, 0);
+		}
+
+		beginTest("14-bit window");
+		{
+			MidiControlAction action(0, MidiMessage(0xf0));
+			action.learn();
+
+			// a fine controller that comes along much later is a control of its own
+			send(MidiMessage::controllerEvent(4, 2, 64));
+			bindLearnedControls();
+			Thread::sleep(700);
+
+			counter.numMessages = 0;
+			send(MidiMessage::controllerEvent(4, 34, 5));
+			bindLearnedControls();
+
+			expect(action.getControlType() == MidiControlAction::controller);
+			expectEquals(counter.numMessages, 1);
+		}
+
+		beginTest("NRPNs");
+		{
+			MidiControlAction action(0, MidiMessage(0xf0));
+			action.learn();
+
+			send(MidiMessage::controllerEvent(5, 99, 1));
+			send(MidiMessage::controllerEvent(5, 98, 2));
+			send(MidiMessage::controllerEvent(5, 6, 100));
+			bindLearnedControls();
+
+			expect(action.getControlType() == MidiControlAction::nrpn);
+			expectEquals(action.getNumber(), (1 << 7) | 2);
+		}
+
+		beginTest("Curve and encoder settings");
+		{
+			MidiControlAction action(0, MidiMessage(0xf0));
+			action.setEncoderMode(MidiControlAction::relativeBinaryOffset, 0.05f);
+			action.setCurve(0.25f, 0.75f, 2.0f);
+
+			XmlElement xml(T("ACTION"));
+			action.writeToXml(xml);
+
+			MidiControlAction restored(0, MidiMessage(0xf0));
+			restored.restoreFromXml(xml);
+
+			expect(restored.getEncoderMode() == MidiControlAction::relativeBinaryOffset);
+			expectEquals(restored.getEncoderStep(), 0.05f);
+			expectEquals(restored.getCurveMinimum(), 0.25f);
+			expectEquals(restored.getCurveMaximum(), 0.75f);
+			expectEquals(restored.getCurveSkew(), 2.0f);
+		}
+
+		dispatcher->cancelLearning();
+		dispatcher->setPassThrough(0);
+	}
+};
+
+static MidiRemoteControlDispatcherTests midiRemoteControlDispatcherTests;
+
+#endif
@@ -24,47 +24,104 @@ public:
 	virtual const String getText() const;
 };
 
+class MidiRemoteControlDispatcher;
+
+// Maps a MIDI note or controller onto a control. The dispatcher looks actions up
+// by their binding, so they never have to look at messages meant for others.
 class MidiControlAction : public ControlAction
 {
-	//AudioProcessorGraph::Node::Ptr node;
-	const MidiInput* source;
-	MidiMessage messageTemplate;
-	/*int channel;
-	int status;
-	int value;*/
-
-	bool followInput;
-	bool sendOutput;
+public:
+	// The kind of MIDI control that an action is bound to.
+	enum ControlType
+	{
+		noteToggle = 0,		// each note-on flips the value between 0 and 1
+		controller,			// a 7-bit controller
+		controller14Bit,	// a controller 0-31, with its fine value on controller + 32
+		nrpn				// a 14-bit NRPN, selected with controllers 99/98, with data on 6/38
+	};
 
-	bool isLearning;
+	// How a controller's values are read. The relative modes are for endless
+	// encoders, which send how far they've turned rather than where they are.
+	enum EncoderMode
+	{
+		absolute = 0,
+		relativeTwosComplement,	// 1 upwards turns up, 127 downwards turns down
+		relativeBinaryOffset,	// 65 upwards turns up, 63 downwards turns down
+		relativeSignMagnitude	// 1 upwards turns up, 65 upwards turns down
+	};
 
-public:	
 	MidiControlAction(/*AudioProcessorGraph::Node::Ptr node,*/ MidiInput* source, const MidiMessage& message);	
 	~MidiControlAction();
 
 	// instructs the control action to latch onto the next received remote message
 	void learn();
 
-	// returns true if the message was handled, false if not a match
-	bool processIncomingMessage(const MidiMessage& message);
+	// Binds the action to a control. An empty source name matches any device,
+	// and a negative number leaves the action unbound.
+	void setBinding(const String& sourceDeviceName, ControlType type, int channel, int number);
+
+	const String& getSourceDeviceName() const	{ return sourceName; }
+	ControlType getControlType() const			{ return type; }
+	int getChannel() const						{ return channel; }
+	int getNumber() const						{ return number; }
+
+	void setEncoderMode(EncoderMode newMode, float stepPerTick = 1.0f / 127.0f);
+	EncoderMode getEncoderMode() const			{ return encoderMode; }
+	float getEncoderStep() const				{ return relativeStep; }
+
+	// Sets the curve that controller positions go through before reaching the
+	// control: value = minimum + (maximum - minimum) * position ^ skew, so a skew
+	// of 1 is linear, and maximum can be less than minimum to invert it.
+	void setCurve(float minimum, float maximum, float skew);
+	float getCurveMinimum() const				{ return minimum; }
+	float getCurveMaximum() const				{ return maximum; }
+	float getCurveSkew() const					{ return skew; }
 
 	void setValue(float value);
-};
 
-class MidiRemoteControlDispatcher : public MidiInputCallback
-{
-	Array<MidiControlAction*> midiControlActions;
+	void writeToXml(XmlElement& xml) const;
+	void restoreFromXml(const XmlElement& xml);
 
-	// chain to the graphPlayer
-	MidiInputCallback* passThrough;
+private:
+	friend class MidiRemoteControlDispatcher;
 
-	virtual void handleIncomingMidiMessage(MidiInput* source, const MidiMessage& message);
-	virtual void handlePartialSysexMessage(MidiInput* source, const JUCE_NAMESPACE::uint8 *messageData,
-		const int numBytesSoFar, const double timestamp);
+	String sourceName;
+	ControlType type;
+	int channel;
+	int number;
+
+	EncoderMode encoderMode;
+	float relativeStep;
+	float minimum, maximum, skew;
+
+	bool followInput;
+	bool sendOutput;
+
+	// the dispatcher's record of where the action is in its table
+	int sourceId;
+	MidiControlAction* nextWithSameBinding;
+
+	// these are called by the dispatcher on the MIDI thread
+	void handleNoteOn();
+	void handleControllerValue(int value, int maxValue);
+
+	float positionToValue(float position) const;
+	float valueToPosition(float value) const;
+
+	MidiControlAction(const MidiControlAction&);
+	MidiControlAction& operator= (const MidiControlAction&);
+};
+
+// Receives messages from the MIDI inputs and passes them to the actions bound to
+// them, using a hash table keyed on device, channel, kind of control and number,
+// so the cost of each message doesn't depend on how many bindings there are.
+// It also keeps track of the running state needed for 14-bit controllers and
+// NRPNs, and assigns controls to actions that are learning.
+class MidiRemoteControlDispatcher : public MidiInputCallback, public AsyncUpdater
+{
 public:
-	inline MidiRemoteControlDispatcher() : passThrough(0)
-	{
-	}
+	MidiRemoteControlDispatcher();
+	~MidiRemoteControlDispatcher();
 
 	inline void setPassThrough(MidiInputCallback* p)
 	{
@@ -74,7 +131,97 @@ public:
 	void addMidiControlAction(MidiControlAction*);
 	void removeMidiControlAction(MidiControlAction*);
 
+	// Makes the actions learn one after another: each new control that gets moved
+	// is assigned to the next action in the list.
+	void learn(const Array<MidiControlAction*>& actionsToLearn);
+	void cancelLearning();
+	bool isLearning() const;
+
+	// Sets up the running state for an input device, so that nothing has to be
+	// allocated on the MIDI thread when its messages start to arrive. This should
+	// be called for each device as it's opened; messages from devices it hasn't
+	// been called for only reach the actions that are bound to any device.
+	void addSource(const String& deviceName);
+
 	juce_DeclareSingleton (MidiRemoteControlDispatcher, true)
+
+private:
+	friend class MidiControlAction;
+
+	CriticalSection lock;
+	HashMap<int, MidiControlAction*> bindings;
+
+	// the actions waiting to learn are the ones from numActionsLearned onwards,
+	// so that learning doesn't have to shrink the array on the MIDI thread
+	Array<MidiControlAction*> learningActions;
+	int numActionsLearned;
+
+	// Binding an action can allocate, so the MIDI thread only notes down what
+	// each one has learned, and the message thread binds them afterwards. Room
+	// for one per action being learned is set aside when learning starts.
+	struct LearnedBinding
+	{
+		MidiControlAction* action;
+		String sourceName;
+		int sourceId, type, channel, number;
+		bool needsBinding;
+	};
+
+	Array<LearnedBinding> learnedBindings;
+
+	// the fine half of a 14-bit controller can turn up just after the last action
+	// in the queue has learned its coarse half, so that one stays open for a while
+	enum { fineControllerWindowMs = 500 };
+	int lastLearned;
+	uint32 lastLearnedTime;
+
+	// the running state of each channel of each device
+	struct ChannelState
+	{
+		int nrpnNumber;
+		int nrpnDataCoarse;
+		uint8 coarseControllerValues[32];
+	};
+
+	struct SourceState
+	{
+		const MidiInput* input;
+		String name;
+		int sourceId;
+		ChannelState channels[16];
+
+		void reset();
+	};
+
+	StringArray sourceNames;
+	OwnedArray<SourceState> sourceStates;
+	SourceState unknownSource;
+
+	// chain to the graphPlayer
+	MidiInputCallback* passThrough;
+
+	virtual void handleIncomingMidiMessage(MidiInput* source, const MidiMessage& message);
+	virtual void handlePartialSysexMessage(MidiInput* source, const JUCE_NAMESPACE::uint8 *messageData,
+		const int numBytesSoFar, const double timestamp);
+
+	static int makeKey(int sourceId, int type, int channel, int number) noexcept;
+
+	int getSourceId(const String& sourceName);
+	SourceState& getSourceState(const MidiInput* source);
+
+	void bind(MidiControlAction*);
+	void unbind(MidiControlAction*);
+
+	bool dispatch(int sourceId, int type, int channel, int number, int value, int maxValue);
+	bool learnControl(const SourceState& source, int type, int channel, int number);
+	bool learnFineController(int sourceId, int channel, int number);
+	bool wasJustLearned(int sourceId, int type, int channel, int number) const;
+	void bindLearnedActions();
+
+	virtual void handleAsyncUpdate();
+
+	MidiRemoteControlDispatcher(const MidiRemoteControlDispatcher&);
+	MidiRemoteControlDispatcher& operator= (const MidiRemoteControlDispatcher&);
 };
 
 class PluginParameterControlAction : public ControlAction, public AudioProcessorListener
@@ -94,6 +241,11 @@ public:
 		return boundNode->nodeId;
 	}
 
+	inline AudioProcessorGraph::Node* getBoundNode() const
+	{
+		return boundNode;
+	}
+
 	inline int getBoundParameterIndex() const
 	{
 		return boundParameterIndex;
@@ -189,13 +189,332 @@ public:
 
 // ================================================
 
+// Edits to the control surface go into the same history as the edits to the
+// graph, since the two are saved and loaded together.
+static UndoManager* getUndoManagerFor(Component* c)
+{
+	MainHostWindow* const window = dynamic_cast<MainHostWindow*>(c->getTopLevelComponent());
+	GraphDocumentComponent* const graphDoc = window != 0 ? window->getGraphEditor() : 0;
+
+	return graphDoc != 0 ? &graphDoc->graph.getUndoManager() : 0;
+}
+
+// Moves or resizes a widget. All the steps of one drag are merged into a
+// single move from where the widget started to where it ended up.
+class WidgetBoundsAction : public UndoableAction
+{
+public:
+	WidgetBoundsAction(Component* c, const Rectangle<int>& oldBounds_, const Rectangle<int>& newBounds_)
+		: component(c), oldBounds(oldBounds_), newBounds(newBounds_)
+	{
+	}
+
+	bool perform()		{ return moveTo(newBounds); }
+	bool undo()			{ return moveTo(oldBounds); }
+	int getSizeInUnits()	{ return 1; }
+
+	UndoableAction* createCoalescedAction(UndoableAction* nextAction)
+	{
+		const WidgetBoundsAction* const next = dynamic_cast<WidgetBoundsAction*>(nextAction);
+
+		if (next != 0 && next->component.getComponent() == component.getComponent())
+			return new WidgetBoundsAction(component, oldBounds, next->newBounds);
+
+		return 0;
+	}
+
+private:
+	Component::SafePointer<Component> component;
+	const Rectangle<int> oldBounds, newBounds;
+
+	bool moveTo(const Rectangle<int>& bounds)
+	{
+		if (component == 0)
+			return false;
+
+		component->setBounds(bounds);
+		return true;
+	}
+};
+
+// Maps new actions to one or more controls, so that mapping a whole view is
+// undone in one go. While it's undone, the actions are kept here rather than
+// by their controls, with their MIDI bindings released.
+class ControlMappingAction : public UndoableAction
+{
+public:
+	ControlMappingAction()
+		: isMapped(false), hasBeenUndone(false)
+	{
+	}
+
+	~ControlMappingAction()
+	{
+		if (! isMapped)
+			for (int i = 0; i < mappings.size(); ++i)
+				delete mappings.getReference(i).action;
+	}
+
+	void add(ControlSurfaceMappableComponent* c, ControlAction* action)
+	{
+		Mapping m = { c, action };
+		mappings.add(m);
+	}
+
+	bool perform()
+	{
+		bool anyMapped = false;
+
+		for (int i = 0; i < mappings.size(); ++i)
+		{
+			Mapping& m = mappings.getReference(i);
+
+			if (m.action == 0)
+				continue;
+
+			if (m.component == 0)
+			{
+				deleteAndZero(m.action);
+				continue;
+			}
+
+			// a new MIDI action is bound when it's created, but one that's been
+			// undone has to be bound again
+			MidiControlAction* const midiAction = dynamic_cast<MidiControlAction*>(m.action);
+
+			if (midiAction != 0 && hasBeenUndone)
+				MidiRemoteControlDispatcher::getInstance()->addMidiControlAction(midiAction);
+
+			m.component->attachControlAction(m.action);
+			m.component->refresh();
+			anyMapped = true;
+		}
+
+		isMapped = true;
+		return anyMapped;
+	}
+
+	bool undo()
+	{
+		bool anyUnmapped = false;
+
+		for (int i = 0; i < mappings.size(); ++i)
+		{
+			Mapping& m = mappings.getReference(i);
+
+			// a control that's been deleted took its actions with it
+			if (m.component == 0)
+				m.action = 0;
+
+			if (m.action == 0)
+				continue;
+
+			MidiControlAction* const midiAction = dynamic_cast<MidiControlAction*>(m.action);
+
+			if (midiAction != 0)
+				MidiRemoteControlDispatcher::getInstance()->removeMidiControlAction(midiAction);
+
+			m.component->detachControlAction(m.action);
+			m.component->refresh();
+			anyUnmapped = true;
+		}
+
+		isMapped = false;
+		hasBeenUndone = true;
+		return anyUnmapped;
+	}
+
+	int getSizeInUnits()	{ return mappings.size(); }
+
+private:
+	struct Mapping
+	{
+		Component::SafePointer<ControlSurfaceMappableComponent> component;
+		ControlAction* action;
+	};
+
+	Array<Mapping> mappings;
+	bool isMapped, hasBeenUndone;
+};
+
+// Undo doesn't bring deleted widgets back, so the history that refers to them
+// has to go along with them, or undoing past the deletion would quietly do
+// nothing.
+static void clearHistoryForDeletedWidgets(Component* c)
+{
+	UndoManager* const undoManager = getUndoManagerFor(c);
+
+	if (undoManager != 0)
+		undoManager->clearUndoHistory();
+}
+
+static void deleteWidget(Component* c)
+{
+	clearHistoryForDeletedWidgets(c);
+	delete c;
+}
+
+static void performMapping(Component* c, ControlMappingAction* mapping, const String& name)
+{
+	UndoManager* const undoManager = getUndoManagerFor(c);
+
+	if (undoManager != 0)
+	{
+		undoManager->beginNewTransaction(name);
+		undoManager->perform(mapping);
+	}
+	else
+	{
+		mapping->perform();
+		delete mapping;
+	}
+}
+
+// ================================================
+
+CachedLayer::CachedLayer()
+{
+}
+
+bool CachedLayer::needsRedrawing(int width, int height)
+{
+	if (image.isValid() && image.getWidth() == width && image.getHeight() == height)
+		return false;
+
+	invalidate();
+
+	if (width <= 0 || height <= 0)
+		return false;
+
+	image = Image(Image::ARGB, width, height, true);
+	return true;
+}
+
+void CachedLayer::invalidate()
+{
+	image = Image::null;
+}
+
+void CachedLayer::drawAt(Graphics& g, int x, int y) const
+{
+	if (image.isValid())
+		g.drawImageAt(image, x, y);
+}
+
+// ================================================
+
+namespace
+{
+	union FloatBits
+	{
+		float f;
+		int i;
+	};
+}
+
+ControlFeedbackMirror::Slot::Slot()
+	: pending(0)
+{
+	store(0.f);
+}
+
+void ControlFeedbackMirror::Slot::post(float newValue)
+{
+	// the value has to be in place before the flag is raised
+	store(newValue);
+	pending.set(1);
+}
+
+void ControlFeedbackMirror::Slot::store(float newValue)
+{
+	FloatBits bits;
+	bits.f = newValue;
+	valueBits.set(bits.i);
+}
+
+float ControlFeedbackMirror::Slot::getLatest() const
+{
+	FloatBits bits;
+	bits.i = valueBits.get();
+	return bits.f;
+}
+
+bool ControlFeedbackMirror::Slot::collect(float& latestValue)
+{
+	// if another value arrives after the flag's cleared, it'll either be read
+	// here or raise the flag again for the next frame
+	if (pending.get() == 0 || ! pending.compareAndSetBool(0, 1))
+		return false;
+
+	latestValue = getLatest();
+	return true;
+}
+
+ControlFeedbackMirror::ControlFeedbackMirror()
+	: anythingPending(0)
+{
+}
+
+ControlFeedbackMirror::~ControlFeedbackMirror()
+{
+	stopTimer();
+	clearSingletonInstance();
+}
+
+void ControlFeedbackMirror::addComponent(ControlSurfaceMappableComponent* c)
+{
+	components.addIfNotAlreadyThere(c);
+
+	if (! isTimerRunning())
+		startTimer(1000 / framesPerSecond);
+}
+
+void ControlFeedbackMirror::removeComponent(ControlSurfaceMappableComponent* c)
+{
+	components.removeValue(c);
+
+	if (components.size() == 0)
+		stopTimer();
+}
+
+void ControlFeedbackMirror::post(Slot& slot, float newValue)
+{
+	slot.post(newValue);
+	anythingPending.set(1);
+}
+
+void ControlFeedbackMirror::timerCallback()
+{
+	if (anythingPending.get() == 0 || ! anythingPending.compareAndSetBool(0, 1))
+		return;
+
+	float newValue;
+
+	for (int i = components.size(); --i >= 0;)
+	{
+		ControlSurfaceMappableComponent* const c = components.getUnchecked(i);
+
+		if (c->feedbackSlot.collect(newValue))
+			c->applyPostedValue(newValue);
+	}
+}
+
+juce_ImplementSingleton (ControlFeedbackMirror);
+
+// ================================================
+
 ControlSurfaceMappableComponent::ControlSurfaceMappableComponent(const String& componentName)
 	: Component(componentName), value(0.f), text(T("Test"))
 {
+	ControlFeedbackMirror::getInstance()->addComponent(this);
 }
 
 ControlSurfaceMappableComponent::~ControlSurfaceMappableComponent()
 {		
+	ControlFeedbackMirror* const mirror = ControlFeedbackMirror::getInstanceWithoutCreating();
+
+	if (mirror != nullptr)
+		mirror->removeComponent(this);
 }
 
 void ControlSurfaceMappableComponent::showContextMenu()
@@ -207,7 +526,32 @@ void ControlSurfaceMappableComponent::showContextMenu()
 	m.addSeparator();
 	m.addItem (-4, "Assign new ControlAction...");
 	m.addItem (-5, "MIDI Learn");
+	m.addItem (-6, "MIDI Learn all controls in this view");
+
+	// the encoder mode and curve of the control's MIDI bindings
+	Array<MidiControlAction*> midiActions;
+
+	for (int i = 0; i < controlActions.size(); ++i)
+	{
+		MidiControlAction* const midiAction = dynamic_cast<MidiControlAction*>(controlActions.getUnchecked(i));
+
+		if (midiAction != 0)
+			midiActions.add(midiAction);
+	}
+
+	if (midiActions.size() > 0)
+	{
+		const MidiControlAction::EncoderMode mode = midiActions.getUnchecked(0)->getEncoderMode();
 
+		PopupMenu midiMenu;
+		midiMenu.addItem(-20, "Absolute", true, mode == MidiControlAction::absolute);
+		midiMenu.addItem(-21, "Relative (two's complement)", true, mode == MidiControlAction::relativeTwosComplement);
+		midiMenu.addItem(-22, "Relative (binary offset)", true, mode == MidiControlAction::relativeBinaryOffset);
+		midiMenu.addItem(-23, "Relative (sign and magnitude)", true, mode == MidiControlAction::relativeSignMagnitude);
+		midiMenu.addSeparator();
+		midiMenu.addItem(-24, "Curve...");
+		m.addSubMenu("MIDI Control", midiMenu);
+	}
 	
 	GraphDocumentComponent* graphDoc = dynamic_cast<MainHostWindow*>(getTopLevelComponent())->getGraphEditor();
 
@@ -250,15 +594,13 @@ void ControlSurfaceMappableComponent::showContextMenu()
 			debug << T("Selected filter ") << filterIndex << T(" and parameter ") << paramIndex;
 			Logger::outputDebugString(debug);
 		}
-		PluginParameterControlAction* action = new PluginParameterControlAction(graphDoc->graph.getNode(filterIndex), paramIndex);
-		action->setMappedComponent(this);
-		controlActions.add(action);
+		ControlMappingAction* mapping = new ControlMappingAction();
+		mapping->add(this, new PluginParameterControlAction(graphDoc->graph.getNode(filterIndex), paramIndex));
+		performMapping(this, mapping, T("Map Control"));
 		
 		/*boundNode = graphDoc->graph.getNode(filterIndex);
 		boundParameterIndex = paramIndex;
 		boundNode->getProcessor()->addListener(this);*/
-
-		refresh();
 	}
 	else if (choice == -1)
 	{
@@ -270,7 +612,7 @@ void ControlSurfaceMappableComponent::showContextMenu()
 	}
 	else if (choice == -3)
 	{
-		delete this;
+		deleteWidget(this);
 	}
 	else if (choice == -4)
 	{
@@ -287,24 +629,76 @@ void ControlSurfaceMappableComponent::showContextMenu()
 		PluginParameterControlAction* action = new PluginParameterControlAction(graphDoc->graph.getNode(filterIndex), paramIndex);*/
 		if (action != 0)
 		{
-			action->setMappedComponent(this);
-			controlActions.add(action);
+			ControlMappingAction* mapping = new ControlMappingAction();
+			mapping->add(this, action);
+			performMapping(this, mapping, T("Map Control"));
 		}
 		
 		/*boundNode = graphDoc->graph.getNode(filterIndex);
 		boundParameterIndex = paramIndex;
 		boundNode->getProcessor()->addListener(this);*/
-
-		refresh();
 	}
 	else if (choice == -5)
 	{
 		// MIDI learn
 		MidiControlAction* midiAction = new MidiControlAction(0, MidiMessage(0xf0));
-		midiAction->setMappedComponent(this);
-		controlActions.add(midiAction);
+		ControlMappingAction* mapping = new ControlMappingAction();
+		mapping->add(this, midiAction);
+		performMapping(this, mapping, T("MIDI Learn"));
 		midiAction->learn();
 	}
+	else if (choice == -6)
+	{
+		// each control in turn is assigned the next MIDI control to be moved
+		Array<MidiControlAction*> learningActions;
+		ControlMappingAction* mapping = new ControlMappingAction();
+		Component* const parent = getParentComponent();
+
+		for (int i=0; i<parent->getNumChildComponents(); ++i)
+		{
+			ControlSurfaceMappableComponent* c = dynamic_cast<ControlSurfaceMappableComponent*>(parent->getChildComponent(i));
+
+			if (c != 0)
+			{
+				MidiControlAction* midiAction = new MidiControlAction(0, MidiMessage(0xf0));
+				mapping->add(c, midiAction);
+				learningActions.add(midiAction);
+			}
+		}
+
+		performMapping(this, mapping, T("MIDI Learn All"));
+		MidiRemoteControlDispatcher::getInstance()->learn(learningActions);
+	}
+	else if (choice <= -20 && choice >= -23)
+	{
+		for (int i = 0; i < midiActions.size(); ++i)
+			midiActions.getUnchecked(i)->setEncoderMode((MidiControlAction::EncoderMode) (-20 - choice),
+														midiActions.getUnchecked(i)->getEncoderStep());
+	}
+	else if (choice == -24)
+	{
+		const MidiControlAction* const first = midiActions.getUnchecked(0);
+
+		AlertWindow w(T("MIDI Control Curve"),
+					  T("Controller positions are mapped onto the range from minimum to maximum, "
+						"bent by the skew: 1 is linear, and the maximum can be below the minimum to invert it."),
+					  AlertWindow::NoIcon);
+		w.addTextEditor(T("minimum"), String(first->getCurveMinimum()), T("Minimum:"));
+		w.addTextEditor(T("maximum"), String(first->getCurveMaximum()), T("Maximum:"));
+		w.addTextEditor(T("skew"), String(first->getCurveSkew()), T("Skew:"));
+		w.addButton(T("OK"), 1, KeyPress(KeyPress::returnKey));
+		w.addButton(T("Cancel"), 0, KeyPress(KeyPress::escapeKey));
+
+		if (w.runModalLoop() != 0)
+		{
+			const float minimum = jlimit(0.0f, 1.0f, w.getTextEditorContents(T("minimum")).getFloatValue());
+			const float maximum = jlimit(0.0f, 1.0f, w.getTextEditorContents(T("maximum")).getFloatValue());
+			const float skew = w.getTextEditorContents(T("skew")).getFloatValue();
+
+			for (int i = 0; i < midiActions.size(); ++i)
+				midiActions.getUnchecked(i)->setCurve(minimum, maximum, skew > 0 ? skew : 1.0f);
+		}
+	}
 }
 
 
@@ -319,10 +713,6 @@ virtual void audioProcessorChanged(AudioProcessor *processor)
 {
 }*/
 
-void ControlSurfaceMappableComponent::handleAsyncUpdate()
-{
-	refresh();
-}
 
 /*int getBoundNodeId() const
 {
@@ -361,6 +751,8 @@ void ControlSurfaceMappableComponent::setValue(float value)
 	}*/
 
 	this->value = value;
+	feedbackSlot.store(value);
+
 	for (int i=controlActions.size(); --i >= 0; )
 	{
 		controlActions.getUnchecked(i)->setValue(value);
@@ -368,11 +760,50 @@ void ControlSurfaceMappableComponent::setValue(float value)
 
 }
 
+void ControlSurfaceMappableComponent::postValueFromAction(float newValue, ControlAction* source)
+{
+	for (int i=controlActions.size(); --i >= 0; )
+	{
+		ControlAction* const action = controlActions.getUnchecked(i);
+
+		if (action != source)
+			action->setValue(newValue);
+	}
+
+	ControlFeedbackMirror* const mirror = ControlFeedbackMirror::getInstanceWithoutCreating();
+
+	if (mirror != nullptr)
+		mirror->post(feedbackSlot, newValue);
+}
+
+float ControlSurfaceMappableComponent::getLatestValue() const
+{
+	return feedbackSlot.getLatest();
+}
+
+void ControlSurfaceMappableComponent::applyPostedValue(float newValue)
+{
+	value = newValue;
+	refresh();
+}
+
 void ControlSurfaceMappableComponent::setText(const String& newText)
 {
 	text = newText;
 }
 
+void ControlSurfaceMappableComponent::attachControlAction(ControlAction* action)
+{
+	action->setMappedComponent(this);
+	controlActions.add(action);
+}
+
+void ControlSurfaceMappableComponent::detachControlAction(ControlAction* action)
+{
+	controlActions.removeObject(action, false);
+	action->setMappedComponent(0);
+}
+
 const String ControlSurfaceMappableComponent::getText() const
 {
 	if (controlActions.size() > 0)
@@ -392,7 +823,7 @@ void ControlSurfaceMappableComponent::createControlActionsXml (XmlElement* contr
 		if (type == typeid(MidiControlAction))
 		{
 			controlActionElement = new XmlElement(T("MidiControlAction"));
-			controlActionElement->setAttribute(T("channel"), 1);
+			static_cast<MidiControlAction*>(controlActions.getUnchecked(i))->writeToXml(*controlActionElement);
 		}
 		else if (type == typeid(PluginParameterControlAction))
 		{
@@ -412,14 +843,25 @@ void ControlSurfaceMappableComponent::restoreControlActionsFromXml (GraphDocumen
 
 	forEachXmlChildElement (*controlElement, controlActionElement)
 	{
+		ControlAction* action = 0;
+
 		if (controlActionElement->hasTagName(T("MidiControlAction")))
 		{
+			MidiControlAction* midiAction = new MidiControlAction(0, MidiMessage(0xf0));
+			midiAction->restoreFromXml(*controlActionElement);
+			action = midiAction;
 		}
 		else if (controlActionElement->hasTagName(T("PluginParameterControlAction")))
 		{
-			controlActions.add(new PluginParameterControlAction(
+			action = new PluginParameterControlAction(
 				graphDoc->graph.getNodeForId(controlActionElement->getIntAttribute(T("nodeId"))),
-				controlActionElement->getIntAttribute(T("nodeParam"))));
+				controlActionElement->getIntAttribute(T("nodeParam")));
+		}
+
+		if (action != 0)
+		{
+			action->setMappedComponent(this);
+			controlActions.add(action);
 		}
 	}
 }
@@ -458,21 +900,34 @@ public:
 	void refresh()
 	{
 		getUpdatedValue();
-		repaint();
+		repaintKnob();
 	}
 
 	void paint(Graphics &g)
 	{
 		Colour colour(Colours::azure);
 
-		g.setColour(colour);
-		g.drawRoundedRectangle(2.f, 2.f, getWidth()-4.f, getHeight()-4.f, 16.0f, 4.0f);
+		if (trackLayer.needsRedrawing(getWidth(), getHeight()))
+		{
+			Graphics lg(trackLayer.getImage());
+			lg.setColour(colour);
+			lg.drawRoundedRectangle(2.f, 2.f, getWidth()-4.f, getHeight()-4.f, 16.0f, 4.0f);
+		}
 
-		this->getLookAndFeel().drawGlassLozenge(g, 0.f, (1.f-getValue())*(getHeight()-getWidth()), static_cast<float>(getWidth()), static_cast<float>(getWidth()), colour, 1.0f, 16.0f, false, false, false, false);
+		if (knobLayer.needsRedrawing(getWidth(), getWidth()))
+		{
+			Graphics lg(knobLayer.getImage());
+			this->getLookAndFeel().drawGlassLozenge(lg, 0.f, 0.f, static_cast<float>(getWidth()), static_cast<float>(getWidth()), colour, 1.0f, 16.0f, false, false, false, false);
+		}
+
+		const int knobTop = getKnobTop();
+
+		trackLayer.drawAt(g, 0, 0);
+		knobLayer.drawAt(g, 0, knobTop);
 		g.setColour(Colours::black);
 		
 		g.setFont(Font(T("BoomBox 2"), 16.0f, 0));
-		g.drawFittedText(getText(), 0, static_cast<int>((1.f-getValue())*(getHeight()-getWidth())), getWidth(), getWidth(), Justification(Justification::centred), 1);		
+		g.drawFittedText(getText(), 0, knobTop, getWidth(), getWidth(), Justification(Justification::centred), 1);		
 	}
 
 	void mouseDown(const MouseEvent &e)
@@ -502,7 +957,7 @@ public:
 		{
 			//Logger::outputDebugPrintf(T("drag Y to %i, new value %f"), e.y, 1.f - (e.y - knobClickOffsetY)/static_cast<float>(getHeight()-getWidth()));
 			setValue(jmin(1.f,jmax(0.f, 1.f - (e.y - knobClickOffsetY)/static_cast<float>(getHeight()-getWidth()))));
-			repaint();
+			repaintKnob();
 		}
 	}
 
@@ -515,6 +970,22 @@ private:
 	//float value;
 	bool draggingKnob;
 	int knobClickOffsetY;
+
+	CachedLayer trackLayer, knobLayer;
+	Rectangle<int> lastKnobArea;
+
+	int getKnobTop()
+	{
+		return static_cast<int>((1.f-getValue())*(getHeight()-getWidth()));
+	}
+
+	// only the strip between where the knob was and where it is now needs drawing
+	void repaintKnob()
+	{
+		const Rectangle<int> knobArea(0, getKnobTop(), getWidth(), getWidth());
+		repaint(knobArea.getUnion(lastKnobArea));
+		lastKnobArea = knobArea;
+	}
 };
 
 class TouchHorizontalSlider : public ControlSurfaceMappableComponent
@@ -533,21 +1004,34 @@ public:
 	void refresh()
 	{
 		getUpdatedValue();
-		repaint();
+		repaintKnob();
 	}
 
 	void paint(Graphics &g)
 	{
 		Colour colour(Colours::azure);
 
-		g.setColour(colour);
-		g.drawRoundedRectangle(2.f, 2.f, getWidth()-4.f, getHeight()-4.f, 16.0f, 4.0f);
+		if (trackLayer.needsRedrawing(getWidth(), getHeight()))
+		{
+			Graphics lg(trackLayer.getImage());
+			lg.setColour(colour);
+			lg.drawRoundedRectangle(2.f, 2.f, getWidth()-4.f, getHeight()-4.f, 16.0f, 4.0f);
+		}
 
-		this->getLookAndFeel().drawGlassLozenge(g, getValue()*(getWidth()-getHeight()), 0.f, static_cast<float>(getHeight()), static_cast<float>(getHeight()), colour, 1.0f, 16.0f, false, false, false, false);
+		if (knobLayer.needsRedrawing(getHeight(), getHeight()))
+		{
+			Graphics lg(knobLayer.getImage());
+			this->getLookAndFeel().drawGlassLozenge(lg, 0.f, 0.f, static_cast<float>(getHeight()), static_cast<float>(getHeight()), colour, 1.0f, 16.0f, false, false, false, false);
+		}
+
+		const int knobLeft = getKnobLeft();
+
+		trackLayer.drawAt(g, 0, 0);
+		knobLayer.drawAt(g, knobLeft, 0);
 		g.setColour(Colours::black);
 		
 		g.setFont(Font(T("BoomBox 2"), 16.0f, 0));
-		g.drawFittedText(getText(), static_cast<int>(getValue()*(getWidth()-getHeight())), 0, getHeight(), getHeight(), Justification(Justification::centred), 1);
+		g.drawFittedText(getText(), knobLeft, 0, getHeight(), getHeight(), Justification(Justification::centred), 1);
 	}
 
 	void mouseDown(const MouseEvent &e)
@@ -576,7 +1060,7 @@ public:
 		{
 			//Logger::outputDebugPrintf(T("drag Y to %i, new value %f"), e.y, 1.f - (e.y - knobClickOffsetY)/static_cast<float>(getHeight()-getWidth()));
 			setValue(jmin(1.f,jmax(0.f, (e.x - knobClickOffsetX)/static_cast<float>(getWidth()-getHeight()))));
-			repaint();
+			repaintKnob();
 		}
 	}
 
@@ -589,6 +1073,21 @@ private:
 	//float value;
 	bool draggingKnob;
 	int knobClickOffsetX;
+
+	CachedLayer trackLayer, knobLayer;
+	Rectangle<int> lastKnobArea;
+
+	int getKnobLeft()
+	{
+		return static_cast<int>(getValue()*(getWidth()-getHeight()));
+	}
+
+	void repaintKnob()
+	{
+		const Rectangle<int> knobArea(getKnobLeft(), 0, getHeight(), getHeight());
+		repaint(knobArea.getUnion(lastKnobArea));
+		lastKnobArea = knobArea;
+	}
 };
 
 class XYDragger : public ControlSurfaceMappableComponent
@@ -610,9 +1109,13 @@ public:
 	{
 		Colour colour(Colours::papayawhip);
 
-		this->getLookAndFeel().drawGlassLozenge(g, 0.f, (1.f-getValue())*(getHeight()-getWidth()), static_cast<float>(getWidth()), static_cast<float>(getWidth()), colour, 1.0f, getWidth()/2.0f, false, false, false, false);
-		g.setColour(Colours::black);
-		
+		if (knobLayer.needsRedrawing(getWidth(), getWidth()))
+		{
+			Graphics lg(knobLayer.getImage());
+			this->getLookAndFeel().drawGlassLozenge(lg, 0.f, 0.f, static_cast<float>(getWidth()), static_cast<float>(getWidth()), colour, 1.0f, getWidth()/2.0f, false, false, false, false);
+		}
+
+		knobLayer.drawAt(g, 0, static_cast<int>((1.f-getValue())*(getHeight()-getWidth())));
 	}
 
 	void mouseDown(const MouseEvent& e)
@@ -635,11 +1138,90 @@ public:
 		// TODO: update
 	}
 
+private:
+	CachedLayer knobLayer;
+};
+
+// Draws a rotary slider like the normal LookAndFeel does, but with the outline
+// ring blitted from a cached image, so only the value arc and pointer are
+// rendered as the knob turns.
+class CachedRotaryLookAndFeel : public LookAndFeel
+{
+public:
+	void drawRotarySlider(Graphics& g, int x, int y, int width, int height, float sliderPos,
+						  const float rotaryStartAngle, const float rotaryEndAngle, Slider& slider)
+	{
+		const float radius = jmin(width / 2, height / 2) - 2.0f;
+
+		if (radius <= 12.0f || ! slider.isEnabled())
+		{
+			LookAndFeel::drawRotarySlider(g, x, y, width, height, sliderPos, rotaryStartAngle, rotaryEndAngle, slider);
+			return;
+		}
+
+		const float centreX = x + width * 0.5f;
+		const float centreY = y + height * 0.5f;
+		const float rw = radius * 2.0f;
+		const float angle = rotaryStartAngle + sliderPos * (rotaryEndAngle - rotaryStartAngle);
+		const bool isMouseOver = slider.isMouseOverOrDragging();
+		const float thickness = 0.7f;
+
+		g.setColour(slider.findColour(Slider::rotarySliderFillColourId).withAlpha(isMouseOver ? 1.0f : 0.7f));
+
+		Path filledArc;
+		filledArc.addPieSegment(centreX - radius, centreY - radius, rw, rw, rotaryStartAngle, angle, thickness);
+		g.fillPath(filledArc);
+
+		const float innerRadius = radius * 0.2f;
+		Path pointer;
+		pointer.addTriangle(-innerRadius, 0.0f, 0.0f, -radius * thickness * 1.1f, innerRadius, 0.0f);
+		pointer.addEllipse(-innerRadius, -innerRadius, innerRadius * 2.0f, innerRadius * 2.0f);
+		g.fillPath(pointer, AffineTransform::rotation(angle).translated(centreX, centreY));
+
+		Outline& outline = isMouseOver ? highlightedOutline : normalOutline;
+		const Colour outlineColour(slider.findColour(Slider::rotarySliderOutlineColourId));
+
+		// the cached ring depends on the colour and angles as well as the size
+		if (outlineColour != outline.colour || rotaryStartAngle != outline.startAngle || rotaryEndAngle != outline.endAngle)
+		{
+			outline.layer.invalidate();
+			outline.colour = outlineColour;
+			outline.startAngle = rotaryStartAngle;
+			outline.endAngle = rotaryEndAngle;
+		}
+
+		if (outline.layer.needsRedrawing(width, height))
+		{
+			Graphics lg(outline.layer.getImage());
+			lg.setColour(outlineColour);
+
+			Path outlineArc;
+			outlineArc.addPieSegment(width * 0.5f - radius, height * 0.5f - radius, rw, rw, rotaryStartAngle, rotaryEndAngle, thickness);
+			outlineArc.closeSubPath();
+			lg.strokePath(outlineArc, PathStrokeType(isMouseOver ? 2.0f : 1.2f));
+		}
+
+		outline.layer.drawAt(g, x, y);
+	}
+
+private:
+	struct Outline
+	{
+		Outline() : startAngle(0), endAngle(0) {}
+
+		CachedLayer layer;
+		Colour colour;
+		float startAngle, endAngle;
+	};
+
+	Outline normalOutline, highlightedOutline;
 };
 
 class RotaryKnob : public ControlSurfaceMappableComponent, public SliderListener
 {
 	Slider* pot;
+	CachedRotaryLookAndFeel potLookAndFeel;
+
 public:
 	RotaryKnob(const String& componentName)
 		: ControlSurfaceMappableComponent(componentName)
@@ -650,6 +1232,7 @@ public:
 		pot->setColour(Slider::rotarySliderOutlineColourId, Colours::aquamarine.darker());
 		pot->setTextBoxStyle(Slider::NoTextBox, false, 0, 0);
 		pot->setRange(0.f, 1.f);
+		pot->setLookAndFeel(&potLookAndFeel);
 		pot->addListener(this);
 		pot->addMouseListener(this, true);
 		
@@ -670,8 +1253,8 @@ public:
 
 	void refresh()
 	{
-		pot->setValue(getUpdatedValue());
-		repaint();
+		// the slider repaints itself, and mustn't send the value back out again
+		pot->setValue(getUpdatedValue(), false);
 	}
 
 	void mouseDown(const MouseEvent &e)
@@ -724,13 +1307,26 @@ public:
 
 		if (isOn())
 		{
-			this->getLookAndFeel().drawGlassLozenge(g, 0.f, 0.f, static_cast<float>(getWidth()), static_cast<float>(getHeight()), colour, 1.0f, 16.0f, false, false, false, false);
+			if (onLayer.needsRedrawing(getWidth(), getHeight()))
+			{
+				Graphics lg(onLayer.getImage());
+				this->getLookAndFeel().drawGlassLozenge(lg, 0.f, 0.f, static_cast<float>(getWidth()), static_cast<float>(getHeight()), colour, 1.0f, 16.0f, false, false, false, false);
+			}
+
+			onLayer.drawAt(g, 0, 0);
 			g.setColour(Colours::black);
 		}		
 		else
 		{
+			if (offLayer.needsRedrawing(getWidth(), getHeight()))
+			{
+				Graphics lg(offLayer.getImage());
+				lg.setColour(colour);
+				lg.drawRoundedRectangle(2.f, 2.f, getWidth()-4.f, getHeight()-4.f, 16.0f, 4.0f);
+			}
+
+			offLayer.drawAt(g, 0, 0);
 			g.setColour(colour);
-			g.drawRoundedRectangle(2.f, 2.f, getWidth()-4.f, getHeight()-4.f, 16.0f, 4.0f);
 		}
 		g.setFont(Font(T("BoomBox 2"), 16.0f, 0));
 		g.drawFittedText(getText(), 0, 0, getWidth(), getHeight(), Justification(Justification::centred), 1);
@@ -753,6 +1349,9 @@ public:
 	{
 		return getValue() >= 0.5f;
 	}
+
+private:
+	CachedLayer onLayer, offLayer;
 };
 ///////////////////
 
@@ -823,7 +1422,7 @@ void SubviewComponent::mouseDown(const MouseEvent &e)
 		m.addItem(5, T("2D Dragger"));
 		m.addSeparator();
 		m.addItem(6, T("Add subview"));
-		m.addItem(5, T("Add PresetSaver"));
+		m.addItem(10, T("Add PresetSaver"));
 		m.addItem(7, T("Add Plugin editor"));
 		m.addSeparator();
 		m.addItem(8, T("Loop view"));
@@ -841,7 +1440,7 @@ void SubviewComponent::mouseDown(const MouseEvent &e)
 		}
 		else if (choice == -3)
 		{
-			delete this;
+			deleteWidget(this);
 		}
 		else if (choice == 1)
 		{
@@ -905,6 +1504,12 @@ void SubviewComponent::mouseDown(const MouseEvent &e)
 			lc->setBounds(e.x, e.y, 192, 96);
 			addAndMakeVisible(lc);
 		}
+		else if (choice == 10)
+		{
+			SettingsSnapshotter* ss = new SettingsSnapshotter();
+			ss->setBounds(e.x, e.y, 64, 64);
+			addAndMakeVisible(ss);
+		}
 	}
 }
 
@@ -912,25 +1517,49 @@ void SubviewComponent::mouseMove(const MouseEvent &e)
 {
 	if (movingComp != 0)
 	{
-		movingComp->setTopLeftPosition((e.x/16)*16, (e.y/16)*16);
+		moveWidget(movingComp, movingComp->getBounds().withPosition((e.x/16)*16, (e.y/16)*16));
 	}
 	else if (resizingComp != 0)
 	{
 		int x = resizingComp->getX(), y = resizingComp->getY();
-		resizingComp->setBounds(x, y, jmax(e.x - x, 32)/16*16, jmax(e.y - y, 32)/16*16);
+		moveWidget(resizingComp, Rectangle<int>(x, y, jmax(e.x - x, 32)/16*16, jmax(e.y - y, 32)/16*16));
 	}
 }
 
+void SubviewComponent::moveWidget(Component* c, const Rectangle<int>& newBounds)
+{
+	if (c->getBounds() == newBounds)
+		return;
+
+	UndoManager* const undoManager = getUndoManagerFor(this);
+
+	if (undoManager != 0)
+		undoManager->perform(new WidgetBoundsAction(c, c->getBounds(), newBounds));
+	else
+		c->setBounds(newBounds);
+}
+
 void SubviewComponent::setMovingComponent(Component *c)
 {
 	movingComp = c;
 	overlayComponent->toFront(true);
+
+	// however long the move goes on, it's undone in one go
+	UndoManager* const undoManager = getUndoManagerFor(this);
+
+	if (undoManager != 0)
+		undoManager->beginNewTransaction(T("Move Widget"));
 }
 
 void SubviewComponent::setResizingComponent(Component *c)
 {
 	resizingComp = c;
 	overlayComponent->toFront(true);
+
+	UndoManager* const undoManager = getUndoManagerFor(this);
+
+	if (undoManager != 0)
+		undoManager->beginNewTransaction(T("Resize Widget"));
 }
 
 
@@ -1057,11 +1686,13 @@ XmlElement* ControlSurfaceComponent::createXml() const
 {
 	XmlElement* xml = new XmlElement(T("CONTROLSURFACE"));
 	xml->addChildElement (createSubviewXml(view));
+	xml->addChildElement (dashboard->createSnapshotsXml());
 	return xml;
 }
 
 void ControlSurfaceComponent::restoreFromXml(const XmlElement& xml)
 {
+	clearHistoryForDeletedWidgets(this);
 	deleteAllChildren();
 
 	// recreate the component mover layer
@@ -1076,8 +1707,19 @@ void ControlSurfaceComponent::restoreFromXml(const XmlElement& xml)
 	SubviewComponent* currentView = view;
 	forEachXmlChildElement (xml, el)
 	{
+		if (el->hasTagName(T("SNAPSHOTS")))
+			continue;
+
 		restoreSubviewFromXml (currentView, *el);
 	}
+
+	// the snapshots refer to filters by id, so they're only restored once the
+	// controls have been, in case anything else needs the graph first
+	forEachXmlChildElementWithTagName (xml, el, T("SNAPSHOTS"))
+	{
+		GraphDocumentComponent* graphDoc = dynamic_cast<MainHostWindow*>(getTopLevelComponent())->getGraphEditor();
+		dashboard->restoreSnapshotsFromXml(*el, graphDoc->graph);
+	}
 }
 
 XmlElement* ControlSurfaceComponent::createSubviewXml(SubviewComponent* subviewComp) const
@@ -1127,6 +1769,18 @@ XmlElement* ControlSurfaceComponent::createSubviewXml(SubviewComponent* subviewC
 			
 			subviewCompElement->addChildElement (subSubview);
 		}
+		else if (dynamic_cast<SettingsSnapshotter*>(subviewComp->getChildComponent(i)) != 0)
+		{
+			const Component* const c = subviewComp->getChildComponent(i);
+
+			XmlElement* snapshotterElement = new XmlElement(T("SNAPSHOTTER"));
+			snapshotterElement->setAttribute (T("x"), c->getX());
+			snapshotterElement->setAttribute (T("y"), c->getY());
+			snapshotterElement->setAttribute (T("width"), c->getWidth());
+			snapshotterElement->setAttribute (T("height"), c->getHeight());
+
+			subviewCompElement->addChildElement (snapshotterElement);
+		}
 	}
 
 	return subviewCompElement;
@@ -1147,6 +1801,15 @@ void ControlSurfaceComponent::restoreSubviewFromXml (SubviewComponent* container
 					el->getIntAttribute(T("height")));
 			restoreSubviewFromXml(nestedView, *el);
 		}
+		else if (el->hasTagName(T("SNAPSHOTTER")))
+		{
+			SettingsSnapshotter* snapshotter = new SettingsSnapshotter();
+			container->addAndMakeVisible(snapshotter);
+			snapshotter->setBounds(el->getIntAttribute(T("x")),
+					el->getIntAttribute(T("y")),
+					el->getIntAttribute(T("width")),
+					el->getIntAttribute(T("height")));
+		}
 		else
 		{
 			ControlSurfaceMappableComponent* touchComp = 0;
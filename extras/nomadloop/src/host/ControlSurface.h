@@ -23,6 +23,10 @@ public:
 
 	void setMovingComponent(Component* c);
 	void setResizingComponent(Component* c);
+
+private:
+	// moves or resizes a widget as an edit that can be undone
+	void moveWidget(Component* c, const Rectangle<int>& newBounds);
 };
 
 // Base class for a GUI widget for controlling arbitrary commands
@@ -56,9 +60,85 @@ public:
 	// ===========
 	XmlElement* createXml() const;
 	void restoreFromXml (const XmlElement& xml);
+
+	DashboardComponent* getDashboard() const { return dashboard; }
+};
+
+// A static part of a widget's look, which is rendered into an image once and
+// then just blitted, until the widget changes size or the layer is invalidated.
+class CachedLayer
+{
+public:
+	CachedLayer();
+
+	// Returns true if the layer has to be drawn again at this size, in which
+	// case it's been cleared, ready to draw into with a Graphics on getImage().
+	bool needsRedrawing(int width, int height);
+
+	void invalidate();
+
+	Image& getImage() { return image; }
+
+	void drawAt(Graphics& g, int x, int y) const;
+
+private:
+	Image image;
 };
 
-class ControlSurfaceMappableComponent : public Component, public AsyncUpdater
+class ControlSurfaceMappableComponent;
+
+// Carries values from the MIDI and audio threads to the control-surface widgets.
+// Posting a value just stores it in the widget's slot, where a later one
+// replaces it, and once per display frame the GUI thread applies the values of
+// any widgets that have changed. However many controller messages arrive, the
+// widgets are only touched by the GUI thread and nothing is posted to the
+// message queue.
+class ControlFeedbackMirror : private Timer, public DeletedAtShutdown
+{
+public:
+	ControlFeedbackMirror();
+	~ControlFeedbackMirror();
+
+	// The value of a single widget, which any thread can post to.
+	class Slot
+	{
+	public:
+		Slot();
+
+		void post(float newValue);
+
+		// Stores a value without marking it as needing to be applied.
+		void store(float newValue);
+		float getLatest() const;
+
+		// If something's been posted since the last call, returns true and
+		// the most recent value.
+		bool collect(float& latestValue);
+
+	private:
+		Atomic<int> valueBits;
+		Atomic<int> pending;
+	};
+
+	// these must be called on the message thread
+	void addComponent(ControlSurfaceMappableComponent*);
+	void removeComponent(ControlSurfaceMappableComponent*);
+
+	// Can be called from any thread.
+	void post(Slot& slot, float newValue);
+
+	juce_DeclareSingleton (ControlFeedbackMirror, false)
+
+private:
+	Array<ControlSurfaceMappableComponent*> components;
+	Atomic<int> anythingPending;
+
+	enum { framesPerSecond = 60 };
+
+	void timerCallback();
+};
+
+class ControlSurfaceMappableComponent : public Component
 {
 public:
 	ControlSurfaceMappableComponent(const String& componentName);
@@ -66,7 +146,6 @@ public:
 
 	void showContextMenu();
 
-	virtual void handleAsyncUpdate();
 	virtual void refresh() = 0;
 
 	/*int getBoundNodeId() const
@@ -102,9 +181,30 @@ public:
 	// safe to call from GUI thread
 	float getValue();
 
+	// Called from the MIDI or audio thread when one of this widget's actions
+	// receives a new value. The other actions get it straight away, and the
+	// widget picks it up on the next display frame.
+	void postValueFromAction(float newValue, ControlAction* source);
+
+	// Returns the last value that was set or posted, from any thread.
+	float getLatestValue() const;
+
+	// Called by the ControlFeedbackMirror on the message thread.
+	void applyPostedValue(float newValue);
+
 	void setText(const String&);
 	const String getText() const;
 
+	// Maps an action to this control, which then owns it.
+	void attachControlAction(ControlAction* action);
+
+	// Takes an action off this control without deleting it, so that the mapping
+	// can be undone and redone.
+	void detachControlAction(ControlAction* action);
+
+	int getNumControlActions() const { return controlActions.size(); }
+	ControlAction* getControlAction(int index) const { return controlActions[index]; }
+
 	void createControlActionsXml (XmlElement*) const;
 	void restoreControlActionsFromXml (GraphDocumentComponent*, const XmlElement*);
 
@@ -121,6 +221,10 @@ protected:
 private:
 	float value;
 	String text;
+
+	ControlFeedbackMirror::Slot feedbackSlot;
+
+	friend class ControlFeedbackMirror;
 };
 
 #endif
@@ -1,50 +1,98 @@
-#include "Dashboard.h"
-#include "MainHostWindow.h"
-
-DashboardComponent::DashboardComponent()
-{
-	
-	addAndMakeVisible(playHeadLabel = new Label(T("playHeadLabel"), T("Playhead: ")));
-	playHeadLabel->setColour(Label::textColourId, Colours::white);
-	
-	addAndMakeVisible(cpuUsageLabel = new Label(T("cpuUsageLabel"), T("CPU: ")));
-	cpuUsageLabel->setColour(Label::textColourId, Colours::white);
-
-	for (int i=0; i<4; ++i)
-	{
-		SettingsSnapshotSlotComponent* c = new SettingsSnapshotSlotComponent();		
-		snapshotSlots.add(c);
-		addAndMakeVisible(c);
-	}
-
-	startTimer(1000/45);
-}
-
-DashboardComponent::~DashboardComponent()
-{
-	deleteAllChildren();
-}
-
-void DashboardComponent::paint(Graphics &g)
-{
-	//g.fillAll(Colours::linen);
-}
-
-void DashboardComponent::resized()
-{
-	playHeadLabel->setBounds(16, 16, 256, 16);
-	cpuUsageLabel->setBounds(16, 32, 256, 16);
-
-	for (int i=0; i<snapshotSlots.size(); ++i)
-	{
-		snapshotSlots.getUnchecked(i)->setBounds(256+32 + i*(getHeight()-16), 16, getHeight()-32, getHeight()-32);
-	}
-}
-
-void DashboardComponent::timerCallback()
-{
-	const AudioDeviceManager* manager = static_cast<MainHostWindow*>(getTopLevelComponent())->getAudioDeviceManager();
-	cpuUsageLabel->setText(T("CPU: ") + String(manager->getCpuUsage() * 100, 2) + T("%"), false);
-	repaint();
-}
-
+#include "Dashboard.h"
+#include "MainHostWindow.h"
+
+DashboardComponent::DashboardComponent()
+{
+	
+	addAndMakeVisible(playHeadLabel = new Label(T("playHeadLabel"), T("Playhead: ")));
+	playHeadLabel->setColour(Label::textColourId, Colours::white);
+	
+	addAndMakeVisible(cpuUsageLabel = new Label(T("cpuUsageLabel"), T("CPU: ")));
+	cpuUsageLabel->setColour(Label::textColourId, Colours::white);
+
+	for (int i=0; i<4; ++i)
+	{
+		SettingsSnapshotSlotComponent* c = new SettingsSnapshotSlotComponent();		
+		snapshotSlots.add(c);
+		addAndMakeVisible(c);
+	}
+
+	startTimer(1000/45);
+}
+
+DashboardComponent::~DashboardComponent()
+{
+	deleteAllChildren();
+}
+
+void DashboardComponent::paint(Graphics &g)
+{
+	//g.fillAll(Colours::linen);
+}
+
+void DashboardComponent::resized()
+{
+	playHeadLabel->setBounds(16, 16, 256, 16);
+	cpuUsageLabel->setBounds(16, 32, 256, 16);
+
+	for (int i=0; i<snapshotSlots.size(); ++i)
+	{
+		snapshotSlots.getUnchecked(i)->setBounds(256+32 + i*(getHeight()-16), 16, getHeight()-32, getHeight()-32);
+	}
+}
+
+void DashboardComponent::timerCallback()
+{
+	const AudioDeviceManager* manager = static_cast<MainHostWindow*>(getTopLevelComponent())->getAudioDeviceManager();
+	cpuUsageLabel->setText(T("CPU: ") + String(manager->getCpuUsage() * 100, 2) + T("%"), false);
+	repaint();
+}
+
+
+void DashboardComponent::storeSnapshot(SettingsSnapshot* snapshot)
+{
+	SettingsSnapshotSlotComponent* slot = 0;
+
+	for (int i = 0; i < snapshotSlots.size() && slot == 0; ++i)
+		if (! snapshotSlots.getUnchecked(i)->hasSnapshot())
+			slot = snapshotSlots.getUnchecked(i);
+
+	for (int i = 0; i < snapshotSlots.size() && slot == 0; ++i)
+		if (snapshotSlots.getUnchecked(i)->isSelected())
+			slot = snapshotSlots.getUnchecked(i);
+
+	if (slot == 0)
+		slot = snapshotSlots.getFirst();
+
+	slot->setSnapshot(snapshot);
+	selectSnapshotSlot(slot);
+}
+
+void DashboardComponent::selectSnapshotSlot(SettingsSnapshotSlotComponent* slot)
+{
+	for (int i = 0; i < snapshotSlots.size(); ++i)
+		snapshotSlots.getUnchecked(i)->setSelected(snapshotSlots.getUnchecked(i) == slot);
+}
+
+XmlElement* DashboardComponent::createSnapshotsXml() const
+{
+	XmlElement* xml = new XmlElement(T("SNAPSHOTS"));
+
+	for (int i = 0; i < snapshotSlots.size(); ++i)
+		xml->addChildElement(snapshotSlots.getUnchecked(i)->createXml());
+
+	return xml;
+}
+
+void DashboardComponent::restoreSnapshotsFromXml(const XmlElement& xml, FilterGraph& graph)
+{
+	int i = 0;
+
+	forEachXmlChildElementWithTagName (xml, e, T("SNAPSHOT"))
+	{
+		if (i >= snapshotSlots.size())
+			break;
+
+		snapshotSlots.getUnchecked(i++)->restoreFromXml(*e, graph);
+	}
+}
@@ -1,24 +1,32 @@
-#ifndef ADLER_DASHBOARD
-#define ADLER_DASHBOARD
-
-#include "../includes.h"
-#include "SettingsSnapshot.h"
-
-class DashboardComponent : public Component, public Timer
-{
-	Label* playHeadLabel;
-	Label* cpuUsageLabel;
-
-	Array<SettingsSnapshotSlotComponent*> snapshotSlots;
-
-public:
-	DashboardComponent();
-	~DashboardComponent();
-
-	void paint(Graphics& g);
-	void resized();
-
-	void timerCallback();
-};
-
-#endif
+#ifndef ADLER_DASHBOARD
+#define ADLER_DASHBOARD
+
+#include "../includes.h"
+#include "SettingsSnapshot.h"
+
+class DashboardComponent : public Component, public Timer
+{
+	Label* playHeadLabel;
+	Label* cpuUsageLabel;
+
+	Array<SettingsSnapshotSlotComponent*> snapshotSlots;
+
+public:
+	DashboardComponent();
+	~DashboardComponent();
+
+	void paint(Graphics& g);
+	void resized();
+
+	void timerCallback();
+
+	// Puts a new snapshot into the first empty slot, or if they're all full,
+	// replaces the one that was recalled last.
+	void storeSnapshot(SettingsSnapshot* snapshot);
+	void selectSnapshotSlot(SettingsSnapshotSlotComponent* slot);
+
+	XmlElement* createSnapshotsXml() const;
+	void restoreSnapshotsFromXml(const XmlElement& xml, FilterGraph& graph);
+};
+
+#endif
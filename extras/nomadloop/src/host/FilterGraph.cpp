@@ -27,6 +27,9 @@
 #include "FilterGraph.h"
 #include "InternalFilters.h"
 #include "GraphEditorPanel.h"
+#include "Looper.h"
+#include "ProjectFile.h"
+#include "PluginSandbox.h"
 
 
 //==============================================================================
@@ -57,8 +60,13 @@ FilterGraph::FilterGraph()
                          filenameWildcard,
                          "Load a filter graph",
                          "Save a filter graph"),
-      lastUID (0)
+      graph (new AudioProcessorGraph()),
+      lastUID (0),
+      deviceInputLatency (0),
+      deviceOutputLatency (0)
 {
+    graph->addListener (this);
+
     InternalPluginFormat internalFormat;
 
     addFilter (internalFormat.getDescriptionFor (InternalPluginFormat::audioInputFilter),
@@ -73,12 +81,14 @@ FilterGraph::FilterGraph()
 	addFilter (internalFormat.getDescriptionFor (InternalPluginFormat::midiOutputFilter),
 		0.25f, 0.9f);
 
+    undoManager.clearUndoHistory();
     setChangedFlag (false);
 }
 
 FilterGraph::~FilterGraph()
 {
-    graph.clear();
+    graph->removeListener (this);
+    graph->clear();
 }
 
 uint32 FilterGraph::getNextUID() throw()
@@ -86,20 +96,198 @@ uint32 FilterGraph::getNextUID() throw()
     return ++lastUID;
 }
 
+//==============================================================================
+/*  The edits that can be undone.
+
+    Each one holds only what it changes - some connections, a filter's position,
+    or a single filter along with its state and connections - rather than a copy
+    of the whole graph. All the edits of a transaction are undone or redone in
+    the same message callback, so the graph rebuilds its rendering sequence once.
+*/
+class FilterGraph::ConnectionAction  : public UndoableAction
+{
+public:
+    ConnectionAction (FilterGraph& owner_, const Array <AudioProcessorGraph::Connection>& connections_,
+                      const bool isAdding_)
+        : owner (owner_), connections (connections_), isAdding (isAdding_)
+    {
+    }
+
+    bool perform()                  { return connect (isAdding); }
+    bool undo()                     { return connect (! isAdding); }
+    int getSizeInUnits()            { return connections.size(); }
+
+private:
+    FilterGraph& owner;
+    Array <AudioProcessorGraph::Connection> connections;
+    const bool isAdding;
+
+    bool connect (const bool shouldBeConnected)
+    {
+        bool anythingChanged = false;
+
+        for (int i = 0; i < connections.size(); ++i)
+        {
+            const AudioProcessorGraph::Connection& c = connections.getReference (i);
+
+            if (shouldBeConnected ? owner.graph->addConnection (c.sourceNodeId, c.sourceChannelIndex,
+                                                                c.destNodeId, c.destChannelIndex)
+                                  : owner.graph->removeConnection (c.sourceNodeId, c.sourceChannelIndex,
+                                                                   c.destNodeId, c.destChannelIndex))
+                anythingChanged = true;
+        }
+
+        if (anythingChanged)
+            owner.changed();
+
+        return anythingChanged;
+    }
+};
+
+class FilterGraph::FilterAction  : public UndoableAction
+{
+public:
+    /** Adds a filter that's just been created. */
+    FilterAction (FilterGraph& owner_, AudioPluginInstance* const newInstance, double x, double y)
+        : owner (owner_), isAdding (true), uid (0), instance (newInstance)
+    {
+        properties.set ("x", x);
+        properties.set ("y", y);
+    }
+
+    /** Removes one that's in the graph. */
+    FilterAction (FilterGraph& owner_, const uint32 uid_)
+        : owner (owner_), isAdding (false), uid (uid_)
+    {
+    }
+
+    bool perform()                  { return isAdding ? insert() : takeOut(); }
+    bool undo()                     { return isAdding ? takeOut() : insert(); }
+    int getSizeInUnits()            { return 10 + (int) (state.getSize() / 1024); }
+
+private:
+    FilterGraph& owner;
+    const bool isAdding;
+    uint32 uid;
+
+    // a filter that's out of the graph is kept as its description and state, and
+    // is recreated with the same id, so that the other edits still refer to it
+    ScopedPointer <AudioPluginInstance> instance;
+    PluginDescription description;
+    MemoryBlock state;
+    NamedValueSet properties;
+    Array <AudioProcessorGraph::Connection> connections;
+
+    bool insert()
+    {
+        if (instance == 0)
+        {
+            String errorMessage;
+            instance = AudioPluginFormatManager::getInstance()->createPluginInstance (description, errorMessage);
+
+            if (instance == 0)
+                return false;
+
+            instance->setStateInformation (state.getData(), (int) state.getSize());
+        }
+
+        AudioProcessorGraph::Node* const node = owner.graph->addNode (instance, uid);
+
+        if (node == 0)
+            return false;
+
+        instance.release();
+        uid = node->nodeId;
+        node->properties = properties;
+        node->getProcessor()->setPlayHead (owner.graph->getPlayHead());
+
+        for (int i = 0; i < connections.size(); ++i)
+        {
+            const AudioProcessorGraph::Connection& c = connections.getReference (i);
+            owner.graph->addConnection (c.sourceNodeId, c.sourceChannelIndex, c.destNodeId, c.destChannelIndex);
+        }
+
+        connections.clear();
+        state.setSize (0);
+        owner.changed();
+        return true;
+    }
+
+    bool takeOut()
+    {
+        const AudioProcessorGraph::Node::Ptr node (owner.graph->getNodeForId (uid));
+        AudioPluginInstance* const plugin = node != 0 ? dynamic_cast <AudioPluginInstance*> (node->getProcessor()) : 0;
+
+        if (plugin == 0)
+            return false;
+
+        plugin->fillInPluginDescription (description);
+        plugin->getStateInformation (state);
+        properties = node->properties;
+
+        connections.clearQuick();
+        owner.getConnectionsOf (uid, connections);
+
+        PluginWindow::closeCurrentlyOpenWindowsFor (uid);
+        owner.graph->removeNode (uid);
+        owner.changed();
+        return true;
+    }
+};
+
+class FilterGraph::MoveAction  : public UndoableAction
+{
+public:
+    MoveAction (FilterGraph& owner_, const uint32 uid_, double oldX_, double oldY_, double newX_, double newY_)
+        : owner (owner_), uid (uid_), oldX (oldX_), oldY (oldY_), newX (newX_), newY (newY_)
+    {
+    }
+
+    bool perform()                  { return moveTo (newX, newY); }
+    bool undo()                     { return moveTo (oldX, oldY); }
+    int getSizeInUnits()            { return 1; }
+
+    UndoableAction* createCoalescedAction (UndoableAction* nextAction)
+    {
+        // a drag is one move, from where the filter started to where it ended up
+        const MoveAction* const next = dynamic_cast <MoveAction*> (nextAction);
+
+        if (next != 0 && next->uid == uid)
+            return new MoveAction (owner, uid, oldX, oldY, next->newX, next->newY);
+
+        return 0;
+    }
+
+private:
+    FilterGraph& owner;
+    const uint32 uid;
+    const double oldX, oldY, newX, newY;
+
+    bool moveTo (double x, double y)
+    {
+        if (owner.graph->getNodeForId (uid) == 0)
+            return false;
+
+        owner.setNodePosition (uid, x, y);
+        owner.changed();
+        return true;
+    }
+};
+
 //==============================================================================
 int FilterGraph::getNumFilters() const throw()
 {
-    return graph.getNumNodes();
+    return graph->getNumNodes();
 }
 
 const AudioProcessorGraph::Node::Ptr FilterGraph::getNode (const int index) const throw()
 {
-    return graph.getNode (index);
+    return graph->getNode (index);
 }
 
 const AudioProcessorGraph::Node::Ptr FilterGraph::getNodeForId (const uint32 uid) const throw()
 {
-    return graph.getNodeForId (uid);
+    return graph->getNodeForId (uid);
 }
 
 void FilterGraph::addFilter (const PluginDescription* desc, double x, double y)
@@ -111,19 +299,7 @@ void FilterGraph::addFilter (const PluginDescription* desc, double x, double y)
         AudioPluginInstance* instance
             = AudioPluginFormatManager::getInstance()->createPluginInstance (*desc, errorMessage);
 
-        AudioProcessorGraph::Node* node = 0;
-
-        if (instance != 0)
-            node = graph.addNode (instance);
-
-        if (node != 0)
-        {
-            node->properties.set ("x", x);
-            node->properties.set ("y", y);				
-			node->getProcessor()->setPlayHead(graph.getPlayHead());			
-            changed();
-        }
-        else
+        if (instance == 0 || ! undoManager.perform (new FilterAction (*this, instance, x, y)))
         {
             AlertWindow::showMessageBox (AlertWindow::WarningIcon,
                                          TRANS("Couldn't create filter"),
@@ -134,27 +310,37 @@ void FilterGraph::addFilter (const PluginDescription* desc, double x, double y)
 
 void FilterGraph::removeFilter (const uint32 id)
 {
-    PluginWindow::closeCurrentlyOpenWindowsFor (id);
-
-    if (graph.removeNode (id))
-        changed();
+    if (graph->getNodeForId (id) != 0)
+        undoManager.perform (new FilterAction (*this, id));
 }
 
 void FilterGraph::disconnectFilter (const uint32 id)
 {
-    if (graph.disconnectNode (id))
-        changed();
+    Array <AudioProcessorGraph::Connection> connections;
+    getConnectionsOf (id, connections);
+
+    if (connections.size() > 0)
+        undoManager.perform (new ConnectionAction (*this, connections, false));
 }
 
 void FilterGraph::removeIllegalConnections()
 {
-    if (graph.removeIllegalConnections())
+    if (graph->removeIllegalConnections())
         changed();
 }
 
+void FilterGraph::moveFilter (const uint32 id, double x, double y)
+{
+    double oldX, oldY;
+    getNodePosition (id, oldX, oldY);
+
+    if (graph->getNodeForId (id) != 0)
+        undoManager.perform (new MoveAction (*this, id, oldX, oldY, jlimit (0.0, 1.0, x), jlimit (0.0, 1.0, y)));
+}
+
 void FilterGraph::setNodePosition (const int nodeId, double x, double y)
 {
-    const AudioProcessorGraph::Node::Ptr n (graph.getNodeForId (nodeId));
+    const AudioProcessorGraph::Node::Ptr n (graph->getNodeForId (nodeId));
 
     if (n != 0)
     {
@@ -167,7 +353,7 @@ void FilterGraph::getNodePosition (const int nodeId, double& x, double& y) const
 {
     x = y = 0;
 
-    const AudioProcessorGraph::Node::Ptr n (graph.getNodeForId (nodeId));
+    const AudioProcessorGraph::Node::Ptr n (graph->getNodeForId (nodeId));
 
     if (n != 0)
     {
@@ -176,65 +362,163 @@ void FilterGraph::getNodePosition (const int nodeId, double& x, double& y) const
     }
 }
 
+void FilterGraph::getConnectionsOf (const uint32 id, Array <AudioProcessorGraph::Connection>& connections) const
+{
+    for (int i = 0; i < graph->getNumConnections(); ++i)
+    {
+        const AudioProcessorGraph::Connection* const c = graph->getConnection (i);
+
+        if (c->sourceNodeId == id || c->destNodeId == id)
+            connections.add (*c);
+    }
+}
+
 //==============================================================================
 int FilterGraph::getNumConnections() const throw()
 {
-    return graph.getNumConnections();
+    return graph->getNumConnections();
 }
 
 const AudioProcessorGraph::Connection* FilterGraph::getConnection (const int index) const throw()
 {
-    return graph.getConnection (index);
+    return graph->getConnection (index);
 }
 
 const AudioProcessorGraph::Connection* FilterGraph::getConnectionBetween (uint32 sourceFilterUID, int sourceFilterChannel,
                                                                           uint32 destFilterUID, int destFilterChannel) const throw()
 {
-    return graph.getConnectionBetween (sourceFilterUID, sourceFilterChannel,
+    return graph->getConnectionBetween (sourceFilterUID, sourceFilterChannel,
                                        destFilterUID, destFilterChannel);
 }
 
 bool FilterGraph::canConnect (uint32 sourceFilterUID, int sourceFilterChannel,
                               uint32 destFilterUID, int destFilterChannel) const throw()
 {
-    return graph.canConnect (sourceFilterUID, sourceFilterChannel,
+    return graph->canConnect (sourceFilterUID, sourceFilterChannel,
                              destFilterUID, destFilterChannel);
 }
 
 bool FilterGraph::addConnection (uint32 sourceFilterUID, int sourceFilterChannel,
                                  uint32 destFilterUID, int destFilterChannel)
 {
-    const bool result = graph.addConnection (sourceFilterUID, sourceFilterChannel,
-                                             destFilterUID, destFilterChannel);
+    if (! graph->canConnect (sourceFilterUID, sourceFilterChannel, destFilterUID, destFilterChannel))
+        return false;
 
-    if (result)
-        changed();
+    Array <AudioProcessorGraph::Connection> connections;
+    connections.add (AudioProcessorGraph::Connection (sourceFilterUID, sourceFilterChannel,
+                                                      destFilterUID, destFilterChannel));
 
-    return result;
+    return undoManager.perform (new ConnectionAction (*this, connections, true));
 }
 
 void FilterGraph::removeConnection (const int index)
 {
-    graph.removeConnection (index);
-    changed();
+    const AudioProcessorGraph::Connection* const c = graph->getConnection (index);
+
+    if (c != 0)
+        removeConnection (c->sourceNodeId, c->sourceChannelIndex, c->destNodeId, c->destChannelIndex);
 }
 
 void FilterGraph::removeConnection (uint32 sourceFilterUID, int sourceFilterChannel,
                                     uint32 destFilterUID, int destFilterChannel)
 {
-    if (graph.removeConnection (sourceFilterUID, sourceFilterChannel,
-                                destFilterUID, destFilterChannel))
-        changed();
+    if (graph->getConnectionBetween (sourceFilterUID, sourceFilterChannel,
+                                     destFilterUID, destFilterChannel) == 0)
+        return;
+
+    Array <AudioProcessorGraph::Connection> connections;
+    connections.add (AudioProcessorGraph::Connection (sourceFilterUID, sourceFilterChannel,
+                                                      destFilterUID, destFilterChannel));
+
+    undoManager.perform (new ConnectionAction (*this, connections, false));
 }
 
 void FilterGraph::clear()
 {
-    PluginWindow::closeAllCurrentlyOpenWindows();
+    PluginWindow::closeCurrentlyOpenWindowsFor (*graph);
 
-    graph.clear();
+    graph->clear();
+    undoManager.clearUndoHistory();
     changed();
 }
 
+void FilterGraph::swapWith (FilterGraph& other)
+{
+    PluginWindow::closeCurrentlyOpenWindowsFor (*graph);
+    PluginWindow::closeCurrentlyOpenWindowsFor (*other.graph);
+
+    graph->removeListener (this);
+    other.graph->removeListener (&other);
+
+    graph.swapWith (other.graph);
+    swapVariables (lastUID, other.lastUID);
+
+    graph->addListener (this);
+    other.graph->addListener (&other);
+
+    const File file (getFile());
+    setFile (other.getFile());
+    other.setFile (file);
+
+    const bool hasChanged = hasChangedSinceSaved();
+    setChangedFlag (other.hasChangedSinceSaved());
+    other.setChangedFlag (hasChanged);
+
+    // the edits that were recorded refer to the other graph's filters
+    undoManager.clearUndoHistory();
+    other.undoManager.clearUndoHistory();
+
+    // the device latencies stay with the document, so the new loopers need them
+    updateLatencyCompensation();
+    sendChangeMessage();
+}
+
+//==============================================================================
+void FilterGraph::setDeviceLatency (int inputLatencySamples, int outputLatencySamples)
+{
+    deviceInputLatency = inputLatencySamples;
+    deviceOutputLatency = outputLatencySamples;
+
+    updateLatencyCompensation();
+}
+
+void FilterGraph::updateLatencyCompensation()
+{
+    // The graph delays every path so that they all reach the output together, so
+    // whatever a looper plays is heard after the graph's total latency plus the
+    // output device's.  Material played along to it then takes the input device's
+    // latency (for audio) plus the path up to the looper to come back, but that
+    // path is already contained in the graph's total.
+    const int graphLatency = graph->getLatencySamples();
+
+    for (int i = graph->getNumNodes(); --i >= 0;)
+    {
+        LoopProcessor* const looper = dynamic_cast <LoopProcessor*> (graph->getNode (i)->getProcessor());
+
+        if (looper != 0)
+            looper->setLatencyCompensation (graphLatency + deviceOutputLatency
+                                             + (looper->recordsAudio() ? deviceInputLatency : 0));
+    }
+}
+
+void FilterGraph::audioProcessorParameterChanged (AudioProcessor*, int, float)
+{
+}
+
+void FilterGraph::audioProcessorChanged (AudioProcessor*)
+{
+    // the graph has rebuilt its rendering sequence, which may happen on the audio thread
+    triggerAsyncUpdate();
+}
+
+void FilterGraph::handleAsyncUpdate()
+{
+    updateLatencyCompensation();
+
+    // let the editor redraw the per-filter latencies
+    sendChangeMessage();
+}
+
 //==============================================================================
 const String FilterGraph::getDocumentTitle()
 {
@@ -329,7 +613,108 @@ static XmlElement* createNodeXml (AudioProcessorGraph::Node* const node) throw()
     return e;
 }
 
-void FilterGraph::createNodeFromXml (const XmlElement& xml)
+//==============================================================================
+/*  A filter that's being recreated while a graph is restored.
+
+    Creating the plugins and restoring their states is what takes most of the time
+    when a project is opened, so all of them are created before any are added to
+    the graph. The ones whose format allows it are loaded on a thread pool while
+    the message thread works through the rest, and the internal filters (such as
+    loopers, whose states can be large) are created on the message thread but have
+    their states decoded and restored on the pool.
+*/
+class FilterGraph::PendingNode  : public ThreadPoolJob
+{
+public:
+    PendingNode (const PluginDescription& description_, uint32 uid_)
+        : ThreadPoolJob (description_.name),
+          description (description_), uid (uid_),
+          x (0), y (0), uiLastX (0), uiLastY (0),
+          stateData (0), stateSize (0), asyncFormat (0), isInternal (false)
+    {
+        // VSTs and AudioUnits expect to be created on the message thread (and
+        // loading a VST changes the working directory), so only sandboxed plugins,
+        // which are loaded by a child process, are sent off to the pool. Internal
+        // filters don't mind which thread restores their state.
+        AudioPluginFormatManager* const formats = AudioPluginFormatManager::getInstance();
+
+        for (int i = 0; i < formats->getNumFormats(); ++i)
+        {
+            AudioPluginFormat* const format = formats->getFormat (i);
+
+            if (format->getName() != description.pluginFormatName)
+                continue;
+
+            if (dynamic_cast <SandboxedPluginFormat*> (format) != 0)
+                asyncFormat = format;
+            else if (dynamic_cast <InternalPluginFormat*> (format) != 0)
+                isInternal = true;
+        }
+    }
+
+    bool canCreateOnAnyThread() const throw()       { return asyncFormat != 0; }
+
+    /** True if, once it's been created, the plugin's state can be restored on the pool. */
+    bool canRestoreOnAnyThread() const throw()      { return asyncFormat != 0 || isInternal; }
+
+    /** Creates the plugin. */
+    void create()
+    {
+        if (asyncFormat != 0)
+            instance = asyncFormat->createInstanceFromDescription (description);
+        else
+            instance = AudioPluginFormatManager::getInstance()->createPluginInstance (description, errorMessage);
+    }
+
+    /** Gives the plugin its state, if it was created. */
+    void restoreState()
+    {
+        if (instance == 0)
+            return;
+
+        if (base64State.isNotEmpty())
+        {
+            MemoryBlock m;
+            m.fromBase64Encoding (base64State);
+            instance->setStateInformation (m.getData(), (int) m.getSize());
+        }
+        else if (stateData != 0)
+        {
+            instance->setStateInformation (stateData, (int) stateSize);
+        }
+    }
+
+    JobStatus runJob()
+    {
+        if (instance == 0)
+            create();
+
+        restoreState();
+        return jobHasFinished;
+    }
+
+    const PluginDescription description;
+    const uint32 uid;
+    double x, y;
+    int uiLastX, uiLastY;
+
+    // the state is either base64 text from an XML document, or points into a project file
+    String base64State;
+    const void* stateData;
+    size_t stateSize;
+
+    ScopedPointer <AudioPluginInstance> instance;
+    String errorMessage;
+
+private:
+    AudioPluginFormat* asyncFormat;
+    bool isInternal;
+
+    PendingNode (const PendingNode&);
+    const PendingNode& operator= (const PendingNode&);
+};
+
+FilterGraph::PendingNode* FilterGraph::createPendingNodeFromXml (const XmlElement& xml)
 {
     PluginDescription pd;
 
@@ -339,37 +724,69 @@ void FilterGraph::createNodeFromXml (const XmlElement& xml)
             break;
     }
 
-    String errorMessage;
+    PendingNode* const n = new PendingNode (pd, (uint32) xml.getIntAttribute (T("uid")));
+    n->x = xml.getDoubleAttribute (T("x"));
+    n->y = xml.getDoubleAttribute (T("y"));
+    n->uiLastX = xml.getIntAttribute (T("uiLastX"));
+    n->uiLastY = xml.getIntAttribute (T("uiLastY"));
 
-    AudioPluginInstance* instance
-        = AudioPluginFormatManager::getInstance()->createPluginInstance (pd, errorMessage);
+    const XmlElement* const state = xml.getChildByName (T("STATE"));
+
+    // the decoding is left to restoreState(), so that it can happen on the pool
+    if (state != 0)
+        n->base64State = state->getAllSubText();
 
-    if (instance == 0)
+    return n;
+}
+
+void FilterGraph::addPendingNodes (OwnedArray <PendingNode>& pendingNodes)
+{
     {
-        // xxx handle ins + outs
-    }
+        ThreadPool pool (jmax (2, SystemStats::getNumCpus()));
 
-    if (instance == 0)
-        return;
+        for (int i = 0; i < pendingNodes.size(); ++i)
+            if (pendingNodes.getUnchecked (i)->canCreateOnAnyThread())
+                pool.addJob (pendingNodes.getUnchecked (i));
 
-    AudioProcessorGraph::Node::Ptr node (graph.addNode (instance, xml.getIntAttribute (T("uid"))));
+        for (int i = 0; i < pendingNodes.size(); ++i)
+        {
+            PendingNode* const n = pendingNodes.getUnchecked (i);
 
-    const XmlElement* const state = xml.getChildByName (T("STATE"));
+            if (n->canCreateOnAnyThread())
+                continue;
 
-    if (state != 0)
-    {
-        MemoryBlock m;
-        m.fromBase64Encoding (state->getAllSubText());
+            n->create();
 
-        node->getProcessor()->setStateInformation (m.getData(), m.getSize());
+            if (n->canRestoreOnAnyThread())
+                pool.addJob (n);
+            else
+                n->restoreState();
+        }
+
+        for (int i = 0; i < pendingNodes.size(); ++i)
+            pool.waitForJobToFinish (pendingNodes.getUnchecked (i), -1);
     }
 
-	node->getProcessor()->setPlayHead(graph.getPlayHead());
+    // the nodes go in in their original order, whichever finished loading first
+    for (int i = 0; i < pendingNodes.size(); ++i)
+    {
+        PendingNode& n = *pendingNodes.getUnchecked (i);
+
+        if (n.instance == 0)
+        {
+            // xxx handle ins + outs
+            continue;
+        }
+
+        n.instance->setPlayHead (graph->getPlayHead());
 
-    node->properties.set ("x", xml.getDoubleAttribute (T("x")));
-    node->properties.set ("y", xml.getDoubleAttribute (T("y")));
-    node->properties.set ("uiLastX", xml.getIntAttribute (T("uiLastX")));
-    node->properties.set ("uiLastY", xml.getIntAttribute (T("uiLastY")));
+        AudioProcessorGraph::Node::Ptr node (graph->addNode (n.instance.release(), n.uid));
+
+        node->properties.set ("x", n.x);
+        node->properties.set ("y", n.y);
+        node->properties.set ("uiLastX", n.uiLastX);
+        node->properties.set ("uiLastY", n.uiLastY);
+    }
 }
 
 XmlElement* FilterGraph::createXml() const
@@ -377,14 +794,14 @@ XmlElement* FilterGraph::createXml() const
     XmlElement* xml = new XmlElement ("FILTERGRAPH");
 
     int i;
-    for (i = 0; i < graph.getNumNodes(); ++i)
+    for (i = 0; i < graph->getNumNodes(); ++i)
     {
-        xml->addChildElement (createNodeXml (graph.getNode (i)));
+        xml->addChildElement (createNodeXml (graph->getNode (i)));
     }
 
-    for (i = 0; i < graph.getNumConnections(); ++i)
+    for (i = 0; i < graph->getNumConnections(); ++i)
     {
-        const AudioProcessorGraph::Connection* const fc = graph.getConnection(i);
+        const AudioProcessorGraph::Connection* const fc = graph->getConnection(i);
 
         XmlElement* e = new XmlElement ("CONNECTION");
 
@@ -403,19 +820,106 @@ void FilterGraph::restoreFromXml (const XmlElement& xml)
 {
     clear();
 
+    OwnedArray <PendingNode> pendingNodes;
+
     forEachXmlChildElementWithTagName (xml, e, T("FILTER"))
+        pendingNodes.add (createPendingNodeFromXml (*e));
+
+    addPendingNodes (pendingNodes);
+
+    forEachXmlChildElementWithTagName (xml, e, T("CONNECTION"))
     {
-        createNodeFromXml (*e);
-        changed();
+        graph->addConnection ((uint32) e->getIntAttribute (T("srcFilter")),
+                             e->getIntAttribute (T("srcChannel")),
+                             (uint32) e->getIntAttribute (T("dstFilter")),
+                             e->getIntAttribute (T("dstChannel")));
     }
 
-    forEachXmlChildElementWithTagName (xml, e, T("CONNECTION"))
+    graph->removeIllegalConnections();
+    changed();
+}
+
+void FilterGraph::writeToProject (ProjectFileWriter& writer) const
+{
+    for (int i = 0; i < graph->getNumNodes(); ++i)
+    {
+        AudioProcessorGraph::Node* const node = graph->getNode (i);
+        AudioPluginInstance* plugin = dynamic_cast <AudioPluginInstance*> (node->getProcessor());
+
+        if (plugin == 0)
+        {
+            jassertfalse
+            continue;
+        }
+
+        PluginDescription pd;
+        plugin->fillInPluginDescription (pd);
+        const ScopedPointer <XmlElement> description (pd.createXml());
+
+        // the state goes out to the file now, rather than being kept until the end
+        MemoryBlock m;
+        plugin->getStateInformation (m);
+
+        ProjectFile::Node n;
+        n.uid = node->nodeId;
+        n.x = node->properties ["x"];
+        n.y = node->properties ["y"];
+        n.uiLastX = node->properties ["uiLastX"];
+        n.uiLastY = node->properties ["uiLastY"];
+        n.pluginDescription = description->createDocument (String::empty, true, false);
+        n.stateChunk = writer.addChunk (ProjectFile::pluginStateChunk, m.getData(), m.getSize());
+
+        writer.addNode (n);
+    }
+
+    for (int i = 0; i < graph->getNumConnections(); ++i)
     {
-        addConnection ((uint32) e->getIntAttribute (T("srcFilter")),
-                       e->getIntAttribute (T("srcChannel")),
-                       (uint32) e->getIntAttribute (T("dstFilter")),
-                       e->getIntAttribute (T("dstChannel")));
+        const AudioProcessorGraph::Connection* const fc = graph->getConnection (i);
+
+        ProjectFile::Connection c;
+        c.sourceNode = fc->sourceNodeId;
+        c.sourceChannel = fc->sourceChannelIndex;
+        c.destNode = fc->destNodeId;
+        c.destChannel = fc->destChannelIndex;
+
+        writer.addConnection (c);
     }
+}
+
+void FilterGraph::restoreFromProject (const ProjectFileReader& reader)
+{
+    clear();
 
-    graph.removeIllegalConnections();
+    OwnedArray <PendingNode> pendingNodes;
+
+    for (int i = 0; i < reader.getNumNodes(); ++i)
+    {
+        const ProjectFile::Node& n = reader.getNode (i);
+
+        PluginDescription pd;
+        const ScopedPointer <XmlElement> description (XmlDocument::parse (n.pluginDescription));
+
+        if (description == 0 || ! pd.loadFromXml (*description))
+            continue;
+
+        PendingNode* const p = new PendingNode (pd, n.uid);
+        p->x = n.x;
+        p->y = n.y;
+        p->uiLastX = n.uiLastX;
+        p->uiLastY = n.uiLastY;
+        p->stateData = reader.getChunkData (n.stateChunk, p->stateSize);
+
+        pendingNodes.add (p);
+    }
+
+    addPendingNodes (pendingNodes);
+
+    for (int i = 0; i < reader.getNumConnections(); ++i)
+    {
+        const ProjectFile::Connection& c = reader.getConnection (i);
+        graph->addConnection (c.sourceNode, c.sourceChannel, c.destNode, c.destChannel);
+    }
+
+    graph->removeIllegalConnections();
+    changed();
 }
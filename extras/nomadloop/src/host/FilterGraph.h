@@ -125,8 +125,16 @@ private:
 //==============================================================================
 /**
     A collection of filters and some connections between them.
+
+    The graph also keeps the loopers in it compensated for the latency of
+    the audio device and of whatever is in the signal path around them.
 */
-class FilterGraph   : public FileBasedDocument
+class ProjectFileWriter;
+class ProjectFileReader;
+
+class FilterGraph   : public FileBasedDocument,
+                      public AudioProcessorListener,
+                      private AsyncUpdater
 {
 public:
     //==============================================================================
@@ -134,7 +142,7 @@ public:
     ~FilterGraph();
 
     //==============================================================================
-    AudioProcessorGraph& getGraph() throw()         { return graph; }
+    AudioProcessorGraph& getGraph() throw()         { return *graph; }
 
     int getNumFilters() const throw();
     const AudioProcessorGraph::Node::Ptr getNode (const int index) const throw();
@@ -147,6 +155,11 @@ public:
 
     void removeIllegalConnections();
 
+    /** Moves a filter as an edit that can be undone. Moves of the same filter that
+        follow each other in a transaction are merged, so a whole drag is undone at once.
+    */
+    void moveFilter (const uint32 filterUID, double x, double y);
+
     void setNodePosition (const int nodeId, double x, double y);
     void getNodePosition (const int nodeId, double& x, double& y) const;
 
@@ -170,12 +183,49 @@ public:
 
     void clear();
 
+    /** Holds the edits made to the graph, and to the control surface that goes with it.
+
+        Adding, removing and moving filters and adding and removing connections are
+        recorded here, as just what each one changed. Whoever makes an edit starts a
+        new transaction when the user begins the gesture, and everything done until
+        the next one is undone as a single step.
+    */
+    UndoManager& getUndoManager() throw()           { return undoManager; }
+
+    /** Exchanges the filters, connections and file with those of another graph.
+
+        This is how a graph that was loaded in the background takes over from
+        the one being shown. The graph objects themselves change owner rather
+        than being rebuilt, so anything that's playing them carries on.
+    */
+    void swapWith (FilterGraph& other);
+
+    //==============================================================================
+    /** Tells the graph how much latency the audio device adds on its way in and out,
+        so that the loopers can be lined up with what the player actually hears.
+    */
+    void setDeviceLatency (int inputLatencySamples, int outputLatencySamples);
+
+    /** Recalculates the latency compensation of every looper in the graph. */
+    void updateLatencyCompensation();
+
+    //==============================================================================
+    void audioProcessorParameterChanged (AudioProcessor*, int, float);
+    void audioProcessorChanged (AudioProcessor*);
 
     //==============================================================================
 
     XmlElement* createXml() const;
     void restoreFromXml (const XmlElement& xml);
 
+    /** Adds the filters, their states and the connections to a binary project file. */
+    void writeToProject (ProjectFileWriter& writer) const;
+
+    /** Rebuilds the graph from a binary project file.
+        Each plugin's state is passed to it straight from the reader's mapped file.
+    */
+    void restoreFromProject (const ProjectFileReader& reader);
+
     //==============================================================================
     const String getDocumentTitle();
     const String loadDocument (const File& file);
@@ -195,13 +245,25 @@ private:
     //ReferenceCountedArray <FilterInGraph> filters;
     //OwnedArray <FilterConnection> connections;
 
-    AudioProcessorGraph graph;
+    ScopedPointer <AudioProcessorGraph> graph;
     AudioProcessorPlayer player;
+    UndoManager undoManager;
 
     uint32 lastUID;
     uint32 getNextUID() throw();
 
-    void createNodeFromXml (const XmlElement& xml);
+    int deviceInputLatency, deviceOutputLatency;
+
+    void handleAsyncUpdate();
+
+    class ConnectionAction;
+    class FilterAction;
+    class MoveAction;
+    void getConnectionsOf (const uint32 filterUID, Array <AudioProcessorGraph::Connection>& connections) const;
+
+    class PendingNode;
+    static PendingNode* createPendingNodeFromXml (const XmlElement& xml);
+    void addPendingNodes (OwnedArray <PendingNode>& pendingNodes);
 
     FilterGraph (const FilterGraph&);
     const FilterGraph& operator= (const FilterGraph&);
@@ -60,6 +60,17 @@ void PluginWindow::closeCurrentlyOpenWindowsFor (const uint32 nodeId)
             delete activePluginWindows.getUnchecked(i);
 }
 
+void PluginWindow::closeCurrentlyOpenWindowsFor (const AudioProcessorGraph& graph)
+{
+    for (int i = activePluginWindows.size(); --i >= 0;)
+    {
+        AudioProcessorGraph::Node* const owner = activePluginWindows.getUnchecked(i)->owner;
+
+        if (graph.getNodeForId (owner->nodeId) == owner)
+            delete activePluginWindows.getUnchecked(i);
+    }
+}
+
 void PluginWindow::closeAllCurrentlyOpenWindows()
 {
     for (int i = activePluginWindows.size(); --i >= 0;)
@@ -256,11 +267,13 @@ public:
 
             if (r == 1)
             {
+                graph.getUndoManager().beginNewTransaction (T("Delete Filter"));
                 graph.removeFilter (filterID);
                 return;
             }
             else if (r == 2)
             {
+                graph.getUndoManager().beginNewTransaction (T("Disconnect Filter"));
                 graph.disconnectFilter (filterID);
             }
             else if (r == 3 || r == 4)
@@ -276,6 +289,11 @@ public:
                 }
             }
         }
+        else
+        {
+            // however far it's dragged, the filter's move is undone in one go
+            graph.getUndoManager().beginNewTransaction (T("Move Filter"));
+        }
     }
 
     void mouseDrag (const MouseEvent& e)
@@ -287,9 +305,9 @@ public:
             if (getParentComponent() != 0)
                 pos = getParentComponent()->globalPositionToRelative (pos);
 
-            graph.setNodePosition (filterID,
-                                   (pos.getX() + getWidth() / 2) / (double) getParentWidth(),
-                                   (pos.getY() + getHeight() / 2) / (double) getParentHeight());
+            graph.moveFilter (filterID,
+                              (pos.getX() + getWidth() / 2) / (double) getParentWidth(),
+                              (pos.getY() + getHeight() / 2) / (double) getParentHeight());
 
             getGraphPanel()->updateComponents();
         }
@@ -309,10 +327,6 @@ public:
                     w->toFront (true);
             }
         }
-        else if (! e.mouseWasClicked())
-        {
-            graph.setChangedFlag (true);
-        }
     }
 
     bool hitTest (int x, int y)
@@ -341,6 +355,14 @@ public:
                           x + 4, y + 2, w - 8, h - 4,
                           Justification::centred, 2);
 
+        if (latencyText.isNotEmpty())
+        {
+            g.setColour (Colours::darkgrey);
+            g.setFont (10.0f);
+            g.drawText (latencyText, x + 2, y + h - 12, w - 4, 11,
+                        Justification::bottomRight, true);
+        }
+
         g.setColour (Colours::grey);
         g.drawRect (x, y, w, h);
     }
@@ -410,6 +432,18 @@ public:
 
         setName (f->getProcessor()->getName());
 
+        // show what this filter adds to the latency, and how much the graph is
+        // holding back its inputs to line them up
+        latencyText = String::empty;
+
+        if (f->getProcessor()->getLatencySamples() > 0)
+            latencyText << f->getProcessor()->getLatencySamples() << " smp";
+
+        if (f->getCompensationDelaySamples() > 0)
+            latencyText << (latencyText.isEmpty() ? "" : ", ") << "+" << f->getCompensationDelaySamples() << " comp";
+
+        repaint();
+
         {
             double x, y;
             graph.getNodePosition (filterID, x, y);
@@ -450,6 +484,7 @@ private:
     int numIns, numOuts;
     DropShadowEffect shadow;
     Font font;
+    String latencyText;
 
     GraphEditorPanel* getGraphPanel() const throw()
     {
@@ -612,8 +647,6 @@ public:
         {
             dragging = true;
 
-            graph.removeConnection (sourceFilterID, sourceFilterChannel, destFilterID, destFilterChannel);
-
             double distanceFromStart, distanceFromEnd;
             getDistancesFromEnds (e.x, e.y, distanceFromStart, distanceFromEnd);
             const bool isNearerSource = (distanceFromStart < distanceFromEnd);
@@ -713,7 +746,8 @@ private:
 //==============================================================================
 GraphEditorPanel::GraphEditorPanel (FilterGraph& graph_)
     : graph (graph_),
-      draggingConnector (0)
+      draggingConnector (0),
+      replacedConnection (0, 0, 0, 0)
 {
     graph.addChangeListener (this);
     setOpaque (true);
@@ -749,13 +783,14 @@ void GraphEditorPanel::mouseDown (const MouseEvent& e)
 
             const int r = m.show();
 
-            createNewPlugin (mainWindow->getChosenType (r), e.x, e.y);
+            mainWindow->createPlugin (mainWindow->getChosenType (r), e.x, e.y);
         }
     }
 }
 
 void GraphEditorPanel::createNewPlugin (const PluginDescription* desc, int x, int y)
 {
+    graph.getUndoManager().beginNewTransaction (T("Add Filter"));
     graph.addFilter (desc, x / (double) getWidth(), y / (double) getHeight());
 }
 
@@ -866,6 +901,9 @@ void GraphEditorPanel::updateComponents()
     {
         const AudioProcessorGraph::Connection* const c = graph.getConnection (i);
 
+        if (draggingConnector != 0 && isReplacedConnection (*c))
+            continue;
+
         if (getComponentForConnection (*c) == 0)
         {
             ConnectorComponent* const comp = new ConnectorComponent (graph);
@@ -877,6 +915,13 @@ void GraphEditorPanel::updateComponents()
     }
 }
 
+bool GraphEditorPanel::isReplacedConnection (const AudioProcessorGraph::Connection& c) const
+{
+    return replacedConnection.sourceNodeId != 0
+            && c.sourceNodeId == replacedConnection.sourceNodeId && c.sourceChannelIndex == replacedConnection.sourceChannelIndex
+            && c.destNodeId == replacedConnection.destNodeId && c.destChannelIndex == replacedConnection.destChannelIndex;
+}
+
 void GraphEditorPanel::beginConnectorDrag (const uint32 sourceFilterID, const int sourceFilterChannel,
                                            const uint32 destFilterID, const int destFilterChannel,
                                            const MouseEvent& e)
@@ -884,8 +929,18 @@ void GraphEditorPanel::beginConnectorDrag (const uint32 sourceFilterID, const in
     delete draggingConnector;
     draggingConnector = dynamic_cast <ConnectorComponent*> (e.originalComponent);
 
-    if (draggingConnector == 0)
+    // a connection that's picked up stays in the graph until it's dropped, so
+    // that taking it out and making its replacement are a single edit
+    if (draggingConnector != 0)
+        replacedConnection = AudioProcessorGraph::Connection (draggingConnector->sourceFilterID,
+                                                              draggingConnector->sourceFilterChannel,
+                                                              draggingConnector->destFilterID,
+                                                              draggingConnector->destFilterChannel);
+    else
+    {
+        replacedConnection.sourceNodeId = 0;
         draggingConnector = new ConnectorComponent (graph);
+    }
 
     draggingConnector->setInput (sourceFilterID, sourceFilterChannel);
     draggingConnector->setOutput (destFilterID, destFilterChannel);
@@ -959,29 +1014,45 @@ void GraphEditorPanel::endDraggingConnector (const MouseEvent& e)
 
     deleteAndZero (draggingConnector);
 
+    const AudioProcessorGraph::Connection replaced (replacedConnection);
+    replacedConnection.sourceNodeId = 0;
+
+    bool isConnecting = false;
     PinComponent* const pin = findPinAt (e2.x, e2.y);
 
     if (pin != 0)
     {
-        if (srcFilter == 0)
+        if (srcFilter == 0 && ! pin->isInput)
         {
-            if (pin->isInput)
-                return;
-
             srcFilter = pin->filterID;
             srcChannel = pin->index;
+            isConnecting = true;
         }
-        else
+        else if (dstFilter == 0 && pin->isInput)
         {
-            if (! pin->isInput)
-                return;
-
             dstFilter = pin->filterID;
             dstChannel = pin->index;
+            isConnecting = true;
         }
+    }
 
-        graph.addConnection (srcFilter, srcChannel, dstFilter, dstChannel);
+    const bool isUnchanged = isConnecting
+                              && replaced.sourceNodeId == srcFilter && replaced.sourceChannelIndex == srcChannel
+                              && replaced.destNodeId == dstFilter && replaced.destChannelIndex == dstChannel;
+    if (! isUnchanged)
+    {
+        graph.getUndoManager().beginNewTransaction (T("Connect"));
+
+        if (replaced.sourceNodeId != 0)
+            graph.removeConnection (replaced.sourceNodeId, replaced.sourceChannelIndex,
+                                    replaced.destNodeId, replaced.destChannelIndex);
+
+        if (isConnecting)
+            graph.addConnection (srcFilter, srcChannel, dstFilter, dstChannel);
     }
+
+    // puts back the connector that was picked up, if the connection's still there
+    updateComponents();
 }
 
 
@@ -1031,12 +1102,14 @@ private:
 
 //==============================================================================
 GraphDocumentComponent::GraphDocumentComponent (AudioDeviceManager* deviceManager_, AudioPlayHead* playHead = 0)
-    : deviceManager (deviceManager_)
+    : songSwitcher (graph),
+      deviceManager (deviceManager_)
 {
     addAndMakeVisible (graphPanel = new GraphEditorPanel (graph));
 
-    graphPlayer.setProcessor (&graph.getGraph());
 	graph.getGraph().setPlayHead(playHead);
+	songSwitcher.setPlayHead(playHead);
+    graphPlayer.setProcessor (&songSwitcher);
 
 	// TODO: make sure this is the proper sample rate
 	graphPlayer.getMidiMessageCollector().reset(44000);
@@ -1062,11 +1135,15 @@ GraphDocumentComponent::GraphDocumentComponent (AudioDeviceManager* deviceManage
 		MidiDeviceManager::getInstance()->addCallback(&graphPlayer);
 	}
 
+    deviceManager->addChangeListener (this);
+    changeListenerCallback (deviceManager);
+
     graphPanel->updateComponents();
 }
 
 GraphDocumentComponent::~GraphDocumentComponent()
 {
+    deviceManager->removeChangeListener (this);
     deviceManager->removeAudioCallback (&graphPlayer);	
     deleteAllChildren();
 
@@ -1086,6 +1163,24 @@ void GraphDocumentComponent::resized()
     keyboardComp->setBounds (0, getHeight() - keysHeight, getWidth(), keysHeight);
 }
 
+void GraphDocumentComponent::changeListenerCallback (ChangeBroadcaster*)
+{
+    AudioIODevice* const device = deviceManager->getCurrentAudioDevice();
+
+    if (device != 0)
+        graph.setDeviceLatency (device->getInputLatencyInSamples(),
+                                device->getOutputLatencyInSamples());
+    else
+        graph.setDeviceLatency (0, 0);
+
+    // have the remote-control dispatcher ready for any MIDI inputs that have been opened
+    const StringArray midiInDevices (MidiInput::getDevices());
+
+    for (int i = 0; i < midiInDevices.size(); ++i)
+        if (deviceManager->isMidiInputEnabled (midiInDevices[i]))
+            MidiRemoteControlDispatcher::getInstance()->addSource (midiInDevices[i]);
+}
+
 void GraphDocumentComponent::createNewPlugin (const PluginDescription* desc, int x, int y)
 {
     graphPanel->createNewPlugin (desc, x, y);
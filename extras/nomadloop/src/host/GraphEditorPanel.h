@@ -27,6 +27,7 @@
 #define __JUCE_FILTERGRAPHEDITOR_JUCEHEADER__
 
 #include "FilterGraph.h"
+#include "SongSwitcher.h"
 
 class FilterComponent;
 class ConnectorComponent;
@@ -70,6 +71,9 @@ public:
 private:
     FilterGraph& graph;
     ConnectorComponent* draggingConnector;
+    AudioProcessorGraph::Connection replacedConnection;
+
+    bool isReplacedConnection (const AudioProcessorGraph::Connection& c) const;
 
     GraphEditorPanel (const GraphEditorPanel&);
     const GraphEditorPanel& operator= (const GraphEditorPanel&);
@@ -82,7 +86,8 @@ private:
 
     It also manages the graph itself, and plays it.
 */
-class GraphDocumentComponent  : public Component
+class GraphDocumentComponent  : public Component,
+                                public ChangeListener
 {
 public:
     //==============================================================================
@@ -95,9 +100,15 @@ public:
     //==============================================================================
     FilterGraph graph;
 
+    /** Plays the graph, and holds the songs that have been loaded ready to follow it. */
+    SongSwitcher songSwitcher;
+
     //==============================================================================
     void resized();
 
+    /** Picks up the latency of the current audio device when it changes. */
+    void changeListenerCallback (ChangeBroadcaster*);
+
     //==============================================================================
     juce_UseDebuggingNewOperator
 
@@ -126,6 +137,9 @@ public:
 
     static void closeCurrentlyOpenWindowsFor (const uint32 nodeId);
 
+    /** Closes the windows of every filter in a particular graph. */
+    static void closeCurrentlyOpenWindowsFor (const AudioProcessorGraph& graph);
+
     static void closeAllCurrentlyOpenWindows();
 
     ~PluginWindow();
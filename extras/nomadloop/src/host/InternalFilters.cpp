@@ -30,6 +30,8 @@
 #include "../filters/UtilityFilters.h"
 #include "../filters/ChordSetter.h"
 #include "../filters/MidiUtilityFilter.h"
+#include "../filters/EqualiserFilters.h"
+#include "../filters/ReverbFilter.h"
 
 #if NOMAD_STATIC_LINK_PLUGINS
 #include "../../plugins/groovegrid/src/GrooveGridFilter.h"
@@ -95,6 +97,21 @@ InternalPluginFormat::InternalPluginFormat()
 		p.fillInPluginDescription(midiUtilityDesc);
 	}
 
+	{
+		Equaliser p;
+		p.fillInPluginDescription(equaliserDesc);
+	}
+
+	{
+		Crossover p;
+		p.fillInPluginDescription(crossoverDesc);
+	}
+
+	{
+		ReverbFilter p;
+		p.fillInPluginDescription(reverbDesc);
+	}
+
 
 #ifdef NOMAD_STATIC_LINK_PLUGINS
 	{
@@ -151,6 +168,18 @@ AudioPluginInstance* InternalPluginFormat::createInstanceFromDescription (const
 	{
 		return new MidiUtilityFilter();
 	}
+	else if (desc.name == equaliserDesc.name)
+	{
+		return new Equaliser();
+	}
+	else if (desc.name == crossoverDesc.name)
+	{
+		return new Crossover();
+	}
+	else if (desc.name == reverbDesc.name)
+	{
+		return new ReverbFilter();
+	}
 #ifdef NOMAD_STATIC_LINK_PLUGINS
 	else if (desc.name == grooveGridDesc.name)
 	{
@@ -187,6 +216,12 @@ const PluginDescription* InternalPluginFormat::getDescriptionFor (const Internal
 		return &chordSetterDesc;
 	case midiUtilityFilter:
 		return &midiUtilityDesc;
+	case equaliserFilter:
+		return &equaliserDesc;
+	case crossoverFilter:
+		return &crossoverDesc;
+	case reverbFilter:
+		return &reverbDesc;
 #ifdef NOMAD_STATIC_LINK_PLUGINS
 	case grooveGridFilter:
 		return &grooveGridDesc;
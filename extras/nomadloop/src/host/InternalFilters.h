@@ -59,6 +59,9 @@ public:
 		arpeggiatorFilter,
 		chordSetterFilter,
 		midiUtilityFilter,
+		equaliserFilter,
+		crossoverFilter,
+		reverbFilter,
 
 #ifdef NOMAD_STATIC_LINK_PLUGINS
 		grooveGridFilter,
@@ -96,6 +99,9 @@ private:
 	PluginDescription arpeggiatorDesc;
 	PluginDescription chordSetterDesc;
 	PluginDescription midiUtilityDesc;
+	PluginDescription equaliserDesc;
+	PluginDescription crossoverDesc;
+	PluginDescription reverbDesc;
 
 #ifdef NOMAD_STATIC_LINK_PLUGINS
 	PluginDescription grooveGridDesc;
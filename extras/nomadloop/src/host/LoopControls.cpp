@@ -62,6 +62,31 @@ void LoopComponent::mouseDown(const MouseEvent& e)
 		m.addItem(-2, T("Resize"));
 		m.addItem(-3, T("Delete"));
 		m.addSeparator();
+
+		AudioLoopProcessor* const audioLoop = dynamic_cast<AudioLoopProcessor*>(loop);
+		const double tempoScale = LoopManager::getInstance()->getTempoScale();
+		const int tempoPercentages[] = { 50, 75, 90, 100, 110, 125, 150, 200 };
+
+		PopupMenu tempoMenu;
+
+		for (int i = 0; i < numElementsInArray(tempoPercentages); ++i)
+			tempoMenu.addItem(-100 - i, String(tempoPercentages[i]) + T("%"), true, roundToInt(tempoScale * 100.0) == tempoPercentages[i]);
+
+		m.addSubMenu(T("Master tempo"), tempoMenu);
+
+		if (audioLoop != 0)
+		{
+			m.addItem(-4, T("Sync to master"), true, audioLoop->isSyncedToMaster());
+			m.addItem(-5, T("Keep pitch"), true, audioLoop->getStretchMode() == LoopStretcher::timeStretch);
+
+			PopupMenu qualityMenu;
+			qualityMenu.addItem(-10, T("Draft"), true, audioLoop->getStretchQuality() == LoopStretcher::draft);
+			qualityMenu.addItem(-11, T("Normal"), true, audioLoop->getStretchQuality() == LoopStretcher::normal);
+			qualityMenu.addItem(-12, T("High"), true, audioLoop->getStretchQuality() == LoopStretcher::high);
+			m.addSubMenu(T("Stretch quality"), qualityMenu);
+		}
+
+		m.addSeparator();
 		
 		GraphDocumentComponent* graphDoc = dynamic_cast<MainHostWindow*>(getTopLevelComponent())->getGraphEditor();
 
@@ -89,6 +114,23 @@ void LoopComponent::mouseDown(const MouseEvent& e)
 		{
 			delete this;
 		}
+		else if (choice == -4)
+		{
+			audioLoop->setSyncedToMaster(! audioLoop->isSyncedToMaster());
+		}
+		else if (choice == -5)
+		{
+			audioLoop->setStretchMode(audioLoop->getStretchMode() == LoopStretcher::timeStretch
+				? LoopStretcher::resample : LoopStretcher::timeStretch);
+		}
+		else if (choice <= -10 && choice >= -12)
+		{
+			audioLoop->setStretchQuality((LoopStretcher::Quality) (-10 - choice));
+		}
+		else if (choice <= -100)
+		{
+			LoopManager::getInstance()->setTempoScale(tempoPercentages[-100 - choice] / 100.0);
+		}
 	}
 }
 
@@ -0,0 +1,431 @@
+#include "LoopStretcher.h"
+
+#if JUCE_INTEL && (JUCE_64BIT || JUCE_MSVC || defined (__SSE__))
+ #define STRETCHER_USE_SSE 1
+ #include <xmmintrin.h>
+#endif
+
+namespace
+{
+	// grain length, search tolerance (both in ms) and search step for each quality
+	const int grainMs[] = { 20, 30, 40 };
+	const int toleranceMs[] = { 4, 8, 12 };
+	const int searchSteps[] = { 4, 2, 1 };
+
+	const int sincZeroCrossings = 16;
+
+	int wrapPosition(int position, int loopLength)
+	{
+		position %= loopLength;
+		return position < 0 ? position + loopLength : position;
+	}
+
+	double wrapPosition(double position, int loopLength)
+	{
+		position = fmod(position, (double) loopLength);
+		return position < 0 ? position + loopLength : position;
+	}
+
+#if STRETCHER_USE_SSE
+	float sumLanes(__m128 v)
+	{
+		float lanes[4];
+		_mm_storeu_ps(lanes, v);
+		return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	}
+#endif
+
+	// Works out the sum of a * b, and of b * b, which together say how well a
+	// candidate grain b carries on from a.
+	void correlate(const float* a, const float* b, int numSamples, float& cross, float& energy)
+	{
+		cross = energy = 0;
+
+#if STRETCHER_USE_SSE
+		__m128 crossLanes = _mm_setzero_ps();
+		__m128 energyLanes = _mm_setzero_ps();
+
+		for (; numSamples >= 4; numSamples -= 4, a += 4, b += 4)
+		{
+			const __m128 bv = _mm_loadu_ps(b);
+			crossLanes = _mm_add_ps(crossLanes, _mm_mul_ps(_mm_loadu_ps(a), bv));
+			energyLanes = _mm_add_ps(energyLanes, _mm_mul_ps(bv, bv));
+		}
+
+		cross = sumLanes(crossLanes);
+		energy = sumLanes(energyLanes);
+#endif
+
+		for (; --numSamples >= 0; ++a, ++b)
+		{
+			cross += *a * *b;
+			energy += *b * *b;
+		}
+	}
+
+	void addWindowed(float* dest, const float* source, const float* window, int numSamples)
+	{
+#if STRETCHER_USE_SSE
+		for (; numSamples >= 4; numSamples -= 4, dest += 4, source += 4, window += 4)
+			_mm_storeu_ps(dest, _mm_add_ps(_mm_loadu_ps(dest), _mm_mul_ps(_mm_loadu_ps(source), _mm_loadu_ps(window))));
+#endif
+
+		while (--numSamples >= 0)
+			*dest++ += *source++ * *window++;
+	}
+}
+
+LoopStretcher::LoopStretcher()
+	: sampleRate(0), maximumBlockSize(0), requestedQuality((int) normal), quality(normal),
+	  grainSize(0), hopSize(0), tolerance(0), searchStep(1),
+	  resampler(1, sincZeroCrossings, maximumRate), isResampling(false), resamplerReadPosition(0), resamplerPosition(0),
+	  isStarted(false), numReady(0), readyPosition(0), lastGrainPosition(0), nextGrainPosition(0)
+{
+}
+
+void LoopStretcher::prepare(double sampleRate_, int maximumBlockSize_)
+{
+	sampleRate = sampleRate_;
+	maximumBlockSize = jmax(1, maximumBlockSize_);
+
+	// room for the biggest grains and search
+	const int maxHopSize = jmax(16, roundToInt(sampleRate * grainMs[high] / 2000.0));
+	const int maxTolerance = roundToInt(sampleRate * toleranceMs[high] / 1000.0);
+
+	window.malloc(maxHopSize * 2);
+	accumulator.malloc(maxHopSize * 2);
+	searchBuffer.malloc(maxHopSize * 2 + maxTolerance * 2);
+	continuation.malloc(maxHopSize);
+	// enough for a block at the fastest rate, plus what the sinc filter needs to look ahead
+	const int maxInputBlockSize = maximumBlockSize * maximumRate + sincZeroCrossings * maximumRate * 4 + 16;
+	resampleBuffer.malloc(maxInputBlockSize);
+	resampler.prepare(maxInputBlockSize);
+
+	quality = requestedQuality.get();
+	configure();
+}
+
+void LoopStretcher::prepareResampler()
+{
+	const double rate = resamplerRate.get();
+
+	if (rate > 0)
+		resampler.prepareRatio(rate);
+}
+
+void LoopStretcher::setQuality(Quality newQuality)
+{
+	requestedQuality = jlimit((int) draft, (int) high, (int) newQuality);
+}
+
+void LoopStretcher::reset()
+{
+	isStarted = false;
+	isResampling = false;
+}
+
+void LoopStretcher::configure()
+{
+	hopSize = jmax(16, roundToInt(sampleRate * grainMs[quality] / 2000.0));
+	grainSize = hopSize * 2;
+	searchStep = searchSteps[quality];
+
+	// a whole number of steps either way, so that the first pass tries the nominal position
+	tolerance = roundToInt(sampleRate * toleranceMs[quality] / 1000.0) / searchStep * searchStep;
+
+	// a Hann window, which adds up to exactly one where two grains overlap by half
+	for (int i = 0; i < grainSize; ++i)
+		window[i] = (float) (0.5 - 0.5 * cos(2.0 * double_Pi * i / grainSize));
+
+	isStarted = false;
+	isResampling = false;
+}
+
+void LoopStretcher::process(const Source& source, int loopLength, double sourcePosition, double rate,
+	Mode mode, float* dest, int numSamples)
+{
+	if (loopLength <= 0 || maximumBlockSize == 0)
+	{
+		zeromem(dest, numSamples * sizeof(float));
+		return;
+	}
+
+	rate = jlimit(1.0 / maximumRate, (double) maximumRate, rate);
+
+	if (requestedQuality.get() != quality)
+	{
+		quality = requestedQuality.get();
+		configure();
+	}
+
+	if (mode == resample)
+	{
+		isStarted = false;
+
+		if (quality == high)
+		{
+			resampleWithSinc(source, loopLength, sourcePosition, rate, dest, numSamples);
+			return;
+		}
+
+		isResampling = false;
+
+		while (numSamples > 0)
+		{
+			const int num = jmin(numSamples, maximumBlockSize);
+			resampleBlock(source, loopLength, sourcePosition, rate, dest, num);
+
+			sourcePosition = wrapPosition(sourcePosition + num * rate, loopLength);
+			dest += num;
+			numSamples -= num;
+		}
+
+		return;
+	}
+
+	if (isStarted)
+	{
+		// Where the grains would have the output be now, compared to where it
+		// should be. Small differences come from rounding, or the rate changing,
+		// and are taken up by moving the next grain.
+		const int numLeft = numReady - readyPosition;
+		double drift = wrapPosition(sourcePosition - (nextGrainPosition - numLeft * rate), loopLength);
+
+		if (drift > loopLength * 0.5)
+			drift -= loopLength;
+
+		if (fabs(drift) > hopSize)
+			isStarted = false;
+		else
+			nextGrainPosition = wrapPosition(sourcePosition + numLeft * rate, loopLength);
+	}
+
+	isResampling = false;
+
+	if (! isStarted)
+		start(source, loopLength, sourcePosition, rate);
+
+	while (numSamples > 0)
+	{
+		if (readyPosition >= numReady)
+		{
+			addGrain(source, loopLength, nextGrainPosition, true);
+			nextGrainPosition = wrapPosition(nextGrainPosition + hopSize * rate, loopLength);
+		}
+
+		const int num = jmin(numSamples, numReady - readyPosition);
+		memcpy(dest, accumulator + readyPosition, num * sizeof(float));
+
+		readyPosition += num;
+		dest += num;
+		numSamples -= num;
+	}
+}
+
+void LoopStretcher::start(const Source& source, int loopLength, double sourcePosition, double rate)
+{
+	// The first grain is only there to fill in the half of the output that the
+	// next one overlaps, so that the output doesn't fade in.
+	zeromem(accumulator, grainSize * sizeof(float));
+	addGrain(source, loopLength, sourcePosition - hopSize * rate, false);
+
+	readyPosition = numReady;
+	nextGrainPosition = wrapPosition(sourcePosition, loopLength);
+	isStarted = true;
+}
+
+void LoopStretcher::addGrain(const Source& source, int loopLength, double nominalPosition, bool search)
+{
+	// the half that the last grain finished is no longer needed
+	memcpy(accumulator, accumulator + hopSize, hopSize * sizeof(float));
+	zeromem(accumulator + hopSize, hopSize * sizeof(float));
+
+	const int searchStart = roundToInt(nominalPosition) - tolerance;
+	source.readLoop(searchBuffer, wrapPosition(searchStart, loopLength), grainSize + tolerance * 2);
+
+	int offset = tolerance;
+
+	if (search)
+	{
+		// the loop as it would carry on from the last grain
+		source.readLoop(continuation, wrapPosition(lastGrainPosition + hopSize, loopLength), hopSize);
+		offset = findBestOffset();
+	}
+
+	addWindowed(accumulator, searchBuffer + offset, window, grainSize);
+
+	lastGrainPosition = wrapPosition(searchStart + offset, loopLength);
+	numReady = hopSize;
+	readyPosition = 0;
+}
+
+int LoopStretcher::findBestOffset() const
+{
+	// the nominal position wins a tie, so a loop at its own speed comes out unchanged
+	int best = tolerance;
+	float bestScore = getScore(best);
+
+	for (int offset = 0; offset <= tolerance * 2; offset += searchStep)
+	{
+		const float score = getScore(offset);
+
+		if (score > bestScore)
+		{
+			best = offset;
+			bestScore = score;
+		}
+	}
+
+	// then every position around the best of those
+	if (searchStep > 1)
+	{
+		const int centre = best;
+		const int end = jmin(tolerance * 2, centre + searchStep - 1);
+
+		for (int offset = jmax(0, centre - searchStep + 1); offset <= end; ++offset)
+		{
+			const float score = getScore(offset);
+
+			if (score > bestScore)
+			{
+				best = offset;
+				bestScore = score;
+			}
+		}
+	}
+
+	return best;
+}
+
+float LoopStretcher::getScore(int offset) const
+{
+	float cross, energy;
+	correlate(continuation, searchBuffer + offset, hopSize, cross, energy);
+
+	// normalised, so that a grain isn't picked just for being louder
+	return cross / sqrtf(energy + 1.0e-9f);
+}
+
+void LoopStretcher::resampleBlock(const Source& source, int loopLength, double sourcePosition, double rate,
+	float* dest, int numSamples)
+{
+	// the samples either side of every position that will be read
+	const int first = (int) floor(sourcePosition) - 1;
+	const int last = (int) floor(sourcePosition + (numSamples - 1) * rate) + 2;
+	const int numInput = last - first + 1;
+
+	source.readLoop(resampleBuffer, wrapPosition(first, loopLength), numInput);
+
+	const float* const input = resampleBuffer;
+	const double start = sourcePosition - first;
+
+	if (quality == draft)
+	{
+		for (int i = 0; i < numSamples; ++i)
+		{
+			const double x = start + i * rate;
+			const int index = (int) x;
+			const float frac = (float) (x - index);
+
+			dest[i] = input[index] + frac * (input[index + 1] - input[index]);
+		}
+
+		return;
+	}
+
+	// Catmull-Rom interpolation through the four samples around each position
+	int i = 0;
+
+#if STRETCHER_USE_SSE
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 oneAndHalf = _mm_set1_ps(1.5f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 twoAndHalf = _mm_set1_ps(2.5f);
+
+	for (; i + 4 <= numSamples; i += 4)
+	{
+		int index[4];
+		float frac[4];
+
+		for (int j = 0; j < 4; ++j)
+		{
+			const double x = start + (i + j) * rate;
+			index[j] = (int) x;
+			frac[j] = (float) (x - index[j]);
+		}
+
+		const __m128 y0 = _mm_setr_ps(input[index[0] - 1], input[index[1] - 1], input[index[2] - 1], input[index[3] - 1]);
+		const __m128 y1 = _mm_setr_ps(input[index[0]], input[index[1]], input[index[2]], input[index[3]]);
+		const __m128 y2 = _mm_setr_ps(input[index[0] + 1], input[index[1] + 1], input[index[2] + 1], input[index[3] + 1]);
+		const __m128 y3 = _mm_setr_ps(input[index[0] + 2], input[index[1] + 2], input[index[2] + 2], input[index[3] + 2]);
+		const __m128 f = _mm_loadu_ps(frac);
+
+		const __m128 c1 = _mm_mul_ps(half, _mm_sub_ps(y2, y0));
+		const __m128 c2 = _mm_sub_ps(_mm_add_ps(_mm_sub_ps(y0, _mm_mul_ps(twoAndHalf, y1)), _mm_mul_ps(two, y2)), _mm_mul_ps(half, y3));
+		const __m128 c3 = _mm_add_ps(_mm_mul_ps(half, _mm_sub_ps(y3, y0)), _mm_mul_ps(oneAndHalf, _mm_sub_ps(y1, y2)));
+
+		_mm_storeu_ps(dest + i, _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(c3, f), c2), f), c1), f), y1));
+	}
+#endif
+
+	for (; i < numSamples; ++i)
+	{
+		const double x = start + i * rate;
+		const int index = (int) x;
+		const float f = (float) (x - index);
+
+		const float y0 = input[index - 1], y1 = input[index], y2 = input[index + 1], y3 = input[index + 2];
+		const float c1 = 0.5f * (y2 - y0);
+		const float c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+		const float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+
+		dest[i] = ((c3 * f + c2) * f + c1) * f + y1;
+	}
+}
+
+void LoopStretcher::resampleWithSinc(const Source& source, int loopLength, double sourcePosition, double rate,
+	float* dest, int numSamples)
+{
+	if (isResampling)
+	{
+		// as with the grains, a block that doesn't carry on from the last one starts afresh
+		double drift = wrapPosition(sourcePosition - resamplerPosition, loopLength);
+
+		if (drift > loopLength * 0.5)
+			drift -= loopLength;
+
+		if (fabs(drift) > 1.0)
+			isResampling = false;
+	}
+
+	if (! isResampling)
+	{
+		// the resampler's output starts on a whole sample of the loop
+		resampler.reset();
+		resamplerReadPosition = wrapPosition((int) floor(sourcePosition), loopLength);
+		resamplerPosition = resamplerReadPosition;
+		isResampling = true;
+	}
+
+	resamplerRate = rate;
+	resampler.setRatio(rate);
+	resamplerPosition = wrapPosition(resamplerPosition + numSamples * rate, loopLength);
+
+	while (numSamples > 0)
+	{
+		const int numNeeded = jmin(resampler.getNumInputSamplesNeeded(numSamples), maximumBlockSize * maximumRate);
+
+		if (numNeeded > 0)
+		{
+			source.readLoop(resampleBuffer, resamplerReadPosition, numNeeded);
+
+			const float* input = resampleBuffer;
+			resampler.addInput(&input, numNeeded);
+			resamplerReadPosition = wrapPosition(resamplerReadPosition + numNeeded, loopLength);
+		}
+
+		const int num = resampler.readOutput(&dest, numSamples);
+		dest += num;
+		numSamples -= num;
+	}
+}
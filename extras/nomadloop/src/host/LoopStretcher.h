@@ -0,0 +1,115 @@
+#ifndef ADLER_LOOPSTRETCHER
+#define ADLER_LOOPSTRETCHER
+
+#include "../includes.h"
+
+// Plays a loop back faster or slower than it was recorded at, so that it can
+// follow a change of tempo or fit the length of the master loop.
+//
+// It can either resample the loop, which changes the pitch along with the
+// speed, or time-stretch it with WSOLA (waveform-similarity overlap-add), which
+// keeps the pitch. WSOLA builds the output from overlapping windowed grains of
+// the loop, each taken from about where the output has got to in it, but moved
+// by up to a few milliseconds to wherever it best carries on from the previous
+// grain. At the loop's own speed the grains line up exactly, so nothing changes.
+//
+// Everything is allocated in prepare(), so process() can run on the audio thread.
+class LoopStretcher
+{
+public:
+	// Where the stretcher reads the loop from.
+	class Source
+	{
+	public:
+		virtual ~Source() {}
+
+		// Fills dest with the loop from the given position on, wrapping round
+		// from its end to its start as many times as it takes.
+		virtual void readLoop(float* dest, int position, int numSamples) const = 0;
+	};
+
+	enum Mode
+	{
+		resample = 0,	// varispeed, like tape
+		timeStretch		// keeps the pitch
+	};
+
+	// Trades the sound against CPU. Draft interpolates linearly and only tries
+	// a few grain positions; high resamples with a windowed-sinc filter, which
+	// doesn't alias, and uses longer grains and searches every position.
+	enum Quality
+	{
+		draft = 0,
+		normal,
+		high
+	};
+
+	// the furthest either way from the loop's own speed that it can play
+	enum { maximumRate = 4 };
+
+	LoopStretcher();
+
+	void prepare(double sampleRate, int maximumBlockSize);
+
+	// This can be called from any thread; it takes effect at the next grain.
+	void setQuality(Quality newQuality);
+	Quality getQuality() const				{ return (Quality) requestedQuality.get(); }
+
+	// Renders numSamples of output, starting at sourcePosition in a loop of
+	// loopLength samples and moving through it by rate samples of loop for each
+	// sample of output. A block that starts about where the last one finished
+	// carries straight on from it; one that doesn't starts afresh.
+	void process(const Source& source, int loopLength, double sourcePosition, double rate,
+		Mode mode, float* dest, int numSamples);
+
+	// Makes the next block start afresh.
+	void reset();
+
+	// Builds the sinc filter for the rate that process() last resampled at, which
+	// takes too long for the audio thread, so this is called regularly from a
+	// background thread. Until it has been, the resampler makes do with the
+	// filter it had.
+	void prepareResampler();
+
+private:
+	double sampleRate;
+	int maximumBlockSize;
+
+	Atomic<int> requestedQuality;
+	int quality;
+
+	// the grain size, and the hop between grains in the output, which is half of it
+	int grainSize, hopSize;
+	int tolerance;		// how far a grain can move from where it would nominally go
+	int searchStep;		// positions tried on the first pass of the search
+
+	HeapBlock<float> window, accumulator, searchBuffer, continuation, resampleBuffer;
+
+	// the sinc resampler, which carries on from one block to the next like the grains do
+	PolyphaseResampler resampler;
+	Atomic<double> resamplerRate;	// set by the audio thread for prepareResampler()
+	bool isResampling;
+	int resamplerReadPosition;		// where the next input for it comes from
+	double resamplerPosition;		// where its next output sample falls in the loop
+
+	bool isStarted;
+	int numReady, readyPosition;	// samples at the start of the accumulator that are finished
+	int lastGrainPosition;
+	double nextGrainPosition;
+
+	void configure();
+	void start(const Source& source, int loopLength, double sourcePosition, double rate);
+	void addGrain(const Source& source, int loopLength, double nominalPosition, bool search);
+	int findBestOffset() const;
+	float getScore(int offset) const;
+
+	void resampleBlock(const Source& source, int loopLength, double sourcePosition, double rate,
+		float* dest, int numSamples);
+	void resampleWithSinc(const Source& source, int loopLength, double sourcePosition, double rate,
+		float* dest, int numSamples);
+
+	LoopStretcher(const LoopStretcher&);
+	LoopStretcher& operator= (const LoopStretcher&);
+};
+
+#endif
@@ -1,6 +1,12 @@
 #include "Looper.h"
 
+#if JUCE_INTEL && (JUCE_64BIT || JUCE_MSVC || defined (__SSE__))
+ #define LOOPER_USE_SSE 1
+ #include <xmmintrin.h>
+#endif
+
 LoopProcessor::LoopProcessor()
+: latencyCompensation(0)
 {
 }
 
@@ -8,12 +14,33 @@ LoopProcessor::~LoopProcessor()
 {
 }
 
+void LoopProcessor::setLatencyCompensation(int numSamples)
+{
+	latencyCompensation = jmax(0, numSamples);
+}
+
+int LoopProcessor::getLatencyCompensation() const
+{
+	return latencyCompensation.get();
+}
+
+bool LoopProcessor::isAtLoopStart() const
+{
+	// the scrub position needn't be a whole number of blocks, once a change of
+	// tempo has rescaled it, but it's always within a block of the start then
+	return getScrubPositionInSamples() < jmax(1, getBlockSize());
+}
+
 // ==========================
 
 MidiLoopProcessor::MidiLoopProcessor()
 : recordingCued(false), recording(false), sampleLength(0), sampleScrub(0)
 {
 	setPlayConfigDetails (1, 1, 0, 0);
+	zeromem(noteIsHeld, sizeof(noteIsHeld));
+
+	sequence.ensureSize(recordingReserve);
+	compensationScratch.ensureSize(recordingReserve);
 }
 
 void MidiLoopProcessor::fillInPluginDescription(PluginDescription &looperDesc) const
@@ -31,64 +58,55 @@ void MidiLoopProcessor::fillInPluginDescription(PluginDescription &looperDesc) c
 	looperDesc.numOutputChannels = 0;
 }
 
-// TODO: this is disgustingly inefficient, and furthermore only works for one-note-per-channel
-// sequences, a la MIDI guitar.  FIX IT!
-void MidiLoopProcessor::drawContent(Graphics &g, int width, int height) const
+namespace
 {
-	MidiBuffer::Iterator itor(sequence);
-	MidiMessage message(0x80, 1, 1);
-	int samplePosition = 0;
-
-	// for now, we limit ourselves to one note per channel... guitar input!
-	bool channelsOn[16] = {0};
-	int channelsNote[16] = {0};
-	int channelsBend[16] = {0};
-	double lastDrawTime = 0.0;
-
-	Colour colours[6] = {Colours::white, Colours::blue, Colours::purple, Colours::orange, Colours::yellow, Colours::lightgreen};
+	// MIDI guitars send each string on its own channel, with a 12 semitone bend range
+	const float loopPitchBendRange = 12.0f;
 
-	while (itor.getNextEvent(message, samplePosition))
+	// Draws each stretch of a voice's pitch as it's tracked through the sequence
+	class PitchTrajectoryPainter : public MidiVoiceTracker::Listener
 	{
-		if (message.isNoteOn())
+		Graphics& g;
+		const float xScale, height;
+
+	public:
+		PitchTrajectoryPainter(Graphics& g_, int width, int height_, int lengthInSamples)
+		: g(g_), xScale(width / (float) jmax(1, lengthInSamples)), height((float) height_)
 		{
-			channelsOn[message.getChannel()-1] = true;
-			channelsNote[message.getChannel()-1] = message.getNoteNumber();
-		}
-		else if (message.isNoteOff())
-		{			
-			for (int c=0; c<16; ++c)
-			{
-				if (channelsOn[c])
-				{
-					g.setColour(colours[c%6]);
-					g.drawLine(
-						(width*lastDrawTime)/getLengthInSamples(),
-						height*(1.0f-(channelsNote[c] + (channelsBend[c])/(8192.0f/12))/128.0f),
-						(width*message.getTimeStamp())/getLengthInSamples(),
-						height*(1.0f-(channelsNote[c] + (channelsBend[c])/(8192.0f/12))/128.0f)
-						);
-				}
-			}
-			channelsOn[message.getChannel()-1] = false;
 		}
-		else if (message.isPitchWheel())
+
+		void voicePitchSegmentEnded(const MidiVoiceTracker::Voice& voice, float pitch, double endTime)
 		{
-			for (int c=0; c<16; ++c)
-			{
-				if (channelsOn[c])
-				{
-					g.setColour(colours[c%6]);
-					g.drawLine(
-						(width*lastDrawTime)/getLengthInSamples(),
-						height*(1.0f-(channelsNote[c] + (channelsBend[c])/(8192.0f/12))/128.0f),
-						(width*message.getTimeStamp())/getLengthInSamples(),
-						height*(1.0f-(channelsNote[c] + (channelsBend[c])/(8192.0f/12))/128.0f)
-						);
-				}
-			}
-			channelsBend[message.getChannel()-1] = message.getPitchWheelValue();			
+			static const Colour colours[6] = {Colours::white, Colours::blue, Colours::purple, Colours::orange, Colours::yellow, Colours::lightgreen};
+
+			const float y = height*(1.0f - pitch/128.0f);
+
+			g.setColour(colours[(voice.channel-1)%6]);
+			g.drawLine((float) (voice.segmentStartTime*xScale), y, (float) (endTime*xScale), y);
 		}
-		lastDrawTime = message.getTimeStamp();
+	};
+}
+
+void MidiLoopProcessor::drawContent(Graphics &g, int width, int height) const
+{
+	PitchTrajectoryPainter painter(g, width, height, getLengthInSamples());
+
+	MidiVoiceTracker tracker;
+	tracker.setPitchBendRangeForAllChannels(loopPitchBendRange);
+	tracker.setListener(&painter);
+
+	MidiBuffer::Iterator itor(sequence);
+	const uint8* data;
+	int numBytes, samplePosition;
+
+	while (itor.getNextEvent(data, numBytes, samplePosition))
+		tracker.processEvent(data, numBytes, samplePosition);
+
+	// notes still held at the end of the loop carry on up to it
+	for (int i = tracker.getNumVoices(); --i >= 0;)
+	{
+		const MidiVoiceTracker::Voice& voice = tracker.getVoice(i);
+		painter.voicePitchSegmentEnded(voice, tracker.getBentPitch(voice), getLengthInSamples());
 	}
 }
 
@@ -109,6 +127,7 @@ void MidiLoopProcessor::releaseResources()
 void MidiLoopProcessor::processBlock(AudioSampleBuffer& sampleBuffer, MidiBuffer& midiBuffer)
 {
 	LoopProcessor* masterLoop = LoopManager::getInstance()->getMasterLoop();
+	const bool wasRecording = recording;
 
 	if (recording != recordingCued)
 	{
@@ -125,16 +144,20 @@ void MidiLoopProcessor::processBlock(AudioSampleBuffer& sampleBuffer, MidiBuffer
 				estimatedKey = a.getKey();
 			}
 		}
-		else if (masterLoop == this || masterLoop->getScrubPositionInSamples() == 0)
+		else if (masterLoop == this || masterLoop->isAtLoopStart())
 			recording = recordingCued;
 		
 	}
 
+	if (wasRecording && !recording)
+	{
+		endHeldNotes();
+		compensateRecordedSequence();
+	}
+
 	if (recording)
 	{
-		// TODO: stick midi buffer data into the loop buffer here
-		this->sequence.addEvents(midiBuffer, 0, sampleBuffer.getNumSamples(), this->sampleLength);
-		sampleLength += sampleBuffer.getNumSamples();
+		recordEvents(midiBuffer, sampleBuffer.getNumSamples());
 	}
 	else if (sampleLength > 0)
 	{
@@ -244,6 +267,7 @@ void MidiLoopProcessor::setParameter(int index, float value)
 			sampleLength = 0;
 			sampleScrub = 0;
 			sequence.clear();
+			zeromem(noteIsHeld, sizeof(noteIsHeld));
 		}
 		recordingCued = (value >= 0.5f);
 	}
@@ -288,6 +312,70 @@ void MidiLoopProcessor::setStateInformation(const void *, int)
 {
 }
 
+void MidiLoopProcessor::recordEvents(const MidiBuffer& input, int numSamples)
+{
+	MidiBuffer::Iterator itor(input);
+	const uint8* data;
+	int numBytes, samplePosition;
+
+	while (itor.getNextEvent(data, numBytes, samplePosition))
+	{
+		if (samplePosition >= numSamples)
+			break;
+
+		const int status = data[0] & 0xf0;
+
+		if (numBytes >= 3 && (status == 0x90 || status == 0x80))
+			noteIsHeld[data[0] & 0x0f][data[1] & 0x7f] = (status == 0x90 && data[2] != 0);
+
+		sequence.addEvent(data, numBytes, sampleLength + samplePosition);
+	}
+
+	sampleLength += numSamples;
+}
+
+void MidiLoopProcessor::endHeldNotes()
+{
+	if (sampleLength <= 0)
+		return;
+
+	for (int channel = 0; channel < 16; ++channel)
+	{
+		for (int note = 0; note < 128; ++note)
+		{
+			if (noteIsHeld[channel][note])
+			{
+				const uint8 noteOff[3] = { (uint8) (0x80 | channel), (uint8) note, 0 };
+				sequence.addEvent(noteOff, 3, sampleLength - 1);
+				noteIsHeld[channel][note] = false;
+			}
+		}
+	}
+}
+
+void MidiLoopProcessor::compensateRecordedSequence()
+{
+	if (sampleLength <= 0)
+		return;
+
+	const int offset = latencyCompensation.get() % sampleLength;
+
+	if (offset > 0)
+	{
+		// the scratch buffer has the same space set aside as the sequence, and
+		// swapping them over keeps it that way for the next take
+		compensationScratch.clear();
+		compensationScratch.addEvents(sequence, offset, -1, -offset);
+		compensationScratch.addEvents(sequence, 0, offset, sampleLength - offset);
+		sequence.swapWith(compensationScratch);
+	}
+}
+
+bool MidiLoopProcessor::recordsAudio() const
+{
+	return false;
+}
+
 int MidiLoopProcessor::getLengthInSamples() const
 {
 	return sampleLength;
@@ -308,97 +396,191 @@ double MidiLoopProcessor::getScrubPositionInSeconds() const
 	return sampleScrub / getSampleRate();
 }
 
-struct MidiEngineInfo
-{
-	// for now, we limit ourselves to one note per channel... guitar input!
-	bool channelsOn[16];
-	int channelsNote[16];
-	int channelsBend[16];
-
-
-	MidiEngineInfo()
-	{
-		zeromem(&channelsOn, sizeof(channelsOn));
-		zeromem(&channelsNote, sizeof(channelsNote));
-		zeromem(&channelsBend, sizeof(channelsBend));
-	}
-
-		// same contract as MidiBuffer::Iterator::getNextEvent, but
-	// stores some stateful information
-	bool readNextMidiMessage(MidiBuffer::Iterator& itor, MidiMessage& msg, int& samplePos)
-	{
-		bool ret = itor.getNextEvent(msg, samplePos);
-		if (ret)
-		{
-			if (msg.isNoteOn())
-			{
-				channelsNote[msg.getChannel()-1] = msg.getNoteNumber();
-				channelsOn[msg.getChannel()-1] = true;
-			}
-			else if (msg.isNoteOff())
-			{
-				channelsOn[msg.getChannel()-1] = false;
-			}
-			else if (msg.isPitchWheel())
-			{
-				channelsBend[msg.getChannel()-1] = msg.getPitchWheelValue();
-			}
-		}
-
-		return ret;
-	}
-
-	int getBentPitch(MidiMessage& msg)
-	{
-		return msg.getNoteNumber() + channelsBend[msg.getChannel()-1]*(8192.0/12);
-	}
-};
-
 // Generates a processed copy of the recorded buffer,
 // making use of only the notes enabled in the keymap
 void MidiLoopProcessor::regenerateAlteredSequence()
 {
 	MidiBuffer::Iterator itor(sequence);
-	MidiMessage message(0x80, 1, 1);
-	int samplePosition = 0;
+	const uint8* data;
+	int numBytes, samplePosition = 0;
 
-	MidiEngineInfo info;
-	double lastDrawTime = 0.0;
+	MidiVoiceTracker tracker;
+	tracker.setPitchBendRangeForAllChannels(loopPitchBendRange);
 
 	// we'll overwrite this with processed copies from the recorded
 	// buffer
 	alteredSequence.ensureSize (sequence.getNumEvents());
 
-	do
+	while (itor.getNextEvent(data, numBytes, samplePosition))
 	{
+		tracker.processEvent(data, numBytes, samplePosition);
+
 		// Find first MIDI note-on
-		while (info.readNextMidiMessage(itor, message, samplePosition) && !message.isNoteOn());
+		if (numBytes < 3 || (data[0] & 0xf0) != 0x90 || data[2] == 0)
+			continue;
 
 		// A MIDI fragment consists of an area between consecutive
 		// pitches which potentially needs to be scaled.  For instance,
 		// a glissando between two notes in the input should yield a
 		// similarly distributed glissando between the output notes
-		int startPitch = info.getBentPitch(message);
+		const int channel = (data[0] & 0x0f) + 1;
+		const int note = data[1];
+		const float startPitch = tracker.getBentPitch(channel, note);
 
 		// Find the spot when the note becomes a different pitch
 		// based on bending
-		while (info.readNextMidiMessage(itor, message, samplePosition) && !message.isNoteOff() && info.getBentPitch(message) == startPitch);
+		while (itor.getNextEvent(data, numBytes, samplePosition))
+		{
+			tracker.processEvent(data, numBytes, samplePosition);
+
+			if (tracker.findVoice(channel, note) == nullptr || tracker.getBentPitch(channel, note) != startPitch)
+				break;
+		}
 
 		// Now find the spot where either another pitch is reached
 		// or the bending tapers off (i.e., dPitchBend = 0)
-		
-	} while (info.readNextMidiMessage(itor, message, samplePosition));
-
+	}
 }
 
 
 
 // ==========================
 
+// Adds a run of samples onto another, which is how the layers are mixed down.
+static void addSamples(float* dest, const float* source, int numSamples)
+{
+#if LOOPER_USE_SSE
+	for (; numSamples >= 8; numSamples -= 8, dest += 8, source += 8)
+	{
+		_mm_storeu_ps(dest, _mm_add_ps(_mm_loadu_ps(dest), _mm_loadu_ps(source)));
+		_mm_storeu_ps(dest + 4, _mm_add_ps(_mm_loadu_ps(dest + 4), _mm_loadu_ps(source + 4)));
+	}
+#endif
+
+	while (--numSamples >= 0)
+		*dest++ += *source++;
+}
+
+struct AudioLoopProcessor::LayerBlock
+{
+	LayerBlock() : next(0)
+	{
+		zeromem(samples, sizeof(samples));
+	}
+
+	LayerBlock* next;	// while it's spare
+	float samples[layerBlockSize];
+};
+
+// The blocks of the loop that one overdub pass wrote to; the others are null.
+class AudioLoopProcessor::Layer
+{
+public:
+	Layer(int numBlocks_)
+		: numBlocks(numBlocks_), numMergedLayers(0), generation(0), nextRetired(0)
+	{
+		blocks.calloc(numBlocks);
+	}
+
+	const int numBlocks;
+	HeapBlock<LayerBlock*> blocks;
+
+	// for a layer made by merging others, how many it replaces, and which
+	// take they belonged to
+	int numMergedLayers, generation;
+
+	Layer* nextRetired;
+};
+
+// Looks after the layers of all the loopers in the background, and builds the
+// filters that their stretchers resample with.
+class LoopLayerMaintainer : public Thread, public DeletedAtShutdown
+{
+public:
+	LoopLayerMaintainer()
+		: Thread("Loop layers")
+	{
+		startThread(3);
+	}
+
+	~LoopLayerMaintainer()
+	{
+		stopThread(2000);
+		clearSingletonInstance();
+	}
+
+	void add(AudioLoopProcessor* looper)
+	{
+		const ScopedLock sl(lock);
+		loopers.add(looper);
+	}
+
+	// once this returns, the looper won't be touched again
+	void remove(AudioLoopProcessor* looper)
+	{
+		const ScopedLock sl(lock);
+		loopers.removeValue(looper);
+	}
+
+	void run()
+	{
+		while (! threadShouldExit())
+		{
+			{
+				const ScopedLock sl(lock);
+
+				for (int i = 0; i < loopers.size(); ++i)
+					loopers.getUnchecked(i)->maintainLayers();
+			}
+
+			wait(50);
+		}
+	}
+
+	juce_DeclareSingleton (LoopLayerMaintainer, false)
+
+private:
+	CriticalSection lock;
+	Array<AudioLoopProcessor*> loopers;
+};
+
+juce_ImplementSingleton (LoopLayerMaintainer)
+
 AudioLoopProcessor::AudioLoopProcessor()
-: /*recordingCued(false), recording(false),*/ cuedState(Paused), state(Paused), sampleScrub(0)
+: /*recordingCued(false), recording(false),*/ cuedState(Paused), state(Paused), sampleScrub(0), playOffset(0),
+  numLayers(0), numAudibleLayers(0), numSettledLayers(0), writingLayer(0), generation(0),
+  overdubInput(1, 1), layerMemoryLimit(32 * 1024 * 1024),
+  syncedToMaster(false), stretchMode(LoopStretcher::timeStretch), playbackLength(0), exactPlaybackLength(0), recordedTempoScale(1.0)
 {
 	setPlayConfigDetails (1, 1, 0, 0);
+	LoopLayerMaintainer::getInstance()->add(this);
+}
+
+AudioLoopProcessor::~AudioLoopProcessor()
+{
+	LoopLayerMaintainer* const maintainer = LoopLayerMaintainer::getInstanceWithoutCreating();
+
+	if (maintainer != 0)
+		maintainer->remove(this);
+
+	clearLayers();
+	retire(spareLayer.exchange(0));
+	retire(pendingMerge.exchange(0));
+
+	for (Layer* layer = retiredLayers.exchange(0); layer != 0;)
+	{
+		Layer* const next = layer->nextRetired;
+		numSpareBlocks = 1 << 30;	// so that the blocks are deleted rather than kept
+		recycle(layer);
+		layer = next;
+	}
+
+	for (LayerBlock* block = spareBlocks.exchange(0); block != 0;)
+	{
+		LayerBlock* const next = block->next;
+		delete block;
+		block = next;
+	}
 }
 
 void AudioLoopProcessor::fillInPluginDescription(PluginDescription &looperDesc) const
@@ -424,6 +606,8 @@ const String AudioLoopProcessor::getName() const
 void AudioLoopProcessor::prepareToPlay(double sampleRate, int estimatedSamplesPerBlock)
 {
 	setPlayConfigDetails (1, 1, sampleRate, estimatedSamplesPerBlock);
+	overdubInput.setSize(1, jmax(1, estimatedSamplesPerBlock));
+	stretcher.prepare(sampleRate, estimatedSamplesPerBlock);
 }
 
 void AudioLoopProcessor::releaseResources()
@@ -433,6 +617,7 @@ void AudioLoopProcessor::releaseResources()
 void AudioLoopProcessor::processBlock(AudioSampleBuffer& sampleBuffer, MidiBuffer& midiBuffer)
 {
 	LoopProcessor* masterLoop = LoopManager::getInstance()->getMasterLoop();
+	const LoopState previousState = state;
 
 	if (state != cuedState)
 	{
@@ -446,10 +631,50 @@ void AudioLoopProcessor::processBlock(AudioSampleBuffer& sampleBuffer, MidiBuffe
 				LoopManager::getInstance()->setMasterLoop(this);
 			}
 		}
-		else if (masterLoop == this || masterLoop->getScrubPositionInSamples() == 0)
+		else if (masterLoop == this || masterLoop->isAtLoopStart())
 			state = cuedState;
 	}
 
+	if (state == Recording && previousState != Recording)
+	{
+		// a new take starts from nothing
+		sampleData.clear();
+		clearLayers();
+		sampleScrub = 0;
+		playOffset = 0;
+		publishedLength = 0;
+		playbackLength = 0;
+		exactPlaybackLength = 0;
+		numDroppedOverdubSamples = 0;
+		stretcher.reset();
+	}
+
+	if (previousState == Recording && state != Recording && !sampleData.empty())
+	{
+		// what we just recorded arrived late by the round-trip latency, so
+		// play it back that much further along
+		playOffset = latencyCompensation.get() % sampleData.size();
+		publishedLength = (int) sampleData.size();
+		recordedTempoScale = LoopManager::getInstance()->getTempoScale();
+	}
+
+	if (previousState == Overdubbing && state != Overdubbing)
+		endOverdubPass();
+
+	takePendingMerge();
+	applyUndoRequests();
+
+	if (state != Recording && !sampleData.empty())
+		updatePlaybackLength();
+
+	// overdubs are only taken while the loop plays at its own speed
+	if (writingLayer != 0 && isStretched())
+		endOverdubPass();
+
+	// a pass that's waiting for a layer to be made ready starts as soon as there is one
+	if (state == Overdubbing && writingLayer == 0 && ! isStretched())
+		beginOverdubPass();
+
 	if (state == Recording)
 	{
 		for (int i=0; i<sampleBuffer.getNumSamples(); ++i)
@@ -460,58 +685,483 @@ void AudioLoopProcessor::processBlock(AudioSampleBuffer& sampleBuffer, MidiBuffe
 	}
 	else if (!sampleData.empty())
 	{
-		// playing back
-		int samplesToCopy = sampleBuffer.getNumSamples();
-		int destStartSample = 0;
+		// playing back, adding the input to the pass's layer when overdubbing.  The
+		// input is written behind the playback position by the latency compensation,
+		// so that it lands where the material the player heard was.
+		const int loopLength = sampleData.size();
+		const int numSamples = sampleBuffer.getNumSamples();
+		float* const data = sampleBuffer.getSampleData(0);
+
+		if (isStretched())
+		{
+			// the scrub position counts samples of output, so it's scaled into the loop
+			const double rate = loopLength / (double) playbackLength;
+			const double readPos = fmod(sampleScrub * rate + playOffset, (double) loopLength);
 
-		while (samplesToCopy > 0)
-		{	
-			int samplesLeftInLoop = sampleData.size() - sampleScrub;
-			if (samplesToCopy <= samplesLeftInLoop)
-			{
-				if (state == Overdubbing)
-				{
-					// first, sum the input to the buffer
-					AudioSampleBuffer sumBuffer(sampleBuffer);
-					sumBuffer.addFrom(0, destStartSample, &sampleData[sampleScrub], samplesToCopy);
-					sampleBuffer.copyFrom(0, destStartSample, &sampleData[sampleScrub], samplesToCopy);
-					float* ds = &sampleData[sampleScrub];
-					AudioSampleBuffer dataStoreBuffer(&ds, 1, samplesToCopy);
-					dataStoreBuffer.copyFrom(0, 0, sumBuffer, 0, 0, samplesToCopy);
-				}
-				else
-				{
-					sampleBuffer.copyFrom(0, destStartSample, &sampleData[sampleScrub], samplesToCopy);
-				}
-				sampleScrub += samplesToCopy;
-				samplesToCopy = 0;
-			}
-			else
+			stretcher.process(*this, loopLength, readPos, rate, stretchMode, data, numSamples);
+		}
+		else
+		{
+			const int readPos = (sampleScrub + playOffset) % loopLength;
+			const int writePos = (readPos + loopLength - latencyCompensation.get() % loopLength) % loopLength;
+
+			// the output replaces the input, so it has to be kept until it's written
+			if (writingLayer != 0)
 			{
-				if (state == Overdubbing)
-				{
-					AudioSampleBuffer sumBuffer(sampleBuffer);
-					sumBuffer.addFrom(0, destStartSample, &sampleData[sampleScrub], samplesLeftInLoop);
-					sampleBuffer.copyFrom(0, destStartSample, &sampleData[sampleScrub], samplesLeftInLoop);
-					float* ds = &sampleData[sampleScrub];
-					AudioSampleBuffer dataStoreBuffer(&ds, 1, samplesLeftInLoop);
-					dataStoreBuffer.copyFrom(0, 0, sumBuffer, 0, 0, samplesLeftInLoop);
-				}
-				else
-				{
-					sampleBuffer.copyFrom(0, destStartSample, &sampleData[sampleScrub], samplesLeftInLoop);				
-				}
-				sampleScrub = 0;  // reset to beginning of loop
-				destStartSample += samplesLeftInLoop;
+				overdubInput.setSize(1, numSamples, false, false, true);
+				overdubInput.copyFrom(0, 0, sampleBuffer, 0, 0, numSamples);
 			}
 
-			sampleScrub = sampleScrub % sampleData.size();
+			mixLayers(data, readPos, numSamples);
+
+			if (writingLayer != 0)
+				overdub(overdubInput.getSampleData(0), writePos, numSamples);
 		}
+
+		sampleScrub = (sampleScrub + numSamples) % playbackLength;
 	}
 	else
 	{
 		sampleBuffer.clear();
 	}
+
+	publishLayers();
+}
+
+// ==========================
+
+int AudioLoopProcessor::getNumBlocksFor(int numSamples)
+{
+	return (numSamples + layerBlockSize - 1) / layerBlockSize;
+}
+
+void AudioLoopProcessor::beginOverdubPass()
+{
+	if (sampleData.empty())
+		return;
+
+	// a new pass replaces any that were undone
+	while (numLayers > numAudibleLayers)
+		retire(layers[--numLayers]);
+
+	if (numLayers < maxNumLayers)
+	{
+		Layer* const layer = spareLayer.exchange(0);
+
+		if (layer == 0)
+			return;
+
+		if (layer->numBlocks != getNumBlocksFor(sampleData.size()))
+		{
+			retire(layer);
+			return;
+		}
+
+		layers[numLayers++] = layer;
+		numAudibleLayers = numLayers;
+		writingLayer = layer;
+	}
+	else if (numAudibleLayers > numSettledLayers)
+	{
+		// with no room for another layer, the pass carries on in the last one
+		writingLayer = layers[numAudibleLayers - 1];
+	}
+
+	numSettledLayers = jmax(numSettledLayers, numAudibleLayers - maxUndoDepth);
+}
+
+void AudioLoopProcessor::endOverdubPass()
+{
+	writingLayer = 0;
+	numSettledLayers = jmax(numSettledLayers, numAudibleLayers - maxUndoDepth);
+}
+
+void AudioLoopProcessor::applyUndoRequests()
+{
+	const int numUndos = undoRequests.exchange(0);
+
+	if (numUndos == 0)
+		return;
+
+	// undoing during a pass drops what it's written so far
+	if (numUndos > 0 && writingLayer != 0)
+		endOverdubPass();
+
+	numAudibleLayers = jlimit(numSettledLayers, numLayers, numAudibleLayers - numUndos);
+}
+
+void AudioLoopProcessor::takePendingMerge()
+{
+	Layer* const merged = pendingMerge.exchange(0);
+
+	if (merged == 0)
+		return;
+
+	const int numMerged = merged->numMergedLayers;
+
+	// the layers it was made from may have gone with a new recording
+	if (merged->generation != generation || numMerged < 2 || numMerged > numSettledLayers)
+	{
+		retire(merged);
+	}
+	else
+	{
+		for (int i = 0; i < numMerged; ++i)
+			retire(layers[i]);
+
+		layers[0] = merged;
+
+		for (int i = numMerged; i < numLayers; ++i)
+			layers[i - numMerged + 1] = layers[i];
+
+		numLayers -= numMerged - 1;
+		numAudibleLayers -= numMerged - 1;
+		numSettledLayers -= numMerged - 1;
+	}
+
+	mergeInProgress = 0;
+}
+
+void AudioLoopProcessor::clearLayers()
+{
+	while (numLayers > 0)
+		retire(layers[--numLayers]);
+
+	numAudibleLayers = numSettledLayers = 0;
+	writingLayer = 0;
+	++generation;
+}
+
+void AudioLoopProcessor::retire(Layer* layer)
+{
+	if (layer == 0)
+		return;
+
+	// only the audio thread pushes, and the background thread takes the whole list at once
+	do
+	{
+		layer->nextRetired = retiredLayers.get();
+	}
+	while (! retiredLayers.compareAndSetBool(layer, layer->nextRetired));
+}
+
+AudioLoopProcessor::LayerBlock* AudioLoopProcessor::takeSpareBlock()
+{
+	// this is the only thread that takes blocks, so the head can't be taken and
+	// put back between reading it and swapping it for the next one
+	LayerBlock* block;
+
+	do
+	{
+		block = spareBlocks.get();
+
+		if (block == 0)
+			return 0;
+	}
+	while (! spareBlocks.compareAndSetBool(block->next, block));
+
+	--numSpareBlocks;
+	++numBlocksInUse;
+	block->next = 0;
+	return block;
+}
+
+void AudioLoopProcessor::mixLayers(float* dest, int position, int numSamples) const
+{
+	const int loopLength = sampleData.size();
+
+	while (numSamples > 0)
+	{
+		const int blockIndex = position / layerBlockSize;
+		const int offset = position % layerBlockSize;
+		const int num = jmin(numSamples, layerBlockSize - offset, loopLength - position);
+
+		memcpy(dest, &sampleData[position], num * sizeof(float));
+
+		for (int i = 0; i < numAudibleLayers; ++i)
+		{
+			const LayerBlock* const block = layers[i]->blocks[blockIndex];
+
+			if (block != 0)
+				addSamples(dest, block->samples + offset, num);
+		}
+
+		dest += num;
+		numSamples -= num;
+		position += num;
+
+		if (position >= loopLength)
+			position = 0;
+	}
+}
+
+void AudioLoopProcessor::overdub(const float* input, int position, int numSamples)
+{
+	const int loopLength = sampleData.size();
+
+	while (numSamples > 0)
+	{
+		const int blockIndex = position / layerBlockSize;
+		const int offset = position % layerBlockSize;
+		const int num = jmin(numSamples, layerBlockSize - offset, loopLength - position);
+
+		LayerBlock*& block = writingLayer->blocks[blockIndex];
+
+		if (block == 0)
+			block = takeSpareBlock();
+
+		// if the background thread hasn't kept up, this bit of the pass is lost
+		if (block != 0)
+			addSamples(block->samples + offset, input, num);
+		else
+			numDroppedOverdubSamples += num;
+
+		input += num;
+		numSamples -= num;
+		position += num;
+
+		if (position >= loopLength)
+			position = 0;
+	}
+}
+
+void AudioLoopProcessor::updatePlaybackLength()
+{
+	const int loopLength = sampleData.size();
+	LoopProcessor* const masterLoop = LoopManager::getInstance()->getMasterLoop();
+	int newLength;
+
+	if (syncedToMaster && masterLoop != 0 && masterLoop != this && masterLoop->getLengthInSamples() > 0)
+	{
+		const int masterLength = masterLoop->getLengthInSamples();
+		const int power = roundToInt(log(loopLength / (double) masterLength) / log(2.0));
+
+		newLength = jmax(1, roundToInt(ldexp((double) masterLength, power)));
+		exactPlaybackLength = newLength;
+	}
+	else
+	{
+		const double tempoScale = LoopManager::getInstance()->getTempoScale();
+		exactPlaybackLength = loopLength * recordedTempoScale / tempoScale;
+
+		if (masterLoop != 0 && masterLoop != this && masterLoop->getLengthInSamples() > 0)
+		{
+			// scaled by however much the master's length was rounded, rather than
+			// rounded separately, so that the two don't drift apart
+			newLength = jmax(1, roundToInt(exactPlaybackLength * masterLoop->getLengthInSamples()
+												/ masterLoop->getExactLengthInSamples()));
+		}
+		else if (tempoScale == recordedTempoScale)
+		{
+			newLength = loopLength;
+		}
+		else
+		{
+			// kept to a whole number of blocks, so that loops cued against this one
+			// still see it come round to the start
+			const int blockSize = jmax(1, getBlockSize());
+			newLength = jmax(1, roundToInt(exactPlaybackLength / blockSize)) * blockSize;
+		}
+	}
+
+	if (newLength != playbackLength)
+	{
+		// carry on from the same point in the loop
+		if (playbackLength > 0)
+			sampleScrub = (int) ((int64) sampleScrub * newLength / playbackLength);
+
+		playbackLength = newLength;
+	}
+}
+
+bool AudioLoopProcessor::isStretched() const
+{
+	return playbackLength > 0 && playbackLength != (int) sampleData.size();
+}
+
+void AudioLoopProcessor::readLoop(float* dest, int position, int numSamples) const
+{
+	mixLayers(dest, position, numSamples);
+}
+
+void AudioLoopProcessor::setSyncedToMaster(bool shouldBeSynced)
+{
+	syncedToMaster = shouldBeSynced;
+}
+
+void AudioLoopProcessor::setStretchMode(LoopStretcher::Mode newMode)
+{
+	stretchMode = newMode;
+}
+
+void AudioLoopProcessor::setStretchQuality(LoopStretcher::Quality newQuality)
+{
+	stretcher.setQuality(newQuality);
+}
+
+void AudioLoopProcessor::publishLayers()
+{
+	publishedNumLayers = numLayers;
+	publishedIsWriting = writingLayer != 0 ? 1 : 0;
+	publishedNumAudibleLayers = numAudibleLayers;
+	publishedNumSettledLayers = numSettledLayers;
+	publishedGeneration = generation;
+}
+
+void AudioLoopProcessor::maintainLayers()
+{
+	// enough empty blocks for a couple of seconds of overdubbing
+	const int numSpareBlocksNeeded = jmax(8, roundToInt(2.0 * getSampleRate() / layerBlockSize));
+
+	for (Layer* layer = retiredLayers.exchange(0); layer != 0;)
+	{
+		Layer* const next = layer->nextRetired;
+		recycle(layer);
+		layer = next;
+	}
+
+	while (numSpareBlocks.get() < numSpareBlocksNeeded)
+	{
+		LayerBlock* const block = new LayerBlock();
+
+		do
+		{
+			block->next = spareBlocks.get();
+		}
+		while (! spareBlocks.compareAndSetBool(block, block->next));
+
+		++numSpareBlocks;
+	}
+
+	stretcher.prepareResampler();
+
+	// an empty layer for the next pass, the size of the loop as it is now
+	const int numBlocks = getNumBlocksFor(publishedLength.get());
+	Layer* const spare = spareLayer.get();
+
+	if (numBlocks > 0 && (spare == 0 || spare->numBlocks != numBlocks))
+		recycle(spareLayer.exchange(new Layer(numBlocks)));
+
+	// The layers that can't be undone any more only change when they're merged,
+	// so they can be read here while the audio thread carries on playing them.
+	// The merged layer is handed over for the audio thread to put in their place.
+	// They're merged before the layers run out too, since after that each pass
+	// would be written into the last one, and undoing it would undo both.
+	const int numToMerge = publishedNumSettledLayers.get();
+
+	if (numToMerge >= 2 && mergeInProgress.get() == 0
+		 && (numBlocksInUse.get() > layerMemoryLimit / (int) sizeof(LayerBlock)
+			  || publishedNumLayers.get() > maxNumLayers - maxUndoDepth))
+	{
+		mergeInProgress = 1;
+		pendingMerge = createMergedLayer(numToMerge, numBlocks);
+	}
+}
+
+void AudioLoopProcessor::recycle(Layer* layer)
+{
+	if (layer == 0)
+		return;
+
+	for (int i = 0; i < layer->numBlocks; ++i)
+	{
+		LayerBlock* const block = layer->blocks[i];
+
+		if (block == 0)
+			continue;
+
+		--numBlocksInUse;
+
+		if (numSpareBlocks.get() >= jmax(8, roundToInt(2.0 * getSampleRate() / layerBlockSize)))
+		{
+			delete block;
+		}
+		else
+		{
+			zeromem(block->samples, sizeof(block->samples));
+
+			do
+			{
+				block->next = spareBlocks.get();
+			}
+			while (! spareBlocks.compareAndSetBool(block, block->next));
+
+			++numSpareBlocks;
+		}
+	}
+
+	delete layer;
+}
+
+AudioLoopProcessor::Layer* AudioLoopProcessor::createMergedLayer(int numLayersToMerge, int numBlocks)
+{
+	// if a new recording has started in the meantime, the audio thread throws this away
+	Layer* const merged = new Layer(numBlocks);
+	merged->numMergedLayers = numLayersToMerge;
+	merged->generation = publishedGeneration.get();
+
+	for (int i = 0; i < numLayersToMerge; ++i)
+	{
+		const Layer* const layer = layers[i];
+
+		for (int j = jmin(numBlocks, layer->numBlocks); --j >= 0;)
+		{
+			const LayerBlock* const block = layer->blocks[j];
+
+			if (block == 0)
+				continue;
+
+			if (merged->blocks[j] == 0)
+			{
+				merged->blocks[j] = new LayerBlock();
+				++numBlocksInUse;
+			}
+
+			addSamples(merged->blocks[j]->samples, block->samples, layerBlockSize);
+		}
+	}
+
+	return merged;
+}
+
+void AudioLoopProcessor::undoOverdub()
+{
+	++undoRequests;
+}
+
+void AudioLoopProcessor::redoOverdub()
+{
+	--undoRequests;
+}
+
+bool AudioLoopProcessor::canUndoOverdub() const
+{
+	return publishedNumAudibleLayers.get() > publishedNumSettledLayers.get();
+}
+
+bool AudioLoopProcessor::canRedoOverdub() const
+{
+	return publishedNumAudibleLayers.get() < publishedNumLayers.get();
+}
+
+int AudioLoopProcessor::getNumAudibleLayers() const
+{
+	return publishedNumAudibleLayers.get();
+}
+
+bool AudioLoopProcessor::isWritingOverdubPass() const
+{
+	return publishedIsWriting.get() != 0;
+}
+
+void AudioLoopProcessor::setLayerMemoryLimit(int numBytes)
+{
+	layerMemoryLimit = jmax(0, numBytes);
+}
+
+int AudioLoopProcessor::getNumDroppedOverdubSamples() const
+{
+	return numDroppedOverdubSamples.get();
 }
 
 const String AudioLoopProcessor::getInputChannelName(const int) const
@@ -553,7 +1203,7 @@ AudioProcessorEditor* AudioLoopProcessor::createEditor()
 
 int AudioLoopProcessor::getNumParameters()
 {
-	return 2;
+	return 8;
 }
 
 const String AudioLoopProcessor::getParameterName(int index)
@@ -562,6 +1212,18 @@ const String AudioLoopProcessor::getParameterName(int index)
 		return T("Recording");
 	else if (index == 1)
 		return T("Overdub");
+	else if (index == 2)
+		return T("Undo overdub");
+	else if (index == 3)
+		return T("Redo overdub");
+	else if (index == 4)
+		return T("Sync to master");
+	else if (index == 5)
+		return T("Keep pitch");
+	else if (index == 6)
+		return T("Stretch quality");
+	else if (index == 7)
+		return T("Master tempo");
 	return String::empty;
 }
 
@@ -571,6 +1233,17 @@ float AudioLoopProcessor::getParameter(int p)
 		return 1.f;
 	else if (cuedState == Overdubbing && p==1)
 		return 1.f;
+	else if (p == 4)
+		return syncedToMaster?1.f:0.f;
+	else if (p == 5)
+		return (stretchMode == LoopStretcher::timeStretch)?1.f:0.f;
+	else if (p == 6)
+		return getStretchQuality() * 0.5f;
+	else if (p == 7)
+	{
+		// half speed to double speed, with the recorded tempo in the middle
+		return (float) (log(LoopManager::getInstance()->getTempoScale() * 2.0) / log(4.0));
+	}
 	return 0.f;
 }
 
@@ -580,6 +1253,17 @@ const String AudioLoopProcessor::getParameterText(int index)
 		return (cuedState==Recording)?T("On"):T("Off");
 	else if (index == 1)
 		return (cuedState==Overdubbing)?T("On"):T("Off");
+	else if (index == 4)
+		return syncedToMaster?T("On"):T("Off");
+	else if (index == 5)
+		return (stretchMode == LoopStretcher::timeStretch)?T("On"):T("Off");
+	else if (index == 6)
+	{
+		const LoopStretcher::Quality quality = getStretchQuality();
+		return (quality == LoopStretcher::draft)?T("Draft"):(quality == LoopStretcher::normal)?T("Normal"):T("High");
+	}
+	else if (index == 7)
+		return String(roundToInt(LoopManager::getInstance()->getTempoScale() * 100.0)) + T("%");
 	return String::empty;
 }
 
@@ -589,12 +1273,7 @@ void AudioLoopProcessor::setParameter(int index, float value)
 
 	if (index == 0)
 	{
-		if (value >= 0.5f && cuedState != Recording)
-		{
-			// clear loop
-			sampleData.clear();
-			sampleScrub = 0;
-		}
+		// the loop is cleared when the recording actually starts
 		cuedState = (value >= 0.5f)?Recording:Playing;
 	}
 	else if (index == 1)
@@ -604,6 +1283,24 @@ void AudioLoopProcessor::setParameter(int index, float value)
 		else
 			cuedState = Playing;
 	}
+	else if (index == 2)
+	{
+		if (value >= 0.5f)
+			undoOverdub();
+	}
+	else if (index == 3)
+	{
+		if (value >= 0.5f)
+			redoOverdub();
+	}
+	else if (index == 4)
+		setSyncedToMaster(value >= 0.5f);
+	else if (index == 5)
+		setStretchMode((value >= 0.5f)?LoopStretcher::timeStretch:LoopStretcher::resample);
+	else if (index == 6)
+		setStretchQuality((LoopStretcher::Quality) jlimit(0, 2, (int) (value * 3.0f)));
+	else if (index == 7)
+		LoopManager::getInstance()->setTempoScale(0.5 * pow(4.0, (double) value));
 
 	if (currentCuedState != cuedState)
 	{
@@ -646,12 +1343,17 @@ void AudioLoopProcessor::setStateInformation(const void *, int)
 
 int AudioLoopProcessor::getLengthInSamples() const
 {
-	return sampleData.size();
+	return playbackLength > 0 ? playbackLength : (int) sampleData.size();
+}
+
+double AudioLoopProcessor::getExactLengthInSamples() const
+{
+	return exactPlaybackLength > 0 ? exactPlaybackLength : (double) getLengthInSamples();
 }
 
 double AudioLoopProcessor::getLengthInSeconds() const
 {
-	return sampleData.size() / getSampleRate();
+	return getLengthInSamples() / getSampleRate();
 }
 
 int AudioLoopProcessor::getScrubPositionInSamples() const
@@ -664,6 +1366,11 @@ double AudioLoopProcessor::getScrubPositionInSeconds() const
 	return sampleScrub / getSampleRate();
 }
 
+bool AudioLoopProcessor::recordsAudio() const
+{
+	return true;
+}
+
 void AudioLoopProcessor::drawContent(Graphics& g, int width, int height) const
 {
 	if (!sampleData.empty())
@@ -679,12 +1386,29 @@ void AudioLoopProcessor::drawContent(Graphics& g, int width, int height) const
 	g.drawText(T("state"), 4, 4, width, height, Justification::topLeft, false);
 	if (state == Overdubbing)
 		g.drawText(T("OVR"), 4, 4, width, height, Justification::topLeft, false);
+
+	const int numAudibleLayers = getNumAudibleLayers();
+
+	if (numAudibleLayers > 0)
+		g.drawText(String(numAudibleLayers) + T(" layers"), 4, 4, width - 8, height - 8, Justification::bottomLeft, false);
+
+	const int numDropped = getNumDroppedOverdubSamples();
+
+	if (numDropped > 0)
+	{
+		g.setColour(Colours::red);
+		g.drawText(String(numDropped) + T(" samples dropped"), 4, 4, width - 8, height - 8, Justification::topRight, false);
+		g.setColour(Colours::white);
+	}
+
+	if (isStretched())
+		g.drawText(String(sampleData.size() / (double) playbackLength, 2) + T("x"), 4, 4, width - 8, height - 8, Justification::bottomRight, false);
 }
 
 juce_ImplementSingleton (LoopManager);
 
 LoopManager::LoopManager()
-: masterLoop(0)
+: masterLoop(0), tempoScale(1.0)
 {
 }
 
@@ -702,3 +1426,195 @@ void LoopManager::setMasterLoop(LoopProcessor* newMasterLoop)
 {
 	masterLoop = newMasterLoop;
 }
+
+void LoopManager::setTempoScale(double newTempoScale)
+{
+	tempoScale = jlimit(0.5, 2.0, newTempoScale);
+}
+
+double LoopManager::getTempoScale() const
+{
+	return tempoScale.get();
+}
+
+// ==================================================
+
+#if JUCE_UNIT_TESTS
+
+class AudioLoopProcessorTests : public UnitTest
+{
+public:
+	AudioLoopProcessorTests() : UnitTest("Audio Looper") {}
+
+	enum { blockSize = 512, loopBlocks = 8 };
+
+	// plays a block with every input sample set to a value, and returns the first output sample
+	static float play(AudioLoopProcessor& looper, float input)
+	{
+		AudioSampleBuffer buffer(1, blockSize);
+		MidiBuffer midi;
+
+		for (int i = 0; i < blockSize; ++i)
+			buffer.getSampleData(0)[i] = input;
+
+		looper.processBlock(buffer, midi);
+		return buffer.getSampleData(0)[0];
+	}
+
+	// records a silent take, a whole layer block long unless it's given another length,
+	// after which the looper is the master
+	static void record(AudioLoopProcessor& looper, int numBlocks = loopBlocks)
+	{
+		looper.setParameter(0, 1.0f);
+
+		for (int i = 0; i < numBlocks; ++i)
+			play(looper, 0.0f);
+
+		looper.setParameter(0, 0.0f);
+		play(looper, 0.0f);
+	}
+
+	// adds a value to the whole loop in one pass, waiting for the background thread
+	// to hand over a layer for it first
+	void overdub(AudioLoopProcessor& looper, float value)
+	{
+		looper.setParameter(1, 1.0f);
+
+		for (int tries = 0;; ++tries)
+		{
+			play(looper, value);
+
+			if (looper.isWritingOverdubPass() || tries > 100)
+				break;
+
+			Thread::sleep(20);
+		}
+
+		expect(looper.isWritingOverdubPass());
+
+		for (int i = 1; i < loopBlocks; ++i)
+			play(looper, value);
+
+		// the pass ends at the start of the next block, before its input is taken
+		looper.setParameter(1, 0.0f);
+		play(looper, value);
+	}
+
+	void runTest()
+	{
+		LoopManager::getInstance()->setMasterLoop(0);
+
+		beginTest("Undo and redo");
+		{
+			AudioLoopProcessor looper;
+			looper.prepareToPlay(44100.0, blockSize);
+			record(looper);
+
+			overdub(looper, 1.0f);
+			overdub(looper, 2.0f);
+			expectEquals(play(looper, 0.0f), 3.0f);
+
+			looper.undoOverdub();
+			expectEquals(play(looper, 0.0f), 1.0f);
+			expect(looper.canUndoOverdub() && looper.canRedoOverdub());
+
+			looper.redoOverdub();
+			expectEquals(play(looper, 0.0f), 3.0f);
+			expect(! looper.canRedoOverdub());
+
+			// a new pass replaces the one that was undone
+			looper.undoOverdub();
+			expectEquals(play(looper, 0.0f), 1.0f);
+			overdub(looper, 4.0f);
+			expectEquals(play(looper, 0.0f), 5.0f);
+			expect(! looper.canRedoOverdub());
+
+			looper.undoOverdub();
+			looper.undoOverdub();
+			expectEquals(play(looper, 0.0f), 0.0f);
+			expect(! looper.canUndoOverdub());
+
+			expectEquals(looper.getNumDroppedOverdubSamples(), 0);
+			LoopManager::getInstance()->setMasterLoop(0);
+		}
+
+		beginTest("Merging past the memory limit");
+		{
+			AudioLoopProcessor looper;
+			looper.prepareToPlay(44100.0, blockSize);
+			looper.setLayerMemoryLimit(0);
+			record(looper);
+
+			const int numPasses = 10;
+
+			for (int i = 0; i < numPasses; ++i)
+				overdub(looper, 1.0f);
+
+			// the two passes that can't be undone any more become one layer
+			for (int tries = 0; looper.getNumAudibleLayers() == numPasses && tries < 100; ++tries)
+			{
+				Thread::sleep(20);
+				play(looper, 0.0f);
+			}
+
+			expectEquals(looper.getNumAudibleLayers(), numPasses - 1);
+			expectEquals(play(looper, 0.0f), (float) numPasses);
+
+			for (int i = 0; i < numPasses; ++i)
+				looper.undoOverdub();
+
+			expectEquals(play(looper, 0.0f), 2.0f);
+			expect(! looper.canUndoOverdub());
+
+			LoopManager::getInstance()->setMasterLoop(0);
+		}
+
+		beginTest("Merging before the layers run out");
+		{
+			AudioLoopProcessor looper;
+			looper.prepareToPlay(44100.0, blockSize);
+			record(looper);
+
+			// every pass gets a layer of its own, so each one can still be undone
+			const int numPasses = 40;
+
+			for (int i = 0; i < numPasses; ++i)
+				overdub(looper, 1.0f);
+
+			expect(looper.getNumAudibleLayers() < numPasses);
+			expectEquals(play(looper, 0.0f), (float) numPasses);
+
+			looper.undoOverdub();
+			expectEquals(play(looper, 0.0f), (float) numPasses - 1);
+
+			LoopManager::getInstance()->setMasterLoop(0);
+		}
+
+		beginTest("Lengths in proportion to the master");
+		{
+			AudioLoopProcessor master, other;
+			master.prepareToPlay(44100.0, blockSize);
+			other.prepareToPlay(44100.0, blockSize);
+
+			record(other, loopBlocks * 3 / 2);
+			LoopManager::getInstance()->setMasterLoop(0);
+			record(master);
+
+			// rounded to whole blocks on its own, the other loop would be 13 blocks
+			// long against the master's 9, rather than 13.5
+			LoopManager::getInstance()->setTempoScale(0.9);
+			play(master, 0.0f);
+			play(other, 0.0f);
+
+			expectEquals(master.getLengthInSamples(), 9 * blockSize);
+			expectEquals(other.getLengthInSamples(), master.getLengthInSamples() * 3 / 2);
+
+			LoopManager::getInstance()->setTempoScale(1.0);
+			LoopManager::getInstance()->setMasterLoop(0);
+		}
+	}
+};
+
+static AudioLoopProcessorTests audioLoopProcessorTests;
+
+#endif
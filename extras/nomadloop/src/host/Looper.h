@@ -3,6 +3,7 @@
 
 #include "../includes.h"
 #include "Analysis.h"
+#include "LoopStretcher.h"
 #include <vector>
 #include <deque>
 
@@ -24,10 +25,33 @@ public:
 	virtual int getLengthInSamples() const = 0;
 	virtual double getLengthInSeconds() const = 0;
 
+	// The length the loop would play at if it weren't rounded to whole samples or
+	// blocks, so that other loops can keep their lengths in proportion to it.
+	virtual double getExactLengthInSamples() const	{ return getLengthInSamples(); }
+
 	virtual int getScrubPositionInSamples() const = 0;
 	virtual double getScrubPositionInSeconds() const = 0;
 
+	// true during the block in which the loop has come back round to its start
+	bool isAtLoopStart() const;
+
 	virtual void drawContent(Graphics&, int width, int height) const = 0;
+
+	// The number of samples by which material arriving at the looper lags
+	// behind what the player was hearing, i.e. the round trip through the
+	// audio device and the graph.  Recorded material is shifted back by this
+	// much so that it lines up with the loop it was played against.
+	void setLatencyCompensation(int numSamples);
+	int getLatencyCompensation() const;
+
+	// true if the looper records audio and so also has to compensate for
+	// the input device latency, not just the output side
+	virtual bool recordsAudio() const = 0;
+
+protected:
+	// set from the message thread whenever the graph or the devices change,
+	// and read by the audio thread
+	Atomic<int> latencyCompensation;
 };
 
 class MidiLoopProcessor : public LoopProcessor
@@ -52,10 +76,29 @@ class MidiLoopProcessor : public LoopProcessor
 
 	bool activePitchClass[12];
 
+	// the notes that are down at the current point in the recording, so that
+	// they can be ended when the recording is
+	bool noteIsHeld[16][128];
+
+	// room for this many bytes of MIDI is set aside for each take, so that
+	// recording doesn't have to allocate on the audio thread
+	enum { recordingReserve = 64 * 1024 };
+	MidiBuffer compensationScratch;
+
 	// sequence converted to a certain subset of notes
 	MidiBuffer alteredSequence;
 	void regenerateAlteredSequence();
 
+	void recordEvents(const MidiBuffer& input, int numSamples);
+
+	// ends any notes still held when the recording stops, so that they don't
+	// sound until the loop next gets round to them
+	void endHeldNotes();
+
+	// moves the recorded sequence back by the latency compensation, wrapping
+	// the events that fall before the loop start around to its end
+	void compensateRecordedSequence();
+
 	Key estimatedKey;
 
 public:
@@ -95,12 +138,26 @@ public:
 	double getScrubPositionInSeconds() const;
 
 	void drawContent(Graphics& g, int width, int height) const;
+	bool recordsAudio() const;
 
 	inline const Key& getEstimatedKey() const { return estimatedKey; }
 };
 
 // A graph filter hooking into the looping engine
-class AudioLoopProcessor : public LoopProcessor
+//
+// The first recording is kept as it is, and each overdub pass on top of it goes
+// into a layer of its own, which only holds the blocks of the loop that the pass
+// touched. Playback sums the recording and the layers that are audible, so undo
+// and redo only change how many layers are heard, and take effect on the next
+// block. Layers too old to be undone are merged into one by a background thread
+// once they take up more than a set amount of memory, or there are nearly too
+// many of them. The same thread keeps the audio thread supplied with empty blocks
+// and layers, so nothing is allocated while overdubbing.
+//
+// A loop plays back faster or slower when the master tempo changes, or when
+// it's synced to a master loop of a different length, either resampled or
+// time-stretched. It can only be overdubbed while it plays at its own speed.
+class AudioLoopProcessor : public LoopProcessor, private LoopStretcher::Source
 {
 	//bool recordingCued;
 	//bool recording;
@@ -112,8 +169,13 @@ class AudioLoopProcessor : public LoopProcessor
 	std::vector<float> sampleData;
 	int sampleScrub;
 
+	// offset between the scrub position and the playback position in sampleData,
+	// taking up the latency compensation applied when recording finished
+	int playOffset;
+
 public:
 	AudioLoopProcessor();
+	~AudioLoopProcessor();
 
 	void fillInPluginDescription(PluginDescription &looperDesc) const;
 
@@ -144,17 +206,121 @@ public:
 
 	int getLengthInSamples() const;
 	double getLengthInSeconds() const;
+	double getExactLengthInSamples() const;
 
 	int getScrubPositionInSamples() const;
 	double getScrubPositionInSeconds() const;
 
 	void drawContent(Graphics& g, int width, int height) const;
+	bool recordsAudio() const;
+
+	// Drops the most recent overdub pass, or brings back the last one dropped.
+	// Undoing during a pass drops what's been overdubbed so far, and the pass
+	// carries on into a fresh layer. Parameters 2 and 3 do the same, so that
+	// they can be mapped to controls.
+	void undoOverdub();
+	void redoOverdub();
+
+	bool canUndoOverdub() const;
+	bool canRedoOverdub() const;
+	int getNumAudibleLayers() const;
+
+	// True while an overdub pass is being written. A pass that's been started
+	// only takes input once the background thread has an empty layer ready.
+	bool isWritingOverdubPass() const;
+
+	// Once the layers take up more than this, the ones that can no longer be
+	// undone are merged.
+	void setLayerMemoryLimit(int numBytes);
+
+	// The samples of overdub input that were lost since the take was recorded,
+	// because the background thread didn't supply empty blocks quickly enough.
+	int getNumDroppedOverdubSamples() const;
+
+	// A synced loop plays at whichever length, out of the master loop's length
+	// times a power of two, is closest to its own, so that a loop recorded a
+	// little off, or over twice as many bars, stays in time with it. Any other
+	// loop keeps the length it was recorded at in proportion to the master's.
+	void setSyncedToMaster(bool shouldBeSynced);
+	bool isSyncedToMaster() const					{ return syncedToMaster; }
+
+	void setStretchMode(LoopStretcher::Mode newMode);
+	LoopStretcher::Mode getStretchMode() const		{ return stretchMode; }
+
+	void setStretchQuality(LoopStretcher::Quality newQuality);
+	LoopStretcher::Quality getStretchQuality() const	{ return stretcher.getQuality(); }
+
+private:
+	enum
+	{
+		layerBlockSize = 4096,	// the samples in each block of a layer
+		maxNumLayers = 32,
+		maxUndoDepth = 8		// the number of passes that can be undone
+	};
+
+	struct LayerBlock;
+	class Layer;
+	friend class LoopLayerMaintainer;
+
+	// these belong to the audio thread
+	Layer* layers[maxNumLayers];
+	int numLayers, numAudibleLayers, numSettledLayers;
+	Layer* writingLayer;
+	int generation;
+	AudioSampleBuffer overdubInput;
+
+	// what the audio thread last did with them, for the other threads
+	Atomic<int> publishedNumLayers, publishedNumAudibleLayers, publishedNumSettledLayers;
+	Atomic<int> publishedGeneration, publishedLength, publishedIsWriting;
+
+	Atomic<int> undoRequests;		// undos less redos, waiting for the audio thread
+	Atomic<LayerBlock*> spareBlocks;
+	Atomic<int> numSpareBlocks, numBlocksInUse;
+	Atomic<Layer*> spareLayer, pendingMerge, retiredLayers;
+	Atomic<int> mergeInProgress;
+	Atomic<int> numDroppedOverdubSamples;
+	int layerMemoryLimit;
+
+	LoopStretcher stretcher;
+	bool syncedToMaster;
+	LoopStretcher::Mode stretchMode;
+
+	// the loop's length as it's played, before and after rounding, and the tempo
+	// scale when it was recorded
+	int playbackLength;
+	double exactPlaybackLength, recordedTempoScale;
+
+	// audio thread
+	void beginOverdubPass();
+	void endOverdubPass();
+	void applyUndoRequests();
+	void takePendingMerge();
+	void clearLayers();
+	void retire(Layer* layer);
+	LayerBlock* takeSpareBlock();
+	void mixLayers(float* dest, int position, int numSamples) const;
+	void overdub(const float* input, int position, int numSamples);
+	void publishLayers();
+	void updatePlaybackLength();
+	bool isStretched() const;
+	void readLoop(float* dest, int position, int numSamples) const;
+
+	// background thread
+	void maintainLayers();
+	void recycle(Layer* layer);
+	Layer* createMergedLayer(int numLayersToMerge, int numBlocks);
+
+	static int getNumBlocksFor(int numSamples);
+
+	AudioLoopProcessor(const AudioLoopProcessor&);
+	AudioLoopProcessor& operator= (const AudioLoopProcessor&);
 };
 
 // Holder of the global loop state, used to sync loops together, i.e. keep track of master loop
 class LoopManager
 {
 	LoopProcessor* masterLoop;
+	Atomic<double> tempoScale;	// set by the message thread, read by the audio thread
 public:
 	LoopManager();
 	~LoopManager();
@@ -162,6 +328,11 @@ public:
 	LoopProcessor* getMasterLoop();
 	void setMasterLoop(LoopProcessor* newMasterLoop);
 
+	// The speed that audio loops play at, relative to the tempo that they were
+	// recorded at, from half to twice as fast.
+	void setTempoScale(double newTempoScale);
+	double getTempoScale() const;
+
 	juce_DeclareSingleton (LoopManager, true)
 };
 
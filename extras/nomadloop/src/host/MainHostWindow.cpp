@@ -28,6 +28,7 @@
 #include "InternalFilters.h"
 #include "ProjectDocument.h"
 #include "SyncPlayHead.h"
+#include "PluginSandbox.h"
 
 
 //==============================================================================
@@ -83,6 +84,7 @@ class ContentComp : public Component
 public:
 	ContentComp(AudioDeviceManager* deviceManager)
 		: deviceManager(deviceManager),
+			playHead(deviceManager),
 			graphDocument(new GraphDocumentComponent(deviceManager, &playHead)),
 			controlSurface(new ControlSurfaceComponent())			
 	{
@@ -160,6 +162,9 @@ MainHostWindow::MainHostWindow()
 	ContentComp* contentComp = new ContentComp (&deviceManager);
     setContentComponent (contentComp);
 	projectDocument = new ProjectDocument(contentComp->controlSurface, &(contentComp->graphDocument->graph));
+	contentComp->graphDocument->songSwitcher.addListener (projectDocument);
+	contentComp->graphDocument->songSwitcher.setMaxNumStandbyGraphs (appProperties->getUserSettings()
+																		->getIntValue ("maxPreloadedSongs", 2));
 
     restoreWindowStateFromString (appProperties->getUserSettings()->getValue ("mainWindowPos"));
 
@@ -183,6 +188,9 @@ MainHostWindow::MainHostWindow()
 
     knownPluginList.addChangeListener (this);
 
+    pluginScanCache = new PluginScanCache (appProperties->getUserSettings()->getFile()
+                                             .getSiblingFile (T("PluginScanCache.xml")));
+
     addKeyListener (commandManager->getKeyMappings());
 
     Process::setPriority (Process::HighPriority);
@@ -207,8 +215,12 @@ MainHostWindow::~MainHostWindow()
     knownPluginList.removeChangeListener (this);
 
     appProperties->getUserSettings()->setValue ("mainWindowPos", getWindowStateAsString());
-	delete projectDocument;
-    setContentComponent (0);	
+
+    if (getGraphEditor() != 0)
+        getGraphEditor()->songSwitcher.removeListener (projectDocument);
+
+    delete projectDocument;
+    setContentComponent (0);
 }
 
 void MainHostWindow::closeButtonPressed()
@@ -249,7 +261,7 @@ void MainHostWindow::changeListenerCallback (ChangeBroadcaster*)
 
 const StringArray MainHostWindow::getMenuBarNames()
 {
-    const wchar_t* const names[] = { T("File"), T("View"), T("Plugins"), T("Options"), 0 };
+    const wchar_t* const names[] = { T("File"), T("Edit"), T("View"), T("Plugins"), T("Options"), 0 };
 
     return StringArray ((const wchar_t**) names);
 }
@@ -273,14 +285,24 @@ const PopupMenu MainHostWindow::getMenuForIndex (int topLevelMenuIndex, const St
 
         menu.addCommandItem (commandManager, CommandIDs::save);
         menu.addCommandItem (commandManager, CommandIDs::saveAs);
+        menu.addCommandItem (commandManager, CommandIDs::exportXml);
+        menu.addSeparator();
+        menu.addCommandItem (commandManager, CommandIDs::preloadSongs);
+        menu.addCommandItem (commandManager, CommandIDs::switchToNextSong);
         menu.addSeparator();
         menu.addCommandItem (commandManager, StandardApplicationCommandIDs::quit);
     }
-	else if (topLevelMenuIndex == 1)
+    else if (topLevelMenuIndex == 1)
+    {
+        // "Edit" menu
+        menu.addCommandItem (commandManager, CommandIDs::undo);
+        menu.addCommandItem (commandManager, CommandIDs::redo);
+    }
+	else if (topLevelMenuIndex == 2)
 	{
 		menu.addCommandItem (commandManager, CommandIDs::toggleView);
 	}
-    else if (topLevelMenuIndex == 2)
+    else if (topLevelMenuIndex == 3)
     {
         // "Plugins" menu
         PopupMenu pluginsMenu;
@@ -290,11 +312,12 @@ const PopupMenu MainHostWindow::getMenuForIndex (int topLevelMenuIndex, const St
         menu.addItem (250, T("Delete all plugins"));
 
     }
-    else if (topLevelMenuIndex == 3)
+    else if (topLevelMenuIndex == 4)
     {
         // "Options" menu
 
         menu.addCommandItem (commandManager, CommandIDs::showPluginListEditor);
+        menu.addCommandItem (commandManager, CommandIDs::scanForPlugins);
 
         PopupMenu sortTypeMenu;
         sortTypeMenu.addItem (200, "List plugins in default order", true, pluginSortMethod == KnownPluginList::defaultOrder);
@@ -303,6 +326,8 @@ const PopupMenu MainHostWindow::getMenuForIndex (int topLevelMenuIndex, const St
         sortTypeMenu.addItem (203, "List plugins by manufacturer", true, pluginSortMethod == KnownPluginList::sortByManufacturer);
         sortTypeMenu.addItem (204, "List plugins based on the directory structure", true, pluginSortMethod == KnownPluginList::sortByFileSystemLocation);
         menu.addSubMenu ("Plugin menu type", sortTypeMenu);
+        menu.addItem (260, "Run external plugins in a separate process", true,
+                      appProperties->getUserSettings()->getBoolValue ("sandboxExternalPlugins", false));
 
         menu.addSeparator();
         menu.addCommandItem (commandManager, CommandIDs::showAudioSettings);
@@ -348,6 +373,11 @@ void MainHostWindow::menuItemSelected (int menuItemID, int /*topLevelMenuIndex*/
         appProperties->getUserSettings()
            ->setValue (T("pluginSortMethod"), (int) pluginSortMethod);
     }
+    else if (menuItemID == 260)
+    {
+        PropertySet* const settings = appProperties->getUserSettings();
+        settings->setValue ("sandboxExternalPlugins", ! settings->getBoolValue ("sandboxExternalPlugins", false));
+    }
     else
     {
         createPlugin (getChosenType (menuItemID),
@@ -360,8 +390,20 @@ void MainHostWindow::createPlugin (const PluginDescription* desc, int x, int y)
 {
     GraphDocumentComponent* const graphEditor = getGraphEditor();
 
-    if (graphEditor != 0)
+    if (graphEditor == 0 || desc == 0)
+        return;
+
+    // a crashing plugin then only takes its own node down with it
+    if (appProperties->getUserSettings()->getBoolValue ("sandboxExternalPlugins", false)
+         && SandboxedPluginFormat::canBeSandboxed (*desc))
+    {
+        const PluginDescription sandboxed (SandboxedPluginFormat::createDescriptionFor (*desc));
+        graphEditor->createNewPlugin (&sandboxed, x, y);
+    }
+    else
+    {
         graphEditor->createNewPlugin (desc, x, y);
+    }
 }
 
 void MainHostWindow::addPluginsToMenu (PopupMenu& m) const
@@ -398,8 +440,14 @@ void MainHostWindow::getAllCommands (Array <CommandID>& commands)
     const CommandID ids[] = { CommandIDs::open,
                               CommandIDs::save,
                               CommandIDs::saveAs,
+                              CommandIDs::exportXml,
+                              CommandIDs::preloadSongs,
+                              CommandIDs::switchToNextSong,
+                              CommandIDs::undo,
+                              CommandIDs::redo,
 							  CommandIDs::toggleView,
                               CommandIDs::showPluginListEditor,
+                              CommandIDs::scanForPlugins,
                               CommandIDs::showAudioSettings,
                               CommandIDs::aboutBox
                             };
@@ -434,6 +482,44 @@ void MainHostWindow::getCommandInfo (const CommandID commandID, ApplicationComma
         result.defaultKeypresses.add (KeyPress (T('s'), ModifierKeys::shiftModifier | ModifierKeys::commandModifier, 0));
         break;
 
+    case CommandIDs::exportXml:
+        result.setInfo (T("Export as XML..."),
+                        T("Saves a copy of the current project as XML, which is easier to compare"),
+                        category, 0);
+        break;
+
+    case CommandIDs::preloadSongs:
+        result.setInfo (T("Preload songs..."),
+                        T("Loads projects into standby graphs while the current one plays, so that they can be switched to without a gap"),
+                        category, 0);
+        break;
+
+    case CommandIDs::switchToNextSong:
+        result.setInfo (T("Switch to next song"),
+                        T("Switches to the song that was preloaded first"),
+                        category, 0);
+        result.setActive (getGraphEditor() != 0 && getGraphEditor()->songSwitcher.getNumPreloadedSongs() > 0);
+        result.defaultKeypresses.add (KeyPress (T('n'), ModifierKeys::commandModifier, 0));
+        break;
+
+    case CommandIDs::undo:
+        result.setInfo (getGraphEditor() != 0 && getGraphEditor()->graph.getUndoManager().canUndo()
+                            ? String (T("Undo ")) + getGraphEditor()->graph.getUndoManager().getUndoDescription() : String (T("Undo")),
+                        T("Undoes the last edit to the graph or the control surface"),
+                        category, 0);
+        result.setActive (getGraphEditor() != 0 && getGraphEditor()->graph.getUndoManager().canUndo());
+        result.defaultKeypresses.add (KeyPress (T('z'), ModifierKeys::commandModifier, 0));
+        break;
+
+    case CommandIDs::redo:
+        result.setInfo (getGraphEditor() != 0 && getGraphEditor()->graph.getUndoManager().canRedo()
+                            ? String (T("Redo ")) + getGraphEditor()->graph.getUndoManager().getRedoDescription() : String (T("Redo")),
+                        T("Redoes the last edit that was undone"),
+                        category, 0);
+        result.setActive (getGraphEditor() != 0 && getGraphEditor()->graph.getUndoManager().canRedo());
+        result.defaultKeypresses.add (KeyPress (T('z'), ModifierKeys::shiftModifier | ModifierKeys::commandModifier, 0));
+        break;
+
 	case CommandIDs::toggleView:
 		result.setInfo (T("Toggle view"),
 						T("Toggles between patchbay and control surface view"),
@@ -448,6 +534,10 @@ void MainHostWindow::getCommandInfo (const CommandID commandID, ApplicationComma
         result.addDefaultKeypress (T('p'), ModifierKeys::commandModifier);
         break;
 
+    case CommandIDs::scanForPlugins:
+        result.setInfo ("Scan for new or updated plug-Ins", String::empty, category, 0);
+        break;
+
     case CommandIDs::showAudioSettings:
         result.setInfo ("Change the audio device settings", String::empty, category, 0);
         result.addDefaultKeypress (T('a'), ModifierKeys::commandModifier);
@@ -499,6 +589,64 @@ bool MainHostWindow::perform (const InvocationInfo& info)
 			projectDocument->saveAs (File::nonexistent, true, true, true);
         break;
 
+    case CommandIDs::exportXml:
+        if (graphEditor != 0)
+        {
+            FileChooser fc (T("Export the project as XML"), File::nonexistent, T("*.xml"));
+
+            if (fc.browseForFileToSave (true))
+            {
+                const String error (projectDocument->exportAsXml (fc.getResult()));
+
+                if (error.isNotEmpty())
+                    AlertWindow::showMessageBox (AlertWindow::WarningIcon, T("Export as XML"), error);
+            }
+        }
+        break;
+
+    case CommandIDs::preloadSongs:
+        if (graphEditor != 0)
+        {
+            FileChooser fc (T("Choose the songs to preload"), File::nonexistent, T("*.nomad"));
+
+            if (fc.browseForMultipleFilesToOpen())
+            {
+                for (int i = 0; i < fc.getResults().size(); ++i)
+                {
+                    const String error (graphEditor->songSwitcher.preload (fc.getResults()[i]));
+
+                    if (error.isNotEmpty())
+                        AlertWindow::showMessageBox (AlertWindow::WarningIcon, T("Preload songs"), error);
+                }
+            }
+        }
+        break;
+
+    case CommandIDs::switchToNextSong:
+        if (graphEditor != 0 && graphEditor->songSwitcher.getNumPreloadedSongs() > 0
+             && projectDocument->saveIfNeededAndUserAgrees() == FileBasedDocument::savedOk)
+        {
+            // with no crossfade set, the new song comes in on the next bar
+            const int crossfadeMs = appProperties->getUserSettings()->getIntValue ("songCrossfadeMs", 0);
+            AudioIODevice* const device = deviceManager.getCurrentAudioDevice();
+            const double sampleRate = device != 0 ? device->getCurrentSampleRate() : 44100.0;
+
+            graphEditor->songSwitcher.switchTo (graphEditor->songSwitcher.getPreloadedSong (0),
+                                                crossfadeMs > 0 ? SongSwitcher::crossfade : SongSwitcher::swapAtNextBar,
+                                                roundToInt (crossfadeMs * sampleRate / 1000.0));
+        }
+        break;
+
+    case CommandIDs::undo:
+        if (graphEditor != 0)
+            graphEditor->graph.getUndoManager().undo();
+        break;
+
+    case CommandIDs::redo:
+        if (graphEditor != 0)
+            graphEditor->graph.getUndoManager().redo();
+        break;
+
 	case CommandIDs::toggleView:
 		dynamic_cast<ContentComp*>(getContentComponent())->toggleFocusedComponent();
 		break;
@@ -510,6 +658,10 @@ bool MainHostWindow::perform (const InvocationInfo& info)
         PluginListWindow::currentPluginListWindow->toFront (true);
         break;
 
+    case CommandIDs::scanForPlugins:
+        scanForPlugins();
+        break;
+
     case CommandIDs::showAudioSettings:
         showAudioSettings();
         break;
@@ -563,6 +715,38 @@ void MainHostWindow::showAudioSettings()
         graphEditor->graph.removeIllegalConnections();
 }
 
+void MainHostWindow::scanForPlugins()
+{
+    StringArray failedFiles;
+
+    for (int i = 0; i < AudioPluginFormatManager::getInstance()->getNumFormats(); ++i)
+    {
+        AudioPluginFormat* const format = AudioPluginFormatManager::getInstance()->getFormat (i);
+
+        // use the same folders that the plugin list editor last scanned
+        FileSearchPath path (format->getDefaultLocationsToSearch());
+        path = appProperties->getUserSettings()
+                   ->getValue ("lastPluginScanPath_" + format->getName(), path.toString());
+
+        if (path.getNumPaths() == 0)
+            continue;
+
+        OutOfProcessPluginScanner scanner (knownPluginList, *pluginScanCache, *format, path,
+                                           SystemStats::getNumCpus(), 20000);
+        scanner.runThread();
+
+        failedFiles.addArray (scanner.getFailedFiles());
+    }
+
+    if (failedFiles.size() > 0)
+    {
+        AlertWindow::showMessageBox (AlertWindow::InfoIcon,
+                                     TRANS("Scan complete"),
+                                     TRANS("The following files appeared to be plugin files, but failed to load correctly:")
+                                       + "\n\n" + failedFiles.joinIntoString (", ", 0, 100));
+    }
+}
+
 bool MainHostWindow::isInterestedInFileDrag (const StringArray&)
 {
     return true;
@@ -30,6 +30,7 @@
 #include "GraphEditorPanel.h"
 #include "ControlSurface.h"
 #include "ProjectDocument.h"
+#include "PluginScanner.h"
 
 
 //==============================================================================
@@ -38,8 +39,14 @@ namespace CommandIDs
     static const int open                   = 0x30000;
     static const int save                   = 0x30001;
     static const int saveAs                 = 0x30002;
+    static const int exportXml              = 0x30003;
+    static const int preloadSongs           = 0x30004;
+    static const int switchToNextSong       = 0x30005;
+    static const int undo                   = 0x30006;
+    static const int redo                   = 0x30007;
 	static const int toggleView				= 0x30010;
     static const int showPluginListEditor   = 0x30100;
+    static const int scanForPlugins         = 0x30110;
     static const int showAudioSettings      = 0x30200;
     static const int aboutBox               = 0x30300;
 }
@@ -103,7 +110,10 @@ private:
 
 	ProjectDocument* projectDocument;
 
+    ScopedPointer <PluginScanCache> pluginScanCache;
+
     void showAudioSettings();    
+    void scanForPlugins();
 };
 
 
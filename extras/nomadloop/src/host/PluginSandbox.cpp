@@ -0,0 +1,1158 @@
+#include "PluginSandbox.h"
+
+#if JUCE_LINUX
+ #include <linux/futex.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+ #include <climits>
+#endif
+
+namespace
+{
+	const char* const sandboxCommandLineFlag = "--host-plugin";
+	const char* const sandboxFormatName = "Sandboxed";
+	const int sandboxLoadTimeoutMs = 20000;
+	const int sandboxRequestTimeoutMs = 5000;
+	const int heartbeatIntervalMs = 100;
+	const int heartbeatTimeoutMs = 1000;
+
+	// MIDI travels as [sample position][size][bytes] records
+	// Room for everything a block's shared MIDI area can hold, since each record
+	// there is at least as big as the MidiBuffer event it turns into, plus the
+	// half-again that MidiBuffer asks for when it's close to running out
+	const int midiBufferSpaceNeeded = SandboxSharedHeader::maxMidiBytes * 2;
+
+	int writeMidiToSharedMemory(const MidiBuffer& midi, uint8* dest, int maxBytes)
+	{
+		MidiBuffer::Iterator i(midi);
+		const uint8* data;
+		int size, position;
+		int used = 0;
+
+		while (i.getNextEvent(data, size, position))
+		{
+			const int needed = 2 * sizeof(int) + size;
+
+			if (used + needed > maxBytes)
+				break;
+
+			memcpy(dest + used, &position, sizeof(int));
+			memcpy(dest + used + sizeof(int), &size, sizeof(int));
+			memcpy(dest + used + 2 * sizeof(int), data, size);
+			used += needed;
+		}
+
+		return used;
+	}
+
+	void readMidiFromSharedMemory(const uint8* src, int numBytes, MidiBuffer& midi)
+	{
+		int used = 0;
+
+		while (used + (int) (2 * sizeof(int)) <= numBytes)
+		{
+			int position, size;
+			memcpy(&position, src + used, sizeof(int));
+			memcpy(&size, src + used + sizeof(int), sizeof(int));
+
+			if (size <= 0 || used + (int) (2 * sizeof(int)) + size > numBytes)
+				break;
+
+			midi.addEvent(src + used + 2 * sizeof(int), size, position);
+			used += 2 * sizeof(int) + size;
+		}
+	}
+
+	// The host and the child wait for each other's counters in the shared memory.
+	// On Linux they sleep on a futex, which works between processes that share a
+	// mapping; elsewhere they fall back to short sleeps.  Returns false if the
+	// counter was still at oldValue when the deadline passed.
+	bool waitForCounterChange(Atomic<int>& counter, const int oldValue, const int64 deadlineTicks)
+	{
+		for (;;)
+		{
+			if (counter.get() != oldValue)
+				return true;
+
+			const int64 ticksLeft = deadlineTicks - Time::getHighResolutionTicks();
+
+			if (ticksLeft <= 0)
+				return false;
+
+		   #if JUCE_LINUX
+			const double secondsLeft = Time::highResolutionTicksToSeconds(ticksLeft);
+
+			timespec timeout;
+			timeout.tv_sec = (time_t) secondsLeft;
+			timeout.tv_nsec = (long) ((secondsLeft - (double) timeout.tv_sec) * 1.0e9);
+
+			// this returns straight away if the counter has already moved on
+			syscall(SYS_futex, (int*) &counter.value, FUTEX_WAIT, oldValue, &timeout, 0, 0);
+		   #else
+			Thread::sleep(1);
+		   #endif
+		}
+	}
+
+	void wakeCounterWaiters(Atomic<int>& counter)
+	{
+	   #if JUCE_LINUX
+		syscall(SYS_futex, (int*) &counter.value, FUTEX_WAKE, INT_MAX, 0, 0, 0);
+	   #else
+		(void) counter;
+	   #endif
+	}
+
+	int64 getTicksFromNow(const int milliseconds)
+	{
+		return Time::getHighResolutionTicks() + Time::secondsToHighResolutionTicks(milliseconds / 1000.0);
+	}
+
+	uint8* getSharedArea(SandboxSharedHeader* header, int offset)
+	{
+		return reinterpret_cast<uint8*>(header) + offset;
+	}
+
+	float* getSharedChannel(SandboxSharedHeader* header, int channel)
+	{
+		return reinterpret_cast<float*>(getSharedArea(header, SandboxSharedHeader::audioOffset))
+			+ channel * SandboxSharedHeader::maxBlockSize;
+	}
+
+	// ==========================
+
+	// Runs in the child, waiting for the host to hand over a block and then
+	// rendering it in place in the shared memory
+	class SandboxRenderThread : public Thread, public AudioPlayHead
+	{
+		SandboxSharedHeader* header;
+		AudioPluginInstance* plugin;
+		MidiBuffer midi;
+		HeapBlock<float*> channels;
+		int lastRequest;
+
+	public:
+		// the thread answers the requests that come after firstRequest, which the host
+		// may start sending before the thread has got going
+		SandboxRenderThread(SandboxSharedHeader* header_, AudioPluginInstance* plugin_, int firstRequest)
+		: Thread("Sandbox render thread"), header(header_), plugin(plugin_), lastRequest(firstRequest)
+		{
+			channels.calloc(SandboxSharedHeader::maxChannels);
+			midi.ensureSize(midiBufferSpaceNeeded);
+			plugin->setPlayHead(this);
+		}
+
+		~SandboxRenderThread()
+		{
+			signalThreadShouldExit();
+			wakeCounterWaiters(header->requestCount);
+			stopThread(2000);
+			plugin->setPlayHead(0);
+		}
+
+		bool getCurrentPosition(CurrentPositionInfo& result)
+		{
+			if (!header->hasPositionInfo)
+				return false;
+
+			result = header->positionInfo;
+			return true;
+		}
+
+		void run()
+		{
+			while (!threadShouldExit())
+			{
+				const int request = header->requestCount.get();
+
+				if (request == lastRequest)
+				{
+					// sleeps until the host hands over a block; the timeout only
+					// matters for noticing that the thread's been asked to stop
+					waitForCounterChange(header->requestCount, lastRequest, getTicksFromNow(heartbeatIntervalMs));
+					continue;
+				}
+
+				lastRequest = request;
+
+				const int numChannels = jmin((int) SandboxSharedHeader::maxChannels,
+					jmax(plugin->getNumInputChannels(), plugin->getNumOutputChannels()));
+
+				for (int i = 0; i < numChannels; ++i)
+					channels[i] = getSharedChannel(header, i);
+
+				AudioSampleBuffer buffer(channels, jmax(1, numChannels), header->numSamples);
+
+				midi.clear();
+				readMidiFromSharedMemory(getSharedArea(header, SandboxSharedHeader::midiInOffset), header->numMidiInBytes, midi);
+
+				plugin->processBlock(buffer, midi);
+
+				header->numMidiOutBytes = writeMidiToSharedMemory(midi,
+					getSharedArea(header, SandboxSharedHeader::midiOutOffset), SandboxSharedHeader::maxMidiBytes);
+
+				header->responseCount.set(request);
+				wakeCounterWaiters(header->responseCount);
+			}
+		}
+	};
+
+	// Keeps the child's heartbeat going on a thread of its own, so that it
+	// carries on while the message thread is busy loading or preparing
+	class SandboxHeartbeatThread : public Thread
+	{
+		SandboxSharedHeader* header;
+
+	public:
+		SandboxHeartbeatThread(SandboxSharedHeader* header_)
+		: Thread("Sandbox heartbeat"), header(header_)
+		{
+		}
+
+		~SandboxHeartbeatThread()
+		{
+			stopThread(2000);
+		}
+
+		void run()
+		{
+			while (!threadShouldExit())
+			{
+				header->childHeartbeat.set((int) Time::getMillisecondCounter());
+				wait(heartbeatIntervalMs);
+			}
+		}
+	};
+
+	// The child's side of the control pipe: loads the plugin into the shared
+	// memory the host set up, and passes on everything apart from the audio
+	class SandboxChild : public InterprocessConnection, public AudioProcessorListener, public DeletedAtShutdown
+	{
+		ScopedPointer<MemoryMappedFile> sharedMemory;
+		ScopedPointer<AudioPluginInstance> plugin;
+		ScopedPointer<SandboxRenderThread> renderThread;
+		ScopedPointer<SandboxHeartbeatThread> heartbeatThread;
+
+		void reply(int requestId, const String& message)
+		{
+			sendMessage(ChildProcessConnection::replyTo(requestId, message));
+		}
+
+		// changes the child reports of its own accord aren't tagged with a request
+		void notify(const String& message)
+		{
+			sendMessage(ChildProcessConnection::messageFromString(message));
+		}
+
+		const String load(const String& sharedFileName, const String& descriptionXml)
+		{
+			sharedMemory = new MemoryMappedFile(File(sharedFileName), MemoryMappedFile::readWrite);
+
+			if (sharedMemory->getData() == 0 || sharedMemory->getSize() < (size_t) SandboxSharedHeader::totalBytes)
+				return "error\nCouldn't open the shared memory";
+
+			heartbeatThread = new SandboxHeartbeatThread(getHeader());
+			heartbeatThread->startThread();
+
+			ScopedPointer<XmlElement> xml(XmlDocument::parse(descriptionXml));
+			PluginDescription desc;
+
+			if (xml == 0 || !desc.loadFromXml(*xml))
+				return "error\nBad plugin description";
+
+			String errorMessage;
+			plugin = AudioPluginFormatManager::getInstance()->createPluginInstance(desc, errorMessage);
+
+			if (plugin == 0)
+				return "error\n" + errorMessage;
+
+			plugin->addListener(this);
+
+			XmlElement info("PLUGININFO");
+			info.setAttribute("name", plugin->getName());
+			info.setAttribute("numInputs", plugin->getNumInputChannels());
+			info.setAttribute("numOutputs", plugin->getNumOutputChannels());
+			info.setAttribute("acceptsMidi", plugin->acceptsMidi());
+			info.setAttribute("producesMidi", plugin->producesMidi());
+			info.setAttribute("latency", plugin->getLatencySamples());
+			info.setAttribute("program", plugin->getCurrentProgram());
+
+			for (int i = 0; i < plugin->getNumParameters(); ++i)
+			{
+				XmlElement* const p = info.createNewChildElement("PARAM");
+				p->setAttribute("name", plugin->getParameterName(i));
+				p->setAttribute("value", plugin->getParameter(i));
+			}
+
+			for (int i = 0; i < plugin->getNumPrograms(); ++i)
+				info.createNewChildElement("PROGRAM")->setAttribute("name", plugin->getProgramName(i));
+
+			return "loaded\n" + info.createDocument(String::empty, true);
+		}
+
+		SandboxSharedHeader* getHeader() const
+		{
+			return static_cast<SandboxSharedHeader*>(sharedMemory->getData());
+		}
+
+	public:
+		SandboxChild()
+		: InterprocessConnection(true, ChildProcessConnection::magicNumber)
+		{
+		}
+
+		~SandboxChild()
+		{
+			renderThread = 0;
+			heartbeatThread = 0;
+
+			if (plugin != 0)
+				plugin->removeListener(this);
+
+			plugin = 0;
+			disconnect();
+		}
+
+		void connectionMade()
+		{
+			notify(ChildProcessConnection::readyMessage);
+		}
+
+		void connectionLost()
+		{
+			JUCEApplication::quit();
+		}
+
+		void messageReceived(const MemoryBlock& message)
+		{
+			int requestId;
+			String request;
+			ChildProcessConnection::splitRequest(message.toString(), requestId, request);
+
+			StringArray lines;
+			lines.addLines(request);
+			const String command(lines[0]);
+
+			if (command == "load")
+			{
+				reply(requestId, load(lines[1], lines.joinIntoString("\n", 2)));
+			}
+			else if (plugin == 0)
+			{
+				reply(requestId, "error\nNo plugin loaded");
+			}
+			else if (command == "prepare")
+			{
+				renderThread = 0;
+				plugin->setPlayConfigDetails(plugin->getNumInputChannels(), plugin->getNumOutputChannels(),
+					lines[1].getDoubleValue(), lines[2].getIntValue());
+				plugin->prepareToPlay(lines[1].getDoubleValue(), lines[2].getIntValue());
+
+				// the host doesn't wait for a reply to this; it holds off sending blocks
+				// until the response count reaches the number it passed along
+				const int readyCount = lines[3].getIntValue();
+				getHeader()->requestCount.set(readyCount);
+				getHeader()->responseCount.set(readyCount);
+
+				renderThread = new SandboxRenderThread(getHeader(), plugin, readyCount);
+				renderThread->startThread(9);
+			}
+			else if (command == "release")
+			{
+				renderThread = 0;
+				plugin->releaseResources();
+			}
+			else if (command == "setparam")
+			{
+				plugin->setParameter(lines[1].getIntValue(), lines[2].getFloatValue());
+			}
+			else if (command == "setprogram")
+			{
+				plugin->setCurrentProgram(lines[1].getIntValue());
+			}
+			else if (command == "getstate")
+			{
+				MemoryBlock state;
+				plugin->getStateInformation(state);
+				reply(requestId, "state\n" + state.toBase64Encoding());
+			}
+			else if (command == "setstate")
+			{
+				MemoryBlock state;
+				state.fromBase64Encoding(lines[1]);
+				plugin->setStateInformation(state.getData(), state.getSize());
+				reply(requestId, "ok");
+			}
+		}
+
+		void audioProcessorParameterChanged(AudioProcessor*, int parameterIndex, float newValue)
+		{
+			notify("param\n" + String(parameterIndex) + "\n" + String(newValue));
+		}
+
+		void audioProcessorChanged(AudioProcessor* processor)
+		{
+			notify("latency\n" + String(processor->getLatencySamples()));
+		}
+	};
+}
+
+// ==========================
+
+// The host's side of the control pipe, which also picks off the changes
+// the child reports of its own accord.  Its sender thread passes on the
+// parameter and program changes that the plugin's been given.
+class SandboxedPluginInstance::Connection : public ChildProcessConnection
+{
+	SandboxedPluginInstance& owner;
+
+	class ChangeSender : public Thread
+	{
+		Connection& connection;
+
+	public:
+		ChangeSender(Connection& connection_)
+		: Thread("Sandbox parameter sender"), connection(connection_)
+		{
+		}
+
+		~ChangeSender()
+		{
+			signalThreadShouldExit();
+			wakeCounterWaiters(connection.owner.numParameterChanges);
+			stopThread(2000);
+		}
+
+		void run()
+		{
+			SandboxedPluginInstance& owner = connection.owner;
+			int changesSent = 0;
+
+			while (!threadShouldExit())
+			{
+				if (!waitForCounterChange(owner.numParameterChanges, changesSent, getTicksFromNow(heartbeatIntervalMs)))
+					continue;
+
+				changesSent = owner.numParameterChanges.get();
+
+				// a program change goes first, since it can reset the parameters
+				const int program = owner.programToSend.exchange(-1);
+
+				if (program >= 0)
+					connection.sendCommand("setprogram\n" + String(program));
+
+				for (int i = 0; i < owner.numParameters; ++i)
+					if (owner.parametersToSend[i].compareAndSetBool(0, 1))
+						connection.sendCommand("setparam\n" + String(i) + "\n" + String(owner.parameterValues[i].get()));
+			}
+		}
+	};
+
+	ScopedPointer<ChangeSender> changeSender;
+
+public:
+	Connection(SandboxedPluginInstance& owner_)
+	: owner(owner_)
+	{
+	}
+
+	~Connection()
+	{
+		changeSender = 0;
+	}
+
+	void startSendingChanges()
+	{
+		changeSender = new ChangeSender(*this);
+		changeSender->startThread();
+	}
+
+	bool handleUnsolicitedMessage(const String& message)
+	{
+		StringArray lines;
+		lines.addLines(message);
+
+		if (lines[0] == "param")
+		{
+			const int index = lines[1].getIntValue();
+			const float value = lines[2].getFloatValue();
+
+			if (isPositiveAndBelow(index, owner.numParameters))
+			{
+				owner.parameterValues[index] = value;
+				owner.sendParamChangeMessageToListeners(index, value);
+			}
+
+			return true;
+		}
+		else if (lines[0] == "latency")
+		{
+			owner.setLatencySamples(lines[1].getIntValue());
+			return true;
+		}
+
+		return false;
+	}
+};
+
+SandboxedPluginInstance::SandboxedPluginInstance(const PluginDescription& sandboxedDescription)
+: description(sandboxedDescription), header(0), requestNumber(0),
+  numPluginInputs(0), numPluginOutputs(0), pluginAcceptsMidi(false), pluginProducesMidi(false),
+  numParameters(0), programToSend(-1), currentProgram(0)
+{
+	const File sharedDirectory("/dev/shm");
+	sharedFile = (sharedDirectory.isDirectory() ? sharedDirectory : File::getSpecialLocation(File::tempDirectory))
+		.getNonexistentChildFile("nomadloop_sandbox", ".shm", false);
+
+	MemoryBlock zeros(SandboxSharedHeader::totalBytes, true);
+
+	if (!sharedFile.replaceWithData(zeros.getData(), zeros.getSize()))
+		return;
+
+	sharedMemory = new MemoryMappedFile(sharedFile, MemoryMappedFile::readWrite);
+
+	if (sharedMemory->getData() == 0)
+		return;
+
+	connection = new Connection(*this);
+
+	if (!connection->launchChild(sandboxCommandLineFlag, String::empty, sandboxLoadTimeoutMs))
+		return;
+
+	ScopedPointer<XmlElement> realDescription(SandboxedPluginFormat::getRealDescription(description).createXml());
+	String reply;
+
+	if (!request("load\n" + sharedFile.getFullPathName() + "\n" + realDescription->createDocument(String::empty, true),
+		reply, sandboxLoadTimeoutMs))
+		return;
+
+	ScopedPointer<XmlElement> info(XmlDocument::parse(reply.fromFirstOccurrenceOf("\n", false, false)));
+
+	if (!reply.startsWith("loaded") || info == 0)
+		return;
+
+	name = info->getStringAttribute("name", description.name);
+	numPluginInputs = info->getIntAttribute("numInputs");
+	numPluginOutputs = info->getIntAttribute("numOutputs");
+	pluginAcceptsMidi = info->getBoolAttribute("acceptsMidi");
+	pluginProducesMidi = info->getBoolAttribute("producesMidi");
+	currentProgram = info->getIntAttribute("program");
+
+	forEachXmlChildElementWithTagName (*info, p, "PARAM")
+		parameterNames.add(p->getStringAttribute("name"));
+
+	numParameters = parameterNames.size();
+	parameterValues.calloc(jmax(1, numParameters));
+	parametersToSend.calloc(jmax(1, numParameters));
+
+	int index = 0;
+
+	forEachXmlChildElementWithTagName (*info, p, "PARAM")
+		parameterValues[index++] = (float) p->getDoubleAttribute("value");
+
+	forEachXmlChildElementWithTagName (*info, p, "PROGRAM")
+		programNames.add(p->getStringAttribute("name"));
+
+	setPlayConfigDetails(numPluginInputs, numPluginOutputs, 0, 0);
+	setLatencySamples(info->getIntAttribute("latency"));
+
+	header = static_cast<SandboxSharedHeader*>(sharedMemory->getData());
+	connection->startSendingChanges();
+}
+
+SandboxedPluginInstance::~SandboxedPluginInstance()
+{
+	// dropping the connection makes the child quit
+	connection = 0;
+	sharedMemory = 0;
+	sharedFile.deleteFile();
+}
+
+bool SandboxedPluginInstance::request(const String& message, String& reply, int timeoutMs)
+{
+	const ScopedLock sl(requestLock);
+
+	return connection != 0 && connection->request(message, reply, timeoutMs);
+}
+
+bool SandboxedPluginInstance::hasCrashed() const
+{
+	if (connection == 0 || connection->hasLostConnection())
+		return true;
+
+	// the millisecond counter is the same for every process, so a heartbeat that's
+	// gone quiet means the child has died, or is too stuck to be any use
+	return header != 0
+		&& Time::getMillisecondCounter() - (uint32) header->childHeartbeat.get() > (uint32) heartbeatTimeoutMs;
+}
+
+void SandboxedPluginInstance::silence(AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
+{
+	buffer.clear();
+	midiMessages.clear();
+}
+
+void SandboxedPluginInstance::fillInPluginDescription(PluginDescription &desc) const
+{
+	desc = description;
+}
+
+const String SandboxedPluginInstance::getName() const
+{
+	return name.isNotEmpty() ? name : description.name;
+}
+
+void SandboxedPluginInstance::prepareToPlay(double sampleRate, int estimatedSamplesPerBlock)
+{
+	setPlayConfigDetails(numPluginInputs, numPluginOutputs, sampleRate, estimatedSamplesPerBlock);
+
+	// The graph may call this with its callback lock held, so rather than waiting
+	// for the child, this moves the request number on to one the child will only
+	// answer with once it's ready.  Blocks are silent until then.
+	++requestNumber;
+
+	if (connection != 0)
+		connection->sendCommand("prepare\n" + String(sampleRate) + "\n" + String(estimatedSamplesPerBlock)
+			+ "\n" + String(requestNumber));
+}
+
+void SandboxedPluginInstance::releaseResources()
+{
+	// as above, and nothing more is rendered until the next prepare
+	++requestNumber;
+
+	if (connection != 0)
+		connection->sendCommand("release");
+}
+
+void SandboxedPluginInstance::processBlock(AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
+{
+	const int numSamples = buffer.getNumSamples();
+
+	// if the child has gone, or is still stuck on an earlier block, this node just goes quiet
+	if (header == 0 || hasCrashed() || numSamples > SandboxSharedHeader::maxBlockSize
+		|| header->responseCount.get() != requestNumber)
+	{
+		silence(buffer, midiMessages);
+		return;
+	}
+
+	const int numChannels = jmin((int) SandboxSharedHeader::maxChannels, buffer.getNumChannels());
+
+	for (int i = 0; i < numChannels; ++i)
+	{
+		if (i < numPluginInputs)
+			memcpy(getSharedChannel(header, i), buffer.getSampleData(i), numSamples * sizeof(float));
+		else
+			zeromem(getSharedChannel(header, i), numSamples * sizeof(float));
+	}
+
+	header->numSamples = numSamples;
+	header->numMidiInBytes = writeMidiToSharedMemory(midiMessages,
+		getSharedArea(header, SandboxSharedHeader::midiInOffset), SandboxSharedHeader::maxMidiBytes);
+
+	header->hasPositionInfo = getPlayHead() != 0 && getPlayHead()->getCurrentPosition(header->positionInfo);
+
+	// hand the block over, then give the child most of the block's duration to render it,
+	// unless we're rendering offline, in which case it can take as long as it needs
+	header->requestCount.set(++requestNumber);
+	wakeCounterWaiters(header->requestCount);
+
+	const double secondsAllowed = isNonRealtime() ? sandboxRequestTimeoutMs / 1000.0
+		: 0.8 * numSamples / jmax(1.0, getSampleRate());
+	const int64 deadline = Time::getHighResolutionTicks() + Time::secondsToHighResolutionTicks(secondsAllowed);
+
+	for (;;)
+	{
+		const int response = header->responseCount.get();
+
+		if (response == requestNumber)
+			break;
+
+		if (hasCrashed() || Time::getHighResolutionTicks() > deadline)
+		{
+			silence(buffer, midiMessages);
+			return;
+		}
+
+		// sleeps until the child answers, but looks at its heartbeat every so
+		// often in case it's died
+		waitForCounterChange(header->responseCount, response, jmin(deadline, getTicksFromNow(heartbeatIntervalMs)));
+	}
+
+	for (int i = 0; i < numChannels; ++i)
+		buffer.copyFrom(i, 0, getSharedChannel(header, i), numSamples);
+
+	// the graph hands this node the same buffer every time, so this only
+	// allocates for the first block after the graph has been rebuilt
+	midiMessages.ensureSize(midiBufferSpaceNeeded);
+	midiMessages.clear();
+	readMidiFromSharedMemory(getSharedArea(header, SandboxSharedHeader::midiOutOffset), header->numMidiOutBytes, midiMessages);
+}
+
+const String SandboxedPluginInstance::getInputChannelName(const int index) const
+{
+	return "Input " + String(index + 1);
+}
+
+const String SandboxedPluginInstance::getOutputChannelName(const int index) const
+{
+	return "Output " + String(index + 1);
+}
+
+bool SandboxedPluginInstance::isInputChannelStereoPair(int) const
+{
+	return true;
+}
+
+bool SandboxedPluginInstance::isOutputChannelStereoPair(int) const
+{
+	return true;
+}
+
+bool SandboxedPluginInstance::acceptsMidi() const
+{
+	return pluginAcceptsMidi;
+}
+
+bool SandboxedPluginInstance::producesMidi() const
+{
+	return pluginProducesMidi;
+}
+
+bool SandboxedPluginInstance::hasEditor() const
+{
+	// the plugin's own editor would have to live in the child's windows, so
+	// only the generic parameter editor is available
+	return false;
+}
+
+AudioProcessorEditor* SandboxedPluginInstance::createEditor()
+{
+	return 0;
+}
+
+int SandboxedPluginInstance::getNumParameters()
+{
+	return parameterNames.size();
+}
+
+const String SandboxedPluginInstance::getParameterName(int index)
+{
+	return parameterNames[index];
+}
+
+float SandboxedPluginInstance::getParameter(int index)
+{
+	return isPositiveAndBelow(index, numParameters) ? parameterValues[index].get() : 0.0f;
+}
+
+const String SandboxedPluginInstance::getParameterText(int index)
+{
+	return String(getParameter(index), 2);
+}
+
+void SandboxedPluginInstance::setParameter(int index, float value)
+{
+	if (!isPositiveAndBelow(index, numParameters))
+		return;
+
+	// the value has to be in place before it's flagged for sending
+	parameterValues[index] = value;
+	parametersToSend[index] = 1;
+	flagParameterChange();
+}
+
+void SandboxedPluginInstance::flagParameterChange() noexcept
+{
+	++numParameterChanges;
+	wakeCounterWaiters(numParameterChanges);
+}
+
+int SandboxedPluginInstance::getNumPrograms()
+{
+	return jmax(1, programNames.size());
+}
+
+int SandboxedPluginInstance::getCurrentProgram()
+{
+	return currentProgram.get();
+}
+
+void SandboxedPluginInstance::setCurrentProgram(int index)
+{
+	if (index < 0)
+		return;
+
+	currentProgram = index;
+	programToSend = index;
+	flagParameterChange();
+}
+
+const String SandboxedPluginInstance::getProgramName(int index)
+{
+	return programNames[index];
+}
+
+void SandboxedPluginInstance::changeProgramName(int, const String&)
+{
+}
+
+void SandboxedPluginInstance::getStateInformation(MemoryBlock& destData)
+{
+	String reply;
+
+	// if the child has crashed or stopped answering, the last state it gave
+	// is saved instead, so that saving a project doesn't lose the plugin's settings
+	if (request("getstate", reply, sandboxRequestTimeoutMs) && reply.startsWith("state"))
+		lastKnownState.fromBase64Encoding(reply.fromFirstOccurrenceOf("\n", false, false));
+
+	destData = lastKnownState;
+}
+
+void SandboxedPluginInstance::setStateInformation(const void* data, int sizeInBytes)
+{
+	lastKnownState = MemoryBlock(data, sizeInBytes);
+
+	String reply;
+	request("setstate\n" + lastKnownState.toBase64Encoding(), reply, sandboxRequestTimeoutMs);
+}
+
+// ==========================
+
+SandboxedPluginFormat::SandboxedPluginFormat()
+{
+}
+
+SandboxedPluginFormat::~SandboxedPluginFormat()
+{
+}
+
+bool SandboxedPluginFormat::canBeSandboxed(const PluginDescription& desc)
+{
+	// internal filters talk to the graph and the looper directly, so they have to stay in-process
+	return desc.pluginFormatName != "Internal" && desc.pluginFormatName != sandboxFormatName;
+}
+
+const PluginDescription SandboxedPluginFormat::createDescriptionFor(const PluginDescription& desc)
+{
+	PluginDescription sandboxed(desc);
+	sandboxed.pluginFormatName = sandboxFormatName;
+	sandboxed.fileOrIdentifier = desc.pluginFormatName + ":" + desc.fileOrIdentifier;
+	return sandboxed;
+}
+
+const PluginDescription SandboxedPluginFormat::getRealDescription(const PluginDescription& sandboxedDesc)
+{
+	PluginDescription real(sandboxedDesc);
+	real.pluginFormatName = sandboxedDesc.fileOrIdentifier.upToFirstOccurrenceOf(":", false, false);
+	real.fileOrIdentifier = sandboxedDesc.fileOrIdentifier.fromFirstOccurrenceOf(":", false, false);
+	return real;
+}
+
+bool SandboxedPluginFormat::startChildProcessIfRequested(const String& commandLine)
+{
+	StringArray arguments;
+
+	if (!ChildProcessConnection::parseCommandLine(commandLine, sandboxCommandLineFlag, arguments))
+		return false;
+
+	SandboxChild* const child = new SandboxChild();
+
+	if (!child->connectToPipe(arguments[0]))
+		JUCEApplication::quit();
+
+	return true;
+}
+
+String SandboxedPluginFormat::getName() const
+{
+	return sandboxFormatName;
+}
+
+bool SandboxedPluginFormat::fileMightContainThisPluginType(const String&)
+{
+	return false;
+}
+
+FileSearchPath SandboxedPluginFormat::getDefaultLocationsToSearch()
+{
+	return FileSearchPath();
+}
+
+void SandboxedPluginFormat::findAllTypesForFile(OwnedArray<PluginDescription>&, const String&)
+{
+}
+
+bool SandboxedPluginFormat::doesPluginStillExist(const PluginDescription& desc)
+{
+	return AudioPluginFormatManager::getInstance()->doesPluginStillExist(getRealDescription(desc));
+}
+
+String SandboxedPluginFormat::getNameOfPluginFromIdentifier(const String& fileOrIdentifier)
+{
+	return fileOrIdentifier.fromFirstOccurrenceOf(":", false, false);
+}
+
+StringArray SandboxedPluginFormat::searchPathsForPlugins(const FileSearchPath&, const bool)
+{
+	return StringArray();
+}
+
+AudioPluginInstance* SandboxedPluginFormat::createInstanceFromDescription(const PluginDescription& desc)
+{
+	if (desc.pluginFormatName != sandboxFormatName)
+		return 0;
+
+	ScopedPointer<SandboxedPluginInstance> instance(new SandboxedPluginInstance(desc));
+
+	return instance->isLoaded() ? instance.release() : 0;
+}
+
+// ==========================
+
+#if JUCE_UNIT_TESTS
+
+namespace
+{
+	const char* const standInFormatName = "SandboxStandIn";
+
+	class SandboxStandInPlugin : public AudioPluginInstance
+	{
+		float gain;
+		bool shouldCrash;
+
+	public:
+		enum Parameters
+		{
+			gainParam = 0,
+			crashParam,
+			numParams
+		};
+
+		SandboxStandInPlugin() : gain(0.5f), shouldCrash(false)
+		{
+			setPlayConfigDetails(2, 2, 0, 0);
+		}
+
+		void fillInPluginDescription(PluginDescription& desc) const		{ desc = SandboxStandInFormat::getStandInDescription(); }
+		const String getName() const									{ return T("Sandbox Stand-In"); }
+		void prepareToPlay(double, int)									{}
+		void releaseResources()											{}
+
+		void processBlock(AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
+		{
+			if (shouldCrash)
+				abort();
+
+			buffer.applyGain(0, buffer.getNumSamples(), gain);
+
+			MidiBuffer::Iterator i(midiMessages);
+			MidiMessage message(0xf8);
+			int position;
+			MidiBuffer echoes;
+
+			while (i.getNextEvent(message, position))
+				if (message.isNoteOnOrOff())
+					echoes.addEvent(MidiMessage(message.getRawData()[0], message.getNoteNumber() + 12, message.getVelocity()), position);
+
+			midiMessages.addEvents(echoes, 0, -1, 0);
+		}
+
+		const String getInputChannelName(const int) const				{ return String::empty; }
+		const String getOutputChannelName(const int) const				{ return String::empty; }
+		bool isInputChannelStereoPair(int) const						{ return true; }
+		bool isOutputChannelStereoPair(int) const						{ return true; }
+		bool acceptsMidi() const										{ return true; }
+		bool producesMidi() const										{ return true; }
+		bool hasEditor() const											{ return false; }
+		AudioProcessorEditor* createEditor()							{ return 0; }
+		int getNumParameters()											{ return numParams; }
+		const String getParameterName(int index)						{ return index == gainParam ? T("Gain") : T("Crash"); }
+		float getParameter(int index)									{ return index == gainParam ? gain : (shouldCrash ? 1.0f : 0.0f); }
+		const String getParameterText(int index)						{ return String(getParameter(index), 2); }
+		int getNumPrograms()											{ return 1; }
+		int getCurrentProgram()											{ return 0; }
+		void setCurrentProgram(int)										{}
+		const String getProgramName(int)								{ return String::empty; }
+		void changeProgramName(int, const String&)						{}
+
+		void setParameter(int index, float value)
+		{
+			if (index == gainParam)
+				gain = value;
+			else if (index == crashParam)
+				shouldCrash = value >= 0.5f;
+		}
+
+		void getStateInformation(MemoryBlock& destData)
+		{
+			destData.setSize(0);
+			destData.append(&gain, sizeof(gain));
+		}
+
+		void setStateInformation(const void* data, int sizeInBytes)
+		{
+			if (sizeInBytes == (int) sizeof(gain))
+				memcpy(&gain, data, sizeof(gain));
+		}
+	};
+}
+
+const PluginDescription SandboxStandInFormat::getStandInDescription()
+{
+	PluginDescription desc;
+	desc.name = "Sandbox Stand-In";
+	desc.pluginFormatName = standInFormatName;
+	desc.category = "Test";
+	desc.manufacturerName = "Monkey Fairness Productions";
+	desc.version = "0.1";
+	desc.fileOrIdentifier = "standin";
+	desc.uid = 1;
+	desc.isInstrument = false;
+	desc.numInputChannels = 2;
+	desc.numOutputChannels = 2;
+	return desc;
+}
+
+String SandboxStandInFormat::getName() const										{ return standInFormatName; }
+bool SandboxStandInFormat::fileMightContainThisPluginType(const String&)			{ return false; }
+FileSearchPath SandboxStandInFormat::getDefaultLocationsToSearch()					{ return FileSearchPath(); }
+void SandboxStandInFormat::findAllTypesForFile(OwnedArray<PluginDescription>&, const String&) {}
+bool SandboxStandInFormat::doesPluginStillExist(const PluginDescription&)			{ return true; }
+String SandboxStandInFormat::getNameOfPluginFromIdentifier(const String& id)		{ return id; }
+StringArray SandboxStandInFormat::searchPathsForPlugins(const FileSearchPath&, const bool) { return StringArray(); }
+
+AudioPluginInstance* SandboxStandInFormat::createInstanceFromDescription(const PluginDescription& desc)
+{
+	return desc.pluginFormatName == standInFormatName ? new SandboxStandInPlugin() : 0;
+}
+
+// ==========================
+
+class PluginSandboxTests : public UnitTest
+{
+	enum { blockSize = 256 };
+
+	AudioSampleBuffer buffer;
+	MidiBuffer midi;
+
+	// plays a block of ones with a note in it, and returns the first output sample
+	float playBlock(SandboxedPluginInstance& plugin)
+	{
+		for (int i = 0; i < buffer.getNumChannels(); ++i)
+			buffer.copyFrom(i, 0, ones, blockSize);
+
+		midi.clear();
+		midi.addEvent(MidiMessage::noteOn(1, 60, (uint8) 100), 10);
+
+		plugin.processBlock(buffer, midi);
+		return *buffer.getSampleData(0);
+	}
+
+	// the child prepares in its own time, so blocks are silent to begin with
+	float waitForSound(SandboxedPluginInstance& plugin)
+	{
+		const uint32 timeout = Time::getMillisecondCounter() + 5000;
+
+		while (Time::getMillisecondCounter() < timeout)
+		{
+			const float output = playBlock(plugin);
+
+			if (output != 0)
+				return output;
+
+			Thread::sleep(5);
+		}
+
+		return 0;
+	}
+
+	HeapBlock<float> ones;
+
+public:
+	PluginSandboxTests() : UnitTest("PluginSandbox"), buffer(2, blockSize) {}
+
+	void runTest()
+	{
+		ones.malloc(blockSize);
+
+		for (int i = 0; i < blockSize; ++i)
+			ones[i] = 1.0f;
+
+		SandboxedPluginInstance plugin(SandboxedPluginFormat::createDescriptionFor(SandboxStandInFormat::getStandInDescription()));
+
+		beginTest("Loading");
+		expect(plugin.isLoaded());
+		expectEquals(plugin.getNumParameters(), (int) SandboxStandInPlugin::numParams);
+		expect(plugin.acceptsMidi() && plugin.producesMidi());
+
+		if (!plugin.isLoaded())
+			return;
+
+		plugin.setPlayConfigDetails(2, 2, 44100, blockSize);
+		plugin.prepareToPlay(44100, blockSize);
+
+		beginTest("Rendering");
+		expectEquals(waitForSound(plugin), 0.5f);
+		expectEquals(buffer.getSampleData(1)[blockSize - 1], 0.5f);
+
+		{
+			MidiBuffer::Iterator i(midi);
+			MidiMessage message(0xf8);
+			int position, numNotes = 0;
+
+			while (i.getNextEvent(message, position))
+			{
+				expectEquals(position, 10);
+				++numNotes;
+			}
+
+			expectEquals(numNotes, 2);
+		}
+
+		beginTest("State");
+		{
+			const float gain = 0.25f;
+			plugin.setStateInformation(&gain, sizeof(gain));
+			expectEquals(waitForSound(plugin), 0.25f);
+
+			MemoryBlock state;
+			plugin.getStateInformation(state);
+			expect(state == MemoryBlock(&gain, sizeof(gain)));
+		}
+
+		beginTest("Preparing again");
+		plugin.releaseResources();
+		expectEquals(playBlock(plugin), 0.0f);
+		plugin.prepareToPlay(44100, blockSize);
+		expectEquals(waitForSound(plugin), 0.25f);
+
+		beginTest("Crashing");
+		{
+			plugin.setParameter(SandboxStandInPlugin::crashParam, 1.0f);
+
+			const uint32 timeout = Time::getMillisecondCounter() + 5000;
+
+			while (!plugin.hasCrashed() && Time::getMillisecondCounter() < timeout)
+			{
+				playBlock(plugin);
+				Thread::sleep(5);
+			}
+
+			expect(plugin.hasCrashed());
+			expectEquals(playBlock(plugin), 0.0f);
+			expect(midi.getNumEvents() == 0);
+
+			// the state it had before it went is still there to be saved
+			const float gain = 0.25f;
+			MemoryBlock state;
+			plugin.getStateInformation(state);
+			expect(state == MemoryBlock(&gain, sizeof(gain)));
+		}
+	}
+};
+
+static PluginSandboxTests pluginSandboxTests;
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef ADLER_PLUGINSANDBOX
+#define ADLER_PLUGINSANDBOX
+
+#include "../includes.h"
+#include "ChildProcessConnection.h"
+
+// The start of the memory shared between the host and a sandbox child, which
+// is followed by the audio channels and the MIDI going each way.  The host
+// fills in a block and bumps requestCount; the child renders it in place and
+// sets responseCount to match.
+struct SandboxSharedHeader
+{
+	enum
+	{
+		maxChannels = 32,
+		maxBlockSize = 16384,
+		maxMidiBytes = 65536,
+
+		headerBytes = 1024,
+		audioOffset = headerBytes,
+		midiInOffset = audioOffset + maxChannels * maxBlockSize * sizeof(float),
+		midiOutOffset = midiInOffset + maxMidiBytes,
+		totalBytes = midiOutOffset + maxMidiBytes
+	};
+
+	Atomic<int> requestCount;
+	Atomic<int> responseCount;
+
+	// the child stamps this with the millisecond counter every so often, since
+	// a child that dies doesn't always close its end of the pipe
+	Atomic<int> childHeartbeat;
+
+	int numSamples;
+	int numMidiInBytes;
+	int numMidiOutBytes;
+
+	int hasPositionInfo;
+	AudioPlayHead::CurrentPositionInfo positionInfo;
+};
+
+// A plugin running in a child copy of the host.  If the plugin crashes, or
+// can't finish a block within most of the block's duration, this node just
+// goes quiet and the rest of the graph carries on.
+class SandboxedPluginInstance : public AudioPluginInstance
+{
+	class Connection;
+	friend class Connection;
+
+	PluginDescription description;
+	ScopedPointer<Connection> connection;
+	CriticalSection requestLock;
+
+	File sharedFile;
+	ScopedPointer<MemoryMappedFile> sharedMemory;
+	SandboxSharedHeader* header;
+	int requestNumber;
+
+	String name;
+	int numPluginInputs, numPluginOutputs;
+	bool pluginAcceptsMidi, pluginProducesMidi;
+
+	// setParameter() and setCurrentProgram() get called from the audio and MIDI
+	// threads, so they only store the new values, and flag them for the
+	// connection's own thread to send on
+	StringArray parameterNames;
+	int numParameters;
+	HeapBlock<Atomic<float> > parameterValues;
+	HeapBlock<Atomic<int> > parametersToSend;
+	Atomic<int> numParameterChanges, programToSend;
+	StringArray programNames;
+	Atomic<int> currentProgram;
+
+	void flagParameterChange() noexcept;
+
+	MemoryBlock lastKnownState;
+
+	bool request(const String& message, String& reply, int timeoutMs);
+	void silence(AudioSampleBuffer& buffer, MidiBuffer& midiMessages);
+
+public:
+	SandboxedPluginInstance(const PluginDescription& sandboxedDescription);
+	~SandboxedPluginInstance();
+
+	// false if the child couldn't be started or couldn't load the plugin
+	bool isLoaded() const { return header != 0; }
+	bool hasCrashed() const;
+
+	void fillInPluginDescription(PluginDescription &desc) const;
+
+	const String getName() const;
+	void prepareToPlay(double sampleRate, int estimatedSamplesPerBlock);
+	void releaseResources();
+	void processBlock(AudioSampleBuffer &, MidiBuffer &);
+	const String getInputChannelName(const int) const;
+	const String getOutputChannelName(const int) const;
+	bool isInputChannelStereoPair(int) const;
+	bool isOutputChannelStereoPair(int) const;
+	bool acceptsMidi() const;
+	bool producesMidi() const;
+	bool hasEditor() const;
+	AudioProcessorEditor* createEditor();
+	int getNumParameters();
+	const String getParameterName(int);
+	float getParameter(int);
+	const String getParameterText(int);
+	void setParameter(int, float);
+	int getNumPrograms();
+	int getCurrentProgram();
+	void setCurrentProgram(int);
+	const String getProgramName(int);
+	void changeProgramName(int, const String&);
+	void getStateInformation(MemoryBlock&);
+	void setStateInformation(const void *, int);
+};
+
+// Wraps the descriptions of other formats' plugins so that they're created
+// as SandboxedPluginInstances.  The wrapped description is the same apart
+// from its format, with the real format's name put in front of the file or
+// identifier, so that saved graphs recreate the plugin sandboxed again.
+class SandboxedPluginFormat : public AudioPluginFormat
+{
+public:
+	SandboxedPluginFormat();
+	~SandboxedPluginFormat();
+
+	static bool canBeSandboxed(const PluginDescription& desc);
+	static const PluginDescription createDescriptionFor(const PluginDescription& desc);
+	static const PluginDescription getRealDescription(const PluginDescription& sandboxedDesc);
+
+	// If the command line asks for it, starts this process off as a sandbox
+	// child and returns true, in which case the app shouldn't open any windows
+	static bool startChildProcessIfRequested(const String& commandLine);
+
+	String getName() const;
+	bool fileMightContainThisPluginType(const String&);
+	FileSearchPath getDefaultLocationsToSearch();
+	void findAllTypesForFile(OwnedArray<PluginDescription>&, const String&);
+	bool doesPluginStillExist(const PluginDescription&);
+	String getNameOfPluginFromIdentifier(const String& fileOrIdentifier);
+	StringArray searchPathsForPlugins(const FileSearchPath&, const bool);
+	AudioPluginInstance* createInstanceFromDescription(const PluginDescription& desc);
+};
+
+#if JUCE_UNIT_TESTS
+// Makes a stand-in plugin for the sandbox's tests to load in a child, which
+// scales its input by its one parameter, echoes its MIDI an octave up, and can
+// be told to crash.  Both the host and the child need it registered.
+class SandboxStandInFormat : public AudioPluginFormat
+{
+public:
+	static const PluginDescription getStandInDescription();
+
+	String getName() const;
+	bool fileMightContainThisPluginType(const String&);
+	FileSearchPath getDefaultLocationsToSearch();
+	void findAllTypesForFile(OwnedArray<PluginDescription>&, const String&);
+	bool doesPluginStillExist(const PluginDescription&);
+	String getNameOfPluginFromIdentifier(const String& fileOrIdentifier);
+	StringArray searchPathsForPlugins(const FileSearchPath&, const bool);
+	AudioPluginInstance* createInstanceFromDescription(const PluginDescription& desc);
+};
+#endif
+
+#endif
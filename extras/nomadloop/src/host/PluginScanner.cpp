@@ -0,0 +1,352 @@
+#include "PluginScanner.h"
+#include "ChildProcessConnection.h"
+
+namespace
+{
+	const char* const scanCommandLineFlag = "--scan-plugin";
+
+	// Kills the child if its plugin hangs, so that stuck processes don't pile up
+	class ScanWatchdog : public Thread
+	{
+		int timeoutMs;
+
+	public:
+		ScanWatchdog(int timeoutMs_)
+		: Thread("Plugin scan watchdog"), timeoutMs(timeoutMs_)
+		{
+		}
+
+		~ScanWatchdog()
+		{
+			stopThread(1000);
+		}
+
+		void run()
+		{
+			if (!wait(timeoutMs))
+				Process::terminate();
+		}
+	};
+
+	// The child's side: waits for a request from the host, loads the plugin
+	// file, sends back what was found and quits.
+	class PluginScannerChild : public InterprocessConnection, public DeletedAtShutdown
+	{
+		ScanWatchdog watchdog;
+
+	public:
+		PluginScannerChild(int timeoutMs)
+		: InterprocessConnection(true, ChildProcessConnection::magicNumber), watchdog(timeoutMs)
+		{
+			watchdog.startThread();
+		}
+
+		~PluginScannerChild()
+		{
+			disconnect();
+		}
+
+		void connectionMade()
+		{
+			sendMessage(ChildProcessConnection::messageFromString(ChildProcessConnection::readyMessage));
+		}
+
+		void connectionLost()
+		{
+			JUCEApplication::quit();
+		}
+
+		void messageReceived(const MemoryBlock& message)
+		{
+			int requestId;
+			String request;
+			ChildProcessConnection::splitRequest(message.toString(), requestId, request);
+
+			const String formatName(request.upToFirstOccurrenceOf("\n", false, false));
+			const String fileOrIdentifier(request.fromFirstOccurrenceOf("\n", false, false));
+
+			XmlElement result("SCANRESULT");
+
+			for (int i = 0; i < AudioPluginFormatManager::getInstance()->getNumFormats(); ++i)
+			{
+				AudioPluginFormat* const format = AudioPluginFormatManager::getInstance()->getFormat(i);
+
+				if (format->getName() == formatName)
+				{
+					OwnedArray<PluginDescription> found;
+					format->findAllTypesForFile(found, fileOrIdentifier);
+
+					for (int j = 0; j < found.size(); ++j)
+						result.addChildElement(found[j]->createXml());
+
+					break;
+				}
+			}
+
+			sendMessage(ChildProcessConnection::replyTo(requestId, result.createDocument(String::empty, true)));
+			JUCEApplication::quit();
+		}
+	};
+}
+
+// ==========================
+
+PluginScanCache::PluginScanCache(const File& cacheFile_)
+: cacheFile(cacheFile_)
+{
+	entries = XmlDocument::parse(cacheFile);
+
+	if (entries == 0 || !entries->hasTagName("PLUGINSCANCACHE"))
+		entries = new XmlElement("PLUGINSCANCACHE");
+}
+
+PluginScanCache::~PluginScanCache()
+{
+}
+
+XmlElement* PluginScanCache::findEntry(const String& fileOrIdentifier) const
+{
+	forEachXmlChildElementWithTagName (*entries, e, "FILE")
+	{
+		if (e->getStringAttribute("path") == fileOrIdentifier)
+			return e;
+	}
+
+	return 0;
+}
+
+void PluginScanCache::getFileDetails(const String& fileOrIdentifier, int64& modTime, int64& size)
+{
+	modTime = size = 0;
+
+	// some formats use identifiers rather than files, which can't change under us
+	if (File::isAbsolutePath(fileOrIdentifier))
+	{
+		const File f(fileOrIdentifier);
+
+		if (f.exists())
+		{
+			modTime = f.getLastModificationTime().toMilliseconds();
+			size = f.getSize();
+		}
+	}
+}
+
+bool PluginScanCache::getCachedResult(const String& fileOrIdentifier, OwnedArray<PluginDescription>& typesFound, bool& failed)
+{
+	const ScopedLock sl(lock);
+	const XmlElement* const e = findEntry(fileOrIdentifier);
+
+	if (e == 0)
+		return false;
+
+	int64 modTime, size;
+	getFileDetails(fileOrIdentifier, modTime, size);
+
+	if (e->getStringAttribute("modTime").getHexValue64() != modTime
+		|| e->getStringAttribute("size").getHexValue64() != size)
+		return false;
+
+	failed = e->getBoolAttribute("failed");
+
+	forEachXmlChildElement (*e, p)
+	{
+		PluginDescription desc;
+
+		if (desc.loadFromXml(*p))
+			typesFound.add(new PluginDescription(desc));
+	}
+
+	return true;
+}
+
+void PluginScanCache::setResult(const String& fileOrIdentifier, const OwnedArray<PluginDescription>& typesFound, bool failed)
+{
+	const ScopedLock sl(lock);
+
+	XmlElement* const oldEntry = findEntry(fileOrIdentifier);
+	if (oldEntry != 0)
+		entries->removeChildElement(oldEntry, true);
+
+	int64 modTime, size;
+	getFileDetails(fileOrIdentifier, modTime, size);
+
+	XmlElement* const e = entries->createNewChildElement("FILE");
+	e->setAttribute("path", fileOrIdentifier);
+	e->setAttribute("modTime", String::toHexString(modTime));
+	e->setAttribute("size", String::toHexString(size));
+	e->setAttribute("failed", failed);
+
+	for (int i = 0; i < typesFound.size(); ++i)
+		e->addChildElement(typesFound[i]->createXml());
+}
+
+void PluginScanCache::clear()
+{
+	const ScopedLock sl(lock);
+	entries->deleteAllChildElements();
+}
+
+bool PluginScanCache::save()
+{
+	const ScopedLock sl(lock);
+	return entries->writeToFile(cacheFile, String::empty);
+}
+
+// ==========================
+
+class OutOfProcessPluginScanner::ScanJob : public ThreadPoolJob
+{
+	OutOfProcessPluginScanner& owner;
+	const String fileOrIdentifier;
+
+public:
+	ScanJob(OutOfProcessPluginScanner& owner_, const String& fileOrIdentifier_)
+	: ThreadPoolJob(fileOrIdentifier_), owner(owner_), fileOrIdentifier(fileOrIdentifier_)
+	{
+	}
+
+	JobStatus runJob()
+	{
+		OwnedArray<PluginDescription> found;
+		bool failed = true;
+
+		ChildProcessConnection connection;
+
+		if (connection.launchChild(scanCommandLineFlag, String(owner.timeoutMs), owner.timeoutMs))
+		{
+			String reply;
+
+			if (connection.request(owner.format.getName() + "\n" + fileOrIdentifier, reply, owner.timeoutMs))
+			{
+				ScopedPointer<XmlElement> xml(XmlDocument::parse(reply));
+
+				if (xml != 0 && xml->hasTagName("SCANRESULT"))
+				{
+					forEachXmlChildElement (*xml, p)
+					{
+						PluginDescription desc;
+
+						if (desc.loadFromXml(*p))
+							found.add(new PluginDescription(desc));
+					}
+
+					failed = found.size() == 0;
+				}
+			}
+		}
+
+		// an interrupted scan says nothing about the plugin, so don't remember it
+		if (!shouldExit())
+		{
+			owner.cache.setResult(fileOrIdentifier, found, failed);
+			owner.addResult(fileOrIdentifier, found, failed);
+		}
+
+		return jobHasFinishedAndShouldBeDeleted;
+	}
+};
+
+OutOfProcessPluginScanner::OutOfProcessPluginScanner(KnownPluginList& listToAddTo, PluginScanCache& cache_,
+	AudioPluginFormat& formatToLookFor, const FileSearchPath& directoriesToSearch,
+	int numProcesses_, int timeoutMs_)
+: ThreadWithProgressWindow(TRANS("Scanning for plugins..."), true, true),
+  list(listToAddTo), cache(cache_), format(formatToLookFor),
+  numProcesses(jmax(1, numProcesses_)), timeoutMs(timeoutMs_), numFinished(0)
+{
+	FileSearchPath path(directoriesToSearch);
+	path.removeRedundantPaths();
+
+	filesToScan = format.searchPathsForPlugins(path, true);
+}
+
+OutOfProcessPluginScanner::~OutOfProcessPluginScanner()
+{
+	// the scan has finished by now, so pick up whatever it found last
+	handleUpdateNowIfNeeded();
+}
+
+void OutOfProcessPluginScanner::addResult(const String& fileOrIdentifier, const OwnedArray<PluginDescription>& typesFound, bool failed)
+{
+	{
+		const ScopedLock sl(resultLock);
+
+		for (int i = 0; i < typesFound.size(); ++i)
+			typesToAdd.add(new PluginDescription(*typesFound[i]));
+
+		if (failed)
+			failedFiles.add(fileOrIdentifier);
+
+		++numFinished;
+	}
+
+	if (typesFound.size() > 0)
+		triggerAsyncUpdate();
+}
+
+void OutOfProcessPluginScanner::handleAsyncUpdate()
+{
+	OwnedArray<PluginDescription> types;
+
+	{
+		const ScopedLock sl(resultLock);
+		types.swapWithArray(typesToAdd);
+	}
+
+	for (int i = 0; i < types.size(); ++i)
+		list.addType(*types[i]);
+}
+
+void OutOfProcessPluginScanner::run()
+{
+	ThreadPool pool(numProcesses);
+
+	setStatusMessage(TRANS("Checking the plugin cache..."));
+
+	for (int i = 0; i < filesToScan.size() && !threadShouldExit(); ++i)
+	{
+		OwnedArray<PluginDescription> cached;
+		bool failed = false;
+
+		if (cache.getCachedResult(filesToScan[i], cached, failed))
+			addResult(filesToScan[i], cached, failed);
+		else
+			pool.addJob(new ScanJob(*this, filesToScan[i]));
+	}
+
+	while (pool.getNumJobs() > 0)
+	{
+		if (threadShouldExit())
+		{
+			pool.removeAllJobs(true, timeoutMs, true);
+			break;
+		}
+
+		{
+			const ScopedLock sl(resultLock);
+
+			setStatusMessage(TRANS("Scanning") + " " + String(numFinished) + " / " + String(filesToScan.size()));
+			setProgress(filesToScan.size() > 0 ? numFinished / (double) filesToScan.size() : 1.0);
+		}
+
+		wait(100);
+	}
+
+	cache.save();
+}
+
+bool OutOfProcessPluginScanner::startChildProcessIfRequested(const String& commandLine)
+{
+	StringArray arguments;
+
+	if (!ChildProcessConnection::parseCommandLine(commandLine, scanCommandLineFlag, arguments))
+		return false;
+
+	const int timeoutMs = arguments[1].getIntValue();
+	PluginScannerChild* const child = new PluginScannerChild(timeoutMs > 0 ? timeoutMs : 30000);
+
+	if (!child->connectToPipe(arguments[0]))
+		JUCEApplication::quit();
+
+	return true;
+}
@@ -0,0 +1,75 @@
+#ifndef ADLER_PLUGINSCANNER
+#define ADLER_PLUGINSCANNER
+
+#include "../includes.h"
+
+// Remembers what was found in each plugin file, keyed by the file's path,
+// modification time and size, so that a rescan only has to load the files
+// that have changed since they were last looked at.  Files that crashed or
+// timed out are remembered too, so they aren't retried until they change.
+class PluginScanCache
+{
+	File cacheFile;
+	ScopedPointer<XmlElement> entries;
+	CriticalSection lock;
+
+	XmlElement* findEntry(const String& fileOrIdentifier) const;
+	static void getFileDetails(const String& fileOrIdentifier, int64& modTime, int64& size);
+
+public:
+	PluginScanCache(const File& cacheFile);
+	~PluginScanCache();
+
+	// Returns true if there's a result for this file that's still valid, in which
+	// case the types it contained (if any) are added to the array
+	bool getCachedResult(const String& fileOrIdentifier, OwnedArray<PluginDescription>& typesFound, bool& failed);
+	void setResult(const String& fileOrIdentifier, const OwnedArray<PluginDescription>& typesFound, bool failed);
+
+	void clear();
+	bool save();
+};
+
+// Scans plugin files in child processes, several at a time, so that a plugin
+// which crashes or hangs while loading can't take the host down with it.
+// Each child is given a fixed time to report back, after which its file is
+// treated as having failed.
+//
+// The types that are found are handed over to the message thread to be added
+// to the list, since the rest of the app reads it from there; any that are
+// still waiting when the scanner is deleted are added then.
+class OutOfProcessPluginScanner : public ThreadWithProgressWindow,
+                                  private AsyncUpdater
+{
+	KnownPluginList& list;
+	PluginScanCache& cache;
+	AudioPluginFormat& format;
+	StringArray filesToScan;
+	StringArray failedFiles;
+	int numProcesses;
+	int timeoutMs;
+
+	CriticalSection resultLock;
+	int numFinished;
+	OwnedArray<PluginDescription> typesToAdd;
+
+	class ScanJob;
+	friend class ScanJob;
+	void addResult(const String& fileOrIdentifier, const OwnedArray<PluginDescription>& typesFound, bool failed);
+	void handleAsyncUpdate();
+
+public:
+	OutOfProcessPluginScanner(KnownPluginList& listToAddTo, PluginScanCache& cache,
+		AudioPluginFormat& formatToLookFor, const FileSearchPath& directoriesToSearch,
+		int numProcesses, int timeoutMs);
+	~OutOfProcessPluginScanner();
+
+	void run();
+
+	const StringArray& getFailedFiles() const { return failedFiles; }
+
+	// If the command line asks for it, starts this process off as a scanning
+	// child and returns true, in which case the app shouldn't open any windows
+	static bool startChildProcessIfRequested(const String& commandLine);
+};
+
+#endif
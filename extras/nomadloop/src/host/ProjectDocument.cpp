@@ -19,6 +19,36 @@ const String ProjectDocument::getDocumentTitle()
 }
 
 const String ProjectDocument::loadDocument (const File& file)
+{
+	ScopedPointer<XmlElement> controlSurfaceXml;
+	const String error (loadProject (file, *graph, controlSurfaceXml));
+
+	if (error.isEmpty() && controlSurfaceXml != 0)
+		controlSurfaceComp->restoreFromXml (*controlSurfaceXml);
+
+	return error;
+}
+
+const String ProjectDocument::loadProject (const File& file, FilterGraph& graphToRestore,
+										   ScopedPointer<XmlElement>& controlSurfaceXml)
+{
+	// projects saved before the binary format are XML
+	if (! ProjectFile::isProjectFile (file))
+		return loadXmlProject (file, graphToRestore, controlSurfaceXml);
+
+	ProjectFileReader reader (file);
+
+	if (! reader.isValid())
+		return "Not a valid NomadLoop project file";
+
+	graphToRestore.restoreFromProject (reader);
+	controlSurfaceXml = reader.createControlSurfaceXml();
+
+	return String::empty;
+}
+
+const String ProjectDocument::loadXmlProject (const File& file, FilterGraph& graphToRestore,
+											  ScopedPointer<XmlElement>& controlSurfaceXml)
 {
 	XmlDocument doc (file);
     XmlElement* xml = doc.getDocumentElement();
@@ -31,12 +61,12 @@ const String ProjectDocument::loadDocument (const File& file)
 
 	forEachXmlChildElementWithTagName (*xml, e, T("FILTERGRAPH"))
 	{
-		graph->restoreFromXml (*e);
+		graphToRestore.restoreFromXml (*e);
 	}
 
 	forEachXmlChildElementWithTagName (*xml, e, T("CONTROLSURFACE"))
 	{
-		controlSurfaceComp->restoreFromXml (*e);
+		controlSurfaceXml = new XmlElement (*e);
 	}
 
     delete xml;
@@ -44,20 +74,52 @@ const String ProjectDocument::loadDocument (const File& file)
     return String::empty;
 }
 
+void ProjectDocument::songSwitched (const File& file, const XmlElement* controlSurfaceXml)
+{
+	// the switcher has already swapped the new graph in
+	if (controlSurfaceXml != 0)
+		controlSurfaceComp->restoreFromXml (*controlSurfaceXml);
+
+	setFile (file);
+	setChangedFlag (false);
+	setLastDocumentOpened (file);
+}
+
 const String ProjectDocument::saveDocument (const File& file)
 {
-	XmlElement* xml = new XmlElement(T("NOMADPROJECT")); //createXml();
+	ProjectFileWriter writer (file);
+
+	graph->writeToProject (writer);
+
+	const ScopedPointer<XmlElement> controlSurfaceXml (controlSurfaceComp->createXml());
+	writer.setControlSurface (*controlSurfaceXml);
+
+	if (! writer.finish())
+		return "Couldn't write to the file";
+
+	return String::empty;
+}
+
+XmlElement* ProjectDocument::createXml() const
+{
+	XmlElement* xml = new XmlElement(T("NOMADPROJECT"));
 
 	xml->addChildElement (graph->createXml());
 
 	xml->addChildElement (controlSurfaceComp->createXml());
 
+	return xml;
+}
+
+const String ProjectDocument::exportAsXml (const File& file)
+{
+	const ScopedPointer<XmlElement> xml (createXml());
+
     String error;
 
     if (! xml->writeToFile (file, String::empty))
         error = "Couldn't write to the file";
 
-    delete xml;
     return error;
 }
 
@@ -5,8 +5,10 @@
 #include "FilterGraph.h"
 #include "GraphEditorPanel.h"
 #include "ControlSurface.h"
+#include "ProjectFile.h"
+#include "SongSwitcher.h"
 
-class ProjectDocument : public FileBasedDocument
+class ProjectDocument : public FileBasedDocument, public SongSwitcher::Listener
 {
 	ControlSurfaceComponent* controlSurfaceComp;
 	FilterGraph* graph;
@@ -19,6 +21,22 @@ public:
     const String saveDocument (const File& file);
     const File getLastDocumentOpened();
     void setLastDocumentOpened (const File& file);
+
+	// Projects are saved in the binary format, but can also be exported as
+	// XML, e.g. to compare two versions of a project.
+	XmlElement* createXml() const;
+	const String exportAsXml (const File& file);
+
+	// Restores a project into a graph, handing back the control surface layout
+	// rather than applying it, so that songs can be loaded in the background.
+	static const String loadProject (const File& file, FilterGraph& graphToRestore,
+									 ScopedPointer<XmlElement>& controlSurfaceXml);
+
+	void songSwitched (const File& file, const XmlElement* controlSurfaceXml);
+
+private:
+	static const String loadXmlProject (const File& file, FilterGraph& graphToRestore,
+										ScopedPointer<XmlElement>& controlSurfaceXml);
 };
 
 #endif
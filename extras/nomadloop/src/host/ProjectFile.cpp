@@ -0,0 +1,296 @@
+#include "ProjectFile.h"
+
+namespace
+{
+	const char magic[4] = { 'N', 'L', 'P', 'F' };
+	const int formatVersion = 1;
+
+	// magic, version, number of chunks, directory offset
+	const int headerSize = 4 + 4 + 4 + 8;
+
+	// type, reserved, offset, size
+	const int directoryEntrySize = 4 + 4 + 8 + 8;
+
+	const int chunkAlignment = 16;
+}
+
+bool ProjectFile::isProjectFile(const File& file)
+{
+	const ScopedPointer<FileInputStream> in(file.createInputStream());
+	char header[4];
+
+	return in != 0
+			&& in->read(header, 4) == 4
+			&& memcmp(header, magic, 4) == 0;
+}
+
+// ==================================================
+
+ProjectFileWriter::ProjectFileWriter(const File& targetFile)
+	: tempFile(targetFile)
+{
+	out = tempFile.getFile().createOutputStream();
+
+	if (out != 0 && out->failedToOpen())
+		out = 0;
+
+	if (out != 0)
+	{
+		// the real header is written once the directory's position is known
+		char blankHeader[headerSize] = { 0 };
+		out->write(blankHeader, headerSize);
+	}
+}
+
+ProjectFileWriter::~ProjectFileWriter()
+{
+	out = 0;
+}
+
+int ProjectFileWriter::addChunk(ProjectFile::ChunkType type, const void* data, size_t size)
+{
+	if (out == 0)
+		return -1;
+
+	const int64 position = out->getPosition();
+	const int padding = (int) ((chunkAlignment - position % chunkAlignment) % chunkAlignment);
+
+	if (padding > 0)
+	{
+		const char zeros[chunkAlignment] = { 0 };
+		out->write(zeros, padding);
+	}
+
+	ChunkInfo chunk;
+	chunk.type = (uint32) type;
+	chunk.offset = position + padding;
+	chunk.size = (int64) size;
+
+	if (size > 0 && ! out->write(data, size))
+		return -1;
+
+	chunks.add(chunk);
+	return chunks.size() - 1;
+}
+
+void ProjectFileWriter::addNode(const ProjectFile::Node& node)
+{
+	nodes.add(node);
+}
+
+void ProjectFileWriter::addConnection(const ProjectFile::Connection& connection)
+{
+	connections.add(connection);
+}
+
+void ProjectFileWriter::setControlSurface(const XmlElement& controlSurfaceXml)
+{
+	controlSurface = controlSurfaceXml.createDocument(String::empty, false, false);
+}
+
+bool ProjectFileWriter::finish()
+{
+	if (out == 0)
+		return false;
+
+	{
+		MemoryOutputStream table;
+		table.writeInt(nodes.size());
+
+		for (int i = 0; i < nodes.size(); ++i)
+		{
+			const ProjectFile::Node& n = nodes.getReference(i);
+			table.writeInt((int) n.uid);
+			table.writeDouble(n.x);
+			table.writeDouble(n.y);
+			table.writeInt(n.uiLastX);
+			table.writeInt(n.uiLastY);
+			table.writeInt(n.stateChunk);
+			table.writeString(n.pluginDescription);
+		}
+
+		addChunk(ProjectFile::nodeTableChunk, table.getData(), table.getDataSize());
+	}
+
+	{
+		MemoryOutputStream table;
+		table.writeInt(connections.size());
+
+		for (int i = 0; i < connections.size(); ++i)
+		{
+			const ProjectFile::Connection& c = connections.getReference(i);
+			table.writeInt((int) c.sourceNode);
+			table.writeInt(c.sourceChannel);
+			table.writeInt((int) c.destNode);
+			table.writeInt(c.destChannel);
+		}
+
+		addChunk(ProjectFile::connectionTableChunk, table.getData(), table.getDataSize());
+	}
+
+	if (controlSurface.isNotEmpty())
+	{
+		const MemoryBlock utf8(controlSurface.toUTF8(), controlSurface.getNumBytesAsUTF8());
+		addChunk(ProjectFile::controlSurfaceChunk, utf8.getData(), utf8.getSize());
+	}
+
+	const int64 directoryOffset = out->getPosition();
+
+	for (int i = 0; i < chunks.size(); ++i)
+	{
+		out->writeInt((int) chunks.getReference(i).type);
+		out->writeInt(0);
+		out->writeInt64(chunks.getReference(i).offset);
+		out->writeInt64(chunks.getReference(i).size);
+	}
+
+	out->setPosition(0);
+	out->write(magic, 4);
+	out->writeInt(formatVersion);
+	out->writeInt(chunks.size());
+	out->writeInt64(directoryOffset);
+	out->flush();
+
+	const bool ok = out->getStatus().wasOk();
+	out = 0;
+
+	return ok && tempFile.overwriteTargetFileWithTemporary();
+}
+
+// ==================================================
+
+ProjectFileReader::ProjectFileReader(const File& file)
+	: mappedFile(new MemoryMappedFile(file, MemoryMappedFile::readOnly)),
+	  valid(false)
+{
+	valid = readTables();
+
+	if (! valid)
+	{
+		chunks.clear();
+		nodes.clear();
+		connections.clear();
+	}
+}
+
+ProjectFileReader::~ProjectFileReader()
+{
+}
+
+bool ProjectFileReader::readTables()
+{
+	const char* const data = static_cast<const char*>(mappedFile->getData());
+	const int64 fileSize = (int64) mappedFile->getSize();
+
+	if (data == 0 || fileSize < headerSize || memcmp(data, magic, 4) != 0)
+		return false;
+
+	MemoryInputStream header(data, headerSize, false);
+	header.skipNextBytes(4);
+
+	if (header.readInt() > formatVersion)
+		return false;
+
+	const int numChunks = header.readInt();
+	const int64 directoryOffset = header.readInt64();
+
+	if (numChunks < 0 || directoryOffset < headerSize
+		 || directoryOffset + (int64) numChunks * directoryEntrySize > fileSize)
+		return false;
+
+	MemoryInputStream directory(data + directoryOffset, (size_t) numChunks * directoryEntrySize, false);
+
+	for (int i = 0; i < numChunks; ++i)
+	{
+		ChunkInfo chunk;
+		chunk.type = (uint32) directory.readInt();
+		directory.readInt();
+		chunk.offset = directory.readInt64();
+		chunk.size = directory.readInt64();
+
+		if (chunk.offset < headerSize || chunk.size < 0 || chunk.offset + chunk.size > fileSize)
+			return false;
+
+		chunks.add(chunk);
+	}
+
+	size_t size;
+	const void* nodeTable = getChunkData(findChunk(ProjectFile::nodeTableChunk), size);
+
+	if (nodeTable == 0)
+		return false;
+
+	{
+		MemoryInputStream table(nodeTable, size, false);
+		const int numNodes = table.readInt();
+
+		for (int i = 0; i < numNodes && ! table.isExhausted(); ++i)
+		{
+			ProjectFile::Node n;
+			n.uid = (uint32) table.readInt();
+			n.x = table.readDouble();
+			n.y = table.readDouble();
+			n.uiLastX = table.readInt();
+			n.uiLastY = table.readInt();
+			n.stateChunk = table.readInt();
+			n.pluginDescription = table.readString();
+
+			if (n.stateChunk >= chunks.size() || (n.stateChunk >= 0 && chunks.getReference(n.stateChunk).type != ProjectFile::pluginStateChunk))
+				n.stateChunk = -1;
+
+			nodes.add(n);
+		}
+	}
+
+	const void* connectionTable = getChunkData(findChunk(ProjectFile::connectionTableChunk), size);
+
+	if (connectionTable != 0)
+	{
+		MemoryInputStream table(connectionTable, size, false);
+		const int numConnections = jmin(table.readInt(), (int) (size / 16));
+
+		for (int i = 0; i < numConnections; ++i)
+		{
+			ProjectFile::Connection c;
+			c.sourceNode = (uint32) table.readInt();
+			c.sourceChannel = table.readInt();
+			c.destNode = (uint32) table.readInt();
+			c.destChannel = table.readInt();
+			connections.add(c);
+		}
+	}
+
+	return true;
+}
+
+int ProjectFileReader::findChunk(ProjectFile::ChunkType type) const
+{
+	for (int i = 0; i < chunks.size(); ++i)
+		if (chunks.getReference(i).type == (uint32) type)
+			return i;
+
+	return -1;
+}
+
+const void* ProjectFileReader::getChunkData(int chunkIndex, size_t& size) const
+{
+	size = 0;
+
+	if (! isPositiveAndBelow(chunkIndex, chunks.size()))
+		return 0;
+
+	const ChunkInfo& chunk = chunks.getReference(chunkIndex);
+	size = (size_t) chunk.size;
+	return static_cast<const char*>(mappedFile->getData()) + chunk.offset;
+}
+
+XmlElement* ProjectFileReader::createControlSurfaceXml() const
+{
+	size_t size;
+	const char* const text = static_cast<const char*>(getChunkData(findChunk(ProjectFile::controlSurfaceChunk), size));
+
+	if (text == 0)
+		return 0;
+
+	return XmlDocument::parse(String::fromUTF8(text, (int) size));
+}
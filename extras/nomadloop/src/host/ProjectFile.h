@@ -0,0 +1,129 @@
+#ifndef ADLER_PROJECTFILE
+#define ADLER_PROJECTFILE
+
+#include "../includes.h"
+
+// The binary project format. A file starts with a header, which gives the
+// location of a directory of chunks, each addressed by its offset:
+//  - the node table, with each filter's id, position, plugin description and
+//    the index of the chunk holding its state
+//  - the connection table
+//  - the control surface layout, as XML
+//  - one chunk of raw plugin state for each node
+//
+// Opening a project only reads the header and the tables. The state chunks are
+// read through a memory-mapped file and handed to the plugins as they are, with
+// no decoding or copying, so loading takes time proportional to the size of the
+// graph rather than the amount of state saved in it. All numbers are stored
+// little-endian, and chunks start on 16-byte boundaries.
+namespace ProjectFile
+{
+	enum ChunkType
+	{
+		nodeTableChunk = 1,
+		connectionTableChunk,
+		controlSurfaceChunk,
+		pluginStateChunk
+	};
+
+	struct Node
+	{
+		uint32 uid;
+		double x, y;
+		int uiLastX, uiLastY;
+		String pluginDescription;	// a PluginDescription's XML
+		int stateChunk;				// -1 if the node has no state
+	};
+
+	struct Connection
+	{
+		uint32 sourceNode, destNode;
+		int sourceChannel, destChannel;
+	};
+
+	// Returns true if a file starts with the project file header.
+	bool isProjectFile(const File& file);
+}
+
+// Writes a project file. The state chunks go straight out to a temporary file as
+// they're added, and the tables and directory follow them when finish() is called,
+// which then replaces the target file.
+class ProjectFileWriter
+{
+public:
+	ProjectFileWriter(const File& targetFile);
+	~ProjectFileWriter();
+
+	// Returns the index of the new chunk, or -1 if it couldn't be written.
+	int addChunk(ProjectFile::ChunkType type, const void* data, size_t size);
+
+	void addNode(const ProjectFile::Node& node);
+	void addConnection(const ProjectFile::Connection& connection);
+	void setControlSurface(const XmlElement& controlSurfaceXml);
+
+	bool finish();
+
+private:
+	struct ChunkInfo
+	{
+		uint32 type;
+		int64 offset, size;
+	};
+
+	TemporaryFile tempFile;
+	ScopedPointer<FileOutputStream> out;
+	Array<ChunkInfo> chunks;
+	Array<ProjectFile::Node> nodes;
+	Array<ProjectFile::Connection> connections;
+	String controlSurface;
+
+	ProjectFileWriter(const ProjectFileWriter&);
+	ProjectFileWriter& operator= (const ProjectFileWriter&);
+};
+
+// Reads a project file. The tables are read when it's opened, and the chunks are
+// left in the memory-mapped file until they're asked for.
+class ProjectFileReader
+{
+public:
+	ProjectFileReader(const File& file);
+	~ProjectFileReader();
+
+	// Returns false if the file couldn't be opened, or isn't a valid project.
+	bool isValid() const					{ return valid; }
+
+	int getNumNodes() const					{ return nodes.size(); }
+	const ProjectFile::Node& getNode(int index) const				{ return nodes.getReference(index); }
+
+	int getNumConnections() const			{ return connections.size(); }
+	const ProjectFile::Connection& getConnection(int index) const	{ return connections.getReference(index); }
+
+	// Returns a pointer into the mapped file, which stays valid until the reader is
+	// deleted, or 0 if there's no such chunk.
+	const void* getChunkData(int chunkIndex, size_t& size) const;
+
+	// Returns the control surface layout, or 0 if there isn't one. The caller must
+	// delete the element.
+	XmlElement* createControlSurfaceXml() const;
+
+private:
+	struct ChunkInfo
+	{
+		uint32 type;
+		int64 offset, size;
+	};
+
+	ScopedPointer<MemoryMappedFile> mappedFile;
+	Array<ChunkInfo> chunks;
+	Array<ProjectFile::Node> nodes;
+	Array<ProjectFile::Connection> connections;
+	bool valid;
+
+	int findChunk(ProjectFile::ChunkType type) const;
+	bool readTables();
+
+	ProjectFileReader(const ProjectFileReader&);
+	ProjectFileReader& operator= (const ProjectFileReader&);
+};
+
+#endif
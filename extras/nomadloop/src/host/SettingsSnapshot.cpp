@@ -1,28 +1,482 @@
-#include "SettingsSnapshot.h"
-
-SettingsSnapshotSlotComponent::SettingsSnapshotSlotComponent()
-{
-}
-
-void SettingsSnapshotSlotComponent::paint(Graphics &g)
-{
-	g.setColour(Colours::aliceblue);
-	g.drawRect(0, 0, getWidth(), getHeight());
-}
-
-// ======================================
-
-SettingsSnapshotter::SettingsSnapshotter()
-: drawable(0)
-{
-}
-
-void SettingsSnapshotter::paint(Graphics& g)
-{	
-	if (drawable != 0)
-	{
-		//g.drawImage(drawable, 0, 0, getWidth(), getHeight(), 0, 0, drawable->get
-		drawable->drawWithin(g, Rectangle<float>(getWidth(), getHeight()), RectanglePlacement::fillDestination, 1.0f);
-	}
-}
-
+#include "SettingsSnapshot.h"
+#include "ControlSurface.h"
+
+SettingsSnapshot::SettingsSnapshot()
+{
+}
+
+SettingsSnapshot::SettingsSnapshot(const SettingsSnapshot& other)
+	: nodes(other.nodes), parameters(other.parameters)
+{
+}
+
+AudioProcessor* SettingsSnapshot::getProcessor(int index) const
+{
+	return nodes.getUnchecked(parameters.getReference(index).node)->getProcessor();
+}
+
+void SettingsSnapshot::addParameter(AudioProcessorGraph::Node* node, int parameterIndex, float value)
+{
+	int nodeIndex = nodes.indexOf(node);
+
+	if (nodeIndex < 0)
+	{
+		nodeIndex = nodes.size();
+		nodes.add(node);
+	}
+
+	Parameter p;
+	p.node = nodeIndex;
+	p.parameterIndex = parameterIndex;
+	p.value = value;
+	parameters.add(p);
+}
+
+void SettingsSnapshot::capture(Component& view)
+{
+	nodes.clear();
+	parameters.clear();
+
+	HashMap<int, int> alreadyCaptured;
+	captureComponent(view, alreadyCaptured);
+}
+
+void SettingsSnapshot::captureComponent(Component& c, HashMap<int, int>& alreadyCaptured)
+{
+	ControlSurfaceMappableComponent* const control = dynamic_cast<ControlSurfaceMappableComponent*>(&c);
+
+	if (control != 0)
+	{
+		for (int i = 0; i < control->getNumControlActions(); ++i)
+		{
+			PluginParameterControlAction* const action
+				= dynamic_cast<PluginParameterControlAction*>(control->getControlAction(i));
+
+			if (action == 0 || action->getBoundNode() == 0)
+				continue;
+
+			// several controls can be mapped to the same parameter
+			const int key = (action->getBoundNodeId() << 16) ^ action->getBoundParameterIndex();
+
+			if (alreadyCaptured.contains(key))
+				continue;
+
+			alreadyCaptured.set(key, 1);
+
+			AudioProcessorGraph::Node* const node = action->getBoundNode();
+			addParameter(node, action->getBoundParameterIndex(),
+				node->getProcessor()->getParameter(action->getBoundParameterIndex()));
+		}
+	}
+
+	for (int i = 0; i < c.getNumChildComponents(); ++i)
+		captureComponent(*c.getChildComponent(i), alreadyCaptured);
+}
+
+void SettingsSnapshot::writeToXml(XmlElement& xml) const
+{
+	// node id, parameter and value for each entry, which is much smaller than
+	// an element apiece when there are hundreds of them
+	MemoryOutputStream out;
+
+	for (int i = 0; i < parameters.size(); ++i)
+	{
+		const Parameter& p = parameters.getReference(i);
+		out.writeInt((int) nodes.getUnchecked(p.node)->nodeId);
+		out.writeInt(p.parameterIndex);
+		out.writeFloat(p.value);
+	}
+
+	MemoryBlock m(out.getData(), out.getDataSize());
+	xml.setAttribute(T("values"), m.toBase64Encoding());
+}
+
+void SettingsSnapshot::restoreFromXml(const XmlElement& xml, FilterGraph& graph)
+{
+	nodes.clear();
+	parameters.clear();
+
+	MemoryBlock m;
+	m.fromBase64Encoding(xml.getStringAttribute(T("values")));
+
+	MemoryInputStream in(m.getData(), m.getSize(), false);
+
+	while (in.getTotalLength() - in.getPosition() >= 12)
+	{
+		const uint32 nodeId = (uint32) in.readInt();
+		const int parameterIndex = in.readInt();
+		const float value = in.readFloat();
+
+		// the filter may have been removed since the snapshot was taken
+		AudioProcessorGraph::Node* const node = graph.getNodeForId(nodeId);
+
+		if (node != 0 && parameterIndex < node->getProcessor()->getNumParameters())
+			addParameter(node, parameterIndex, value);
+	}
+}
+
+// ==================================================
+
+// AudioProcessor only lets its subclasses tell its listeners about a parameter, so
+// this reaches the method through one, without setting the parameter again
+struct ParameterChangeNotifier  : public AudioProcessor
+{
+	static void send(AudioProcessor& processor, int parameterIndex, float value)
+	{
+		void (AudioProcessor::* const sendMessage)(int, float) = &ParameterChangeNotifier::sendParamChangeMessageToListeners;
+		(processor.*sendMessage)(parameterIndex, value);
+	}
+};
+
+class SnapshotMorpher::Morph
+{
+public:
+	Morph(const SettingsSnapshot& target_, double seconds_)
+		: target(target_), startValues(target_.getNumParameters()), seconds(seconds_),
+		  lengthInSamples(1), position(0), timePosted(Time::getMillisecondCounter()), nextRetired(0)
+	{
+	}
+
+	// Called on the audio thread when the morph takes over.
+	void start(double sampleRate, int blockSize)
+	{
+		for (int i = 0; i < target.getNumParameters(); ++i)
+			startValues[i] = target.getProcessor(i)->getParameter(target.getParameterIndex(i));
+
+		lengthInSamples = jmax(1, minimumMorphBlocks * blockSize,
+							   roundToInt(jmax(seconds, minimumMorphMs / 1000.0) * sampleRate));
+	}
+
+	// Moves the parameters on by a block, returning true once they've arrived.
+	bool advance(int numSamples)
+	{
+		position = jmin(position + numSamples, lengthInSamples);
+		const float proportion = position / (float) lengthInSamples;
+
+		for (int i = 0; i < target.getNumParameters(); ++i)
+		{
+			const float endValue = target.getValue(i);
+
+			if (startValues[i] != endValue)
+				target.getProcessor(i)->setParameter(target.getParameterIndex(i),
+					startValues[i] + (endValue - startValues[i]) * proportion);
+		}
+
+		return position >= lengthInSamples;
+	}
+
+	// Without an audio device running, the values are just set straight away.
+	void finishImmediately()
+	{
+		for (int i = 0; i < target.getNumParameters(); ++i)
+			target.getProcessor(i)->setParameter(target.getParameterIndex(i), target.getValue(i));
+	}
+
+	const SettingsSnapshot target;
+	HeapBlock<float> startValues;
+	const double seconds;
+	int lengthInSamples, position;
+	const uint32 timePosted;
+
+	Morph* nextRetired;
+
+private:
+	Morph(const Morph&);
+	const Morph& operator=(const Morph&);
+};
+
+juce_ImplementSingleton (SnapshotMorpher)
+
+SnapshotMorpher::SnapshotMorpher()
+	: activeMorph(0), numMorphsAlive(0)
+{
+}
+
+SnapshotMorpher::~SnapshotMorpher()
+{
+	delete pendingMorph.exchange(0);
+	delete activeMorph;
+	deleteRetiredMorphs();
+
+	clearSingletonInstance();
+}
+
+void SnapshotMorpher::recall(const SettingsSnapshot& snapshot, double morphSeconds)
+{
+	Morph* const morph = new Morph(snapshot, morphSeconds);
+	++numMorphsAlive;
+	recalledSnapshots.add(new SettingsSnapshot(snapshot));
+
+	// a recall that the audio thread hasn't got round to yet is simply replaced
+	Morph* const superseded = pendingMorph.exchange(morph);
+
+	if (superseded != 0)
+	{
+		delete superseded;
+		--numMorphsAlive;
+	}
+
+	startTimer(100);
+}
+
+void SnapshotMorpher::process(int numSamples, double sampleRate)
+{
+	Morph* const newMorph = pendingMorph.exchange(0);
+
+	if (newMorph != 0)
+	{
+		if (activeMorph != 0)
+			retire(activeMorph);
+
+		activeMorph = newMorph;
+		activeMorph->start(sampleRate, numSamples);
+	}
+
+	if (activeMorph != 0 && activeMorph->advance(numSamples))
+	{
+		retire(activeMorph);
+		activeMorph = 0;
+	}
+}
+
+void SnapshotMorpher::retire(Morph* morph)
+{
+	// only the audio thread pushes, and the message thread takes the whole list at once
+	do
+	{
+		morph->nextRetired = retiredMorphs.get();
+	}
+	while (! retiredMorphs.compareAndSetBool(morph, morph->nextRetired));
+}
+
+void SnapshotMorpher::deleteRetiredMorphs()
+{
+	Morph* morph = retiredMorphs.exchange(0);
+
+	while (morph != 0)
+	{
+		Morph* const next = morph->nextRetired;
+		delete morph;
+		--numMorphsAlive;
+		morph = next;
+	}
+}
+
+void SnapshotMorpher::timerCallback()
+{
+	deleteRetiredMorphs();
+
+	// if nothing has picked the recall up, the audio isn't running
+	Morph* const waiting = pendingMorph.get();
+
+	if (waiting != 0 && Time::getMillisecondCounter() - waiting->timePosted > 500
+		 && pendingMorph.compareAndSetBool(0, waiting))
+	{
+		waiting->finishImmediately();
+		delete waiting;
+		--numMorphsAlive;
+	}
+
+	// once nothing is moving them, this reports where they ended up
+	notifyListeners();
+
+	if (numMorphsAlive == 0)
+	{
+		recalledSnapshots.clear();
+		stopTimer();
+	}
+}
+
+void SnapshotMorpher::notifyListeners()
+{
+	for (int i = 0; i < recalledSnapshots.size(); ++i)
+	{
+		const SettingsSnapshot& snapshot = *recalledSnapshots.getUnchecked(i);
+
+		for (int j = 0; j < snapshot.getNumParameters(); ++j)
+		{
+			AudioProcessor* const processor = snapshot.getProcessor(j);
+			const int parameterIndex = snapshot.getParameterIndex(j);
+
+			ParameterChangeNotifier::send(*processor, parameterIndex, processor->getParameter(parameterIndex));
+		}
+	}
+}
+
+// ==================================================
+
+SettingsSnapshotSlotComponent::SettingsSnapshotSlotComponent()
+	: morphSeconds(0), selected(false)
+{
+}
+
+void SettingsSnapshotSlotComponent::paint(Graphics &g)
+{
+	if (snapshot != 0)
+	{
+		g.setColour(Colours::aliceblue.withAlpha(selected ? 0.6f : 0.3f));
+		g.fillRect(0, 0, getWidth(), getHeight());
+
+		if (morphSeconds > 0)
+		{
+			g.setColour(Colours::white);
+			g.setFont(10.0f);
+			g.drawText(String(morphSeconds, 1) + "s", 2, getHeight() - 14, getWidth() - 4, 12,
+				Justification::centredRight, false);
+		}
+	}
+
+	g.setColour(Colours::aliceblue);
+	g.drawRect(0, 0, getWidth(), getHeight(), selected ? 2 : 1);
+}
+
+void SettingsSnapshotSlotComponent::mouseDown(const MouseEvent& e)
+{
+	if (e.mods.isPopupMenu())
+	{
+		const double times[] = { 0, 0.5, 1, 2, 4, 8 };
+
+		PopupMenu morphMenu;
+		for (int i = 0; i < numElementsInArray(times); ++i)
+			morphMenu.addItem(i + 1, i == 0 ? String("Instant") : String(times[i], 1) + " seconds",
+				true, morphSeconds == times[i]);
+
+		PopupMenu m;
+		m.addSubMenu(T("Morph time"), morphMenu);
+		m.addItem(-1, T("Clear"), snapshot != 0);
+
+		const int choice = m.show();
+
+		if (choice == -1)
+			setSnapshot(0);
+		else if (choice > 0)
+			morphSeconds = times[choice - 1];
+
+		repaint();
+	}
+	else
+	{
+		recall();
+	}
+}
+
+void SettingsSnapshotSlotComponent::setSnapshot(SettingsSnapshot* newSnapshot)
+{
+	snapshot = newSnapshot;
+	repaint();
+}
+
+void SettingsSnapshotSlotComponent::recall()
+{
+	if (snapshot == 0)
+		return;
+
+	SnapshotMorpher::getInstance()->recall(*snapshot, morphSeconds);
+
+	DashboardComponent* const dashboard = findParentComponentOfClass((DashboardComponent*) 0);
+
+	if (dashboard != 0)
+		dashboard->selectSnapshotSlot(this);
+}
+
+void SettingsSnapshotSlotComponent::setSelected(bool shouldBeSelected)
+{
+	if (selected != shouldBeSelected)
+	{
+		selected = shouldBeSelected;
+		repaint();
+	}
+}
+
+XmlElement* SettingsSnapshotSlotComponent::createXml() const
+{
+	XmlElement* xml = new XmlElement(T("SNAPSHOT"));
+	xml->setAttribute(T("morphSeconds"), morphSeconds);
+
+	if (snapshot != 0)
+		snapshot->writeToXml(*xml);
+
+	return xml;
+}
+
+void SettingsSnapshotSlotComponent::restoreFromXml(const XmlElement& xml, FilterGraph& graph)
+{
+	morphSeconds = xml.getDoubleAttribute(T("morphSeconds"));
+
+	if (xml.hasAttribute(T("values")))
+	{
+		SettingsSnapshot* const s = new SettingsSnapshot();
+		s->restoreFromXml(xml, graph);
+		setSnapshot(s);
+	}
+	else
+	{
+		setSnapshot(0);
+	}
+}
+
+// ======================================
+
+SettingsSnapshotter::SettingsSnapshotter()
+: drawable(0)
+{
+}
+
+void SettingsSnapshotter::paint(Graphics& g)
+{
+	if (drawable != 0)
+	{
+		//g.drawImage(drawable, 0, 0, getWidth(), getHeight(), 0, 0, drawable->get
+		drawable->drawWithin(g, Rectangle<float>(getWidth(), getHeight()), RectanglePlacement::fillDestination, 1.0f);
+	}
+	else
+	{
+		g.setColour(isMouseButtonDown() ? Colours::aliceblue.withAlpha(0.5f) : Colours::aliceblue.withAlpha(0.2f));
+		g.fillRoundedRectangle(1.0f, 1.0f, getWidth() - 2.0f, getHeight() - 2.0f, 4.0f);
+		g.setColour(Colours::white);
+		g.drawFittedText(T("Snapshot"), 0, 0, getWidth(), getHeight(), Justification::centred, 2);
+	}
+}
+
+void SettingsSnapshotter::mouseDown(const MouseEvent& e)
+{
+	if (e.mods.isPopupMenu())
+	{
+		PopupMenu m;
+		m.addItem(-1, T("Move"));
+		m.addItem(-2, T("Resize"));
+		m.addItem(-3, T("Delete"));
+
+		const int choice = m.show();
+		SubviewComponent* const view = dynamic_cast<SubviewComponent*>(getParentComponent());
+
+		if (choice == -1 && view != 0)
+			view->setMovingComponent(this);
+		else if (choice == -2 && view != 0)
+			view->setResizingComponent(this);
+		else if (choice == -3)
+			delete this;
+
+		return;
+	}
+
+	repaint();
+}
+
+void SettingsSnapshotter::mouseUp(const MouseEvent& e)
+{
+	repaint();
+
+	if (e.mods.isPopupMenu() || ! contains(Point<int>(e.x, e.y)) || getParentComponent() == 0)
+		return;
+
+	ControlSurfaceComponent* const surface = findParentComponentOfClass((ControlSurfaceComponent*) 0);
+
+	if (surface == 0)
+		return;
+
+	SettingsSnapshot* const snapshot = new SettingsSnapshot();
+	snapshot->capture(*getParentComponent());
+
+	surface->getDashboard()->storeSnapshot(snapshot);
+}
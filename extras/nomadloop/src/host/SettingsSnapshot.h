@@ -1,26 +1,128 @@
-#ifndef ADLER_SNAPSHOT
-#define ADLER_SNAPSHOT
-
-#include "../includes.h"
-
-class SettingsSnapshotSlotComponent : public Component
-{
-public:
-	SettingsSnapshotSlotComponent();
-
-	void paint(Graphics &g);
-};
-
-// This is a special control similar to a button.
-// When pressed, it grabs the settings for the components in the same Subview
-// and stores them as a snapshot in the dashboard, which can later be restored.
-class SettingsSnapshotter : public Component
-{
-	Drawable* drawable;
-public:
-	SettingsSnapshotter();
-
-	void paint(Graphics &g);
-};
-
-#endif
+#ifndef ADLER_SNAPSHOT
+#define ADLER_SNAPSHOT
+
+#include "../includes.h"
+
+class FilterGraph;
+
+// The values of a set of plugin parameters, held as one compact vector: each
+// entry is just an index into the list of nodes, a parameter number and a value.
+class SettingsSnapshot
+{
+public:
+	SettingsSnapshot();
+	SettingsSnapshot(const SettingsSnapshot&);
+
+	// Takes the current value of every plugin parameter that a control in this
+	// component, or any nested inside it, is mapped to.
+	void capture(Component& view);
+
+	int getNumParameters() const					{ return parameters.size(); }
+	AudioProcessor* getProcessor(int index) const;
+	int getParameterIndex(int index) const			{ return parameters.getReference(index).parameterIndex; }
+	float getValue(int index) const					{ return parameters.getReference(index).value; }
+
+	void writeToXml(XmlElement& xml) const;
+	void restoreFromXml(const XmlElement& xml, FilterGraph& graph);
+
+private:
+	struct Parameter
+	{
+		int node;
+		int parameterIndex;
+		float value;
+	};
+
+	ReferenceCountedArray<AudioProcessorGraph::Node> nodes;
+	Array<Parameter> parameters;
+
+	void addParameter(AudioProcessorGraph::Node* node, int parameterIndex, float value);
+	void captureComponent(Component& c, HashMap<int, int>& alreadyCaptured);
+
+	const SettingsSnapshot& operator=(const SettingsSnapshot&);
+};
+
+// Moves parameters to the values in a snapshot on the audio thread, either at
+// once or gradually over a given time, recalculated once per audio block. The
+// audio thread only sets the parameters; the plugins' listeners are told about
+// the new values from the message thread while the recall is under way.
+//
+// A recall is prepared on the message thread and handed over through an atomic
+// slot, so the GUI never waits for the audio thread, however many parameters
+// there are. The audio thread reads each parameter's value when it picks the
+// recall up, so a new recall carries on smoothly from wherever an unfinished
+// one had got to. Finished recalls are passed back to the message thread to be
+// deleted, since they may hold the last reference to a node.
+class SnapshotMorpher : private Timer, public DeletedAtShutdown
+{
+public:
+	SnapshotMorpher();
+	~SnapshotMorpher();
+
+	// Even an instant recall is ramped over at least this long, and over at least
+	// this many blocks, since the values only move once a block, so that parameters
+	// that change the sound abruptly don't click.
+	enum { minimumMorphMs = 5, minimumMorphBlocks = 4 };
+
+	void recall(const SettingsSnapshot& snapshot, double morphSeconds);
+
+	// Called by the audio thread at the start of each block.
+	void process(int numSamples, double sampleRate);
+
+	juce_DeclareSingleton (SnapshotMorpher, false)
+
+private:
+	class Morph;
+
+	Atomic<Morph*> pendingMorph;	// waiting for the audio thread to pick it up
+	Morph* activeMorph;				// belongs to the audio thread
+	Atomic<Morph*> retiredMorphs;	// waiting for the message thread to delete them
+	int numMorphsAlive;
+	OwnedArray<SettingsSnapshot> recalledSnapshots;	// the message thread's copies, for telling listeners
+
+	void retire(Morph* morph);
+	void deleteRetiredMorphs();
+	void notifyListeners();
+
+	void timerCallback();
+};
+
+class SettingsSnapshotSlotComponent : public Component
+{
+public:
+	SettingsSnapshotSlotComponent();
+
+	void paint(Graphics &g);
+	void mouseDown(const MouseEvent& e);
+
+	bool hasSnapshot() const						{ return snapshot != 0; }
+	void setSnapshot(SettingsSnapshot* newSnapshot);
+	void recall();
+
+	void setSelected(bool shouldBeSelected);
+	bool isSelected() const							{ return selected; }
+
+	XmlElement* createXml() const;
+	void restoreFromXml(const XmlElement& xml, FilterGraph& graph);
+
+private:
+	ScopedPointer<SettingsSnapshot> snapshot;
+	double morphSeconds;
+	bool selected;
+};
+
+// This is a special control similar to a button.
+// When pressed, it grabs the settings for the components in the same Subview
+// and stores them as a snapshot in the dashboard, which can later be restored.
+class SettingsSnapshotter : public Component
+{
+	Drawable* drawable;
+public:
+	SettingsSnapshotter();
+
+	void paint(Graphics &g);
+	void mouseDown(const MouseEvent& e);
+	void mouseUp(const MouseEvent& e);
+};
+
+#endif
@@ -0,0 +1,403 @@
+#include "SongSwitcher.h"
+#include "ProjectDocument.h"
+#include "SettingsSnapshot.h"
+
+class SongSwitcher::StandbySong
+{
+public:
+	StandbySong(const File& file_) : file(file_) {}
+
+	~StandbySong()
+	{
+		graph.getGraph().releaseResources();
+	}
+
+	const File file;
+	FilterGraph graph;
+	ScopedPointer<XmlElement> controlSurfaceXml;
+};
+
+// ==================================================
+
+SongSwitcher::SongSwitcher(FilterGraph& liveGraph_)
+	: liveGraph(liveGraph_), maxNumStandbyGraphs(2), isPrepared(false),
+	  current(&liveGraph_.getGraph()), incoming(0), switchMode(crossfade),
+	  samplesUntilSwitch(-1), fadeLength(1), fadePosition(0), switchHasFinished(false),
+	  incomingBuffer(1, 1)
+{
+}
+
+SongSwitcher::~SongSwitcher()
+{
+	cancelPendingUpdate();
+}
+
+const String SongSwitcher::preload(const File& projectFile)
+{
+	if (isPreloaded(projectFile))
+		return String::empty;
+
+	ScopedPointer<StandbySong> song(new StandbySong(projectFile));
+
+	// the plugins pick up the play head as they're added to the graph, and the
+	// connections to the audio i/o can only be made once it knows its channels
+	AudioProcessorGraph& graph = song->graph.getGraph();
+	graph.setPlayHead(getPlayHead());
+	graph.setPlayConfigDetails(liveGraph.getGraph().getNumInputChannels(), liveGraph.getGraph().getNumOutputChannels(),
+		liveGraph.getGraph().getSampleRate(), liveGraph.getGraph().getBlockSize());
+
+	const String error(ProjectDocument::loadProject(projectFile, song->graph, song->controlSurfaceXml));
+
+	if (error.isNotEmpty())
+		return error;
+
+	song->graph.setFile(projectFile);
+	song->graph.setChangedFlag(false);
+
+	{
+		const ScopedLock sl(standbyLock);
+
+		if (isPrepared)
+			prepareGraph(graph);
+
+		standbySongs.add(song.release());
+	}
+
+	removeExcessStandbyGraphs();
+	return String::empty;
+}
+
+bool SongSwitcher::isPreloaded(const File& projectFile) const
+{
+	return findStandbySong(projectFile) != 0;
+}
+
+int SongSwitcher::getNumPreloadedSongs() const
+{
+	const ScopedLock sl(standbyLock);
+	return standbySongs.size();
+}
+
+const File SongSwitcher::getPreloadedSong(int index) const
+{
+	const ScopedLock sl(standbyLock);
+	StandbySong* const song = standbySongs[index];
+
+	return song != 0 ? song->file : File::nonexistent;
+}
+
+void SongSwitcher::discard(const File& projectFile)
+{
+	ScopedPointer<StandbySong> discarded;
+
+	{
+		const ScopedLock sl(getCallbackLock());
+		const ScopedLock sl2(standbyLock);
+
+		StandbySong* const song = findStandbySong(projectFile);
+
+		if (song == 0 || isInUse(*song))
+			return;
+
+		standbySongs.removeObject(song, false);
+		discarded = song;
+	}
+}
+
+void SongSwitcher::setMaxNumStandbyGraphs(int maxNumGraphs)
+{
+	maxNumStandbyGraphs = jmax(0, maxNumGraphs);
+	removeExcessStandbyGraphs();
+}
+
+void SongSwitcher::removeExcessStandbyGraphs()
+{
+	// the graphs are deleted once the locks have been let go of, so the audio thread isn't held up
+	OwnedArray<StandbySong> discarded;
+
+	{
+		const ScopedLock sl(getCallbackLock());
+		const ScopedLock sl2(standbyLock);
+
+		// the oldest go first, but not one that's being switched to, or that's playing
+		for (int i = 0; i < standbySongs.size() && standbySongs.size() > maxNumStandbyGraphs;)
+		{
+			if (isInUse(*standbySongs.getUnchecked(i)))
+				++i;
+			else
+				discarded.add(standbySongs.removeAndReturn(i));
+		}
+	}
+}
+
+bool SongSwitcher::isInUse(StandbySong& song) const
+{
+	// once the audio thread has switched to a song, its graph is the current one, but it
+	// still belongs to the standby song until handleAsyncUpdate() hands it to the live graph
+	const AudioProcessorGraph* const graph = &song.graph.getGraph();
+	return graph == incoming || graph == current;
+}
+
+SongSwitcher::StandbySong* SongSwitcher::findStandbySong(const File& projectFile) const
+{
+	const ScopedLock sl(standbyLock);
+
+	for (int i = 0; i < standbySongs.size(); ++i)
+		if (standbySongs.getUnchecked(i)->file == projectFile)
+			return standbySongs.getUnchecked(i);
+
+	return 0;
+}
+
+SongSwitcher::StandbySong* SongSwitcher::findStandbySong(const AudioProcessorGraph* graph) const
+{
+	const ScopedLock sl(standbyLock);
+
+	for (int i = 0; i < standbySongs.size(); ++i)
+		if (&standbySongs.getUnchecked(i)->graph.getGraph() == graph)
+			return standbySongs.getUnchecked(i);
+
+	return 0;
+}
+
+// ==================================================
+
+bool SongSwitcher::switchTo(const File& projectFile, SwitchMode mode, int crossfadeSamples)
+{
+	{
+		const ScopedLock sl(getCallbackLock());
+
+		StandbySong* const song = findStandbySong(projectFile);
+
+		if (song == 0 || incoming != 0 || switchHasFinished)
+			return false;
+
+		incoming = &song->graph.getGraph();
+		switchMode = mode;
+		samplesUntilSwitch = -1;
+		fadeLength = jmax(1, crossfadeSamples);
+		fadePosition = 0;
+
+		// with no audio running, there's nothing to line the switch up with
+		if (! isPrepared)
+		{
+			current = incoming;
+			incoming = 0;
+			switchHasFinished = true;
+		}
+	}
+
+	if (! isPrepared)
+		triggerAsyncUpdate();
+
+	return true;
+}
+
+bool SongSwitcher::isSwitching() const
+{
+	const ScopedLock sl(getCallbackLock());
+	return incoming != 0 || switchHasFinished;
+}
+
+void SongSwitcher::handleAsyncUpdate()
+{
+	StandbySong* song;
+
+	{
+		const ScopedLock sl(getCallbackLock());
+
+		if (! switchHasFinished)
+			return;
+
+		switchHasFinished = false;
+		song = findStandbySong(current);
+	}
+
+	if (song == 0)
+		return;
+
+	// the new graph is already playing, so this only changes which document owns it
+	liveGraph.swapWith(song->graph);
+
+	const File file(song->file);
+	const ScopedPointer<XmlElement> controlSurfaceXml(song->controlSurfaceXml.release());
+
+	{
+		const ScopedLock sl(standbyLock);
+		standbySongs.removeObject(song);
+	}
+
+	listeners.call(&Listener::songSwitched, file, (const XmlElement*) controlSurfaceXml);
+}
+
+void SongSwitcher::addListener(Listener* listener)
+{
+	listeners.add(listener);
+}
+
+void SongSwitcher::removeListener(Listener* listener)
+{
+	listeners.remove(listener);
+}
+
+// ==================================================
+
+void SongSwitcher::prepareGraph(AudioProcessorGraph& graph)
+{
+	graph.setPlayConfigDetails(getNumInputChannels(), getNumOutputChannels(),
+		getSampleRate(), getBlockSize());
+
+	graph.prepareToPlay(getSampleRate(), getBlockSize());
+}
+
+void SongSwitcher::prepareToPlay(double, int estimatedSamplesPerBlock)
+{
+	const ScopedLock sl(standbyLock);
+
+	prepareGraph(*current);
+
+	for (int i = 0; i < standbySongs.size(); ++i)
+		if (&standbySongs.getUnchecked(i)->graph.getGraph() != current)
+			prepareGraph(standbySongs.getUnchecked(i)->graph.getGraph());
+
+	// a switch needs a second buffer, which mustn't be allocated on the audio thread
+	incomingBuffer.setSize(jmax(1, getNumInputChannels(), getNumOutputChannels()), estimatedSamplesPerBlock);
+	incomingMidi.ensureSize(2048);
+	spareMidi.ensureSize(2048);
+
+	isPrepared = true;
+}
+
+void SongSwitcher::releaseResources()
+{
+	const ScopedLock sl(standbyLock);
+
+	isPrepared = false;
+	current->releaseResources();
+
+	for (int i = 0; i < standbySongs.size(); ++i)
+		if (&standbySongs.getUnchecked(i)->graph.getGraph() != current)
+			standbySongs.getUnchecked(i)->graph.getGraph().releaseResources();
+}
+
+void SongSwitcher::render(AudioProcessorGraph& graph, AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
+{
+	if (graph.isNonRealtime() != isNonRealtime())
+		graph.setNonRealtime(isNonRealtime());
+
+	// the graph swaps in a new rendering sequence under its own callback lock
+	const ScopedLock sl(graph.getCallbackLock());
+	graph.processBlock(buffer, midiMessages);
+}
+
+void SongSwitcher::processBlock(AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
+{
+	// recalled snapshots move their parameters on once per block, before anything's rendered
+	SnapshotMorpher* const morpher = SnapshotMorpher::getInstanceWithoutCreating();
+
+	if (morpher != 0)
+		morpher->process(buffer.getNumSamples(), getSampleRate());
+
+	if (incoming == 0)
+	{
+		render(*current, buffer, midiMessages);
+		return;
+	}
+
+	const int numSamples = buffer.getNumSamples();
+	const int numChannels = buffer.getNumChannels();
+
+	// the new song hears the same input as the old one
+	incomingBuffer.setSize(numChannels, numSamples, false, false, true);
+
+	for (int i = 0; i < numChannels; ++i)
+		incomingBuffer.copyFrom(i, 0, buffer, i, 0, numSamples);
+
+	incomingMidi.clear();
+	incomingMidi.addEvents(midiMessages, 0, numSamples, 0);
+
+	render(*current, buffer, midiMessages);
+	render(*incoming, incomingBuffer, incomingMidi);
+
+	// from this sample on, the block comes only from the new song
+	int newSongOnly;
+	bool finished;
+
+	if (switchMode == swapAtNextBar)
+	{
+		if (samplesUntilSwitch < 0)
+			samplesUntilSwitch = getSamplesUntilNextBar();
+
+		newSongOnly = jmin(samplesUntilSwitch, numSamples);
+		samplesUntilSwitch -= newSongOnly;
+		finished = samplesUntilSwitch == 0;
+
+		spliceMidi(midiMessages, newSongOnly, newSongOnly, numSamples);
+	}
+	else
+	{
+		newSongOnly = jmin(fadeLength - fadePosition, numSamples);
+
+		const float startGain = fadePosition / (float) fadeLength;
+		const float endGain = (fadePosition + newSongOnly) / (float) fadeLength;
+
+		for (int i = 0; i < numChannels; ++i)
+		{
+			buffer.applyGainRamp(i, 0, newSongOnly, 1.0f - startGain, 1.0f - endGain);
+			buffer.addFromWithRamp(i, 0, incomingBuffer.getSampleData(i), newSongOnly, startGain, endGain);
+		}
+
+		fadePosition += newSongOnly;
+		finished = fadePosition >= fadeLength;
+
+		// while both songs are playing, so is both songs' MIDI
+		spliceMidi(midiMessages, newSongOnly, 0, numSamples);
+	}
+
+	if (newSongOnly < numSamples)
+		for (int i = 0; i < numChannels; ++i)
+			buffer.copyFrom(i, newSongOnly, incomingBuffer, i, newSongOnly, numSamples - newSongOnly);
+
+	if (finished)
+	{
+		current = incoming;
+		incoming = 0;
+		switchHasFinished = true;
+		triggerAsyncUpdate();
+	}
+}
+
+int SongSwitcher::getSamplesUntilNextBar()
+{
+	AudioPlayHead* const playHead = getPlayHead();
+	AudioPlayHead::CurrentPositionInfo pos;
+
+	// without a running transport, any sample is as good as a bar line
+	if (playHead == 0 || ! playHead->getCurrentPosition(pos) || ! pos.isPlaying
+		 || pos.bpm <= 0 || pos.timeSigNumerator <= 0 || pos.timeSigDenominator <= 0)
+		return 0;
+
+	const double quartersPerBar = pos.timeSigNumerator * 4.0 / pos.timeSigDenominator;
+	const double intoBar = fmod(jmax(0.0, pos.ppqPosition - pos.ppqPositionOfLastBarStart), quartersPerBar);
+
+	if (intoBar <= 0)
+		return 0;
+
+	return roundToInt((quartersPerBar - intoBar) * 60.0 / pos.bpm * getSampleRate());
+}
+
+void SongSwitcher::spliceMidi(MidiBuffer& midiMessages, int oldSongEnd, int newSongStart, int numSamples)
+{
+	if (oldSongEnd >= numSamples && newSongStart >= numSamples)
+		return;
+
+	spareMidi.clear();
+
+	if (oldSongEnd > 0)
+		spareMidi.addEvents(midiMessages, 0, oldSongEnd, 0);
+
+	if (newSongStart < numSamples)
+		spareMidi.addEvents(incomingMidi, newSongStart, numSamples - newSongStart, 0);
+
+	midiMessages.swapWith(spareMidi);
+}
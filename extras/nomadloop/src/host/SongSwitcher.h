@@ -0,0 +1,137 @@
+#ifndef ADLER_SONGSWITCHER
+#define ADLER_SONGSWITCHER
+
+#include "../includes.h"
+#include "FilterGraph.h"
+
+// Plays the live graph, and lets the next few songs of a set be loaded into
+// standby graphs beforehand, so that changing songs doesn't mean silence while
+// the plugins are created and their states restored.
+//
+// Standby graphs are prepared with the same sample rate and block size as the
+// live one, so switching to one is just a change of which graph gets rendered.
+// The switch is made on the audio thread, either as a crossfade, during which
+// both songs play, or as a cut on the first sample of the next bar. Once it's
+// been made, the new song's graph is swapped into the live FilterGraph, so the
+// editor and the control surface pick it up, and the old one is deleted.
+class SongSwitcher : public AudioProcessor, private AsyncUpdater
+{
+public:
+	SongSwitcher(FilterGraph& liveGraph);
+	~SongSwitcher();
+
+	enum SwitchMode
+	{
+		crossfade,		// both songs play while one fades into the other
+		swapAtNextBar	// the new song takes over on the first sample of the next bar
+	};
+
+	// Loads a project into a standby graph, ready to be switched to, while the live
+	// one carries on playing. This runs on the message thread, which waits while
+	// FilterGraph's loading pool creates the sandboxed plugins and restores the
+	// states of those it can. If that would take more standby graphs than the
+	// budget allows, the one that was loaded longest ago is discarded. Returns an
+	// error message if it fails.
+	const String preload(const File& projectFile);
+
+	bool isPreloaded(const File& projectFile) const;
+	int getNumPreloadedSongs() const;
+	const File getPreloadedSong(int index) const;
+
+	// Discards a song that was preloaded, unless it's being switched to, or has
+	// just been switched to and hasn't yet taken over the live FilterGraph.
+	void discard(const File& projectFile);
+
+	// Each standby graph holds every plugin of a song, so this caps how many can
+	// be resident at once.
+	void setMaxNumStandbyGraphs(int maxNumGraphs);
+	int getMaxNumStandbyGraphs() const			{ return maxNumStandbyGraphs; }
+
+	// Starts switching to a preloaded song. Returns false if it hasn't been
+	// preloaded, or if another switch is still under way.
+	bool switchTo(const File& projectFile, SwitchMode mode, int crossfadeSamples);
+
+	bool isSwitching() const;
+
+	class Listener
+	{
+	public:
+		virtual ~Listener() {}
+
+		// Called on the message thread once a new song's graph has taken over
+		// the live FilterGraph.
+		virtual void songSwitched(const File& projectFile, const XmlElement* controlSurfaceXml) = 0;
+	};
+
+	void addListener(Listener* listener);
+	void removeListener(Listener* listener);
+
+	//==============================================================================
+	const String getName() const					{ return "Song Switcher"; }
+	void prepareToPlay(double sampleRate, int estimatedSamplesPerBlock);
+	void releaseResources();
+	void processBlock(AudioSampleBuffer& buffer, MidiBuffer& midiMessages);
+
+	const String getInputChannelName(int channelIndex) const	{ return String(channelIndex + 1); }
+	const String getOutputChannelName(int channelIndex) const	{ return String(channelIndex + 1); }
+	bool isInputChannelStereoPair(int) const		{ return true; }
+	bool isOutputChannelStereoPair(int) const		{ return true; }
+	bool acceptsMidi() const						{ return true; }
+	bool producesMidi() const						{ return true; }
+
+	AudioProcessorEditor* createEditor()			{ return 0; }
+	bool hasEditor() const							{ return false; }
+
+	int getNumParameters()							{ return 0; }
+	const String getParameterName(int)				{ return String::empty; }
+	float getParameter(int)							{ return 0; }
+	const String getParameterText(int)				{ return String::empty; }
+	void setParameter(int, float)					{}
+
+	int getNumPrograms()							{ return 0; }
+	int getCurrentProgram()							{ return 0; }
+	void setCurrentProgram(int)						{}
+	const String getProgramName(int)				{ return String::empty; }
+	void changeProgramName(int, const String&)		{}
+
+	void getStateInformation(JUCE_NAMESPACE::MemoryBlock&)	{}
+	void setStateInformation(const void*, int)		{}
+
+private:
+	class StandbySong;
+
+	FilterGraph& liveGraph;
+	OwnedArray<StandbySong> standbySongs;
+	CriticalSection standbyLock;
+	int maxNumStandbyGraphs;
+	bool isPrepared;
+	ListenerList<Listener> listeners;
+
+	// these belong to the audio thread, and are changed under the callback lock, which
+	// is always taken before the standby lock
+	AudioProcessorGraph* current;
+	AudioProcessorGraph* incoming;
+	SwitchMode switchMode;
+	int samplesUntilSwitch, fadeLength, fadePosition;
+	bool switchHasFinished;
+
+	AudioSampleBuffer incomingBuffer;
+	MidiBuffer incomingMidi, spareMidi;
+
+	StandbySong* findStandbySong(const File& projectFile) const;
+	StandbySong* findStandbySong(const AudioProcessorGraph* graph) const;
+	void prepareGraph(AudioProcessorGraph& graph);
+	void removeExcessStandbyGraphs();
+	bool isInUse(StandbySong& song) const;
+
+	void render(AudioProcessorGraph& graph, AudioSampleBuffer& buffer, MidiBuffer& midiMessages);
+	int getSamplesUntilNextBar();
+	void spliceMidi(MidiBuffer& midiMessages, int oldSongEnd, int newSongStart, int numSamples);
+
+	void handleAsyncUpdate();
+
+	SongSwitcher(const SongSwitcher&);
+	const SongSwitcher& operator=(const SongSwitcher&);
+};
+
+#endif
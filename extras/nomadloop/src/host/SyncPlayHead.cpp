@@ -1,7 +1,7 @@
 #include "SyncPlayHead.h"
 
-SyncPlayHead::SyncPlayHead()
-	: ppqn(24), /*bpm(90.f),*/ lastClockTime(0.f), ppqCycleCount(0)
+SyncPlayHead::SyncPlayHead(AudioDeviceManager* deviceManager_)
+	: deviceManager(deviceManager_), ppqn(24), /*bpm(90.f),*/ lastClockTime(0.f), ppqCycleCount(0)
 {
 	currentPositionInfo.bpm = 90.f;
 	currentPositionInfo.editOriginTime = 0.f;
@@ -38,8 +38,12 @@ bool SyncPlayHead::getCurrentPosition(AudioPlayHead::CurrentPositionInfo &result
 	}
 	else
 	{
-		// use any information coming in from MIDI sync
-		result = currentPositionInfo;
+		// follow the audio device's own transport if it has one (e.g. JACK),
+		// otherwise use any information coming in from MIDI sync
+		AudioIODevice* const device = deviceManager != 0 ? deviceManager->getCurrentAudioDevice() : 0;
+
+		if (device == 0 || !device->getTransportPosition(result))
+			result = currentPositionInfo;
 	}
 	
 	return true;
@@ -6,6 +6,8 @@
 
 class SyncPlayHead : public AudioPlayHead, public MidiInputCallback, public AudioIODeviceCallback
 {
+	AudioDeviceManager* deviceManager;
+
 	int ppqn;
 	//double bpm;
 	double lastClockTime;	
@@ -29,7 +31,7 @@ class SyncPlayHead : public AudioPlayHead, public MidiInputCallback, public Audi
 	void audioDeviceStopped();
 
 public:
-	SyncPlayHead();
+	SyncPlayHead(AudioDeviceManager* deviceManager);
 
 	bool getCurrentPosition(CurrentPositionInfo &result);
 
@@ -18164,6 +18164,9 @@ public:
 	/** Checks whether Intel SSE2 instructions are available. */
 	static bool hasSSE2() noexcept		  { return getCPUFlags().hasSSE2; }
 
+	/** Checks whether Intel AVX2 instructions are available, and the OS lets them be used. */
+	static bool hasAVX2() noexcept		  { return getCPUFlags().hasAVX2; }
+
 	/** Checks whether AMD 3DNOW instructions are available. */
 	static bool has3DNow() noexcept		 { return getCPUFlags().has3DNow; }
 
@@ -18193,6 +18196,7 @@ private:
 		bool hasMMX : 1;
 		bool hasSSE : 1;
 		bool hasSSE2 : 1;
+		bool hasAVX2 : 1;
 		bool has3DNow : 1;
 	};
 
@@ -23191,6 +23195,117 @@ private:
 /*** End of inlined file: juce_ScopedWriteLock.h ***/
 
 
+#endif
+#ifndef __JUCE_SEQLOCK_JUCEHEADER__
+
+/*** Start of inlined file: juce_SeqLock.h ***/
+#ifndef __JUCE_SEQLOCK_JUCEHEADER__
+#define __JUCE_SEQLOCK_JUCEHEADER__
+
+/**
+	Guards some values that one thread reads without ever blocking, while other
+	threads change them.
+
+	The threads that change the values lock each other out with a SpinLock, and
+	count up a version number before and after each change, so that it's odd while
+	a change is under way. The reading thread, usually an audio callback, never
+	takes the lock: it copies the values when a new version has come in and no one's
+	writing, and keeps the copy only if the version hasn't moved by the time it's
+	finished. If they were changed while being copied, they're left until the next
+	time it looks, so it carries on with the values it had before.
+
+	e.g. @code
+	void setThing (const Thing& newThing)
+	{
+		const SeqLock::ScopedWriteType sl (thingLock);
+		thing = newThing;
+	}
+
+	void process()
+	{
+		int newVersion;
+
+		if (thingLock.beginRead (thingVersionInUse, newVersion))
+		{
+			const Thing newThing (thing);
+
+			if (thingLock.endRead (newVersion))
+			{
+				thingInUse = newThing;
+				thingVersionInUse = newVersion;
+			}
+		}
+
+		// ...use thingInUse
+	}
+	@endcode
+
+	@see SpinLock
+*/
+class JUCE_API  SeqLock
+{
+public:
+	inline SeqLock() noexcept {}
+	inline ~SeqLock() noexcept {}
+
+	/** Takes the lock before changing the values, and makes the version odd.
+		Use a ScopedWriteType rather than calling this directly.
+	*/
+	inline void enter() const noexcept	  { lock.enter(); ++version; }
+
+	/** Makes the version even again, and releases the lock. */
+	inline void exit() const noexcept	   { ++version; lock.exit(); }
+
+	/** Starts copying the values without locking.
+
+		Returns true if there's a newer version than lastVersionRead, and nothing is
+		in the middle of changing it. The version's number is put in versionBeingRead,
+		to pass to endRead() once the values have been copied.
+	*/
+	inline bool beginRead (const int lastVersionRead, int& versionBeingRead) const noexcept
+	{
+		versionBeingRead = version.get();
+		return versionBeingRead != lastVersionRead && (versionBeingRead & 1) == 0;
+	}
+
+	/** Returns true if the values weren't changed while they were being copied.
+		If this returns false, the copy has to be thrown away.
+	*/
+	inline bool endRead (const int versionBeingRead) const noexcept
+	{
+		return version.get() == versionBeingRead;
+	}
+
+	/** Holds the lock while the values are changed. */
+	typedef GenericScopedLock <SeqLock>	 ScopedWriteType;
+
+	/** Holds the lock while one of the writing threads reads the values, without
+		changing the version.
+	*/
+	class ScopedReadType
+	{
+	public:
+		inline explicit ScopedReadType (const SeqLock& seqLock) noexcept  : sl (seqLock.lock) {}
+
+	private:
+		const SpinLock::ScopedLockType sl;
+
+		JUCE_DECLARE_NON_COPYABLE (ScopedReadType);
+	};
+
+private:
+
+	SpinLock lock;
+	mutable Atomic<int> version;
+
+	JUCE_DECLARE_NON_COPYABLE (SeqLock);
+};
+
+#endif   // __JUCE_SEQLOCK_JUCEHEADER__
+
+/*** End of inlined file: juce_SeqLock.h ***/
+
+
 #endif
 #ifndef __JUCE_SPINLOCK_JUCEHEADER__
 
@@ -38286,7 +38401,105 @@ private:
 #ifndef __JUCE_AUDIOIODEVICE_JUCEHEADER__
 #define __JUCE_AUDIOIODEVICE_JUCEHEADER__
 
+
+/*** Start of inlined file: juce_AudioPlayHead.h ***/
+#ifndef __JUCE_AUDIOPLAYHEAD_JUCEHEADER__
+#define __JUCE_AUDIOPLAYHEAD_JUCEHEADER__
+
+/**
+	A subclass of AudioPlayHead can supply information about the position and
+	status of a moving play head during audio playback.
+
+	One of these can be supplied to an AudioProcessor object so that it can find
+	out about the position of the audio that it is rendering.
+
+	@see AudioProcessor::setPlayHead, AudioProcessor::getPlayHead
+*/
+class JUCE_API  AudioPlayHead
+{
+protected:
+
+	AudioPlayHead() {}
+
+public:
+	virtual ~AudioPlayHead() {}
+
+	/** Frame rate types. */
+	enum FrameRateType
+	{
+		fps24	   = 0,
+		fps25	   = 1,
+		fps2997	 = 2,
+		fps30	   = 3,
+		fps2997drop	 = 4,
+		fps30drop	   = 5,
+		fpsUnknown	  = 99
+	};
+
+	/** This structure is filled-in by the AudioPlayHead::getCurrentPosition() method.
+	*/
+	struct JUCE_API  CurrentPositionInfo
+	{
+		/** The tempo in BPM */
+		double bpm;
+
+		/** Time signature numerator, e.g. the 3 of a 3/4 time sig */
+		int timeSigNumerator;
+		/** Time signature denominator, e.g. the 4 of a 3/4 time sig */
+		int timeSigDenominator;
+
+		/** The current play position, in seconds from the start of the edit. */
+		double timeInSeconds;
+
+		/** For timecode, the position of the start of the edit, in seconds from 00:00:00:00. */
+		double editOriginTime;
+
+		/** The current play position in pulses-per-quarter-note.
+
+			This is the number of quarter notes since the edit start.
+		*/
+		double ppqPosition;
+
+		/** The position of the start of the last bar, in pulses-per-quarter-note.
+
+			This is the number of quarter notes from the start of the edit to the
+			start of the current bar.
+
+			Note - this value may be unavailable on some hosts, e.g. Pro-Tools. If
+			it's not available, the value will be 0.
+		*/
+		double ppqPositionOfLastBarStart;
+
+		/** The video frame rate, if applicable. */
+		FrameRateType frameRate;
+
+		/** True if the transport is currently playing. */
+		bool isPlaying;
+
+		/** True if the transport is currently recording.
+
+			(When isRecording is true, then isPlaying will also be true).
+		*/
+		bool isRecording;
+
+		bool operator== (const CurrentPositionInfo& other) const noexcept;
+		bool operator!= (const CurrentPositionInfo& other) const noexcept;
+
+		void resetToDefault();
+	};
+
+	/** Fills-in the given structure with details about the transport's
+		position at the start of the current processing block.
+	*/
+	virtual bool getCurrentPosition (CurrentPositionInfo& result) = 0;
+};
+
+#endif   // __JUCE_AUDIOPLAYHEAD_JUCEHEADER__
+
+/*** End of inlined file: juce_AudioPlayHead.h ***/
+
 class AudioIODevice;
+class MidiBuffer;
 
 /**
 	One of these is passed to an AudioIODevice object to stream the audio data
@@ -38346,6 +38559,25 @@ public:
 										int numOutputChannels,
 										int numSamples) = 0;
 
+	/** Processes a block of audio along with the MIDI that the device itself carries.
+
+		Devices which have their own MIDI ports, such as JACK, call this instead of
+		audioDeviceIOCallback(), so that incoming events arrive with sample-accurate
+		offsets in the same clock domain as the audio.
+
+		Events that the callback adds to outgoingMidi will be sent out of the device's
+		MIDI ports, at the sample positions they have within the block.
+
+		The default implementation ignores the MIDI and just calls audioDeviceIOCallback().
+	*/
+	virtual void audioDeviceIOCallbackWithMidi (const float** inputChannelData,
+												int numInputChannels,
+												float** outputChannelData,
+												int numOutputChannels,
+												int numSamples,
+												const MidiBuffer& incomingMidi,
+												MidiBuffer& outgoingMidi);
+
 	/** Called to indicate that the device is about to start calling back.
 
 		This will be called just before the audio callbacks begin, either when this
@@ -38370,6 +38602,14 @@ public:
 		this callback.
 	*/
 	virtual void audioDeviceError (const String& errorMessage);
+
+	/** Called when the device's input or output latency has changed while it's running.
+
+		Be aware that this could be called by any thread, and that not all devices
+		perform this callback.
+		@see AudioIODevice::getInputLatencyInSamples, AudioIODevice::getOutputLatencyInSamples
+	*/
+	virtual void audioDeviceLatencyChanged (AudioIODevice* device);
 };
 
 /**
@@ -38554,6 +38794,23 @@ public:
 	*/
 	virtual int getInputLatencyInSamples() = 0;
 
+	/** Returns true if the device is currently running offline, calling back as fast
+		as it can rather than in real time.
+
+		This is true of JACK when its server is in freewheel mode. Callbacks can use it to
+		skip any work that's only there to meet real-time deadlines.
+	*/
+	virtual bool isFreewheeling();
+
+	/** If the device follows an external transport, this fills in its current position.
+
+		This is for devices like JACK, whose server can carry a tempo and bar/beat position
+		along with the audio. It should be called from inside the audio callback, and
+		returns false if the device has no transport, or if the transport has no musical
+		position to report.
+	*/
+	virtual bool getTransportPosition (AudioPlayHead::CurrentPositionInfo& result);
+
 	/** True if this device can show a pop-up control panel for editing its settings.
 
 		This is generally just true of ASIO devices. If true, you can call showControlPanel()
@@ -39112,15 +39369,108 @@ private:
 #define __JUCE_IIRFILTERAUDIOSOURCE_JUCEHEADER__
 
 
+/*** Start of inlined file: juce_IIRFilterBank.h ***/
+#ifndef __JUCE_IIRFILTERBANK_JUCEHEADER__
+#define __JUCE_IIRFILTERBANK_JUCEHEADER__
+
+
 /*** Start of inlined file: juce_IIRFilter.h ***/
 #ifndef __JUCE_IIRFILTER_JUCEHEADER__
 #define __JUCE_IIRFILTER_JUCEHEADER__
 
+/**
+	A set of coefficients for use in an IIRFilter or IIRFilterBank.
+
+	These are the coefficients of a biquad, normalised so that the output's own
+	coefficient is 1. The static methods create the most common kinds of filter.
+
+	@see IIRFilter, IIRFilterBank
+*/
+class JUCE_API  IIRCoefficients
+{
+public:
+
+	/** Creates a set of coefficients that passes its input through unchanged. */
+	IIRCoefficients() noexcept;
+
+	/** Creates a set of coefficients from the six terms of a biquad's transfer function.
+
+		c1, c2 and c3 are the feed-forward terms, c4 is the output's term, and c5 and
+		c6 are the feedback terms. They're all divided by c4.
+	*/
+	IIRCoefficients (double c1, double c2, double c3,
+					 double c4, double c5, double c6) noexcept;
+
+	/** Creates a copy of another set of coefficients. */
+	IIRCoefficients (const IIRCoefficients& other) noexcept;
+
+	/** Copies another set of coefficients. */
+	IIRCoefficients& operator= (const IIRCoefficients& other) noexcept;
+
+	/** Destructor. */
+	~IIRCoefficients() noexcept;
+
+	/** Returns the coefficients for a low-pass filter. */
+	static const IIRCoefficients makeLowPass (double sampleRate,
+											  double frequency) noexcept;
+
+	/** Returns the coefficients for a high-pass filter. */
+	static const IIRCoefficients makeHighPass (double sampleRate,
+											   double frequency) noexcept;
+
+	/** Returns the coefficients for a low-pass shelf filter with variable Q and gain.
+
+		The gain is a scale factor that the low frequencies are multiplied by, so values
+		greater than 1.0 will boost the low frequencies, values less than 1.0 will
+		attenuate them.
+	*/
+	static const IIRCoefficients makeLowShelf (double sampleRate,
+											   double cutOffFrequency,
+											   double Q,
+											   float gainFactor) noexcept;
+
+	/** Returns the coefficients for a high-pass shelf filter with variable Q and gain.
+
+		The gain is a scale factor that the high frequencies are multiplied by, so values
+		greater than 1.0 will boost the high frequencies, values less than 1.0 will
+		attenuate them.
+	*/
+	static const IIRCoefficients makeHighShelf (double sampleRate,
+												double cutOffFrequency,
+												double Q,
+												float gainFactor) noexcept;
+
+	/** Returns the coefficients for a band pass filter centred around a
+		frequency, with a variable Q and gain.
+
+		The gain is a scale factor that the centre frequencies are multiplied by, so
+		values greater than 1.0 will boost the centre frequencies, values less than
+		1.0 will attenuate them.
+	*/
+	static const IIRCoefficients makeBandPass (double sampleRate,
+											   double centreFrequency,
+											   double Q,
+											   float gainFactor) noexcept;
+
+	/** The coefficients, in the order b0, b1, b2, a1, a2.
+
+		The filter works out y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2].
+	*/
+	float coefficients[5];
+};
+
 /**
 	An IIR filter that can perform low, high, or band-pass filtering on an
 	audio signal.
 
-	@see IIRFilterAudioSource
+	The filter's settings can be changed from any thread without blocking the one
+	that's processing it: processSamples() picks up the new coefficients at the
+	start of its next block.
+
+	To filter several channels at once, or to run several filters one after another,
+	an IIRFilterBank will be quicker.
+
+	@see IIRFilterAudioSource, IIRFilterBank
 */
 class JUCE_API  IIRFilter
 {
@@ -39149,6 +39499,9 @@ public:
 	void reset() noexcept;
 
 	/** Performs the filter operation on the given set of samples.
+
+		This doesn't lock, so it's safe to call on the audio thread while another
+		thread changes the filter's settings.
 	*/
 	void processSamples (float* samples,
 						 int numSamples) noexcept;
@@ -39208,21 +39561,41 @@ public:
 	*/
 	void makeInactive() noexcept;
 
+	/** Sets the filter's coefficients directly. */
+	void setCoefficients (const IIRCoefficients& newCoefficients) noexcept;
+
+	/** Returns the filter's coefficients.
+
+		If the filter's inactive, this returns a set of coefficients that has no effect.
+	*/
+	const IIRCoefficients getCoefficients() const noexcept;
+
+	/** Returns true if the filter has been given some coefficients. */
+	bool isActive() const noexcept			  { return active; }
+
 	/** Makes this filter duplicate the set-up of another one.
 	*/
 	void copyCoefficientsFrom (const IIRFilter& other) noexcept;
 
 protected:
 
-	CriticalSection processLock;
+	// guards the settings, which processSamples() copies without locking
+	SeqLock coefficientLock;
 
 	void setCoefficients (double c1, double c2, double c3,
 						  double c4, double c5, double c6) noexcept;
 
 	bool active;
-	float coefficients[6];
+	IIRCoefficients coefficients;
 	float x1, x2, y1, y2;
 
+	// the settings that processSamples() is using, and the version they came from
+	bool processingActive;
+	IIRCoefficients processingCoefficients;
+	int processingVersion;
+
+	void setActiveCoefficients (const IIRCoefficients& newCoefficients, bool shouldBeActive) noexcept;
+
 	// (use the copyCoefficientsFrom() method instead of this operator)
 	IIRFilter& operator= (const IIRFilter&);
 	JUCE_LEAK_DETECTOR (IIRFilter);
@@ -39232,10 +39605,123 @@ protected:
 
 /*** End of inlined file: juce_IIRFilter.h ***/
 
+/**
+	A chain of biquad filters that processes several channels at once.
+
+	Every channel goes through the same stages, one after another, and each stage
+	has its own IIRCoefficients, so one bank can make up a multi-band EQ, or a
+	steeper filter built from several sections, like one side of a crossover.
+
+	The filters use the transposed direct form II, and run in the lanes of SSE
+	registers: up to eight channels at a time when there are three or more channels,
+	or otherwise four stages at a time, each stage working a sample behind the one
+	before it. Either way, the output is the same as running each filter on its own.
+
+	The stages can be changed from any thread without blocking the one that's doing
+	the processing. New coefficients are picked up at the start of the next block, and
+	if a smoothing length has been set, the filters glide from the old coefficients to
+	the new ones over that many samples, so that moving a filter doesn't make it click.
+
+	@see IIRFilter, IIRCoefficients
+*/
+class JUCE_API  IIRFilterBank
+{
+public:
+
+	/** Creates a bank of filters.
+
+		Initially, all the stages pass their input straight through.
+
+		@param numChannels  the number of channels that it can process
+		@param numStages	the number of filters that each channel goes through
+	*/
+	IIRFilterBank (int numChannels, int numStages);
+
+	/** Destructor. */
+	~IIRFilterBank();
+
+	/** Returns the number of channels that the bank was created with. */
+	int getNumChannels() const noexcept			 { return numChannels; }
+
+	/** Returns the number of stages that the bank was created with. */
+	int getNumStages() const noexcept			   { return numStages; }
+
+	/** Changes the coefficients of one of the stages.
+
+		This can be called from any thread. The change takes effect at the start of the
+		next block that gets processed.
+	*/
+	void setStage (int stageIndex, const IIRCoefficients& newCoefficients) noexcept;
+
+	/** Returns the coefficients that a stage was last given. */
+	const IIRCoefficients getStage (int stageIndex) const noexcept;
+
+	/** Sets how many samples the filters take to move to new coefficients.
+
+		If this is 0, which is the default, new coefficients are used straight away.
+	*/
+	void setSmoothingLength (int numSamples) noexcept;
+
+	/** Clears the filters' state, ready to start a new stream of data.
+
+		This can be called from any thread, and takes effect at the start of the next
+		block. The coefficients aren't changed, but if the filters were gliding to new
+		ones, they jump straight to them.
+	*/
+	void reset() noexcept;
+
+	/** Filters some channels of audio in place.
+
+		@param channels		 the channels' samples
+		@param numChannelsToProcess	 how many channels to process, which can be fewer than
+										the number the bank was created with
+		@param numSamples		   the number of samples in each channel
+	*/
+	void processSamples (float* const* channels, int numChannelsToProcess, int numSamples) noexcept;
+
+private:
+
+	const int numChannels, numStages;
+
+	// the coefficients that setStage() writes
+	SeqLock targetLock;
+	HeapBlock<float> targets;
+
+	Atomic<int> smoothingLength, resetPending;
+
+	// the processing thread's coefficients, and how they're changing
+	HeapBlock<float> current, increments, rampTargets, incoming;
+	int currentVersion, rampSamplesLeft;
+
+	// s1 and s2 for each stage of each channel, and space for the channels side by side
+	HeapBlock<float> state, interleaved;
+
+	void updateCoefficients() noexcept;
+	void processSection (float* const* channels, int numChannelsToProcess,
+						 int startSample, int numSamples, bool ramping) noexcept;
+	void processChannelGroup (float* const* channels, int firstChannel, int numLanes,
+							  int startSample, int numSamples, bool ramping) noexcept;
+	void processStageGroup (float* samples, int channel, int firstStage, int numLanes,
+							int numSamples, bool ramping) noexcept;
+	void processChannel (float* samples, int channel, int numSamples, bool ramping) noexcept;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IIRFilterBank);
+};
+
+#endif   // __JUCE_IIRFILTERBANK_JUCEHEADER__
+
+/*** End of inlined file: juce_IIRFilterBank.h ***/
+
 /**
 	An AudioSource that performs an IIR filter on another source.
+
+	If the buffers it's given have more channels than it has filters for, it makes
+	room for them on the message thread, and in the meantime the extra channels pass
+	through unfiltered. So if you know how many channels there'll be, it's best to
+	say so when it's created.
 */
-class JUCE_API  IIRFilterAudioSource  : public AudioSource
+class JUCE_API  IIRFilterAudioSource  : public AudioSource,
+										private AsyncUpdater
 {
 public:
 
@@ -39244,9 +39730,11 @@ public:
 		@param inputSource		  the input source to read from - this must not be null
 		@param deleteInputWhenDeleted   if true, the input source will be deleted when
 										this object is deleted
+		@param numChannels		  the number of channels to make room for
 	*/
 	IIRFilterAudioSource (AudioSource* inputSource,
-						  bool deleteInputWhenDeleted);
+						  bool deleteInputWhenDeleted,
+						  int numChannels = 2);
 
 	/** Destructor. */
 	~IIRFilterAudioSource();
@@ -39261,7 +39749,14 @@ public:
 private:
 
 	OptionalScopedPointer<AudioSource> input;
-	OwnedArray <IIRFilter> iirFilters;
+	ScopedPointer<IIRFilterBank> filters;
+	HeapBlock<float*> channels;
+	IIRCoefficients coefficients;
+	Atomic<int> numChannelsNeeded;
+	CriticalSection callbackLock;
+
+	void resizeFilters();
+	void handleAsyncUpdate();
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IIRFilterAudioSource);
 };
@@ -39377,6 +39872,11 @@ private:
 #define __JUCE_REVERBAUDIOSOURCE_JUCEHEADER__
 
 
+/*** Start of inlined file: juce_SIMDReverb.h ***/
+#ifndef __JUCE_SIMDREVERB_JUCEHEADER__
+#define __JUCE_SIMDREVERB_JUCEHEADER__
+
+
 /*** Start of inlined file: juce_Reverb.h ***/
 #ifndef __JUCE_REVERB_JUCEHEADER__
 #define __JUCE_REVERB_JUCEHEADER__
@@ -39557,7 +40057,7 @@ private:
 		shouldUpdateDamping = false;
 
 		if (isFrozen (parameters.freezeMode))
-			setDamping (1.0f, 0.0f);
+			setDamping (0.0f, 1.0f);
 		else
 			setDamping (parameters.damping * dampScaleFactor,
 						parameters.roomSize * roomScaleFactor + roomOffset);
@@ -39673,9 +40173,140 @@ private:
 /*** End of inlined file: juce_Reverb.h ***/
 
 /**
-	An AudioSource that uses the Reverb class to apply a reverb to another AudioSource.
+	A faster version of the Reverb class, which runs its filters in SSE registers.
 
-	@see Reverb
+	This is the same FreeVerb-style design as Reverb, with the same tunings and
+	parameters, and its output matches Reverb's to within a few rounding errors. The
+	difference is in how the work is split up: it processes blocks of samples that
+	are shorter than any of its delay lines, so no sample in a block depends on
+	another one in the same block having been written to a delay line first.
+
+	Within a block, the eight comb filters of both channels, which are all fed the
+	same input, run side by side in four SSE registers, and the all-pass filters
+	each work through the whole block four samples at a time.
+
+	The parameters can be changed from any thread without blocking the one that's
+	doing the processing, and instead of jumping to new settings, the reverb glides
+	to them. The levels move smoothly from sample to sample, and the damping and
+	room size are updated once per block, which is too short a time to hear.
+
+	@see Reverb, ReverbAudioSource
+*/
+class JUCE_API  SIMDReverb
+{
+public:
+
+	/** The reverb's settings, which are the same as Reverb's. */
+	typedef Reverb::Parameters Parameters;
+
+	/** Creates a reverb with the default parameters, for a 44.1KHz sample rate. */
+	SIMDReverb();
+
+	/** Destructor. */
+	~SIMDReverb();
+
+	/** Returns the parameters that the reverb was last given. */
+	const Parameters& getParameters() const noexcept	   { return parameters; }
+
+	/** Applies a new set of parameters to the reverb.
+
+		This can be called from any thread. The reverb starts gliding to the new settings
+		at the start of the next block that it processes.
+	*/
+	void setParameters (const Parameters& newParams) noexcept;
+
+	/** Sets how long the reverb takes to glide to new parameters.
+
+		If this is 0, new parameters are used straight away, like Reverb does. The
+		default is 50 milliseconds.
+	*/
+	void setSmoothingTime (double seconds) noexcept;
+
+	/** Sets the sample rate that will be used for the reverb.
+
+		You must call this before the process methods, in order to tell it the correct
+		sample rate. This allocates the delay lines, so it mustn't be called while
+		another thread is processing.
+	*/
+	void setSampleRate (double sampleRate);
+
+	/** Clears the reverb's buffers, and jumps straight to the latest parameters.
+
+		Like setSampleRate(), this mustn't be called while another thread is processing.
+	*/
+	void reset() noexcept;
+
+	/** Applies the reverb to two stereo channels of audio data. */
+	void processStereo (float* left, float* right, int numSamples) noexcept;
+
+	/** Applies the reverb to a single mono channel of audio data. */
+	void processMono (float* samples, int numSamples) noexcept;
+
+private:
+
+	enum
+	{
+		numCombs = 8,
+		numAllPasses = 4,
+		numChannels = 2,
+		numCombLanes = numCombs * numChannels,
+		maxBlockSize = 256
+	};
+
+	// the values that the parameters turn into, which are smoothed while processing
+	enum
+	{
+		gainValue = 0,
+		wet1Value,
+		wet2Value,
+		dryValue,
+		feedbackValue,
+		dampValue,
+		numValues
+	};
+
+	// the parameters that setParameters() writes
+	SeqLock parameterLock;
+	Parameters parameters;
+	int currentVersion;
+
+	double sampleRate, smoothingTime;
+	int smoothingLength, rampSamplesLeft;
+	bool isStarting;
+	float current [numValues], target [numValues];
+
+	// all the delay lines, one after another in a single block of memory
+	HeapBlock<float> delayLines;
+	int combStart [numCombLanes], combSize [numCombLanes], combIndex [numCombLanes];
+	int allPassStart [numChannels][numAllPasses], allPassSize [numChannels][numAllPasses];
+	int allPassIndex [numChannels][numAllPasses];
+	float combState [numCombLanes];
+	int blockSize;
+
+	// a block's input to the combs, and the output of each channel's filters
+	HeapBlock<float> input, wetLeft, wetRight;
+
+	void updateParameters() noexcept;
+	void advanceValues (int numSamples, float* start, float* step) noexcept;
+	int getNextBlockSize (int numSamplesLeft) const noexcept;
+	void processCombs (int numLanes, int numSamples, float feedback, float damp) noexcept;
+	void processAllPasses (int channel, float* samples, int numSamples) noexcept;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SIMDReverb);
+};
+
+#endif   // __JUCE_SIMDREVERB_JUCEHEADER__
+
+/*** End of inlined file: juce_SIMDReverb.h ***/
+
+/**
+	An AudioSource that uses the SIMDReverb class to apply a reverb to another AudioSource.
+
+	Unlike a plain Reverb, which jumps to new parameters, this glides to them over
+	SIMDReverb's default smoothing time of 50 milliseconds, so changing them while
+	it's playing doesn't click.
+
+	@see SIMDReverb, Reverb
 */
 class JUCE_API  ReverbAudioSource   : public AudioSource
 {
@@ -39695,7 +40326,9 @@ public:
 	/** Returns the parameters from the reverb. */
 	const Reverb::Parameters& getParameters() const noexcept	{ return reverb.getParameters(); }
 
-	/** Changes the reverb's parameters. */
+	/** Changes the reverb's parameters.
+		The reverb glides to them over the next 50 milliseconds.
+	*/
 	void setParameters (const Reverb::Parameters& newParams);
 
 	void setBypassed (bool isBypassed) noexcept;
@@ -39709,7 +40342,7 @@ private:
 
 	CriticalSection lock;
 	OptionalScopedPointer<AudioSource> input;
-	Reverb reverb;
+	SIMDReverb reverb;
 	volatile bool bypass;
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReverbAudioSource);
@@ -39720,6 +40353,280 @@ private:
 /*** End of inlined file: juce_ReverbAudioSource.h ***/
 
 
+#endif
+#ifndef __JUCE_SINCRESAMPLINGAUDIOSOURCE_JUCEHEADER__
+
+/*** Start of inlined file: juce_SincResamplingAudioSource.h ***/
+#ifndef __JUCE_SINCRESAMPLINGAUDIOSOURCE_JUCEHEADER__
+#define __JUCE_SINCRESAMPLINGAUDIOSOURCE_JUCEHEADER__
+
+
+/*** Start of inlined file: juce_PolyphaseResampler.h ***/
+#ifndef __JUCE_POLYPHASERESAMPLER_JUCEHEADER__
+#define __JUCE_POLYPHASERESAMPLER_JUCEHEADER__
+
+/**
+	Changes the sample rate of some audio using a windowed-sinc filter.
+
+	Each output sample is worked out from the input samples around it, weighted
+	by a Kaiser-windowed sinc function, which is a much closer approximation to
+	ideal band-limited interpolation than linear interpolation followed by a low-pass
+	filter, as used by ResamplingAudioSource. When down-sampling, the filter's
+	cut-off is lowered so that nothing above the new Nyquist frequency aliases.
+
+	The filter is kept as a table of phases, i.e. sets of coefficients for output
+	samples falling at different fractions of the way between two input samples.
+	If the ratio is a fraction with a small enough denominator, like 160/147 for
+	48KHz to 44.1KHz, the table holds exactly the phases that get used. Otherwise,
+	it holds a fixed number of phases and interpolates between the two nearest
+	ones, so the ratio can be anything and can be changed at any time.
+
+	Building a table takes far too long for the audio thread, so it's done by
+	prepareRatio(), which can be called on any other thread, and setRatio() then
+	just swaps the finished table in. Until the table for a ratio is ready, the
+	interpolated table is used, since it works for any ratio, although when
+	down-sampling its cut-off may be a little out.
+
+	Input is pushed in with addInput() and the resampled output read back with
+	readOutput(); getNumInputSamplesNeeded() says how much input has to go in to get
+	a given amount out. All the channels are processed together, either as separate
+	channels or interleaved, and the inner loops use SSE where it's available.
+
+	Output sample n lines up with the input at n * ratio, so the output isn't delayed,
+	but the resampler needs to see some input samples ahead of each output sample
+	before it can produce it.
+
+	@see SincResamplingAudioSource, ResamplingAudioSource
+*/
+class JUCE_API  PolyphaseResampler
+{
+public:
+
+	/** Creates a resampler.
+
+		@param numChannels	  the number of channels of audio that it processes
+		@param numZeroCrossings	 the number of zero crossings of the sinc function on
+									each side of a sample, which trades the quality against
+									the CPU. 8 is fast, 16 is good, and 32 is very clean.
+		@param maximumRatio	 the largest ratio that setRatio() will be given, which
+									sets how long the filter can get when down-sampling
+	*/
+	PolyphaseResampler (int numChannels,
+						int numZeroCrossings = 16,
+						double maximumRatio = 4.0);
+
+	/** Destructor. */
+	~PolyphaseResampler();
+
+	/** Builds the filter table for a ratio, ready for setRatio() to swap in.
+
+		This does all the slow work of changing the ratio, so it should be called on a
+		thread other than the audio thread, before the ratio is set. Only the most recently
+		prepared table is kept, and preparing the same ratio again does nothing.
+
+		@see setRatio
+	*/
+	void prepareRatio (double samplesInPerOutputSample);
+
+	/** Changes the resampling ratio.
+
+		This never builds a table or allocates any memory, so it can be called from the
+		audio thread, e.g. to vary the speed of playback. If prepareRatio() has built the
+		table for the new ratio, it's swapped in; otherwise the interpolated table is used
+		until it has.
+
+		@param samplesInPerOutputSample	 if this is 1.0, the input is passed through; higher
+											values speed it up, and lower values slow it down.
+											It can't be more than the maximum ratio that was given
+											to the constructor.
+	*/
+	void setRatio (double samplesInPerOutputSample);
+
+	/** Returns the current resampling ratio. */
+	double getRatio() const noexcept			{ return ratio; }
+
+	/** Allocates enough space for blocks of up to the given number of input samples.
+
+		The space is also grown as needed by addInput(), but calling this first means that
+		nothing gets allocated while processing.
+	*/
+	void prepare (int maximumInputBlockSize);
+
+	/** Discards all the input and clears the filter history. */
+	void reset();
+
+	/** Returns the number of input samples that have to be added before the given
+		number of output samples can be read.
+	*/
+	int getNumInputSamplesNeeded (int numOutputSamples) const noexcept;
+
+	/** Returns the number of output samples that can be read at the moment. */
+	int getNumOutputSamplesAvailable() const noexcept;
+
+	/** Adds some input, one array of samples for each channel. */
+	void addInput (const float* const* inputChannels, int numSamples);
+
+	/** Adds some input with the channels interleaved. */
+	void addInterleavedInput (const float* input, int numSamples);
+
+	/** Reads some resampled output, one array of samples for each channel.
+
+		This produces as many samples as it can, up to the number asked for, and
+		returns how many it produced.
+	*/
+	int readOutput (float* const* outputChannels, int numSamples);
+
+	/** Reads some resampled output with the channels interleaved.
+
+		This produces as many samples as it can, up to the number asked for, and
+		returns how many it produced.
+	*/
+	int readInterleavedOutput (float* output, int numSamples);
+
+private:
+
+	enum
+	{
+		numInterpolatedPhases = 256,
+		maxExactPhases = 512
+	};
+
+	/** A table of filter phases, with the taps either side of each output sample,
+		and the filter's cut-off as a proportion of the input's Nyquist frequency.
+		An exact table has one phase for each multiple of 1 / denominator.
+	*/
+	struct FilterTable
+	{
+		HeapBlock<float> coeffs;
+		bool isExact;
+		int numPhases, halfLength;
+		double cutoff;
+	};
+
+	enum PendingTableState
+	{
+		noPendingTable,
+		buildingPendingTable,
+		pendingTableReady,
+		takingPendingTable
+	};
+
+	const int numChannels, numZeroCrossings;
+	const double maximumRatio;
+	double ratio;
+	int maxHalfLength;
+
+	// the audio thread's tables, and one built by prepareRatio(), which belongs to
+	// whichever thread the pending state says
+	FilterTable exactTable, interpolatedTable, pendingTable;
+	Atomic<int> pendingTableState;
+	CriticalSection prepareLock;
+	double lastPreparedRatio;
+
+	// the table in use
+	const float* phases;
+	bool isExact;
+	int numerator, denominator;
+	int numPhases, halfLength;
+
+	// the input that's still needed, with the channels one after another
+	HeapBlock<float> history;
+	int historySize, numStored;
+
+	// where the next output sample falls in the input
+	int position;
+	double fraction;
+	int phase;
+
+	void designTable (double ratio, bool exactIfPossible, FilterTable& table, int& numerator) const;
+	void buildTable (FilterTable& table) const;
+	bool takePendingTable();
+	void updateFilter();
+	void ensureHistorySize (int numSamples);
+	void discardUsedInput();
+	int renderSamples (float* const* outputChannels, float* interleaved, int numSamples);
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PolyphaseResampler);
+};
+
+#endif   // __JUCE_POLYPHASERESAMPLER_JUCEHEADER__
+
+/*** End of inlined file: juce_PolyphaseResampler.h ***/
+
+/**
+	A type of AudioSource that takes an input source and changes its sample rate
+	with a windowed-sinc filter.
+
+	This does the same job as ResamplingAudioSource, but uses a PolyphaseResampler,
+	so it doesn't alias when down-sampling and keeps the top end clean when
+	up-sampling, at the cost of more CPU.
+
+	@see ResamplingAudioSource, PolyphaseResampler, AudioSource
+*/
+class JUCE_API  SincResamplingAudioSource  : public AudioSource
+{
+public:
+
+	/** Creates a SincResamplingAudioSource for a given input source.
+
+		@param inputSource		  the input source to read from
+		@param deleteInputWhenDeleted   if true, the input source will be deleted when
+										this object is deleted
+		@param numChannels		  the number of channels to process
+		@param numZeroCrossings	 the length of the filter - see PolyphaseResampler
+		@param maximumRatio		 the largest ratio that setResamplingRatio() will be given
+	*/
+	SincResamplingAudioSource (AudioSource* inputSource,
+							   bool deleteInputWhenDeleted,
+							   int numChannels = 2,
+							   int numZeroCrossings = 16,
+							   double maximumRatio = 4.0);
+
+	/** Destructor. */
+	~SincResamplingAudioSource();
+
+	/** Changes the resampling ratio.
+
+		(This value can be changed at any time, even while the source is running. The
+		filter for the new ratio is built on the calling thread, so it's best not to call
+		this from the audio thread).
+
+		@param samplesInPerOutputSample	 if set to 1.0, the input is passed through; higher
+											values will speed it up; lower values will slow it
+											down. The ratio must be greater than 0, and can't be
+											more than the maximum ratio given to the constructor
+	*/
+	void setResamplingRatio (double samplesInPerOutputSample);
+
+	/** Returns the current resampling ratio.
+
+		This is the value that was set by setResamplingRatio().
+	*/
+	double getResamplingRatio() const noexcept		  { return ratio; }
+
+	void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
+	void releaseResources();
+	void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill);
+
+private:
+
+	OptionalScopedPointer<AudioSource> input;
+	const int numChannels;
+	const double maximumRatio;
+	double ratio;
+	SpinLock ratioLock;
+	PolyphaseResampler resampler;
+	AudioSampleBuffer buffer, spareChannels;
+	HeapBlock<float*> destBuffers;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SincResamplingAudioSource);
+};
+
+#endif   // __JUCE_SINCRESAMPLINGAUDIOSOURCE_JUCEHEADER__
+
+/*** End of inlined file: juce_SincResamplingAudioSource.h ***/
+
+
 #endif
 #ifndef __JUCE_TONEGENERATORAUDIOSOURCE_JUCEHEADER__
 
@@ -41171,6 +42078,7 @@ public:
 private:
 
 	friend class MidiBuffer::Iterator;
+	friend class MidiEventPipeline;
 	MemoryBlock data;
 	int bytesUsed;
 
@@ -41735,8 +42643,10 @@ private:
 	{
 	public:
 		void audioDeviceIOCallback (const float**, int, float**, int, int);
+		void audioDeviceIOCallbackWithMidi (const float**, int, float**, int, int, const MidiBuffer&, MidiBuffer&);
 		void audioDeviceAboutToStart (AudioIODevice*);
 		void audioDeviceStopped();
+		void audioDeviceLatencyChanged (AudioIODevice*);
 		void handleIncomingMidiMessage (MidiInput*, const MidiMessage&);
 		void audioDeviceListChanged();
 
@@ -41747,7 +42657,8 @@ private:
 	friend class CallbackHandler;
 
 	void audioDeviceIOCallbackInt (const float** inputChannelData, int totalNumInputChannels,
-								   float** outputChannelData, int totalNumOutputChannels, int numSamples);
+								   float** outputChannelData, int totalNumOutputChannels, int numSamples,
+								   const MidiBuffer* incomingMidi, MidiBuffer* outgoingMidi);
 	void audioDeviceAboutToStartInt (AudioIODevice*);
 	void audioDeviceStoppedInt();
 	void handleIncomingMidiMessageInt (MidiInput*, const MidiMessage&);
@@ -41874,12 +42785,198 @@ private:
 #endif
 #ifndef __JUCE_IIRFILTER_JUCEHEADER__
 
+#endif
+#ifndef __JUCE_IIRFILTERBANK_JUCEHEADER__
+
+#endif
+#ifndef __JUCE_POLYPHASERESAMPLER_JUCEHEADER__
+
 #endif
 #ifndef __JUCE_REVERB_JUCEHEADER__
 
+#endif
+#ifndef __JUCE_SIMDREVERB_JUCEHEADER__
+
 #endif
 #ifndef __JUCE_MIDIBUFFER_JUCEHEADER__
 
+#endif
+#ifndef __JUCE_MIDIEVENTPIPELINE_JUCEHEADER__
+
+/*** Start of inlined file: juce_MidiEventPipeline.h ***/
+#ifndef __JUCE_MIDIEVENTPIPELINE_JUCEHEADER__
+#define __JUCE_MIDIEVENTPIPELINE_JUCEHEADER__
+
+class MidiEventProcessor;
+
+/**
+	Runs a chain of MidiEventProcessors over a MidiBuffer in a single pass.
+
+	Each event is handed through the processors in turn as raw bytes, which they
+	can edit in place, drop, or add new events in front of. The survivors are
+	written straight into a second, preallocated buffer, which is copied back into
+	the original at the end - so once prepare() has been called, nothing gets
+	allocated and no MidiMessage objects are created along the way.
+
+	Because the whole chain runs in one pass, a sequence of MIDI-only processors
+	can share one of these rather than each re-writing the buffer in turn.
+
+	@see MidiEventProcessor, MidiBuffer
+*/
+class JUCE_API  MidiEventPipeline
+{
+public:
+
+	/** Creates an empty pipeline. */
+	MidiEventPipeline();
+
+	/** Destructor. */
+	~MidiEventPipeline();
+
+	/** Adds a processor to the end of the chain.
+
+		The processor isn't owned by the pipeline, and the chain mustn't be changed
+		while process() is running.
+	*/
+	void addProcessor (MidiEventProcessor* processor);
+
+	/** Removes all the processors. */
+	void clear();
+
+	/** Returns the number of processors in the chain. */
+	int getNumProcessors() const noexcept		   { return processors.size(); }
+
+	/** Preallocates the space that a block's events and any inserted events will need.
+
+		Call this before processing starts, e.g. from prepareToPlay(). Events that
+		don't fit into this much space are dropped.
+	*/
+	void prepare (int maxBytesPerBlock = 8192);
+
+	/** Runs the chain over a block of events, leaving the results in the same buffer.
+
+		The buffer only has to grow if the processors leave it with more events than
+		it has room for.
+	*/
+	void process (MidiBuffer& buffer, int numSamples);
+
+	/**
+		Passed to a MidiEventProcessor so that it can add new events.
+
+		Inserted events go in front of the event that's currently being processed
+		(or at the start of the block, from MidiEventProcessor::beginMidiBlock()), and
+		are handed on through the rest of the chain just like the original ones.
+
+		From MidiEventProcessor::renderMidiUpTo(), events can also be put at any
+		position up to the one being rendered to.
+	*/
+	class JUCE_API  Output
+	{
+	public:
+		/** Adds an event in front of the current one. */
+		void insertEvent (const uint8* data, int numBytes);
+
+		/** Adds an event in front of the current one. */
+		void insertEvent (const MidiMessage& message);
+
+		/** Adds an event at a position of its own.
+
+			This is only for use from MidiEventProcessor::renderMidiUpTo(), and the
+			position mustn't be before any event that the processor has already
+			inserted or been given, nor after the position being rendered to - so
+			a processor has to add its events in time order.
+		*/
+		void insertEventAt (const uint8* data, int numBytes, int samplePosition);
+
+	private:
+		friend class MidiEventPipeline;
+		Output (MidiEventPipeline& owner, int nextStage, int samplePosition) noexcept;
+
+		MidiEventPipeline& owner;
+		const int nextStage, samplePosition;
+
+		JUCE_DECLARE_NON_COPYABLE (Output);
+	};
+
+private:
+
+	friend class Output;
+	Array <MidiEventProcessor*> processors;
+	MidiBuffer outputBuffer;
+	HeapBlock <uint8> scratch;
+	int scratchSize, scratchUsed;
+
+	void runFromStage (int stage, uint8* data, int numBytes, int samplePosition);
+	void insertEvent (int stage, const uint8* data, int numBytes, int samplePosition);
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiEventPipeline);
+};
+
+/**
+	A MIDI-only process that works on one event at a time, so that it can be run
+	as part of a MidiEventPipeline.
+
+	If an AudioProcessor with no audio channels and no latency also inherits from this,
+	an AudioProcessorGraph will run chains of such nodes together in one pipeline, and
+	won't call their processBlock() methods at all - so they should do all their
+	per-block work here.
+
+	@see MidiEventPipeline, AudioProcessorGraph
+*/
+class JUCE_API  MidiEventProcessor
+{
+public:
+	/** Destructor. */
+	virtual ~MidiEventProcessor()  {}
+
+	/** Called once at the start of each block, before any of its events.
+
+		Any events inserted here will go at the start of the block.
+	*/
+	virtual void beginMidiBlock (MidiEventPipeline::Output& output, int numSamples);
+
+	/** Called before each event is processed, and once more at the end of the block
+		with the block's length, so that a processor can generate events of its own
+		between the incoming ones.
+
+		Use Output::insertEventAt() to add events from here, at positions between the
+		last one that was rendered to and this one.
+	*/
+	virtual void renderMidiUpTo (int samplePosition, MidiEventPipeline::Output& output);
+
+	/** Called for each event in the block, in time order.
+
+		The event's bytes can be changed in place, as long as its length stays the same -
+		to change the length, drop it and insert a replacement.
+
+		@returns true to keep the event, or false to drop it
+	*/
+	virtual bool processMidiEvent (uint8* data, int numBytes, int samplePosition,
+								   MidiEventPipeline::Output& output) = 0;
+
+	/** Returns the channel of a channel message, in the range 1 to 16, or 0 for
+		system messages.
+	*/
+	static int getChannel (const uint8* data) noexcept;
+
+	/** Moves a channel message onto another channel, in the range 1 to 16.
+		System messages are left alone.
+	*/
+	static void setChannel (uint8* data, int newChannel) noexcept;
+
+	/** Shifts the note number of a note-on, note-off or aftertouch message.
+
+		@returns false if the note would end up outside the MIDI range, in which case
+				 the message is left unchanged, and probably ought to be dropped
+	*/
+	static bool transposeNote (uint8* data, int semitones) noexcept;
+};
+
+#endif   // __JUCE_MIDIEVENTPIPELINE_JUCEHEADER__
+
+/*** End of inlined file: juce_MidiEventPipeline.h ***/
+
+
 #endif
 #ifndef __JUCE_MIDIFILE_JUCEHEADER__
 
@@ -42560,6 +43657,168 @@ private:
 #endif
 #ifndef __JUCE_MIDIMESSAGESEQUENCE_JUCEHEADER__
 
+#endif
+#ifndef __JUCE_MIDIVOICETRACKER_JUCEHEADER__
+
+/*** Start of inlined file: juce_MidiVoiceTracker.h ***/
+#ifndef __JUCE_MIDIVOICETRACKER_JUCEHEADER__
+#define __JUCE_MIDIVOICETRACKER_JUCEHEADER__
+
+/**
+	Keeps track of the notes that are playing in a stream of MIDI, and where each
+	channel's pitch-wheel has bent them to.
+
+	This is aimed at MIDI where each channel's pitch-wheel applies to its own notes,
+	e.g. from a MIDI guitar or an MPE controller, so the pitch of each voice can be
+	followed as it's bent around. Events are fed in one at a time with their times,
+	in order, and the state is all kept in fixed-size tables, so each update takes
+	constant time and nothing is allocated.
+
+	A Listener can be given the stretches of time that each voice spent at a steady
+	pitch, which is enough to draw or re-play its pitch trajectory.
+
+	@see MidiKeyboardState
+*/
+class JUCE_API  MidiVoiceTracker
+{
+public:
+
+	/** Creates a tracker with no notes playing, and a bend range of 2 semitones
+		on every channel.
+	*/
+	MidiVoiceTracker();
+
+	/** Destructor. */
+	~MidiVoiceTracker();
+
+	enum
+	{
+		maxVoices = 128	 /**< Notes played while this many are already going are ignored. */
+	};
+
+	/** A note that's currently playing. */
+	struct Voice
+	{
+		uint8 channel;		  /**< The channel, from 1 to 16. */
+		uint8 note;		 /**< The note number that was played. */
+		uint8 velocity;
+
+		double startTime;	   /**< When the note started. */
+		double segmentStartTime;	/**< When the voice's pitch last changed. */
+
+		float startPitch;	   /**< The bent pitch when the note started. */
+		float lowestPitch;	  /**< The lowest bent pitch the note has reached so far. */
+		float highestPitch;	 /**< The highest bent pitch the note has reached so far. */
+
+		/** Returns how long the note has been playing at a given time. */
+		double getLifetime (double time) const noexcept	{ return time - startTime; }
+	};
+
+	/** Resets all the voices and pitch-wheels, but not the bend ranges. */
+	void reset();
+
+	/** Updates the state from a raw MIDI event, which happened at the given time.
+
+		Times can be in whatever units the caller likes, but they mustn't go backwards.
+	*/
+	void processEvent (const uint8* data, int numBytes, double time);
+
+	/** Updates the state from a MIDI message, using its time-stamp. */
+	void processEvent (const MidiMessage& message);
+
+	/** Sets how far a channel's pitch-wheel bends, in semitones either way. */
+	void setPitchBendRange (int channel, float semitones) noexcept;
+
+	/** Sets the pitch-wheel range for all 16 channels. */
+	void setPitchBendRangeForAllChannels (float semitones) noexcept;
+
+	/** Returns how far a channel's pitch-wheel bends, in semitones either way. */
+	float getPitchBendRange (int channel) const noexcept;
+
+	/** Returns a channel's last pitch-wheel position, from 0 to 16383. */
+	int getPitchWheel (int channel) const noexcept;
+
+	/** Returns how far a channel's pitch-wheel is bending its notes, in semitones. */
+	float getPitchBend (int channel) const noexcept;
+
+	/** Returns the note that was most recently started on a channel, which may have
+		finished by now, or -1 if there hasn't been one.
+	*/
+	int getLastNote (int channel) const noexcept;
+
+	/** Returns the number of voices that are playing. */
+	int getNumVoices() const noexcept			   { return numVoices; }
+
+	/** Returns one of the voices that are playing.
+
+		The order of the voices changes as they start and stop.
+	*/
+	const Voice& getVoice (int index) const noexcept;
+
+	/** Returns the voice for a note, or nullptr if it isn't playing. */
+	const Voice* findVoice (int channel, int note) const noexcept;
+
+	/** Returns the pitch that a voice is bent to, in fractional semitones. */
+	float getBentPitch (const Voice& voice) const noexcept;
+
+	/** Returns the pitch that a note on a channel would be bent to, in fractional semitones. */
+	float getBentPitch (int channel, int note) const noexcept;
+
+	/**
+		Receives the stretches of time that voices spend at a steady pitch.
+
+		The callbacks are made from inside processEvent().
+	*/
+	class JUCE_API  Listener
+	{
+	public:
+		/** Destructor. */
+		virtual ~Listener()  {}
+
+		/** Called when a voice's pitch is about to change, or the voice is about to end,
+			with the pitch it has had since the voice's segmentStartTime.
+		*/
+		virtual void voicePitchSegmentEnded (const Voice& voice, float pitch, double endTime) = 0;
+	};
+
+	/** Sets a listener to receive the voices' pitch segments, or nullptr for none.
+		The listener isn't owned by the tracker.
+	*/
+	void setListener (Listener* newListener) noexcept	   { listener = newListener; }
+
+private:
+
+	struct ChannelState
+	{
+		float bendRange;
+		float bend;
+		int16 pitchWheel;
+		int16 lastNote;
+		int16 numVoices;
+	};
+
+	ChannelState channels [16];
+	Voice voices [maxVoices];
+	int numVoices;
+
+	// the index into voices of each channel's notes, or -1 if they're not playing
+	int16 voiceIndex [16][128];
+
+	Listener* listener;
+
+	void startVoice (int channel, int note, int velocity, double time);
+	void stopVoice (int channel, int note, double time);
+	void stopAllVoices (int channel, double time);
+	void setPitchWheel (int channel, int position, double time);
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiVoiceTracker);
+};
+
+#endif   // __JUCE_MIDIVOICETRACKER_JUCEHEADER__
+
+/*** End of inlined file: juce_MidiVoiceTracker.h ***/
+
+
 #endif
 #ifndef __JUCE_MIDIOUTPUT_JUCEHEADER__
 
@@ -42712,103 +43971,6 @@ public:
 
 /*** End of inlined file: juce_AudioProcessorListener.h ***/
 
-
-/*** Start of inlined file: juce_AudioPlayHead.h ***/
-#ifndef __JUCE_AUDIOPLAYHEAD_JUCEHEADER__
-#define __JUCE_AUDIOPLAYHEAD_JUCEHEADER__
-
-/**
-	A subclass of AudioPlayHead can supply information about the position and
-	status of a moving play head during audio playback.
-
-	One of these can be supplied to an AudioProcessor object so that it can find
-	out about the position of the audio that it is rendering.
-
-	@see AudioProcessor::setPlayHead, AudioProcessor::getPlayHead
-*/
-class JUCE_API  AudioPlayHead
-{
-protected:
-
-	AudioPlayHead() {}
-
-public:
-	virtual ~AudioPlayHead() {}
-
-	/** Frame rate types. */
-	enum FrameRateType
-	{
-		fps24	   = 0,
-		fps25	   = 1,
-		fps2997	 = 2,
-		fps30	   = 3,
-		fps2997drop	 = 4,
-		fps30drop	   = 5,
-		fpsUnknown	  = 99
-	};
-
-	/** This structure is filled-in by the AudioPlayHead::getCurrentPosition() method.
-	*/
-	struct JUCE_API  CurrentPositionInfo
-	{
-		/** The tempo in BPM */
-		double bpm;
-
-		/** Time signature numerator, e.g. the 3 of a 3/4 time sig */
-		int timeSigNumerator;
-		/** Time signature denominator, e.g. the 4 of a 3/4 time sig */
-		int timeSigDenominator;
-
-		/** The current play position, in seconds from the start of the edit. */
-		double timeInSeconds;
-
-		/** For timecode, the position of the start of the edit, in seconds from 00:00:00:00. */
-		double editOriginTime;
-
-		/** The current play position in pulses-per-quarter-note.
-
-			This is the number of quarter notes since the edit start.
-		*/
-		double ppqPosition;
-
-		/** The position of the start of the last bar, in pulses-per-quarter-note.
-
-			This is the number of quarter notes from the start of the edit to the
-			start of the current bar.
-
-			Note - this value may be unavailable on some hosts, e.g. Pro-Tools. If
-			it's not available, the value will be 0.
-		*/
-		double ppqPositionOfLastBarStart;
-
-		/** The video frame rate, if applicable. */
-		FrameRateType frameRate;
-
-		/** True if the transport is currently playing. */
-		bool isPlaying;
-
-		/** True if the transport is currently recording.
-
-			(When isRecording is true, then isPlaying will also be true).
-		*/
-		bool isRecording;
-
-		bool operator== (const CurrentPositionInfo& other) const noexcept;
-		bool operator!= (const CurrentPositionInfo& other) const noexcept;
-
-		void resetToDefault();
-	};
-
-	/** Fills-in the given structure with details about the transport's
-		position at the start of the current processing block.
-	*/
-	virtual bool getCurrentPosition (CurrentPositionInfo& result) = 0;
-};
-
-#endif   // __JUCE_AUDIOPLAYHEAD_JUCEHEADER__
-
-/*** End of inlined file: juce_AudioPlayHead.h ***/
-
 /**
 	Base class for audio processing filters or plugins.
 
@@ -46626,6 +47788,19 @@ public:
 		*/
 		NamedValueSet properties;
 
+		/** Returns the latency, in samples, of the signals arriving at this node's inputs.
+
+			This is the largest accumulated latency of all the paths that feed into the
+			node, as calculated when the graph last rebuilt its rendering sequence. It
+			doesn't include the latency of the node's own processor.
+		*/
+		int getInputLatencySamples() const noexcept		 { return inputLatency; }
+
+		/** Returns the largest delay that the graph has inserted on any of this node's
+			inputs (audio or midi) so that they all line up with its slowest input path.
+		*/
+		int getCompensationDelaySamples() const noexcept	{ return compensationDelay; }
+
 		/** A convenient typedef for referring to a pointer to a node object.
 		*/
 		typedef ReferenceCountedObjectPtr <Node> Ptr;
@@ -46636,6 +47811,7 @@ public:
 
 		const ScopedPointer<AudioProcessor> processor;
 		bool isPrepared;
+		int inputLatency, compensationDelay;
 
 		Node (uint32 nodeId, AudioProcessor* processor) noexcept;
 
@@ -47011,6 +48187,14 @@ public:
 								int totalNumOutputChannels,
 								int numSamples);
 	/** @internal */
+	void audioDeviceIOCallbackWithMidi (const float** inputChannelData,
+										int totalNumInputChannels,
+										float** outputChannelData,
+										int totalNumOutputChannels,
+										int numSamples,
+										const MidiBuffer& incomingDeviceMidi,
+										MidiBuffer& outgoingDeviceMidi);
+	/** @internal */
 	void audioDeviceAboutToStart (AudioIODevice* device);
 	/** @internal */
 	void audioDeviceStopped();
@@ -47020,6 +48204,7 @@ public:
 private:
 
 	AudioProcessor* processor;
+	AudioIODevice* device;
 	CriticalSection lock;
 	double sampleRate;
 	int blockSize;
@@ -47032,6 +48217,10 @@ private:
 	MidiBuffer incomingMidi;
 	MidiMessageCollector messageCollector;
 
+	void processAudio (const float** inputChannelData, int numInputChannels,
+					   float** outputChannelData, int numOutputChannels, int numSamples,
+					   const MidiBuffer* incomingDeviceMidi, MidiBuffer* outgoingDeviceMidi);
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioProcessorPlayer);
 };
 
@@ -67561,6 +68750,204 @@ protected:
 /*** End of inlined file: juce_LowLevelGraphicsSoftwareRenderer.h ***/
 
 
+#endif
+#ifndef __JUCE_LOWLEVELGRAPHICSTILEDRENDERER_JUCEHEADER__
+
+/*** Start of inlined file: juce_LowLevelGraphicsTiledRenderer.h ***/
+#ifndef __JUCE_LOWLEVELGRAPHICSTILEDRENDERER_JUCEHEADER__
+#define __JUCE_LOWLEVELGRAPHICSTILEDRENDERER_JUCEHEADER__
+
+/**
+	A software renderer that splits large areas into tiles and rasterises them on
+	several threads at once.
+
+	When the area being drawn is big enough to be worth it, the drawing operations
+	are recorded rather than carried out, and when the renderer is deleted, the area
+	is split into horizontal bands which are each drawn by replaying the recording
+	through a LowLevelGraphicsSoftwareRenderer clipped to that band. The bands are
+	shared out between a pool of worker threads and the calling thread, which waits
+	until they're all finished, so the image is complete once the destructor returns.
+
+	Smaller areas, or machines with only one CPU, are simply drawn directly.
+
+	Because the drawing happens later, any images that are drawn mustn't be changed
+	until the renderer has been deleted.
+
+	User code is not supposed to create instances of this class directly - do all your
+	rendering via the Graphics class instead.
+
+	@see LowLevelGraphicsSoftwareRenderer
+*/
+class JUCE_API  LowLevelGraphicsTiledRenderer	: public LowLevelGraphicsContext
+{
+public:
+
+	/** Creates a renderer.
+
+		The maxNumThreads parameter limits how many threads will share the work, including
+		the one that deletes the renderer. If it's less than 1, the number of CPUs is used,
+		and if only one thread can be used, the drawing is done directly.
+	*/
+	LowLevelGraphicsTiledRenderer (const Image& imageToRenderOn, int xOffset, int yOffset,
+								   const RectangleList& initialClip, int maxNumThreads = 0);
+
+	/** Destructor.
+		If the drawing was recorded, this is where it actually gets rendered.
+	*/
+	~LowLevelGraphicsTiledRenderer();
+
+	/** Returns true if the drawing is being recorded to be rendered in tiles, or false if
+		it's being drawn directly.
+	*/
+	bool isRenderingInTiles() const noexcept		{ return numTiles > 1; }
+
+	bool isVectorDevice() const;
+
+	void setOrigin (int x, int y);
+	void addTransform (const AffineTransform& transform);
+	float getScaleFactor();
+
+	bool clipToRectangle (const Rectangle<int>& r);
+	bool clipToRectangleList (const RectangleList& clipRegion);
+	void excludeClipRectangle (const Rectangle<int>& r);
+	void clipToPath (const Path& path, const AffineTransform& transform);
+	void clipToImageAlpha (const Image& sourceImage, const AffineTransform& transform);
+
+	bool clipRegionIntersects (const Rectangle<int>& r);
+	const Rectangle<int> getClipBounds() const;
+	bool isClipEmpty() const;
+
+	void saveState();
+	void restoreState();
+
+	void beginTransparencyLayer (float opacity);
+	void endTransparencyLayer();
+
+	void setFill (const FillType& fillType);
+	void setOpacity (float opacity);
+	void setInterpolationQuality (Graphics::ResamplingQuality quality);
+
+	void fillRect (const Rectangle<int>& r, bool replaceExistingContents);
+	void fillPath (const Path& path, const AffineTransform& transform);
+
+	void drawImage (const Image& sourceImage, const AffineTransform& transform, bool fillEntireClipAsTiles);
+
+	void drawLine (const Line <float>& line);
+
+	void drawVerticalLine (int x, float top, float bottom);
+	void drawHorizontalLine (int y, float left, float right);
+
+	void setFont (const Font& newFont);
+	Font getFont();
+	void drawGlyph (int glyphNumber, const AffineTransform& transform);
+
+	enum
+	{
+		minimumAreaForTiling = 256 * 256,   /**< Areas with fewer pixels than this are drawn directly. */
+		minimumTileHeight = 32		  /**< The smallest band that an area will be split into. */
+	};
+
+private:
+
+	Image image;
+	const int xOffset, yOffset;
+
+	// This keeps track of the origin, clip, etc. so that they can be queried while
+	// recording, and does all the drawing when the area isn't being tiled.
+	LowLevelGraphicsSoftwareRenderer directRenderer;
+
+	class Command;
+	class TileJob;
+	friend class OwnedArray <Command>;
+	friend class TileJob;
+	OwnedArray <Command> commands;
+
+	Array <RectangleList> tileRegions;
+	int numThreads, numTiles;
+	Atomic<int> nextTile;
+
+	void addCommand (Command* command);
+	void renderAvailableTiles();
+	void renderTile (int tileIndex);
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LowLevelGraphicsTiledRenderer);
+};
+
+#endif   // __JUCE_LOWLEVELGRAPHICSTILEDRENDERER_JUCEHEADER__
+
+/*** End of inlined file: juce_LowLevelGraphicsTiledRenderer.h ***/
+
+
+#endif
+#ifndef __JUCE_PIXELSPANKERNELS_JUCEHEADER__
+
+/*** Start of inlined file: juce_PixelSpanKernels.h ***/
+#ifndef __JUCE_PIXELSPANKERNELS_JUCEHEADER__
+#define __JUCE_PIXELSPANKERNELS_JUCEHEADER__
+
+/**
+	Blends runs of pixels, using SIMD instructions where the CPU has them.
+
+	These are the inner loops of the software renderer's solid, gradient and image
+	fills. Each one gives exactly the same result as calling the equivalent
+	PixelARGB or PixelRGB blend() method on each pixel in turn, as long as the source
+	colours are premultiplied (which the renderer's always are), so the faster
+	versions can be swapped in without changing what gets drawn.
+
+	The best instruction set the machine supports is picked the first time any of
+	them is used.
+
+	@see LowLevelGraphicsSoftwareRenderer
+*/
+class JUCE_API  PixelSpanKernels
+{
+public:
+
+	/** Blends a single colour over a run of pixels. */
+	static void blendSolid (PixelARGB* dest, const PixelARGB& colour, int width) noexcept;
+
+	/** Blends a single colour over a run of pixels. */
+	static void blendSolid (PixelRGB* dest, const PixelARGB& colour, int width) noexcept;
+
+	/** Blends a run of source pixels over a run of destination pixels. */
+	static void blendSpan (PixelARGB* dest, const PixelARGB* src, int width) noexcept;
+
+	/** Blends a run of source pixels over a run of destination pixels, with their opacity
+		scaled by extraAlpha, in the same way as PixelARGB::blend (src, extraAlpha).
+	*/
+	static void blendSpan (PixelARGB* dest, const PixelARGB* src, int width, int extraAlpha) noexcept;
+
+	/** The versions of the kernels that can be used. */
+	enum InstructionSet
+	{
+		scalar = 0,
+		sse2,
+		avx2
+	};
+
+	/** Returns true if this build and this CPU can use a particular set of kernels. */
+	static bool isSupported (InstructionSet instructionSet) noexcept;
+
+	/** Returns the set of kernels that's being used. */
+	static InstructionSet getInstructionSet() noexcept;
+
+	/** Switches to a different set of kernels, e.g. to compare them in a test.
+
+		This mustn't be called while anything is being drawn. If the set isn't
+		supported, nothing is changed and it returns false.
+	*/
+	static bool setInstructionSet (InstructionSet newInstructionSet) noexcept;
+
+private:
+	PixelSpanKernels();
+	JUCE_DECLARE_NON_COPYABLE (PixelSpanKernels);
+};
+
+#endif   // __JUCE_PIXELSPANKERNELS_JUCEHEADER__
+
+/*** End of inlined file: juce_PixelSpanKernels.h ***/
+
+
 #endif
 #ifndef __JUCE_RECTANGLEPLACEMENT_JUCEHEADER__
 
@@ -32,13 +32,13 @@ BEGIN_JUCE_NAMESPACE
 
 //==============================================================================
 IIRFilterAudioSource::IIRFilterAudioSource (AudioSource* const inputSource,
-                                            const bool deleteInputWhenDeleted)
-    : input (inputSource, deleteInputWhenDeleted)
+                                            const bool deleteInputWhenDeleted,
+                                            const int numChannels)
+    : input (inputSource, deleteInputWhenDeleted),
+      numChannelsNeeded (jmax (1, numChannels))
 {
     jassert (inputSource != nullptr);
-
-    for (int i = 2; --i >= 0;)
-        iirFilters.add (new IIRFilter());
+    resizeFilters();
 }
 
 IIRFilterAudioSource::~IIRFilterAudioSource()  {}
@@ -46,17 +46,45 @@ IIRFilterAudioSource::~IIRFilterAudioSource()  {}
 //==============================================================================
 void IIRFilterAudioSource::setFilterParameters (const IIRFilter& newSettings)
 {
-    for (int i = iirFilters.size(); --i >= 0;)
-        iirFilters.getUnchecked(i)->copyCoefficientsFrom (newSettings);
+    const ScopedLock sl (callbackLock);
+    coefficients = newSettings.getCoefficients();
+    filters->setStage (0, coefficients);
+}
+
+void IIRFilterAudioSource::resizeFilters()
+{
+    const int numChannels = numChannelsNeeded.get();
+
+    // the new bank is built before taking the lock, and the old one is deleted
+    // after letting go of it
+    ScopedPointer<IIRFilterBank> newFilters (new IIRFilterBank (numChannels, 1));
+    HeapBlock<float*> newChannels (numChannels);
+
+    const ScopedLock sl (callbackLock);
+
+    if (filters == nullptr || filters->getNumChannels() < numChannels)
+    {
+        newFilters->setStage (0, coefficients);
+        filters.swapWith (newFilters);
+        channels.swapWith (newChannels);
+    }
+}
+
+void IIRFilterAudioSource::handleAsyncUpdate()
+{
+    resizeFilters();
 }
 
 //==============================================================================
 void IIRFilterAudioSource::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
 {
+    cancelPendingUpdate();
+    resizeFilters();
+
     input->prepareToPlay (samplesPerBlockExpected, sampleRate);
 
-    for (int i = iirFilters.size(); --i >= 0;)
-        iirFilters.getUnchecked(i)->reset();
+    const ScopedLock sl (callbackLock);
+    filters->reset();
 }
 
 void IIRFilterAudioSource::releaseResources()
@@ -68,16 +96,22 @@ void IIRFilterAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& buff
 {
     input->getNextAudioBlock (bufferToFill);
 
-    const int numChannels = bufferToFill.buffer->getNumChannels();
+    const ScopedLock sl (callbackLock);
 
-    while (numChannels > iirFilters.size())
-        iirFilters.add (new IIRFilter (*iirFilters.getUnchecked (0)));
+    int numChannels = bufferToFill.buffer->getNumChannels();
+
+    if (numChannels > filters->getNumChannels())
+    {
+        // the extra channels go unfiltered until there's room for them
+        numChannelsNeeded = numChannels;
+        triggerAsyncUpdate();
+        numChannels = filters->getNumChannels();
+    }
 
     for (int i = 0; i < numChannels; ++i)
-        iirFilters.getUnchecked(i)
-            ->processSamples (bufferToFill.buffer->getSampleData (i, bufferToFill.startSample),
-                              bufferToFill.numSamples);
-}
+        channels[i] = bufferToFill.buffer->getSampleData (i, bufferToFill.startSample);
 
+    filters->processSamples (channels, numChannels, bufferToFill.numSamples);
+}
 
 END_JUCE_NAMESPACE
@@ -27,16 +27,22 @@
 #define __JUCE_IIRFILTERAUDIOSOURCE_JUCEHEADER__
 
 #include "juce_AudioSource.h"
-#include "../dsp/juce_IIRFilter.h"
-#include "../../containers/juce_OwnedArray.h"
+#include "../dsp/juce_IIRFilterBank.h"
 #include "../../memory/juce_OptionalScopedPointer.h"
+#include "../../events/juce_AsyncUpdater.h"
 
 
 //==============================================================================
 /**
     An AudioSource that performs an IIR filter on another source.
+
+    If the buffers it's given have more channels than it has filters for, it makes
+    room for them on the message thread, and in the meantime the extra channels pass
+    through unfiltered. So if you know how many channels there'll be, it's best to
+    say so when it's created.
 */
-class JUCE_API  IIRFilterAudioSource  : public AudioSource
+class JUCE_API  IIRFilterAudioSource  : public AudioSource,
+                                        private AsyncUpdater
 {
 public:
     //==============================================================================
@@ -45,9 +51,11 @@ public:
         @param inputSource              the input source to read from - this must not be null
         @param deleteInputWhenDeleted   if true, the input source will be deleted when
                                         this object is deleted
+        @param numChannels              the number of channels to make room for
     */
     IIRFilterAudioSource (AudioSource* inputSource,
-                          bool deleteInputWhenDeleted);
+                          bool deleteInputWhenDeleted,
+                          int numChannels = 2);
 
     /** Destructor. */
     ~IIRFilterAudioSource();
@@ -64,7 +72,14 @@ public:
 private:
     //==============================================================================
     OptionalScopedPointer<AudioSource> input;
-    OwnedArray <IIRFilter> iirFilters;
+    ScopedPointer<IIRFilterBank> filters;
+    HeapBlock<float*> channels;
+    IIRCoefficients coefficients;
+    Atomic<int> numChannelsNeeded;
+    CriticalSection callbackLock;
+
+    void resizeFilters();
+    void handleAsyncUpdate();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IIRFilterAudioSource);
 };
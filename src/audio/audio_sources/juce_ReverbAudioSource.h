@@ -27,16 +27,20 @@
 #define __JUCE_REVERBAUDIOSOURCE_JUCEHEADER__
 
 #include "juce_AudioSource.h"
-#include "../dsp/juce_Reverb.h"
+#include "../dsp/juce_SIMDReverb.h"
 #include "../../threads/juce_CriticalSection.h"
 #include "../../memory/juce_OptionalScopedPointer.h"
 
 
 //==============================================================================
 /**
-    An AudioSource that uses the Reverb class to apply a reverb to another AudioSource.
+    An AudioSource that uses the SIMDReverb class to apply a reverb to another AudioSource.
 
-    @see Reverb
+    Unlike a plain Reverb, which jumps to new parameters, this glides to them over
+    SIMDReverb's default smoothing time of 50 milliseconds, so changing them while
+    it's playing doesn't click.
+
+    @see SIMDReverb, Reverb
 */
 class JUCE_API  ReverbAudioSource   : public AudioSource
 {
@@ -57,7 +61,9 @@ public:
     /** Returns the parameters from the reverb. */
     const Reverb::Parameters& getParameters() const noexcept    { return reverb.getParameters(); }
 
-    /** Changes the reverb's parameters. */
+    /** Changes the reverb's parameters.
+        The reverb glides to them over the next 50 milliseconds.
+    */
     void setParameters (const Reverb::Parameters& newParams);
 
     void setBypassed (bool isBypassed) noexcept;
@@ -72,7 +78,7 @@ private:
     //==============================================================================
     CriticalSection lock;
     OptionalScopedPointer<AudioSource> input;
-    Reverb reverb;
+    SIMDReverb reverb;
     volatile bool bypass;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReverbAudioSource);
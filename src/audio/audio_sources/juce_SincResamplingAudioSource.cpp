@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#include "../../core/juce_StandardHeader.h"
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_SincResamplingAudioSource.h"
+
+
+//==============================================================================
+SincResamplingAudioSource::SincResamplingAudioSource (AudioSource* const inputSource,
+                                                      const bool deleteInputWhenDeleted,
+                                                      const int numChannels_,
+                                                      const int numZeroCrossings,
+                                                      const double maximumRatio_)
+    : input (inputSource, deleteInputWhenDeleted),
+      numChannels (numChannels_),
+      maximumRatio (jmax (1.0, maximumRatio_)),
+      ratio (1.0),
+      resampler (numChannels_, numZeroCrossings, maximumRatio_),
+      buffer (numChannels_, 0),
+      spareChannels (numChannels_, 0)
+{
+    jassert (input != nullptr);
+}
+
+SincResamplingAudioSource::~SincResamplingAudioSource() {}
+
+void SincResamplingAudioSource::setResamplingRatio (const double samplesInPerOutputSample)
+{
+    jassert (samplesInPerOutputSample > 0 && samplesInPerOutputSample <= maximumRatio);
+
+    const double newRatio = jlimit (0.001, maximumRatio, samplesInPerOutputSample);
+
+    // the slow part is done here, so the audio thread only has to swap the new filter in
+    resampler.prepareRatio (newRatio);
+
+    const SpinLock::ScopedLockType sl (ratioLock);
+    ratio = newRatio;
+}
+
+void SincResamplingAudioSource::prepareToPlay (int samplesPerBlockExpected,
+                                               double sampleRate)
+{
+    const SpinLock::ScopedLockType sl (ratioLock);
+
+    input->prepareToPlay (samplesPerBlockExpected, sampleRate);
+
+    const int maxInputBlockSize = (int) std::ceil (samplesPerBlockExpected * maximumRatio) + 32;
+
+    buffer.setSize (numChannels, maxInputBlockSize);
+    buffer.clear();
+    spareChannels.setSize (numChannels, samplesPerBlockExpected);
+    destBuffers.calloc (numChannels);
+
+    resampler.prepareRatio (ratio);
+    resampler.setRatio (ratio);
+    resampler.prepare (maxInputBlockSize);
+}
+
+void SincResamplingAudioSource::releaseResources()
+{
+    input->releaseResources();
+    buffer.setSize (numChannels, 0);
+    spareChannels.setSize (numChannels, 0);
+}
+
+void SincResamplingAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info)
+{
+    {
+        // this also picks up a filter that's been prepared since the last block
+        const SpinLock::ScopedLockType sl (ratioLock);
+        resampler.setRatio (ratio);
+    }
+
+    if (spareChannels.getNumSamples() < info.numSamples)
+        spareChannels.setSize (numChannels, info.numSamples);
+
+    const int channelsToProcess = jmin (numChannels, info.buffer->getNumChannels());
+    int numDone = 0;
+
+    while (numDone < info.numSamples)
+    {
+        const int numLeft = info.numSamples - numDone;
+        const int numNeeded = resampler.getNumInputSamplesNeeded (numLeft);
+
+        if (numNeeded > 0)
+        {
+            if (buffer.getNumSamples() < numNeeded)
+                buffer.setSize (numChannels, numNeeded + 32);
+
+            AudioSourceChannelInfo readInfo;
+            readInfo.buffer = &buffer;
+            readInfo.numSamples = numNeeded;
+            readInfo.startSample = 0;
+
+            input->getNextAudioBlock (readInfo);
+            resampler.addInput (buffer.getArrayOfChannels(), numNeeded);
+        }
+
+        // any channels that the destination doesn't have are resampled and thrown away
+        for (int i = 0; i < numChannels; ++i)
+            destBuffers[i] = i < channelsToProcess ? info.buffer->getSampleData (i, info.startSample + numDone)
+                                                   : spareChannels.getSampleData (i);
+
+        const int numRead = resampler.readOutput (destBuffers, numLeft);
+
+        if (numRead == 0)
+        {
+            jassertfalse;    // the resampler should always have what it needs by now
+
+            for (int i = 0; i < channelsToProcess; ++i)
+                info.buffer->clear (i, info.startSample + numDone, numLeft);
+
+            break;
+        }
+
+        numDone += numRead;
+    }
+
+    for (int i = channelsToProcess; i < info.buffer->getNumChannels(); ++i)
+        info.buffer->clear (i, info.startSample, info.numSamples);
+}
+
+END_JUCE_NAMESPACE
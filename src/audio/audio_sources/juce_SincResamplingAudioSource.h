@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_SINCRESAMPLINGAUDIOSOURCE_JUCEHEADER__
+#define __JUCE_SINCRESAMPLINGAUDIOSOURCE_JUCEHEADER__
+
+#include "juce_AudioSource.h"
+#include "../dsp/juce_PolyphaseResampler.h"
+#include "../../threads/juce_SpinLock.h"
+#include "../../memory/juce_OptionalScopedPointer.h"
+
+
+//==============================================================================
+/**
+    A type of AudioSource that takes an input source and changes its sample rate
+    with a windowed-sinc filter.
+
+    This does the same job as ResamplingAudioSource, but uses a PolyphaseResampler,
+    so it doesn't alias when down-sampling and keeps the top end clean when
+    up-sampling, at the cost of more CPU.
+
+    @see ResamplingAudioSource, PolyphaseResampler, AudioSource
+*/
+class JUCE_API  SincResamplingAudioSource  : public AudioSource
+{
+public:
+    //==============================================================================
+    /** Creates a SincResamplingAudioSource for a given input source.
+
+        @param inputSource              the input source to read from
+        @param deleteInputWhenDeleted   if true, the input source will be deleted when
+                                        this object is deleted
+        @param numChannels              the number of channels to process
+        @param numZeroCrossings         the length of the filter - see PolyphaseResampler
+        @param maximumRatio             the largest ratio that setResamplingRatio() will be given
+    */
+    SincResamplingAudioSource (AudioSource* inputSource,
+                               bool deleteInputWhenDeleted,
+                               int numChannels = 2,
+                               int numZeroCrossings = 16,
+                               double maximumRatio = 4.0);
+
+    /** Destructor. */
+    ~SincResamplingAudioSource();
+
+    /** Changes the resampling ratio.
+
+        (This value can be changed at any time, even while the source is running. The
+        filter for the new ratio is built on the calling thread, so it's best not to call
+        this from the audio thread).
+
+        @param samplesInPerOutputSample     if set to 1.0, the input is passed through; higher
+                                            values will speed it up; lower values will slow it
+                                            down. The ratio must be greater than 0, and can't be
+                                            more than the maximum ratio given to the constructor
+    */
+    void setResamplingRatio (double samplesInPerOutputSample);
+
+    /** Returns the current resampling ratio.
+
+        This is the value that was set by setResamplingRatio().
+    */
+    double getResamplingRatio() const noexcept                  { return ratio; }
+
+    //==============================================================================
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
+    void releaseResources();
+    void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill);
+
+private:
+    //==============================================================================
+    OptionalScopedPointer<AudioSource> input;
+    const int numChannels;
+    const double maximumRatio;
+    double ratio;
+    SpinLock ratioLock;
+    PolyphaseResampler resampler;
+    AudioSampleBuffer buffer, spareChannels;
+    HeapBlock<float*> destBuffers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SincResamplingAudioSource);
+};
+
+
+#endif   // __JUCE_SINCRESAMPLINGAUDIOSOURCE_JUCEHEADER__
@@ -608,7 +608,9 @@ void AudioDeviceManager::audioDeviceIOCallbackInt (const float** inputChannelDat
                                                    int numInputChannels,
                                                    float** outputChannelData,
                                                    int numOutputChannels,
-                                                   int numSamples)
+                                                   int numSamples,
+                                                   const MidiBuffer* incomingMidi,
+                                                   MidiBuffer* outgoingMidi)
 {
     const ScopedLock sl (audioCallbackLock);
 
@@ -644,15 +646,27 @@ void AudioDeviceManager::audioDeviceIOCallbackInt (const float** inputChannelDat
 
         tempBuffer.setSize (jmax (1, numOutputChannels), jmax (1, numSamples), false, false, true);
 
-        callbacks.getUnchecked(0)->audioDeviceIOCallback (inputChannelData, numInputChannels,
-                                                          outputChannelData, numOutputChannels, numSamples);
+        // if the device has its own MIDI ports, every callback sees the incoming events,
+        // and the events they each produce are merged into the device's output
+        if (incomingMidi != nullptr)
+            callbacks.getUnchecked(0)->audioDeviceIOCallbackWithMidi (inputChannelData, numInputChannels,
+                                                                      outputChannelData, numOutputChannels, numSamples,
+                                                                      *incomingMidi, *outgoingMidi);
+        else
+            callbacks.getUnchecked(0)->audioDeviceIOCallback (inputChannelData, numInputChannels,
+                                                              outputChannelData, numOutputChannels, numSamples);
 
         float** const tempChans = tempBuffer.getArrayOfChannels();
 
         for (int i = callbacks.size(); --i > 0;)
         {
-            callbacks.getUnchecked(i)->audioDeviceIOCallback (inputChannelData, numInputChannels,
-                                                              tempChans, numOutputChannels, numSamples);
+            if (incomingMidi != nullptr)
+                callbacks.getUnchecked(i)->audioDeviceIOCallbackWithMidi (inputChannelData, numInputChannels,
+                                                                          tempChans, numOutputChannels, numSamples,
+                                                                          *incomingMidi, *outgoingMidi);
+            else
+                callbacks.getUnchecked(i)->audioDeviceIOCallback (inputChannelData, numInputChannels,
+                                                                  tempChans, numOutputChannels, numSamples);
 
             for (int chan = 0; chan < numOutputChannels; ++chan)
             {
@@ -859,7 +873,20 @@ void AudioDeviceManager::CallbackHandler::audioDeviceIOCallback (const float** i
                                                                  int numOutputChannels,
                                                                  int numSamples)
 {
-    owner->audioDeviceIOCallbackInt (inputChannelData, numInputChannels, outputChannelData, numOutputChannels, numSamples);
+    owner->audioDeviceIOCallbackInt (inputChannelData, numInputChannels, outputChannelData, numOutputChannels, numSamples,
+                                     nullptr, nullptr);
+}
+
+void AudioDeviceManager::CallbackHandler::audioDeviceIOCallbackWithMidi (const float** inputChannelData,
+                                                                         int numInputChannels,
+                                                                         float** outputChannelData,
+                                                                         int numOutputChannels,
+                                                                         int numSamples,
+                                                                         const MidiBuffer& incomingMidi,
+                                                                         MidiBuffer& outgoingMidi)
+{
+    owner->audioDeviceIOCallbackInt (inputChannelData, numInputChannels, outputChannelData, numOutputChannels, numSamples,
+                                     &incomingMidi, &outgoingMidi);
 }
 
 void AudioDeviceManager::CallbackHandler::audioDeviceAboutToStart (AudioIODevice* device)
@@ -872,6 +899,12 @@ void AudioDeviceManager::CallbackHandler::audioDeviceStopped()
     owner->audioDeviceStoppedInt();
 }
 
+void AudioDeviceManager::CallbackHandler::audioDeviceLatencyChanged (AudioIODevice*)
+{
+    // listeners re-read the latencies from the current device
+    owner->sendChangeMessage();
+}
+
 void AudioDeviceManager::CallbackHandler::handleIncomingMidiMessage (MidiInput* source, const MidiMessage& message)
 {
     owner->handleIncomingMidiMessageInt (source, message);
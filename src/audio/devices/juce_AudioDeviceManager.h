@@ -481,8 +481,10 @@ private:
     {
     public:
         void audioDeviceIOCallback (const float**, int, float**, int, int);
+        void audioDeviceIOCallbackWithMidi (const float**, int, float**, int, int, const MidiBuffer&, MidiBuffer&);
         void audioDeviceAboutToStart (AudioIODevice*);
         void audioDeviceStopped();
+        void audioDeviceLatencyChanged (AudioIODevice*);
         void handleIncomingMidiMessage (MidiInput*, const MidiMessage&);
         void audioDeviceListChanged();
 
@@ -493,7 +495,8 @@ private:
     friend class CallbackHandler;
 
     void audioDeviceIOCallbackInt (const float** inputChannelData, int totalNumInputChannels,
-                                   float** outputChannelData, int totalNumOutputChannels, int numSamples);
+                                   float** outputChannelData, int totalNumOutputChannels, int numSamples,
+                                   const MidiBuffer* incomingMidi, MidiBuffer* outgoingMidi);
     void audioDeviceAboutToStartInt (AudioIODevice*);
     void audioDeviceStoppedInt();
     void handleIncomingMidiMessageInt (MidiInput*, const MidiMessage&);
@@ -41,6 +41,16 @@ AudioIODevice::~AudioIODevice()
 {
 }
 
+bool AudioIODevice::isFreewheeling()
+{
+    return false;
+}
+
+bool AudioIODevice::getTransportPosition (AudioPlayHead::CurrentPositionInfo&)
+{
+    return false;
+}
+
 bool AudioIODevice::hasControlPanel() const
 {
     return false;
@@ -54,7 +64,15 @@ bool AudioIODevice::showControlPanel()
 }
 
 //==============================================================================
+void AudioIODeviceCallback::audioDeviceIOCallbackWithMidi (const float** inputChannelData, int numInputChannels,
+                                                           float** outputChannelData, int numOutputChannels,
+                                                           int numSamples, const MidiBuffer&, MidiBuffer&)
+{
+    audioDeviceIOCallback (inputChannelData, numInputChannels, outputChannelData, numOutputChannels, numSamples);
+}
+
 void AudioIODeviceCallback::audioDeviceError (const String&) {}
+void AudioIODeviceCallback::audioDeviceLatencyChanged (AudioIODevice*) {}
 
 
 END_JUCE_NAMESPACE
@@ -28,7 +28,9 @@
 
 #include "../../text/juce_StringArray.h"
 #include "../../maths/juce_BigInteger.h"
+#include "../processors/juce_AudioPlayHead.h"
 class AudioIODevice;
+class MidiBuffer;
 
 
 //==============================================================================
@@ -90,6 +92,25 @@ public:
                                         int numOutputChannels,
                                         int numSamples) = 0;
 
+    /** Processes a block of audio along with the MIDI that the device itself carries.
+
+        Devices which have their own MIDI ports, such as JACK, call this instead of
+        audioDeviceIOCallback(), so that incoming events arrive with sample-accurate
+        offsets in the same clock domain as the audio.
+
+        Events that the callback adds to outgoingMidi will be sent out of the device's
+        MIDI ports, at the sample positions they have within the block.
+
+        The default implementation ignores the MIDI and just calls audioDeviceIOCallback().
+    */
+    virtual void audioDeviceIOCallbackWithMidi (const float** inputChannelData,
+                                                int numInputChannels,
+                                                float** outputChannelData,
+                                                int numOutputChannels,
+                                                int numSamples,
+                                                const MidiBuffer& incomingMidi,
+                                                MidiBuffer& outgoingMidi);
+
     /** Called to indicate that the device is about to start calling back.
 
         This will be called just before the audio callbacks begin, either when this
@@ -114,6 +135,14 @@ public:
         this callback.
     */
     virtual void audioDeviceError (const String& errorMessage);
+
+    /** Called when the device's input or output latency has changed while it's running.
+
+        Be aware that this could be called by any thread, and that not all devices
+        perform this callback.
+        @see AudioIODevice::getInputLatencyInSamples, AudioIODevice::getOutputLatencyInSamples
+    */
+    virtual void audioDeviceLatencyChanged (AudioIODevice* device);
 };
 
 
@@ -305,6 +334,24 @@ public:
     */
     virtual int getInputLatencyInSamples() = 0;
 
+    //==============================================================================
+    /** Returns true if the device is currently running offline, calling back as fast
+        as it can rather than in real time.
+
+        This is true of JACK when its server is in freewheel mode. Callbacks can use it to
+        skip any work that's only there to meet real-time deadlines.
+    */
+    virtual bool isFreewheeling();
+
+    /** If the device follows an external transport, this fills in its current position.
+
+        This is for devices like JACK, whose server can carry a tempo and bar/beat position
+        along with the audio. It should be called from inside the audio callback, and
+        returns false if the device has no transport, or if the transport has no musical
+        position to report.
+    */
+    virtual bool getTransportPosition (AudioPlayHead::CurrentPositionInfo& result);
+
 
     //==============================================================================
     /** True if this device can show a pop-up control panel for editing its settings.
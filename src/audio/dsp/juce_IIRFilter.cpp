@@ -30,18 +30,164 @@ BEGIN_JUCE_NAMESPACE
 #include "juce_IIRFilter.h"
 
 
+//==============================================================================
+IIRCoefficients::IIRCoefficients() noexcept
+{
+    coefficients[0] = 1.0f;
+    coefficients[1] = coefficients[2] = coefficients[3] = coefficients[4] = 0;
+}
+
+IIRCoefficients::IIRCoefficients (double c1, double c2, double c3,
+                                  double c4, double c5, double c6) noexcept
+{
+    const double a = 1.0 / c4;
+
+    coefficients[0] = (float) (c1 * a);
+    coefficients[1] = (float) (c2 * a);
+    coefficients[2] = (float) (c3 * a);
+    coefficients[3] = (float) (c5 * a);
+    coefficients[4] = (float) (c6 * a);
+}
+
+IIRCoefficients::IIRCoefficients (const IIRCoefficients& other) noexcept
+{
+    memcpy (coefficients, other.coefficients, sizeof (coefficients));
+}
+
+IIRCoefficients& IIRCoefficients::operator= (const IIRCoefficients& other) noexcept
+{
+    memcpy (coefficients, other.coefficients, sizeof (coefficients));
+    return *this;
+}
+
+IIRCoefficients::~IIRCoefficients() noexcept
+{
+}
+
+//==============================================================================
+const IIRCoefficients IIRCoefficients::makeLowPass (const double sampleRate,
+                                                    const double frequency) noexcept
+{
+    jassert (sampleRate > 0);
+
+    const double n = 1.0 / tan (double_Pi * frequency / sampleRate);
+    const double nSquared = n * n;
+    const double c1 = 1.0 / (1.0 + std::sqrt (2.0) * n + nSquared);
+
+    return IIRCoefficients (c1,
+                            c1 * 2.0f,
+                            c1,
+                            1.0,
+                            c1 * 2.0 * (1.0 - nSquared),
+                            c1 * (1.0 - std::sqrt (2.0) * n + nSquared));
+}
+
+const IIRCoefficients IIRCoefficients::makeHighPass (const double sampleRate,
+                                                     const double frequency) noexcept
+{
+    const double n = tan (double_Pi * frequency / sampleRate);
+    const double nSquared = n * n;
+    const double c1 = 1.0 / (1.0 + std::sqrt (2.0) * n + nSquared);
+
+    return IIRCoefficients (c1,
+                            c1 * -2.0f,
+                            c1,
+                            1.0,
+                            c1 * 2.0 * (nSquared - 1.0),
+                            c1 * (1.0 - std::sqrt (2.0) * n + nSquared));
+}
+
+const IIRCoefficients IIRCoefficients::makeLowShelf (const double sampleRate,
+                                                     const double cutOffFrequency,
+                                                     const double Q,
+                                                     const float gainFactor) noexcept
+{
+    jassert (sampleRate > 0);
+    jassert (Q > 0);
+
+    const double A = jmax (0.0f, gainFactor);
+    const double aminus1 = A - 1.0;
+    const double aplus1 = A + 1.0;
+    const double omega = (double_Pi * 2.0 * jmax (cutOffFrequency, 2.0)) / sampleRate;
+    const double coso = std::cos (omega);
+    const double beta = std::sin (omega) * std::sqrt (A) / Q;
+    const double aminus1TimesCoso = aminus1 * coso;
+
+    return IIRCoefficients (A * (aplus1 - aminus1TimesCoso + beta),
+                            A * 2.0 * (aminus1 - aplus1 * coso),
+                            A * (aplus1 - aminus1TimesCoso - beta),
+                            aplus1 + aminus1TimesCoso + beta,
+                            -2.0 * (aminus1 + aplus1 * coso),
+                            aplus1 + aminus1TimesCoso - beta);
+}
+
+const IIRCoefficients IIRCoefficients::makeHighShelf (const double sampleRate,
+                                                      const double cutOffFrequency,
+                                                      const double Q,
+                                                      const float gainFactor) noexcept
+{
+    jassert (sampleRate > 0);
+    jassert (Q > 0);
+
+    const double A = jmax (0.0f, gainFactor);
+    const double aminus1 = A - 1.0;
+    const double aplus1 = A + 1.0;
+    const double omega = (double_Pi * 2.0 * jmax (cutOffFrequency, 2.0)) / sampleRate;
+    const double coso = std::cos (omega);
+    const double beta = std::sin (omega) * std::sqrt (A) / Q;
+    const double aminus1TimesCoso = aminus1 * coso;
+
+    return IIRCoefficients (A * (aplus1 + aminus1TimesCoso + beta),
+                            A * -2.0 * (aminus1 + aplus1 * coso),
+                            A * (aplus1 + aminus1TimesCoso - beta),
+                            aplus1 - aminus1TimesCoso + beta,
+                            2.0 * (aminus1 - aplus1 * coso),
+                            aplus1 - aminus1TimesCoso - beta);
+}
+
+const IIRCoefficients IIRCoefficients::makeBandPass (const double sampleRate,
+                                                     const double centreFrequency,
+                                                     const double Q,
+                                                     const float gainFactor) noexcept
+{
+    jassert (sampleRate > 0);
+    jassert (Q > 0);
+
+    const double A = jmax (0.0f, gainFactor);
+    const double omega = (double_Pi * 2.0 * jmax (centreFrequency, 2.0)) / sampleRate;
+    const double alpha = 0.5 * std::sin (omega) / Q;
+    const double c2 = -2.0 * std::cos (omega);
+    const double alphaTimesA = alpha * A;
+    const double alphaOverA = alpha / A;
+
+    return IIRCoefficients (1.0 + alphaTimesA,
+                            c2,
+                            1.0 - alphaTimesA,
+                            1.0 + alphaOverA,
+                            c2,
+                            1.0 - alphaOverA);
+}
+
 //==============================================================================
 IIRFilter::IIRFilter()
-    : active (false)
+    : active (false),
+      processingActive (false),
+      processingVersion (0)
 {
     reset();
 }
 
 IIRFilter::IIRFilter (const IIRFilter& other)
-    : active (other.active)
+    : processingVersion (0)
 {
-    const ScopedLock sl (other.processLock);
-    memcpy (coefficients, other.coefficients, sizeof (coefficients));
+    {
+        const SeqLock::ScopedReadType sl (other.coefficientLock);
+        coefficients = other.coefficients;
+        active = other.active;
+    }
+
+    processingCoefficients = coefficients;
+    processingActive = active;
     reset();
 }
 
@@ -52,8 +198,6 @@ IIRFilter::~IIRFilter()
 //==============================================================================
 void IIRFilter::reset() noexcept
 {
-    const ScopedLock sl (processLock);
-
     x1 = 0;
     x2 = 0;
     y1 = 0;
@@ -62,11 +206,13 @@ void IIRFilter::reset() noexcept
 
 float IIRFilter::processSingleSampleRaw (const float in) noexcept
 {
-    float out = coefficients[0] * in
-                 + coefficients[1] * x1
-                 + coefficients[2] * x2
-                 - coefficients[4] * y1
-                 - coefficients[5] * y2;
+    const float* const c = coefficients.coefficients;
+
+    float out = c[0] * in
+                 + c[1] * x1
+                 + c[2] * x2
+                 - c[3] * y1
+                 - c[4] * y2;
 
    #if JUCE_INTEL
     if (! (out < -1.0e-8 || out > 1.0e-8))
@@ -84,19 +230,34 @@ float IIRFilter::processSingleSampleRaw (const float in) noexcept
 void IIRFilter::processSamples (float* const samples,
                                 const int numSamples) noexcept
 {
-    const ScopedLock sl (processLock);
+    int latestVersion;
 
-    if (active)
+    if (coefficientLock.beginRead (processingVersion, latestVersion))
     {
+        const IIRCoefficients latestCoefficients (coefficients);
+        const bool latestActive = active;
+
+        if (coefficientLock.endRead (latestVersion))
+        {
+            processingCoefficients = latestCoefficients;
+            processingActive = latestActive;
+            processingVersion = latestVersion;
+        }
+    }
+
+    if (processingActive)
+    {
+        const float* const c = processingCoefficients.coefficients;
+
         for (int i = 0; i < numSamples; ++i)
         {
             const float in = samples[i];
 
-            float out = coefficients[0] * in
-                         + coefficients[1] * x1
-                         + coefficients[2] * x2
-                         - coefficients[4] * y1
-                         - coefficients[5] * y2;
+            float out = c[0] * in
+                         + c[1] * x1
+                         + c[2] * x2
+                         - c[3] * y1
+                         - c[4] * y2;
 
            #if JUCE_INTEL
             if (! (out < -1.0e-8 || out > 1.0e-8))
@@ -117,33 +278,13 @@ void IIRFilter::processSamples (float* const samples,
 void IIRFilter::makeLowPass (const double sampleRate,
                              const double frequency) noexcept
 {
-    jassert (sampleRate > 0);
-
-    const double n = 1.0 / tan (double_Pi * frequency / sampleRate);
-    const double nSquared = n * n;
-    const double c1 = 1.0 / (1.0 + std::sqrt (2.0) * n + nSquared);
-
-    setCoefficients (c1,
-                     c1 * 2.0f,
-                     c1,
-                     1.0,
-                     c1 * 2.0 * (1.0 - nSquared),
-                     c1 * (1.0 - std::sqrt (2.0) * n + nSquared));
+    setCoefficients (IIRCoefficients::makeLowPass (sampleRate, frequency));
 }
 
 void IIRFilter::makeHighPass (const double sampleRate,
                               const double frequency) noexcept
 {
-    const double n = tan (double_Pi * frequency / sampleRate);
-    const double nSquared = n * n;
-    const double c1 = 1.0 / (1.0 + std::sqrt (2.0) * n + nSquared);
-
-    setCoefficients (c1,
-                     c1 * -2.0f,
-                     c1,
-                     1.0,
-                     c1 * 2.0 * (nSquared - 1.0),
-                     c1 * (1.0 - std::sqrt (2.0) * n + nSquared));
+    setCoefficients (IIRCoefficients::makeHighPass (sampleRate, frequency));
 }
 
 void IIRFilter::makeLowShelf (const double sampleRate,
@@ -151,23 +292,7 @@ void IIRFilter::makeLowShelf (const double sampleRate,
                               const double Q,
                               const float gainFactor) noexcept
 {
-    jassert (sampleRate > 0);
-    jassert (Q > 0);
-
-    const double A = jmax (0.0f, gainFactor);
-    const double aminus1 = A - 1.0;
-    const double aplus1 = A + 1.0;
-    const double omega = (double_Pi * 2.0 * jmax (cutOffFrequency, 2.0)) / sampleRate;
-    const double coso = std::cos (omega);
-    const double beta = std::sin (omega) * std::sqrt (A) / Q;
-    const double aminus1TimesCoso = aminus1 * coso;
-
-    setCoefficients (A * (aplus1 - aminus1TimesCoso + beta),
-                     A * 2.0 * (aminus1 - aplus1 * coso),
-                     A * (aplus1 - aminus1TimesCoso - beta),
-                     aplus1 + aminus1TimesCoso + beta,
-                     -2.0 * (aminus1 + aplus1 * coso),
-                     aplus1 + aminus1TimesCoso - beta);
+    setCoefficients (IIRCoefficients::makeLowShelf (sampleRate, cutOffFrequency, Q, gainFactor));
 }
 
 void IIRFilter::makeHighShelf (const double sampleRate,
@@ -175,23 +300,7 @@ void IIRFilter::makeHighShelf (const double sampleRate,
                                const double Q,
                                const float gainFactor) noexcept
 {
-    jassert (sampleRate > 0);
-    jassert (Q > 0);
-
-    const double A = jmax (0.0f, gainFactor);
-    const double aminus1 = A - 1.0;
-    const double aplus1 = A + 1.0;
-    const double omega = (double_Pi * 2.0 * jmax (cutOffFrequency, 2.0)) / sampleRate;
-    const double coso = std::cos (omega);
-    const double beta = std::sin (omega) * std::sqrt (A) / Q;
-    const double aminus1TimesCoso = aminus1 * coso;
-
-    setCoefficients (A * (aplus1 + aminus1TimesCoso + beta),
-                     A * -2.0 * (aminus1 + aplus1 * coso),
-                     A * (aplus1 + aminus1TimesCoso - beta),
-                     aplus1 - aminus1TimesCoso + beta,
-                     2.0 * (aminus1 - aplus1 * coso),
-                     aplus1 - aminus1TimesCoso - beta);
+    setCoefficients (IIRCoefficients::makeHighShelf (sampleRate, cutOffFrequency, Q, gainFactor));
 }
 
 void IIRFilter::makeBandPass (const double sampleRate,
@@ -199,61 +308,54 @@ void IIRFilter::makeBandPass (const double sampleRate,
                               const double Q,
                               const float gainFactor) noexcept
 {
-    jassert (sampleRate > 0);
-    jassert (Q > 0);
-
-    const double A = jmax (0.0f, gainFactor);
-    const double omega = (double_Pi * 2.0 * jmax (centreFrequency, 2.0)) / sampleRate;
-    const double alpha = 0.5 * std::sin (omega) / Q;
-    const double c2 = -2.0 * std::cos (omega);
-    const double alphaTimesA = alpha * A;
-    const double alphaOverA = alpha / A;
-
-    setCoefficients (1.0 + alphaTimesA,
-                     c2,
-                     1.0 - alphaTimesA,
-                     1.0 + alphaOverA,
-                     c2,
-                     1.0 - alphaOverA);
+    setCoefficients (IIRCoefficients::makeBandPass (sampleRate, centreFrequency, Q, gainFactor));
 }
 
 void IIRFilter::makeInactive() noexcept
 {
-    const ScopedLock sl (processLock);
+    const SeqLock::ScopedWriteType sl (coefficientLock);
     active = false;
 }
 
 //==============================================================================
+void IIRFilter::setCoefficients (const IIRCoefficients& newCoefficients) noexcept
+{
+    setActiveCoefficients (newCoefficients, true);
+}
+
+const IIRCoefficients IIRFilter::getCoefficients() const noexcept
+{
+    const SeqLock::ScopedReadType sl (coefficientLock);
+    return active ? coefficients : IIRCoefficients();
+}
+
 void IIRFilter::copyCoefficientsFrom (const IIRFilter& other) noexcept
 {
-    const ScopedLock sl (processLock);
+    IIRCoefficients otherCoefficients;
+    bool otherActive;
 
-    memcpy (coefficients, other.coefficients, sizeof (coefficients));
-    active = other.active;
+    {
+        const SeqLock::ScopedReadType sl (other.coefficientLock);
+        otherCoefficients = other.coefficients;
+        otherActive = other.active;
+    }
+
+    setActiveCoefficients (otherCoefficients, otherActive);
 }
 
 //==============================================================================
 void IIRFilter::setCoefficients (double c1, double c2, double c3,
                                  double c4, double c5, double c6) noexcept
 {
-    const double a = 1.0 / c4;
-
-    c1 *= a;
-    c2 *= a;
-    c3 *= a;
-    c5 *= a;
-    c6 *= a;
-
-    const ScopedLock sl (processLock);
+    setCoefficients (IIRCoefficients (c1, c2, c3, c4, c5, c6));
+}
 
-    coefficients[0] = (float) c1;
-    coefficients[1] = (float) c2;
-    coefficients[2] = (float) c3;
-    coefficients[3] = (float) c4;
-    coefficients[4] = (float) c5;
-    coefficients[5] = (float) c6;
+void IIRFilter::setActiveCoefficients (const IIRCoefficients& newCoefficients, const bool shouldBeActive) noexcept
+{
+    const SeqLock::ScopedWriteType sl (coefficientLock);
 
-    active = true;
+    coefficients = newCoefficients;
+    active = shouldBeActive;
 }
 
 
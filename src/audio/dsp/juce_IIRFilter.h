@@ -26,7 +26,92 @@
 #ifndef __JUCE_IIRFILTER_JUCEHEADER__
 #define __JUCE_IIRFILTER_JUCEHEADER__
 
-#include "../../threads/juce_CriticalSection.h"
+#include "../../threads/juce_SeqLock.h"
+
+
+//==============================================================================
+/**
+    A set of coefficients for use in an IIRFilter or IIRFilterBank.
+
+    These are the coefficients of a biquad, normalised so that the output's own
+    coefficient is 1. The static methods create the most common kinds of filter.
+
+    @see IIRFilter, IIRFilterBank
+*/
+class JUCE_API  IIRCoefficients
+{
+public:
+    //==============================================================================
+    /** Creates a set of coefficients that passes its input through unchanged. */
+    IIRCoefficients() noexcept;
+
+    /** Creates a set of coefficients from the six terms of a biquad's transfer function.
+
+        c1, c2 and c3 are the feed-forward terms, c4 is the output's term, and c5 and
+        c6 are the feedback terms. They're all divided by c4.
+    */
+    IIRCoefficients (double c1, double c2, double c3,
+                     double c4, double c5, double c6) noexcept;
+
+    /** Creates a copy of another set of coefficients. */
+    IIRCoefficients (const IIRCoefficients& other) noexcept;
+
+    /** Copies another set of coefficients. */
+    IIRCoefficients& operator= (const IIRCoefficients& other) noexcept;
+
+    /** Destructor. */
+    ~IIRCoefficients() noexcept;
+
+    //==============================================================================
+    /** Returns the coefficients for a low-pass filter. */
+    static const IIRCoefficients makeLowPass (double sampleRate,
+                                              double frequency) noexcept;
+
+    /** Returns the coefficients for a high-pass filter. */
+    static const IIRCoefficients makeHighPass (double sampleRate,
+                                               double frequency) noexcept;
+
+    /** Returns the coefficients for a low-pass shelf filter with variable Q and gain.
+
+        The gain is a scale factor that the low frequencies are multiplied by, so values
+        greater than 1.0 will boost the low frequencies, values less than 1.0 will
+        attenuate them.
+    */
+    static const IIRCoefficients makeLowShelf (double sampleRate,
+                                               double cutOffFrequency,
+                                               double Q,
+                                               float gainFactor) noexcept;
+
+    /** Returns the coefficients for a high-pass shelf filter with variable Q and gain.
+
+        The gain is a scale factor that the high frequencies are multiplied by, so values
+        greater than 1.0 will boost the high frequencies, values less than 1.0 will
+        attenuate them.
+    */
+    static const IIRCoefficients makeHighShelf (double sampleRate,
+                                                double cutOffFrequency,
+                                                double Q,
+                                                float gainFactor) noexcept;
+
+    /** Returns the coefficients for a band pass filter centred around a
+        frequency, with a variable Q and gain.
+
+        The gain is a scale factor that the centre frequencies are multiplied by, so
+        values greater than 1.0 will boost the centre frequencies, values less than
+        1.0 will attenuate them.
+    */
+    static const IIRCoefficients makeBandPass (double sampleRate,
+                                               double centreFrequency,
+                                               double Q,
+                                               float gainFactor) noexcept;
+
+    //==============================================================================
+    /** The coefficients, in the order b0, b1, b2, a1, a2.
+
+        The filter works out y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2].
+    */
+    float coefficients[5];
+};
 
 
 //==============================================================================
@@ -34,7 +119,14 @@
     An IIR filter that can perform low, high, or band-pass filtering on an
     audio signal.
 
-    @see IIRFilterAudioSource
+    The filter's settings can be changed from any thread without blocking the one
+    that's processing it: processSamples() picks up the new coefficients at the
+    start of its next block.
+
+    To filter several channels at once, or to run several filters one after another,
+    an IIRFilterBank will be quicker.
+
+    @see IIRFilterAudioSource, IIRFilterBank
 */
 class JUCE_API  IIRFilter
 {
@@ -64,6 +156,9 @@ public:
     void reset() noexcept;
 
     /** Performs the filter operation on the given set of samples.
+
+        This doesn't lock, so it's safe to call on the audio thread while another
+        thread changes the filter's settings.
     */
     void processSamples (float* samples,
                          int numSamples) noexcept;
@@ -126,6 +221,18 @@ public:
     void makeInactive() noexcept;
 
     //==============================================================================
+    /** Sets the filter's coefficients directly. */
+    void setCoefficients (const IIRCoefficients& newCoefficients) noexcept;
+
+    /** Returns the filter's coefficients.
+
+        If the filter's inactive, this returns a set of coefficients that has no effect.
+    */
+    const IIRCoefficients getCoefficients() const noexcept;
+
+    /** Returns true if the filter has been given some coefficients. */
+    bool isActive() const noexcept                      { return active; }
+
     /** Makes this filter duplicate the set-up of another one.
     */
     void copyCoefficientsFrom (const IIRFilter& other) noexcept;
@@ -133,15 +240,23 @@ public:
 
 protected:
     //==============================================================================
-    CriticalSection processLock;
+    // guards the settings, which processSamples() copies without locking
+    SeqLock coefficientLock;
 
     void setCoefficients (double c1, double c2, double c3,
                           double c4, double c5, double c6) noexcept;
 
     bool active;
-    float coefficients[6];
+    IIRCoefficients coefficients;
     float x1, x2, y1, y2;
 
+    // the settings that processSamples() is using, and the version they came from
+    bool processingActive;
+    IIRCoefficients processingCoefficients;
+    int processingVersion;
+
+    void setActiveCoefficients (const IIRCoefficients& newCoefficients, bool shouldBeActive) noexcept;
+
     // (use the copyCoefficientsFrom() method instead of this operator)
     IIRFilter& operator= (const IIRFilter&);
     JUCE_LEAK_DETECTOR (IIRFilter);
@@ -0,0 +1,680 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#include "../../core/juce_StandardHeader.h"
+
+#if JUCE_INTEL && (JUCE_64BIT || JUCE_MSVC || defined (__SSE__))
+ #define JUCE_FILTERBANK_SSE 1
+ #include <xmmintrin.h>
+#endif
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_IIRFilterBank.h"
+
+
+//==============================================================================
+namespace IIRFilterBankHelpers
+{
+    enum
+    {
+        numCoefficients = 5,
+        maxLanes = 8,       // two SSE registers' worth of channels are processed side by side
+        chunkSize = 256     // the number of samples that are interleaved at a time
+    };
+
+    /** Clears the tiny values that a filter's state decays to, before they become denormals. */
+    inline float snapToZero (const float value) noexcept
+    {
+        return (value < -1.0e-15f || value > 1.0e-15f) ? value : 0.0f;
+    }
+
+   #if JUCE_FILTERBANK_SSE
+    /** Runs four filters on a sample each. */
+    inline __m128 processStep (const __m128 x, const __m128* c, __m128& s1, __m128& s2) noexcept
+    {
+        const __m128 y = _mm_add_ps (_mm_mul_ps (c[0], x), s1);
+        s1 = _mm_sub_ps (_mm_add_ps (_mm_mul_ps (c[1], x), s2), _mm_mul_ps (c[3], y));
+        s2 = _mm_sub_ps (_mm_mul_ps (c[2], x), _mm_mul_ps (c[4], y));
+        return y;
+    }
+
+    inline __m128 select (const __m128 mask, const __m128 ifTrue, const __m128 ifFalse) noexcept
+    {
+        return _mm_or_ps (_mm_and_ps (mask, ifTrue), _mm_andnot_ps (mask, ifFalse));
+    }
+   #endif
+}
+
+//==============================================================================
+IIRFilterBank::IIRFilterBank (const int numChannels_, const int numStages_)
+    : numChannels (jmax (1, numChannels_)),
+      numStages (jmax (1, numStages_)),
+      currentVersion (0),
+      rampSamplesLeft (0)
+{
+    using namespace IIRFilterBankHelpers;
+
+    const int numValues = numStages * numCoefficients;
+
+    targets.malloc (numValues);
+    current.malloc (numValues);
+    increments.calloc (numValues);
+    rampTargets.malloc (numValues);
+    incoming.malloc (numValues);
+
+    const IIRCoefficients passThrough;
+
+    for (int i = 0; i < numStages; ++i)
+        memcpy (targets + i * numCoefficients, passThrough.coefficients, sizeof (passThrough.coefficients));
+
+    memcpy (current, targets, sizeof (float) * (size_t) numValues);
+    memcpy (rampTargets, targets, sizeof (float) * (size_t) numValues);
+
+    state.calloc (numChannels * numStages * 2);
+    interleaved.calloc (chunkSize * maxLanes);
+}
+
+IIRFilterBank::~IIRFilterBank()
+{
+}
+
+//==============================================================================
+void IIRFilterBank::setStage (const int stageIndex, const IIRCoefficients& newCoefficients) noexcept
+{
+    using namespace IIRFilterBankHelpers;
+    jassert (isPositiveAndBelow (stageIndex, numStages));
+
+    if (isPositiveAndBelow (stageIndex, numStages))
+    {
+        const SeqLock::ScopedWriteType sl (targetLock);
+        memcpy (targets + stageIndex * numCoefficients, newCoefficients.coefficients, sizeof (newCoefficients.coefficients));
+    }
+}
+
+const IIRCoefficients IIRFilterBank::getStage (const int stageIndex) const noexcept
+{
+    using namespace IIRFilterBankHelpers;
+    IIRCoefficients c;
+
+    if (isPositiveAndBelow (stageIndex, numStages))
+    {
+        const SeqLock::ScopedReadType sl (targetLock);
+        memcpy (c.coefficients, targets + stageIndex * numCoefficients, sizeof (c.coefficients));
+    }
+
+    return c;
+}
+
+void IIRFilterBank::setSmoothingLength (const int numSamples) noexcept
+{
+    smoothingLength = jmax (0, numSamples);
+}
+
+void IIRFilterBank::reset() noexcept
+{
+    resetPending = 1;
+}
+
+//==============================================================================
+void IIRFilterBank::updateCoefficients() noexcept
+{
+    using namespace IIRFilterBankHelpers;
+
+    const int numValues = numStages * numCoefficients;
+    const bool isResetting = resetPending.compareAndSetBool (0, 1);
+
+    if (isResetting)
+        zeromem (state, sizeof (float) * (size_t) (numChannels * numStages * 2));
+
+    int latestVersion;
+
+    if (targetLock.beginRead (currentVersion, latestVersion))
+    {
+        memcpy (incoming, targets, sizeof (float) * (size_t) numValues);
+
+        if (targetLock.endRead (latestVersion))
+        {
+            currentVersion = latestVersion;
+            memcpy (rampTargets, incoming, sizeof (float) * (size_t) numValues);
+
+            const int length = smoothingLength.get();
+
+            if (length > 0)
+            {
+                for (int i = 0; i < numValues; ++i)
+                    increments[i] = (rampTargets[i] - current[i]) / length;
+
+                rampSamplesLeft = length;
+            }
+            else
+            {
+                rampSamplesLeft = 0;
+            }
+        }
+    }
+
+    if (rampSamplesLeft > 0 && isResetting)
+        rampSamplesLeft = 0;
+
+    if (rampSamplesLeft == 0)
+        memcpy (current, rampTargets, sizeof (float) * (size_t) numValues);
+}
+
+void IIRFilterBank::processSamples (float* const* channels, int numChannelsToProcess, const int numSamples) noexcept
+{
+    using namespace IIRFilterBankHelpers;
+
+    jassert (numChannelsToProcess <= numChannels);
+    numChannelsToProcess = jmin (numChannels, numChannelsToProcess);
+
+    updateCoefficients();
+
+    int startSample = 0;
+
+    if (rampSamplesLeft > 0)
+    {
+        const int num = jmin (numSamples, rampSamplesLeft);
+        processSection (channels, numChannelsToProcess, 0, num, true);
+
+        rampSamplesLeft -= num;
+
+        if (rampSamplesLeft > 0)
+        {
+            for (int i = numStages * numCoefficients; --i >= 0;)
+                current[i] += increments[i] * num;
+        }
+        else
+        {
+            memcpy (current, rampTargets, sizeof (float) * (size_t) (numStages * numCoefficients));
+        }
+
+        startSample = num;
+    }
+
+    if (startSample < numSamples)
+        processSection (channels, numChannelsToProcess, startSample, numSamples - startSample, false);
+}
+
+void IIRFilterBank::processSection (float* const* channels, const int numChannelsToProcess,
+                                    const int startSample, const int numSamples, const bool ramping) noexcept
+{
+   #if JUCE_FILTERBANK_SSE
+    using namespace IIRFilterBankHelpers;
+
+    if (numChannelsToProcess >= 3)
+    {
+        for (int i = 0; i < numChannelsToProcess; i += maxLanes)
+            processChannelGroup (channels, i, jmin ((int) maxLanes, numChannelsToProcess - i), startSample, numSamples, ramping);
+    }
+    else if (numStages > 1)
+    {
+        for (int i = 0; i < numChannelsToProcess; ++i)
+            for (int j = 0; j < numStages; j += 4)
+                processStageGroup (channels[i] + startSample, i, j, jmin (4, numStages - j), numSamples, ramping);
+    }
+    else
+    {
+        // a single filter on one or two channels wouldn't gain anything from the lanes
+        for (int i = 0; i < numChannelsToProcess; ++i)
+            processChannel (channels[i] + startSample, i, numSamples, ramping);
+    }
+   #else
+    for (int i = 0; i < numChannelsToProcess; ++i)
+        processChannel (channels[i] + startSample, i, numSamples, ramping);
+   #endif
+}
+
+//==============================================================================
+void IIRFilterBank::processChannelGroup (float* const* channels, const int firstChannel, const int numLanes,
+                                         const int startSample, const int numSamples, const bool ramping) noexcept
+{
+   #if JUCE_FILTERBANK_SSE
+    using namespace IIRFilterBankHelpers;
+
+    // Up to eight channels go side by side, as two sets of four. The two sets
+    // don't depend on each other, so the CPU can work on both at once.
+    const bool isDouble = numLanes > 4;
+    const int stride = isDouble ? 8 : 4;
+    float* const data = interleaved;
+
+    for (int done = 0; done < numSamples; done += chunkSize)
+    {
+        const int num = jmin ((int) chunkSize, numSamples - done);
+
+        // each channel goes into its own lane, and any spare lanes filter silence
+        for (int lane = 0; lane < stride; ++lane)
+        {
+            if (lane < numLanes)
+            {
+                const float* const src = channels [firstChannel + lane] + startSample + done;
+
+                for (int i = 0; i < num; ++i)
+                    data [i * stride + lane] = src[i];
+            }
+            else
+            {
+                for (int i = 0; i < num; ++i)
+                    data [i * stride + lane] = 0;
+            }
+        }
+
+        for (int stage = 0; stage < numStages; ++stage)
+        {
+            const float* const c = current + stage * numCoefficients;
+            const float* const inc = increments + stage * numCoefficients;
+            __m128 coeffs [numCoefficients], steps [numCoefficients];
+
+            for (int i = 0; i < numCoefficients; ++i)
+            {
+                coeffs[i] = _mm_set1_ps (ramping ? c[i] + inc[i] * done : c[i]);
+                steps[i] = _mm_set1_ps (inc[i]);
+            }
+
+            float s [maxLanes * 2] = { 0 };
+
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                const float* const laneState = state + ((firstChannel + lane) * numStages + stage) * 2;
+                s [lane] = laneState[0];
+                s [lane + maxLanes] = laneState[1];
+            }
+
+            __m128 s1a = _mm_loadu_ps (s),     s2a = _mm_loadu_ps (s + maxLanes);
+            __m128 s1b = _mm_loadu_ps (s + 4), s2b = _mm_loadu_ps (s + maxLanes + 4);
+
+            if (isDouble)
+            {
+                for (int i = 0; i < num; ++i)
+                {
+                    float* const d = data + i * 8;
+                    const __m128 ya = processStep (_mm_loadu_ps (d), coeffs, s1a, s2a);
+                    const __m128 yb = processStep (_mm_loadu_ps (d + 4), coeffs, s1b, s2b);
+                    _mm_storeu_ps (d, ya);
+                    _mm_storeu_ps (d + 4, yb);
+
+                    if (ramping)
+                        for (int j = 0; j < numCoefficients; ++j)
+                            coeffs[j] = _mm_add_ps (coeffs[j], steps[j]);
+                }
+            }
+            else if (ramping)
+            {
+                for (int i = 0; i < num; ++i)
+                {
+                    _mm_storeu_ps (data + i * 4, processStep (_mm_loadu_ps (data + i * 4), coeffs, s1a, s2a));
+
+                    for (int j = 0; j < numCoefficients; ++j)
+                        coeffs[j] = _mm_add_ps (coeffs[j], steps[j]);
+                }
+            }
+            else
+            {
+                for (int i = 0; i < num; ++i)
+                    _mm_storeu_ps (data + i * 4, processStep (_mm_loadu_ps (data + i * 4), coeffs, s1a, s2a));
+            }
+
+            _mm_storeu_ps (s, s1a);
+            _mm_storeu_ps (s + 4, s1b);
+            _mm_storeu_ps (s + maxLanes, s2a);
+            _mm_storeu_ps (s + maxLanes + 4, s2b);
+
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                float* const laneState = state + ((firstChannel + lane) * numStages + stage) * 2;
+                laneState[0] = snapToZero (s [lane]);
+                laneState[1] = snapToZero (s [lane + maxLanes]);
+            }
+        }
+
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            float* const dest = channels [firstChannel + lane] + startSample + done;
+
+            for (int i = 0; i < num; ++i)
+                dest[i] = data [i * stride + lane];
+        }
+    }
+   #else
+    (void) channels; (void) firstChannel; (void) numLanes;
+    (void) startSample; (void) numSamples; (void) ramping;
+   #endif
+}
+
+void IIRFilterBank::processStageGroup (float* const samples, const int channel, const int firstStage, const int numLanes,
+                                       const int numSamples, const bool ramping) noexcept
+{
+   #if JUCE_FILTERBANK_SSE
+    using namespace IIRFilterBankHelpers;
+
+    // lane n runs stage firstStage + n, and any spare lanes just pass on what they're given
+    const IIRCoefficients passThrough;
+    float c [numCoefficients][4], inc [numCoefficients][4], s[8] = { 0 };
+
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        const int stage = firstStage + lane;
+
+        for (int i = 0; i < numCoefficients; ++i)
+        {
+            c[i][lane] = lane < numLanes ? current [stage * numCoefficients + i] : passThrough.coefficients[i];
+            inc[i][lane] = (lane < numLanes && ramping) ? increments [stage * numCoefficients + i] : 0;
+        }
+
+        if (lane < numLanes)
+        {
+            const float* const laneState = state + (channel * numStages + stage) * 2;
+            s [lane] = laneState[0];
+            s [lane + 4] = laneState[1];
+        }
+    }
+
+    __m128 coeffs [numCoefficients], steps [numCoefficients];
+
+    for (int i = 0; i < numCoefficients; ++i)
+    {
+        coeffs[i] = _mm_loadu_ps (c[i]);
+        steps[i] = _mm_loadu_ps (inc[i]);
+    }
+
+    __m128 s1 = _mm_loadu_ps (s);
+    __m128 s2 = _mm_loadu_ps (s + 4);
+
+    // On step t, lane n works on sample t - n, taking its input from what lane n - 1
+    // put out on the step before, so sample t comes out of the last lane on step t + 3.
+    // At the start and end of the block, the lanes that have no sample to work on are
+    // left as they are.
+    const __m128 laneIndex = _mm_setr_ps (0, 1.0f, 2.0f, 3.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 blockEnd = _mm_set1_ps ((float) numSamples);
+    __m128 previous = zero;
+
+    for (int t = 0; t < numSamples + 3; ++t)
+    {
+        const float in = t < numSamples ? samples[t] : 0.0f;
+        const __m128 x = _mm_move_ss (_mm_shuffle_ps (previous, previous, _MM_SHUFFLE (2, 1, 0, 0)), _mm_set_ss (in));
+
+        if (t >= 3 && t < numSamples)
+        {
+            previous = processStep (x, coeffs, s1, s2);
+
+            if (ramping)
+                for (int i = 0; i < numCoefficients; ++i)
+                    coeffs[i] = _mm_add_ps (coeffs[i], steps[i]);
+        }
+        else
+        {
+            const __m128 position = _mm_sub_ps (_mm_set1_ps ((float) t), laneIndex);
+            const __m128 isBusy = _mm_and_ps (_mm_cmpge_ps (position, zero), _mm_cmplt_ps (position, blockEnd));
+
+            __m128 newS1 = s1, newS2 = s2;
+            previous = processStep (x, coeffs, newS1, newS2);
+            s1 = select (isBusy, newS1, s1);
+            s2 = select (isBusy, newS2, s2);
+
+            if (ramping)
+                for (int i = 0; i < numCoefficients; ++i)
+                    coeffs[i] = _mm_add_ps (coeffs[i], _mm_and_ps (isBusy, steps[i]));
+        }
+
+        if (t >= 3)
+            samples [t - 3] = _mm_cvtss_f32 (_mm_shuffle_ps (previous, previous, _MM_SHUFFLE (3, 3, 3, 3)));
+    }
+
+    _mm_storeu_ps (s, s1);
+    _mm_storeu_ps (s + 4, s2);
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        float* const laneState = state + (channel * numStages + firstStage + lane) * 2;
+        laneState[0] = snapToZero (s [lane]);
+        laneState[1] = snapToZero (s [lane + 4]);
+    }
+   #else
+    (void) samples; (void) channel; (void) firstStage;
+    (void) numLanes; (void) numSamples; (void) ramping;
+   #endif
+}
+
+void IIRFilterBank::processChannel (float* const samples, const int channel,
+                                    const int numSamples, const bool ramping) noexcept
+{
+    using namespace IIRFilterBankHelpers;
+
+    for (int stage = 0; stage < numStages; ++stage)
+    {
+        float c [numCoefficients];
+        const float* const inc = increments + stage * numCoefficients;
+        memcpy (c, current + stage * numCoefficients, sizeof (c));
+
+        float* const stageState = state + (channel * numStages + stage) * 2;
+        float s1 = stageState[0], s2 = stageState[1];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float x = samples[i];
+            const float y = c[0] * x + s1;
+            s1 = (c[1] * x + s2) - c[3] * y;
+            s2 = c[2] * x - c[4] * y;
+            samples[i] = y;
+
+            if (ramping)
+                for (int j = 0; j < numCoefficients; ++j)
+                    c[j] += inc[j];
+        }
+
+        stageState[0] = snapToZero (s1);
+        stageState[1] = snapToZero (s2);
+    }
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+#include "../../maths/juce_Random.h"
+
+class IIRFilterBankTests  : public UnitTest
+{
+public:
+    IIRFilterBankTests() : UnitTest ("IIRFilterBank") {}
+
+    void runTest()
+    {
+        beginTest ("Matches separate filters");
+        {
+            Random r (4321);
+
+            // these cover the channel lanes, the stage lanes, and partly-used lanes of both
+            const int layouts[][2] = { { 1, 1 }, { 1, 4 }, { 2, 6 }, { 3, 2 }, { 4, 1 }, { 5, 5 }, { 8, 3 } };
+
+            for (int i = 0; i < numElementsInArray (layouts); ++i)
+                expect (testAgainstScalar (r, layouts[i][0], layouts[i][1]) < 1.0e-5f);
+        }
+
+        beginTest ("Smoothing");
+        {
+            // a stage that just scales its input, gliding from 1 to 3
+            IIRFilterBank bank (1, 1);
+            bank.setSmoothingLength (100);
+
+            HeapBlock<float> block (200);
+            float* channel = block;
+            fill (block, 200, 1.0f);
+            bank.processSamples (&channel, 1, 200);
+
+            bank.setStage (0, IIRCoefficients (3.0, 0, 0, 1.0, 0, 0));
+            fill (block, 200, 1.0f);
+            bank.processSamples (&channel, 1, 200);
+
+            expect (block[0] < 1.05f);
+            expect (std::abs (block[50] - 2.0f) < 0.05f);
+            expect (block[100] == 3.0f && block[199] == 3.0f);
+
+            bool isMonotonic = true;
+            for (int i = 1; i < 200; ++i)
+                isMonotonic = isMonotonic && block[i] >= block[i - 1];
+
+            expect (isMonotonic);
+
+            // the same through the stage lanes, with the glide split across blocks
+            IIRFilterBank chain (1, 3);
+            chain.setSmoothingLength (90);
+
+            for (int i = 0; i < 3; ++i)
+                chain.setStage (i, IIRCoefficients (2.0, 0, 0, 1.0, 0, 0));
+
+            float previous = 1.0f;
+            bool isSmooth = true;
+
+            for (int i = 0; i < 10; ++i)
+            {
+                fill (block, 20, 1.0f);
+                chain.processSamples (&channel, 1, 20);
+
+                for (int j = 0; j < 20; ++j)
+                {
+                    isSmooth = isSmooth && block[j] >= previous && block[j] - previous < 0.3f;
+                    previous = block[j];
+                }
+            }
+
+            expect (isSmooth);
+            expect (previous == 8.0f);
+        }
+
+        beginTest ("Reset");
+        {
+            IIRFilterBank bank (2, 2);
+            bank.setStage (0, IIRCoefficients::makeBandPass (44100.0, 1000.0, 10.0, 8.0f));
+            bank.setStage (1, IIRCoefficients::makeLowPass (44100.0, 2000.0));
+
+            HeapBlock<float> block (512);
+            float* channels[2] = { block, block + 256 };
+
+            fill (block, 512, 0.5f);
+            bank.processSamples (channels, 2, 256);
+            bank.reset();
+
+            fill (block, 512, 0);
+            bank.processSamples (channels, 2, 256);
+
+            bool isSilent = true;
+            for (int i = 0; i < 512; ++i)
+                isSilent = isSilent && block[i] == 0;
+
+            expect (isSilent);
+        }
+    }
+
+private:
+    static void fill (float* dest, int num, float value)
+    {
+        while (--num >= 0)
+            *dest++ = value;
+    }
+
+    static const IIRCoefficients createRandomFilter (Random& r)
+    {
+        const double frequency = 50.0 + r.nextDouble() * 15000.0;
+        const float gain = 0.25f + r.nextFloat() * 4.0f;
+
+        switch (r.nextInt (5))
+        {
+            case 0:     return IIRCoefficients::makeLowPass (44100.0, frequency);
+            case 1:     return IIRCoefficients::makeHighPass (44100.0, frequency);
+            case 2:     return IIRCoefficients::makeLowShelf (44100.0, frequency, 0.7, gain);
+            case 3:     return IIRCoefficients::makeHighShelf (44100.0, frequency, 0.7, gain);
+            default:    return IIRCoefficients::makeBandPass (44100.0, frequency, 0.5 + r.nextDouble() * 4.0, gain);
+        }
+    }
+
+    /** Runs some noise through a bank in random-sized blocks, and returns the
+        worst difference from running each channel through each stage in turn.
+    */
+    static float testAgainstScalar (Random& r, const int numChannels, const int numStages)
+    {
+        const int length = 3000;
+        IIRFilterBank bank (numChannels, numStages);
+        Array<IIRCoefficients> stages;
+
+        for (int i = 0; i < numStages; ++i)
+        {
+            stages.add (createRandomFilter (r));
+            bank.setStage (i, stages.getReference (i));
+        }
+
+        HeapBlock<float> input (numChannels * length), output (numChannels * length);
+
+        for (int i = 0; i < numChannels * length; ++i)
+            input[i] = output[i] = r.nextFloat() * 2.0f - 1.0f;
+
+        HeapBlock<float*> channels (numChannels);
+
+        for (int done = 0; done < length;)
+        {
+            const int num = jmin (length - done, 1 + r.nextInt (700));
+
+            for (int i = 0; i < numChannels; ++i)
+                channels[i] = output + i * length + done;
+
+            bank.processSamples (channels, numChannels, num);
+            done += num;
+        }
+
+        float worst = 0;
+
+        for (int i = 0; i < numChannels; ++i)
+        {
+            float* const samples = input + i * length;
+
+            for (int j = 0; j < numStages; ++j)
+            {
+                const float* const c = stages.getReference (j).coefficients;
+                float s1 = 0, s2 = 0;
+
+                for (int k = 0; k < length; ++k)
+                {
+                    const float x = samples[k];
+                    const float y = c[0] * x + s1;
+                    s1 = (c[1] * x + s2) - c[3] * y;
+                    s2 = c[2] * x - c[4] * y;
+                    samples[k] = y;
+                }
+            }
+
+            for (int k = 0; k < length; ++k)
+                worst = jmax (worst, std::abs (samples[k] - output [i * length + k]));
+        }
+
+        return worst;
+    }
+};
+
+static IIRFilterBankTests iirFilterBankTests;
+
+#endif
+
+END_JUCE_NAMESPACE
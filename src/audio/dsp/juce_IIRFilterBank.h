@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_IIRFILTERBANK_JUCEHEADER__
+#define __JUCE_IIRFILTERBANK_JUCEHEADER__
+
+#include "juce_IIRFilter.h"
+#include "../../memory/juce_HeapBlock.h"
+
+
+//==============================================================================
+/**
+    A chain of biquad filters that processes several channels at once.
+
+    Every channel goes through the same stages, one after another, and each stage
+    has its own IIRCoefficients, so one bank can make up a multi-band EQ, or a
+    steeper filter built from several sections, like one side of a crossover.
+
+    The filters use the transposed direct form II, and run in the lanes of SSE
+    registers: up to eight channels at a time when there are three or more channels,
+    or otherwise four stages at a time, each stage working a sample behind the one
+    before it. Either way, the output is the same as running each filter on its own.
+
+    The stages can be changed from any thread without blocking the one that's doing
+    the processing. New coefficients are picked up at the start of the next block, and
+    if a smoothing length has been set, the filters glide from the old coefficients to
+    the new ones over that many samples, so that moving a filter doesn't make it click.
+
+    @see IIRFilter, IIRCoefficients
+*/
+class JUCE_API  IIRFilterBank
+{
+public:
+    //==============================================================================
+    /** Creates a bank of filters.
+
+        Initially, all the stages pass their input straight through.
+
+        @param numChannels  the number of channels that it can process
+        @param numStages    the number of filters that each channel goes through
+    */
+    IIRFilterBank (int numChannels, int numStages);
+
+    /** Destructor. */
+    ~IIRFilterBank();
+
+    //==============================================================================
+    /** Returns the number of channels that the bank was created with. */
+    int getNumChannels() const noexcept                     { return numChannels; }
+
+    /** Returns the number of stages that the bank was created with. */
+    int getNumStages() const noexcept                       { return numStages; }
+
+    /** Changes the coefficients of one of the stages.
+
+        This can be called from any thread. The change takes effect at the start of the
+        next block that gets processed.
+    */
+    void setStage (int stageIndex, const IIRCoefficients& newCoefficients) noexcept;
+
+    /** Returns the coefficients that a stage was last given. */
+    const IIRCoefficients getStage (int stageIndex) const noexcept;
+
+    /** Sets how many samples the filters take to move to new coefficients.
+
+        If this is 0, which is the default, new coefficients are used straight away.
+    */
+    void setSmoothingLength (int numSamples) noexcept;
+
+    //==============================================================================
+    /** Clears the filters' state, ready to start a new stream of data.
+
+        This can be called from any thread, and takes effect at the start of the next
+        block. The coefficients aren't changed, but if the filters were gliding to new
+        ones, they jump straight to them.
+    */
+    void reset() noexcept;
+
+    /** Filters some channels of audio in place.
+
+        @param channels                 the channels' samples
+        @param numChannelsToProcess     how many channels to process, which can be fewer than
+                                        the number the bank was created with
+        @param numSamples               the number of samples in each channel
+    */
+    void processSamples (float* const* channels, int numChannelsToProcess, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    const int numChannels, numStages;
+
+    // the coefficients that setStage() writes
+    SeqLock targetLock;
+    HeapBlock<float> targets;
+
+    Atomic<int> smoothingLength, resetPending;
+
+    // the processing thread's coefficients, and how they're changing
+    HeapBlock<float> current, increments, rampTargets, incoming;
+    int currentVersion, rampSamplesLeft;
+
+    // s1 and s2 for each stage of each channel, and space for the channels side by side
+    HeapBlock<float> state, interleaved;
+
+    void updateCoefficients() noexcept;
+    void processSection (float* const* channels, int numChannelsToProcess,
+                         int startSample, int numSamples, bool ramping) noexcept;
+    void processChannelGroup (float* const* channels, int firstChannel, int numLanes,
+                              int startSample, int numSamples, bool ramping) noexcept;
+    void processStageGroup (float* samples, int channel, int firstStage, int numLanes,
+                            int numSamples, bool ramping) noexcept;
+    void processChannel (float* samples, int channel, int numSamples, bool ramping) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IIRFilterBank);
+};
+
+
+#endif   // __JUCE_IIRFILTERBANK_JUCEHEADER__
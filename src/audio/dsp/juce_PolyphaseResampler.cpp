@@ -0,0 +1,715 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#include "../../core/juce_StandardHeader.h"
+
+#if JUCE_INTEL && (JUCE_64BIT || JUCE_MSVC || defined (__SSE__))
+ #define JUCE_RESAMPLER_SSE 1
+ #include <xmmintrin.h>
+#endif
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_PolyphaseResampler.h"
+#include "../../threads/juce_Thread.h"
+
+
+//==============================================================================
+namespace PolyphaseResamplerHelpers
+{
+    double besselI0 (const double x) noexcept
+    {
+        double sum = 1.0, term = 1.0;
+        const double halfX = x * 0.5;
+
+        for (int k = 1; k < 50 && term > sum * 1.0e-12; ++k)
+        {
+            term *= (halfX / k) * (halfX / k);
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    /** Finds a fraction equal to the given value whose denominator isn't too big. */
+    bool findFraction (const double value, const int maxDenominator, int& numerator, int& denominator) noexcept
+    {
+        // the convergents of the value's continued fraction
+        int64 h0 = 0, h1 = 1, k0 = 1, k1 = 0;
+        double x = value;
+
+        for (int i = 0; i < 32; ++i)
+        {
+            const double wholePart = std::floor (x);
+            const int64 a = (int64) wholePart;
+            const int64 h2 = a * h1 + h0;
+            const int64 k2 = a * k1 + k0;
+
+            if (k2 > maxDenominator || h2 > 0x7fffffff)
+                return false;
+
+            h0 = h1;  h1 = h2;
+            k0 = k1;  k1 = k2;
+
+            if (std::abs (h1 / (double) k1 - value) <= value * 1.0e-10)
+            {
+                numerator = (int) h1;
+                denominator = (int) k1;
+                return true;
+            }
+
+            if (x - wholePart < 1.0e-12)
+                return false;
+
+            x = 1.0 / (x - wholePart);
+        }
+
+        return false;
+    }
+
+    float dotProduct (const float* x, const float* coeffs, int num) noexcept
+    {
+        float sum = 0;
+
+       #if JUCE_RESAMPLER_SSE
+        __m128 sums = _mm_setzero_ps();
+
+        for (; num >= 4; num -= 4, x += 4, coeffs += 4)
+            sums = _mm_add_ps (sums, _mm_mul_ps (_mm_loadu_ps (x), _mm_loadu_ps (coeffs)));
+
+        float lanes[4];
+        _mm_storeu_ps (lanes, sums);
+        sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+       #endif
+
+        while (--num >= 0)
+            sum += *x++ * *coeffs++;
+
+        return sum;
+    }
+
+    /** Applies two neighbouring phases to the same input in one pass. */
+    void dotProduct2 (const float* x, const float* coeffs1, const float* coeffs2, int num,
+                      float& sum1, float& sum2) noexcept
+    {
+        sum1 = sum2 = 0;
+
+       #if JUCE_RESAMPLER_SSE
+        __m128 sums1 = _mm_setzero_ps(), sums2 = _mm_setzero_ps();
+
+        for (; num >= 4; num -= 4, x += 4, coeffs1 += 4, coeffs2 += 4)
+        {
+            const __m128 input = _mm_loadu_ps (x);
+            sums1 = _mm_add_ps (sums1, _mm_mul_ps (input, _mm_loadu_ps (coeffs1)));
+            sums2 = _mm_add_ps (sums2, _mm_mul_ps (input, _mm_loadu_ps (coeffs2)));
+        }
+
+        float lanes[4];
+        _mm_storeu_ps (lanes, sums1);
+        sum1 = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        _mm_storeu_ps (lanes, sums2);
+        sum2 = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+       #endif
+
+        for (; --num >= 0; ++x)
+        {
+            sum1 += *x * *coeffs1++;
+            sum2 += *x * *coeffs2++;
+        }
+    }
+}
+
+//==============================================================================
+PolyphaseResampler::PolyphaseResampler (const int numChannels_, const int numZeroCrossings_, const double maximumRatio_)
+    : numChannels (jmax (1, numChannels_)),
+      numZeroCrossings (jmax (2, numZeroCrossings_)),
+      maximumRatio (jmax (1.0, maximumRatio_)),
+      ratio (0),
+      maxHalfLength (0),
+      lastPreparedRatio (1.0),
+      phases (nullptr),
+      isExact (false),
+      numerator (1),
+      denominator (1),
+      numPhases (0),
+      halfLength (0),
+      historySize (0),
+      numStored (0),
+      position (0),
+      fraction (0),
+      phase (0)
+{
+    // the filter is always a whole number of SSE vectors long
+    maxHalfLength = ((int) std::ceil (numZeroCrossings * maximumRatio) + 1) & ~1;
+
+    const int tableSize = jmax ((int) numInterpolatedPhases + 1, (int) maxExactPhases) * maxHalfLength * 2;
+    exactTable.coeffs.malloc (tableSize);
+    interpolatedTable.coeffs.malloc (tableSize);
+    pendingTable.coeffs.malloc (tableSize);
+
+    // both of the audio thread's tables start out passing the input straight through
+    int unusedNumerator;
+    designTable (1.0, true, exactTable, unusedNumerator);
+    buildTable (exactTable);
+    designTable (1.0, false, interpolatedTable, unusedNumerator);
+    buildTable (interpolatedTable);
+
+    setRatio (1.0);
+    prepare (512);
+}
+
+PolyphaseResampler::~PolyphaseResampler()
+{
+}
+
+//==============================================================================
+void PolyphaseResampler::prepareRatio (const double samplesInPerOutputSample)
+{
+    jassert (samplesInPerOutputSample > 0 && samplesInPerOutputSample <= maximumRatio);
+
+    const double newRatio = jlimit (1.0 / 1024.0, maximumRatio, samplesInPerOutputSample);
+    const ScopedLock sl (prepareLock);
+
+    if (newRatio == lastPreparedRatio)
+        return;
+
+    // a table that the audio thread hasn't picked up yet is taken back and rebuilt,
+    // but one that it's in the middle of taking has to be left to it
+    while (! (pendingTableState.compareAndSetBool (buildingPendingTable, noPendingTable)
+               || pendingTableState.compareAndSetBool (buildingPendingTable, pendingTableReady)))
+        Thread::yield();
+
+    int unusedNumerator;
+    designTable (newRatio, true, pendingTable, unusedNumerator);
+    buildTable (pendingTable);
+
+    lastPreparedRatio = newRatio;
+    pendingTableState = pendingTableReady;
+}
+
+void PolyphaseResampler::setRatio (const double samplesInPerOutputSample)
+{
+    jassert (samplesInPerOutputSample > 0 && samplesInPerOutputSample <= maximumRatio);
+
+    const double newRatio = jlimit (1.0 / 1024.0, maximumRatio, samplesInPerOutputSample);
+
+    // a table that's been prepared is picked up even if the ratio hasn't changed
+    if (takePendingTable() || newRatio != ratio)
+    {
+        ratio = newRatio;
+        updateFilter();
+    }
+}
+
+bool PolyphaseResampler::takePendingTable()
+{
+    if (! pendingTableState.compareAndSetBool (takingPendingTable, pendingTableReady))
+        return false;
+
+    FilterTable& table = pendingTable.isExact ? exactTable : interpolatedTable;
+
+    table.coeffs.swapWith (pendingTable.coeffs);
+    table.numPhases = pendingTable.numPhases;
+    table.halfLength = pendingTable.halfLength;
+    table.cutoff = pendingTable.cutoff;
+
+    pendingTableState = noPendingTable;
+    return true;
+}
+
+void PolyphaseResampler::updateFilter()
+{
+    // where the next output sample falls between two input samples
+    const double currentFraction = isExact ? phase / (double) denominator : fraction;
+
+    FilterTable wanted;
+    int newNumerator = 1;
+    designTable (ratio, true, wanted, newNumerator);
+
+    if (wanted.isExact && wanted.numPhases == exactTable.numPhases
+         && wanted.halfLength == exactTable.halfLength && wanted.cutoff == exactTable.cutoff)
+    {
+        isExact = true;
+        numerator = newNumerator;
+        denominator = exactTable.numPhases;
+        numPhases = exactTable.numPhases;
+        halfLength = exactTable.halfLength;
+        phases = exactTable.coeffs;
+
+        phase = roundToInt (currentFraction * denominator);
+
+        if (phase >= denominator)
+        {
+            phase -= denominator;
+            ++position;
+        }
+    }
+    else
+    {
+        // the interpolated table works for any ratio, so it stands in until the right
+        // table has been prepared, even if its cut-off is a little out
+        isExact = false;
+        fraction = currentFraction;
+        numPhases = interpolatedTable.numPhases;
+        halfLength = interpolatedTable.halfLength;
+        phases = interpolatedTable.coeffs;
+    }
+}
+
+void PolyphaseResampler::designTable (const double newRatio, const bool exactIfPossible,
+                                      FilterTable& table, int& newNumerator) const
+{
+    using namespace PolyphaseResamplerHelpers;
+
+    table.cutoff = jmin (1.0, 1.0 / newRatio);
+    table.halfLength = jmin (maxHalfLength, ((int) std::ceil (numZeroCrossings / table.cutoff) + 1) & ~1);
+
+    int newDenominator = 1;
+    table.isExact = exactIfPossible && findFraction (newRatio, maxExactPhases, newNumerator, newDenominator);
+    table.numPhases = table.isExact ? newDenominator : (int) numInterpolatedPhases;
+}
+
+void PolyphaseResampler::buildTable (FilterTable& table) const
+{
+    using namespace PolyphaseResamplerHelpers;
+
+    // an interpolated table has an extra phase at the end to interpolate towards
+    const int numRows = table.isExact ? table.numPhases : table.numPhases + 1;
+    const int rowLength = table.halfLength * 2;
+    const int tableHalfLength = table.halfLength;
+
+    const double beta = jlimit (5.0, 12.0, 2.0 + 0.4 * numZeroCrossings);
+    const double windowScale = 1.0 / besselI0 (beta);
+
+    for (int row = 0; row < numRows; ++row)
+    {
+        float* const coeffs = table.coeffs + row * rowLength;
+        const double offset = row / (double) table.numPhases;
+        double sum = 0;
+
+        for (int i = 0; i < rowLength; ++i)
+        {
+            // the distance from the output sample to this input sample
+            const double t = i - tableHalfLength + 1 - offset;
+            const double u = t / tableHalfLength;
+
+            double c = 0;
+
+            if (std::abs (u) < 1.0)
+            {
+                const double x = double_Pi * table.cutoff * t;
+                const double sinc = std::abs (x) < 1.0e-9 ? 1.0 : std::sin (x) / x;
+
+                c = sinc * besselI0 (beta * std::sqrt (1.0 - u * u)) * windowScale;
+            }
+
+            coeffs[i] = (float) c;
+            sum += c;
+        }
+
+        // normalised, so that there's no ripple at DC between the phases
+        const float scale = (float) (1.0 / sum);
+
+        for (int i = 0; i < rowLength; ++i)
+            coeffs[i] *= scale;
+    }
+}
+
+//==============================================================================
+void PolyphaseResampler::prepare (const int maximumInputBlockSize)
+{
+    ensureHistorySize (maximumInputBlockSize + maxHalfLength * 4 + (int) std::ceil (maximumRatio) + 8);
+    reset();
+}
+
+void PolyphaseResampler::reset()
+{
+    // The history always keeps enough input behind the next output sample for
+    // the longest filter, so the filter can change length at any point.
+    numStored = maxHalfLength - 1;
+    position = numStored;
+    fraction = 0;
+    phase = 0;
+
+    for (int i = 0; i < numChannels; ++i)
+        zeromem (history + i * historySize, sizeof (float) * (size_t) numStored);
+}
+
+void PolyphaseResampler::ensureHistorySize (const int numSamples)
+{
+    if (numSamples <= historySize)
+        return;
+
+    HeapBlock<float> newHistory;
+    newHistory.calloc ((size_t) (numSamples * numChannels));
+
+    for (int i = 0; i < numChannels; ++i)
+        memcpy (newHistory + i * numSamples, history + i * historySize, sizeof (float) * (size_t) numStored);
+
+    history.swapWith (newHistory);
+    historySize = numSamples;
+}
+
+void PolyphaseResampler::discardUsedInput()
+{
+    const int numToDiscard = position - (maxHalfLength - 1);
+
+    if (numToDiscard <= 0)
+        return;
+
+    numStored -= numToDiscard;
+    position -= numToDiscard;
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        float* const h = history + i * historySize;
+        memmove (h, h + numToDiscard, sizeof (float) * (size_t) numStored);
+    }
+}
+
+//==============================================================================
+int PolyphaseResampler::getNumInputSamplesNeeded (const int numOutputSamples) const noexcept
+{
+    if (numOutputSamples <= 0)
+        return 0;
+
+    int lastPosition;
+
+    if (isExact)
+        lastPosition = position + (int) ((phase + (int64) numerator * (numOutputSamples - 1)) / denominator);
+    else
+        lastPosition = position + (int) std::floor (fraction + ratio * (numOutputSamples - 1));
+
+    // one spare sample allows for the rounding of the position as it's stepped along
+    return jmax (0, lastPosition + halfLength + 2 - numStored);
+}
+
+int PolyphaseResampler::getNumOutputSamplesAvailable() const noexcept
+{
+    const int spaceAhead = numStored - 1 - halfLength - position;
+
+    if (spaceAhead < 0)
+        return 0;
+
+    if (isExact)
+        return (int) (((spaceAhead + 1) * (int64) denominator - phase - 1) / numerator) + 1;
+
+    return jmax (0, (int) std::ceil ((spaceAhead + 1 - fraction) / ratio) - 1);
+}
+
+void PolyphaseResampler::addInput (const float* const* inputChannels, const int numSamples)
+{
+    ensureHistorySize (numStored + numSamples);
+
+    for (int i = 0; i < numChannels; ++i)
+        memcpy (history + i * historySize + numStored, inputChannels[i], sizeof (float) * (size_t) numSamples);
+
+    numStored += numSamples;
+}
+
+void PolyphaseResampler::addInterleavedInput (const float* input, const int numSamples)
+{
+    ensureHistorySize (numStored + numSamples);
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        float* const dest = history + i * historySize + numStored;
+        const float* src = input + i;
+
+        for (int j = 0; j < numSamples; ++j, src += numChannels)
+            dest[j] = *src;
+    }
+
+    numStored += numSamples;
+}
+
+int PolyphaseResampler::readOutput (float* const* outputChannels, const int numSamples)
+{
+    return renderSamples (outputChannels, nullptr, numSamples);
+}
+
+int PolyphaseResampler::readInterleavedOutput (float* output, const int numSamples)
+{
+    return renderSamples (nullptr, output, numSamples);
+}
+
+int PolyphaseResampler::renderSamples (float* const* outputChannels, float* interleaved, const int numSamples)
+{
+    using namespace PolyphaseResamplerHelpers;
+
+    const int rowLength = halfLength * 2;
+    int num = 0;
+
+    for (; num < numSamples && position + halfLength < numStored; ++num)
+    {
+        const float* const input = history + (position - halfLength + 1);
+
+        if (isExact)
+        {
+            const float* const coeffs = phases + phase * rowLength;
+
+            for (int i = 0; i < numChannels; ++i)
+            {
+                const float value = dotProduct (input + i * historySize, coeffs, rowLength);
+
+                if (interleaved != nullptr)
+                    interleaved [num * numChannels + i] = value;
+                else
+                    outputChannels[i][num] = value;
+            }
+
+            phase += numerator;
+            position += phase / denominator;
+            phase %= denominator;
+        }
+        else
+        {
+            const double phasePosition = fraction * numPhases;
+            const int index = (int) phasePosition;
+            const float blend = (float) (phasePosition - index);
+            const float* const coeffs = phases + index * rowLength;
+
+            for (int i = 0; i < numChannels; ++i)
+            {
+                float value1, value2;
+                dotProduct2 (input + i * historySize, coeffs, coeffs + rowLength, rowLength, value1, value2);
+
+                const float value = value1 + blend * (value2 - value1);
+
+                if (interleaved != nullptr)
+                    interleaved [num * numChannels + i] = value;
+                else
+                    outputChannels[i][num] = value;
+            }
+
+            fraction += ratio;
+            const int wholeSamples = (int) fraction;
+            position += wholeSamples;
+            fraction -= wholeSamples;
+        }
+    }
+
+    discardUsedInput();
+    return num;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+#include "../../maths/juce_Random.h"
+
+class PolyphaseResamplerTests  : public UnitTest
+{
+public:
+    PolyphaseResamplerTests() : UnitTest ("PolyphaseResampler") {}
+
+    void runTest()
+    {
+        beginTest ("Passing through");
+        {
+            PolyphaseResampler resampler (1);
+            HeapBlock<float> input (1000), output (1000);
+
+            for (int i = 0; i < 1000; ++i)
+                input[i] = (float) std::sin (i * 0.3);
+
+            const float* in = input;
+            float* out = output;
+
+            resampler.addInput (&in, 1000);
+            const int num = resampler.readOutput (&out, 1000);
+            expect (num > 900 && num < 1000);
+
+            float worst = 0;
+            for (int i = 0; i < num; ++i)
+                worst = jmax (worst, std::abs (output[i] - input[i]));
+
+            expect (worst < 1.0e-6f);
+        }
+
+        beginTest ("Exact ratio, 48KHz to 44.1KHz");
+        expect (testSineAccuracy (48000.0 / 44100.0, 1000.0, 48000.0, 16) < 1.0e-3);
+
+        beginTest ("Arbitrary ratio");
+        expect (testSineAccuracy (1.2345678, 1000.0, 44100.0, 16) < 1.0e-3);
+        expect (testSineAccuracy (0.7654321, 3000.0, 44100.0, 16) < 1.0e-3);
+
+        beginTest ("Down-sampling doesn't alias");
+        {
+            PolyphaseResampler resampler (1, 16, 2.0);
+            resampler.prepareRatio (2.0);
+            resampler.setRatio (2.0);
+
+            expect (getAliasedPeak (resampler) < 0.01f);
+        }
+
+        beginTest ("Preparing on another thread");
+        {
+            PolyphaseResampler resampler (1, 16, 2.0);
+
+            // until the table's been built, the speed is right but the cut-off isn't
+            resampler.setRatio (2.0);
+            expect (getAliasedPeak (resampler) > 0.1f);
+
+            RatioPreparer preparer (resampler, 2.0);
+            preparer.startThread();
+
+            for (int i = 0; i < 1000 && ! preparer.waitForThreadToExit (10); ++i)
+                resampler.setRatio (2.0);
+
+            resampler.reset();
+            resampler.setRatio (2.0);
+            expect (getAliasedPeak (resampler) < 0.01f);
+        }
+
+        beginTest ("Interleaved and in pieces");
+        {
+            Random r (1234);
+            const int numChannels = 3, length = 5000;
+            HeapBlock<float> input (length * numChannels), planar (length * numChannels * 2), interleaved (length * numChannels * 2);
+
+            for (int i = 0; i < length * numChannels; ++i)
+                input[i] = r.nextFloat() - 0.5f;
+
+            const float* channels[numChannels];
+            float* outputs[numChannels];
+
+            for (int i = 0; i < numChannels; ++i)
+            {
+                channels[i] = input + i * length;
+                outputs[i] = planar + i * length * 2;
+            }
+
+            PolyphaseResampler resampler1 (numChannels), resampler2 (numChannels);
+            resampler1.prepareRatio (0.9);
+            resampler1.setRatio (0.9);
+            resampler2.prepareRatio (0.9);
+            resampler2.setRatio (0.9);
+
+            resampler1.addInput (channels, length);
+            const int num = resampler1.readOutput (outputs, length * 2);
+
+            HeapBlock<float> block (1000 * numChannels);
+            int numIn = 0, numOut = 0;
+
+            while (numIn < length)
+            {
+                const int numToAdd = jmin (length - numIn, 1 + r.nextInt (300));
+
+                for (int i = 0; i < numToAdd; ++i)
+                    for (int j = 0; j < numChannels; ++j)
+                        block [i * numChannels + j] = channels[j][numIn + i];
+
+                resampler2.addInterleavedInput (block, numToAdd);
+                numIn += numToAdd;
+                numOut += resampler2.readInterleavedOutput (interleaved + numOut * numChannels, 1 + r.nextInt (400));
+            }
+
+            numOut += resampler2.readInterleavedOutput (interleaved + numOut * numChannels, length);
+            expectEquals (numOut, num);
+
+            bool allSame = true;
+
+            for (int i = 0; i < num; ++i)
+                for (int j = 0; j < numChannels; ++j)
+                    allSame = allSame && interleaved [i * numChannels + j] == outputs[j][i];
+
+            expect (allSame);
+        }
+    }
+
+private:
+    class RatioPreparer  : public Thread
+    {
+    public:
+        RatioPreparer (PolyphaseResampler& resampler_, const double ratio_)
+            : Thread ("Resampler preparer"), resampler (resampler_), ratio (ratio_)
+        {
+        }
+
+        void run()      { resampler.prepareRatio (ratio); }
+
+    private:
+        PolyphaseResampler& resampler;
+        const double ratio;
+    };
+
+    /** Resamples a 16KHz sine at 44.1KHz, which is above the Nyquist frequency at
+        half the rate, and returns the loudest of what gets through.
+    */
+    static float getAliasedPeak (PolyphaseResampler& resampler)
+    {
+        HeapBlock<float> input (8192), output (4096);
+
+        for (int i = 0; i < 8192; ++i)
+            input[i] = (float) std::sin (2.0 * double_Pi * 16000.0 * i / 44100.0);
+
+        const float* in = input;
+        float* out = output;
+        resampler.addInput (&in, 8192);
+        const int num = resampler.readOutput (&out, 4096);
+
+        float peak = 0;
+        for (int i = 100; i < num; ++i)
+            peak = jmax (peak, std::abs (output[i]));
+
+        return peak;
+    }
+
+    /** Resamples a sine wave, and returns the worst difference from the real thing. */
+    static double testSineAccuracy (const double ratio, const double frequency,
+                                    const double sampleRate, const int numZeroCrossings)
+    {
+        PolyphaseResampler resampler (1, numZeroCrossings);
+        resampler.prepareRatio (ratio);
+        resampler.setRatio (ratio);
+
+        const int numInput = 20000;
+        HeapBlock<float> input (numInput), output (numInput * 2);
+
+        for (int i = 0; i < numInput; ++i)
+            input[i] = (float) std::sin (2.0 * double_Pi * frequency * i / sampleRate);
+
+        const float* in = input;
+        float* out = output;
+        resampler.addInput (&in, numInput);
+
+        const int num = resampler.readOutput (&out, numInput * 2);
+        double worst = 0;
+
+        // the start is left out, where the filter's still running into the input
+        for (int i = 200; i < num; ++i)
+            worst = jmax (worst, std::abs (output[i] - std::sin (2.0 * double_Pi * frequency * i * ratio / sampleRate)));
+
+        return worst;
+    }
+};
+
+static PolyphaseResamplerTests polyphaseResamplerTests;
+
+#endif
+
+END_JUCE_NAMESPACE
@@ -0,0 +1,222 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_POLYPHASERESAMPLER_JUCEHEADER__
+#define __JUCE_POLYPHASERESAMPLER_JUCEHEADER__
+
+#include "../../memory/juce_HeapBlock.h"
+#include "../../memory/juce_Atomic.h"
+#include "../../threads/juce_CriticalSection.h"
+
+
+//==============================================================================
+/**
+    Changes the sample rate of some audio using a windowed-sinc filter.
+
+    Each output sample is worked out from the input samples around it, weighted
+    by a Kaiser-windowed sinc function, which is a much closer approximation to
+    ideal band-limited interpolation than linear interpolation followed by a low-pass
+    filter, as used by ResamplingAudioSource. When down-sampling, the filter's
+    cut-off is lowered so that nothing above the new Nyquist frequency aliases.
+
+    The filter is kept as a table of phases, i.e. sets of coefficients for output
+    samples falling at different fractions of the way between two input samples.
+    If the ratio is a fraction with a small enough denominator, like 160/147 for
+    48KHz to 44.1KHz, the table holds exactly the phases that get used. Otherwise,
+    it holds a fixed number of phases and interpolates between the two nearest
+    ones, so the ratio can be anything and can be changed at any time.
+
+    Building a table takes far too long for the audio thread, so it's done by
+    prepareRatio(), which can be called on any other thread, and setRatio() then
+    just swaps the finished table in. Until the table for a ratio is ready, the
+    interpolated table is used, since it works for any ratio, although when
+    down-sampling its cut-off may be a little out.
+
+    Input is pushed in with addInput() and the resampled output read back with
+    readOutput(); getNumInputSamplesNeeded() says how much input has to go in to get
+    a given amount out. All the channels are processed together, either as separate
+    channels or interleaved, and the inner loops use SSE where it's available.
+
+    Output sample n lines up with the input at n * ratio, so the output isn't delayed,
+    but the resampler needs to see some input samples ahead of each output sample
+    before it can produce it.
+
+    @see SincResamplingAudioSource, ResamplingAudioSource
+*/
+class JUCE_API  PolyphaseResampler
+{
+public:
+    //==============================================================================
+    /** Creates a resampler.
+
+        @param numChannels          the number of channels of audio that it processes
+        @param numZeroCrossings     the number of zero crossings of the sinc function on
+                                    each side of a sample, which trades the quality against
+                                    the CPU. 8 is fast, 16 is good, and 32 is very clean.
+        @param maximumRatio         the largest ratio that setRatio() will be given, which
+                                    sets how long the filter can get when down-sampling
+    */
+    PolyphaseResampler (int numChannels,
+                        int numZeroCrossings = 16,
+                        double maximumRatio = 4.0);
+
+    /** Destructor. */
+    ~PolyphaseResampler();
+
+    //==============================================================================
+    /** Builds the filter table for a ratio, ready for setRatio() to swap in.
+
+        This does all the slow work of changing the ratio, so it should be called on a
+        thread other than the audio thread, before the ratio is set. Only the most recently
+        prepared table is kept, and preparing the same ratio again does nothing.
+
+        @see setRatio
+    */
+    void prepareRatio (double samplesInPerOutputSample);
+
+    /** Changes the resampling ratio.
+
+        This never builds a table or allocates any memory, so it can be called from the
+        audio thread, e.g. to vary the speed of playback. If prepareRatio() has built the
+        table for the new ratio, it's swapped in; otherwise the interpolated table is used
+        until it has.
+
+        @param samplesInPerOutputSample     if this is 1.0, the input is passed through; higher
+                                            values speed it up, and lower values slow it down.
+                                            It can't be more than the maximum ratio that was given
+                                            to the constructor.
+    */
+    void setRatio (double samplesInPerOutputSample);
+
+    /** Returns the current resampling ratio. */
+    double getRatio() const noexcept                        { return ratio; }
+
+    /** Allocates enough space for blocks of up to the given number of input samples.
+
+        The space is also grown as needed by addInput(), but calling this first means that
+        nothing gets allocated while processing.
+    */
+    void prepare (int maximumInputBlockSize);
+
+    /** Discards all the input and clears the filter history. */
+    void reset();
+
+    //==============================================================================
+    /** Returns the number of input samples that have to be added before the given
+        number of output samples can be read.
+    */
+    int getNumInputSamplesNeeded (int numOutputSamples) const noexcept;
+
+    /** Returns the number of output samples that can be read at the moment. */
+    int getNumOutputSamplesAvailable() const noexcept;
+
+    /** Adds some input, one array of samples for each channel. */
+    void addInput (const float* const* inputChannels, int numSamples);
+
+    /** Adds some input with the channels interleaved. */
+    void addInterleavedInput (const float* input, int numSamples);
+
+    /** Reads some resampled output, one array of samples for each channel.
+
+        This produces as many samples as it can, up to the number asked for, and
+        returns how many it produced.
+    */
+    int readOutput (float* const* outputChannels, int numSamples);
+
+    /** Reads some resampled output with the channels interleaved.
+
+        This produces as many samples as it can, up to the number asked for, and
+        returns how many it produced.
+    */
+    int readInterleavedOutput (float* output, int numSamples);
+
+private:
+    //==============================================================================
+    enum
+    {
+        numInterpolatedPhases = 256,
+        maxExactPhases = 512
+    };
+
+    /** A table of filter phases, with the taps either side of each output sample,
+        and the filter's cut-off as a proportion of the input's Nyquist frequency.
+        An exact table has one phase for each multiple of 1 / denominator.
+    */
+    struct FilterTable
+    {
+        HeapBlock<float> coeffs;
+        bool isExact;
+        int numPhases, halfLength;
+        double cutoff;
+    };
+
+    enum PendingTableState
+    {
+        noPendingTable,
+        buildingPendingTable,
+        pendingTableReady,
+        takingPendingTable
+    };
+
+    const int numChannels, numZeroCrossings;
+    const double maximumRatio;
+    double ratio;
+    int maxHalfLength;
+
+    // the audio thread's tables, and one built by prepareRatio(), which belongs to
+    // whichever thread the pending state says
+    FilterTable exactTable, interpolatedTable, pendingTable;
+    Atomic<int> pendingTableState;
+    CriticalSection prepareLock;
+    double lastPreparedRatio;
+
+    // the table in use
+    const float* phases;
+    bool isExact;
+    int numerator, denominator;
+    int numPhases, halfLength;
+
+    // the input that's still needed, with the channels one after another
+    HeapBlock<float> history;
+    int historySize, numStored;
+
+    // where the next output sample falls in the input
+    int position;
+    double fraction;
+    int phase;
+
+    void designTable (double ratio, bool exactIfPossible, FilterTable& table, int& numerator) const;
+    void buildTable (FilterTable& table) const;
+    bool takePendingTable();
+    void updateFilter();
+    void ensureHistorySize (int numSamples);
+    void discardUsedInput();
+    int renderSamples (float* const* outputChannels, float* interleaved, int numSamples);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PolyphaseResampler);
+};
+
+
+#endif   // __JUCE_POLYPHASERESAMPLER_JUCEHEADER__
@@ -208,7 +208,7 @@ private:
         shouldUpdateDamping = false;
 
         if (isFrozen (parameters.freezeMode))
-            setDamping (1.0f, 0.0f);
+            setDamping (0.0f, 1.0f);
         else
             setDamping (parameters.damping * dampScaleFactor,
                         parameters.roomSize * roomScaleFactor + roomOffset);
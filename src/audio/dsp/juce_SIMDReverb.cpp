@@ -0,0 +1,849 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#include "../../core/juce_StandardHeader.h"
+
+#if JUCE_INTEL && (JUCE_64BIT || JUCE_MSVC || defined (__SSE__))
+ #define JUCE_SIMDREVERB_SSE 1
+ #include <xmmintrin.h>
+#endif
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_SIMDReverb.h"
+
+
+//==============================================================================
+namespace SIMDReverbHelpers
+{
+    static const short combTunings[] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 }; // (at 44100Hz)
+    static const short allPassTunings[] = { 556, 441, 341, 225 };
+    const int stereoSpread = 23;
+
+   #if JUCE_SIMDREVERB_SSE
+    /** Does the same as JUCE_UNDENORMALISE to four values. */
+    inline void undenormalise (__m128& x) noexcept
+    {
+       #if JUCE_INTEL && JUCE_32BIT
+        const __m128 one = _mm_set1_ps (1.0f);
+        x = _mm_sub_ps (_mm_add_ps (x, one), one);
+       #else
+        (void) x;
+       #endif
+    }
+
+    /** Makes the CPU flush denormals to zero while it's in scope, which only makes a
+        difference to values so small that they'd be inaudible anyway.
+    */
+    class ScopedFlushToZero
+    {
+    public:
+        ScopedFlushToZero() noexcept  : oldMode (_mm_getcsr())    { _mm_setcsr (oldMode | 0x8000); }
+        ~ScopedFlushToZero() noexcept                             { _mm_setcsr (oldMode); }
+
+    private:
+        const unsigned int oldMode;
+    };
+
+    /** Runs a sample through four comb filters, returning what they write to their delay lines. */
+    inline __m128 processCombStep (const __m128 output, const float input, __m128& last,
+                                   const __m128 damp1, const __m128 damp2, const __m128 feedback) noexcept
+    {
+        last = _mm_add_ps (_mm_mul_ps (output, damp2), _mm_mul_ps (last, damp1));
+        undenormalise (last);
+
+        __m128 temp = _mm_add_ps (_mm_set1_ps (input), _mm_mul_ps (last, feedback));
+        undenormalise (temp);
+        return temp;
+    }
+
+    /** Runs four samples through four comb filters, and returns the sum of the combs'
+        outputs for each sample.
+    */
+    inline __m128 processCombQuad (float* const* lines, const int pos, const float* input, __m128& last,
+                                   const __m128 damp1, const __m128 damp2, const __m128 feedback) noexcept
+    {
+        // each row starts off holding four samples from one comb's delay line..
+        __m128 row0 = _mm_loadu_ps (lines[0] + pos), row1 = _mm_loadu_ps (lines[1] + pos);
+        __m128 row2 = _mm_loadu_ps (lines[2] + pos), row3 = _mm_loadu_ps (lines[3] + pos);
+        const __m128 sum = _mm_add_ps (_mm_add_ps (row0, row1), _mm_add_ps (row2, row3));
+
+        // ..and then one sample from each of the four combs
+        _MM_TRANSPOSE4_PS (row0, row1, row2, row3);
+
+        row0 = processCombStep (row0, input[0], last, damp1, damp2, feedback);
+        row1 = processCombStep (row1, input[1], last, damp1, damp2, feedback);
+        row2 = processCombStep (row2, input[2], last, damp1, damp2, feedback);
+        row3 = processCombStep (row3, input[3], last, damp1, damp2, feedback);
+
+        _MM_TRANSPOSE4_PS (row0, row1, row2, row3);
+
+        _mm_storeu_ps (lines[0] + pos, row0);
+        _mm_storeu_ps (lines[1] + pos, row1);
+        _mm_storeu_ps (lines[2] + pos, row2);
+        _mm_storeu_ps (lines[3] + pos, row3);
+        return sum;
+    }
+
+    /** Returns the values of a linear ramp for four samples, starting at the given one. */
+    inline __m128 getRamp (const float start, const float step, const int index) noexcept
+    {
+        const __m128 indexes = _mm_add_ps (_mm_set1_ps ((float) index), _mm_setr_ps (0, 1.0f, 2.0f, 3.0f));
+        return _mm_add_ps (_mm_set1_ps (start), _mm_mul_ps (_mm_set1_ps (step), indexes));
+    }
+
+    /** Runs an all-pass filter over some samples that are all shorter than its delay. */
+    void processAllPass (float* buffer, float* samples, const int numSamples) noexcept
+    {
+        const __m128 half = _mm_set1_ps (0.5f);
+        int i = 0;
+
+        for (; i <= numSamples - 4; i += 4)
+        {
+            const __m128 bufferedValue = _mm_loadu_ps (buffer + i);
+            const __m128 in = _mm_loadu_ps (samples + i);
+            __m128 temp = _mm_add_ps (in, _mm_mul_ps (bufferedValue, half));
+            undenormalise (temp);
+            _mm_storeu_ps (buffer + i, temp);
+            _mm_storeu_ps (samples + i, _mm_sub_ps (bufferedValue, in));
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            const float bufferedValue = buffer[i];
+            float temp = samples[i] + (bufferedValue * 0.5f);
+            JUCE_UNDENORMALISE (temp);
+            buffer[i] = temp;
+            samples[i] = bufferedValue - samples[i];
+        }
+    }
+   #else
+    class ScopedFlushToZero
+    {
+    public:
+        ScopedFlushToZero() noexcept {}
+    };
+
+    void processAllPass (float* buffer, float* samples, const int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float bufferedValue = buffer[i];
+            float temp = samples[i] + (bufferedValue * 0.5f);
+            JUCE_UNDENORMALISE (temp);
+            buffer[i] = temp;
+            samples[i] = bufferedValue - samples[i];
+        }
+    }
+   #endif
+}
+
+//==============================================================================
+SIMDReverb::SIMDReverb()
+    : currentVersion (-1),
+      sampleRate (0),
+      smoothingTime (0.05),
+      smoothingLength (0),
+      rampSamplesLeft (0),
+      isStarting (true),
+      blockSize (1)
+{
+    zerostruct (current);
+    zerostruct (target);
+
+    input.calloc (maxBlockSize);
+    wetLeft.calloc (maxBlockSize);
+    wetRight.calloc (maxBlockSize);
+
+    setParameters (Parameters());
+    setSampleRate (44100.0);
+}
+
+SIMDReverb::~SIMDReverb()
+{
+}
+
+//==============================================================================
+void SIMDReverb::setParameters (const Parameters& newParams) noexcept
+{
+    const SeqLock::ScopedWriteType sl (parameterLock);
+    parameters = newParams;
+}
+
+void SIMDReverb::setSmoothingTime (const double seconds) noexcept
+{
+    smoothingTime = jmax (0.0, seconds);
+    smoothingLength = roundToInt (smoothingTime * sampleRate);
+}
+
+//==============================================================================
+void SIMDReverb::setSampleRate (const double newSampleRate)
+{
+    using namespace SIMDReverbHelpers;
+    jassert (newSampleRate > 0);
+
+    sampleRate = newSampleRate;
+    smoothingLength = roundToInt (smoothingTime * sampleRate);
+
+    // the same sizes as Reverb's filters
+    const int intSampleRate = (int) sampleRate;
+    blockSize = maxBlockSize;
+
+    int channel, i;
+    for (channel = 0; channel < numChannels; ++channel)
+    {
+        const int spread = channel * stereoSpread;
+
+        for (i = 0; i < numCombs; ++i)
+        {
+            const int lane = channel * numCombs + i;
+            combSize [lane] = jmax (1, (intSampleRate * (combTunings[i] + spread)) / 44100);
+            blockSize = jmin (blockSize, combSize [lane]);
+        }
+
+        for (i = 0; i < numAllPasses; ++i)
+        {
+            allPassSize [channel][i] = jmax (1, (intSampleRate * (allPassTunings[i] + spread)) / 44100);
+            blockSize = jmin (blockSize, allPassSize [channel][i]);
+        }
+    }
+
+    // All the delay lines go in one block, with the all-passes at the end. Each comb's
+    // line is followed by a copy of the first block's worth of its samples.
+    int total = 0;
+
+    for (i = 0; i < numCombLanes; ++i)
+    {
+        combStart [i] = total;
+        total += combSize [i] + blockSize;
+    }
+
+    for (channel = 0; channel < numChannels; ++channel)
+    {
+        for (i = 0; i < numAllPasses; ++i)
+        {
+            allPassStart [channel][i] = total;
+            total += allPassSize [channel][i];
+        }
+    }
+
+    delayLines.malloc (total);
+    reset();
+}
+
+void SIMDReverb::reset() noexcept
+{
+    const int total = allPassStart [numChannels - 1][numAllPasses - 1]
+                        + allPassSize [numChannels - 1][numAllPasses - 1];
+
+    zeromem (delayLines, sizeof (float) * (size_t) total);
+    zerostruct (combState);
+    zerostruct (combIndex);
+    zerostruct (allPassIndex);
+    isStarting = true;
+}
+
+//==============================================================================
+void SIMDReverb::updateParameters() noexcept
+{
+    int latestVersion;
+
+    if (parameterLock.beginRead (currentVersion, latestVersion))
+    {
+        const Parameters p (parameters);
+
+        if (parameterLock.endRead (latestVersion))
+        {
+            currentVersion = latestVersion;
+
+            // these are worked out in the same way as Reverb does it
+            const float wetScaleFactor = 3.0f;
+            const float dryScaleFactor = 2.0f;
+            const float roomScaleFactor = 0.28f;
+            const float roomOffset = 0.7f;
+            const float dampScaleFactor = 0.4f;
+            const bool isFrozen = p.freezeMode >= 0.5f;
+
+            const float wet = p.wetLevel * wetScaleFactor;
+            target [wet1Value] = wet * (p.width * 0.5f + 0.5f);
+            target [wet2Value] = wet * (1.0f - p.width) * 0.5f;
+            target [dryValue] = p.dryLevel * dryScaleFactor;
+            target [gainValue] = isFrozen ? 0.0f : 0.015f;
+            target [dampValue] = isFrozen ? 0.0f : p.damping * dampScaleFactor;
+            target [feedbackValue] = isFrozen ? 1.0f : p.roomSize * roomScaleFactor + roomOffset;
+
+            rampSamplesLeft = smoothingLength;
+        }
+    }
+
+    if (isStarting || rampSamplesLeft <= 0)
+    {
+        memcpy (current, target, sizeof (current));
+        rampSamplesLeft = 0;
+        isStarting = false;
+    }
+}
+
+void SIMDReverb::advanceValues (const int numSamples, float* start, float* step) noexcept
+{
+    memcpy (start, current, sizeof (current));
+
+    if (rampSamplesLeft <= 0)
+    {
+        zeromem (step, sizeof (current));
+        return;
+    }
+
+    // the blocks are split where a ramp ends, so this never goes past the end of one
+    jassert (numSamples <= rampSamplesLeft);
+
+    for (int i = 0; i < numValues; ++i)
+        step[i] = (target[i] - current[i]) / rampSamplesLeft;
+
+    rampSamplesLeft -= numSamples;
+
+    if (rampSamplesLeft > 0)
+    {
+        for (int i = 0; i < numValues; ++i)
+            current[i] += step[i] * numSamples;
+    }
+    else
+    {
+        memcpy (current, target, sizeof (current));
+    }
+}
+
+int SIMDReverb::getNextBlockSize (const int numSamplesLeft) const noexcept
+{
+    const int num = jmin (blockSize, numSamplesLeft);
+    return rampSamplesLeft > 0 ? jmin (num, rampSamplesLeft) : num;
+}
+
+//==============================================================================
+void SIMDReverb::processStereo (float* const left, float* const right, const int numSamples) noexcept
+{
+    jassert (left != nullptr && right != nullptr);
+
+    const SIMDReverbHelpers::ScopedFlushToZero ftz;
+    updateParameters();
+
+    for (int done = 0; done < numSamples;)
+    {
+        const int num = getNextBlockSize (numSamples - done);
+        float* const l = left + done;
+        float* const r = right + done;
+
+        float start [numValues], step [numValues];
+        advanceValues (num, start, step);
+
+        int i = 0;
+
+       #if JUCE_SIMDREVERB_SSE
+        using namespace SIMDReverbHelpers;
+
+        for (; i <= num - 4; i += 4)
+            _mm_storeu_ps (input + i, _mm_mul_ps (_mm_add_ps (_mm_loadu_ps (l + i), _mm_loadu_ps (r + i)),
+                                                  getRamp (start [gainValue], step [gainValue], i)));
+       #endif
+
+        for (; i < num; ++i)
+            input[i] = (l[i] + r[i]) * (start [gainValue] + step [gainValue] * i);
+
+        // the damping and room size only change between blocks
+        processCombs (numCombLanes, num, current [feedbackValue], current [dampValue]);
+        processAllPasses (0, wetLeft, num);
+        processAllPasses (1, wetRight, num);
+
+        i = 0;
+
+       #if JUCE_SIMDREVERB_SSE
+        for (; i <= num - 4; i += 4)
+        {
+            const __m128 wet1 = getRamp (start [wet1Value], step [wet1Value], i);
+            const __m128 wet2 = getRamp (start [wet2Value], step [wet2Value], i);
+            const __m128 dry  = getRamp (start [dryValue], step [dryValue], i);
+            const __m128 outL = _mm_loadu_ps (wetLeft + i), outR = _mm_loadu_ps (wetRight + i);
+
+            _mm_storeu_ps (l + i, _mm_add_ps (_mm_add_ps (_mm_mul_ps (outL, wet1), _mm_mul_ps (outR, wet2)),
+                                              _mm_mul_ps (_mm_loadu_ps (l + i), dry)));
+            _mm_storeu_ps (r + i, _mm_add_ps (_mm_add_ps (_mm_mul_ps (outR, wet1), _mm_mul_ps (outL, wet2)),
+                                              _mm_mul_ps (_mm_loadu_ps (r + i), dry)));
+        }
+       #endif
+
+        for (; i < num; ++i)
+        {
+            const float wet1 = start [wet1Value] + step [wet1Value] * i;
+            const float wet2 = start [wet2Value] + step [wet2Value] * i;
+            const float dry  = start [dryValue] + step [dryValue] * i;
+            const float outL = wetLeft[i], outR = wetRight[i];
+
+            l[i] = outL * wet1 + outR * wet2 + l[i] * dry;
+            r[i] = outR * wet1 + outL * wet2 + r[i] * dry;
+        }
+
+        done += num;
+    }
+}
+
+void SIMDReverb::processMono (float* const samples, const int numSamples) noexcept
+{
+    jassert (samples != nullptr);
+
+    const SIMDReverbHelpers::ScopedFlushToZero ftz;
+    updateParameters();
+
+    for (int done = 0; done < numSamples;)
+    {
+        const int num = getNextBlockSize (numSamples - done);
+        float* const s = samples + done;
+
+        float start [numValues], step [numValues];
+        advanceValues (num, start, step);
+
+        int i = 0;
+
+       #if JUCE_SIMDREVERB_SSE
+        using namespace SIMDReverbHelpers;
+
+        for (; i <= num - 4; i += 4)
+            _mm_storeu_ps (input + i, _mm_mul_ps (_mm_loadu_ps (s + i), getRamp (start [gainValue], step [gainValue], i)));
+       #endif
+
+        for (; i < num; ++i)
+            input[i] = s[i] * (start [gainValue] + step [gainValue] * i);
+
+        processCombs (numCombs, num, current [feedbackValue], current [dampValue]);
+        processAllPasses (0, wetLeft, num);
+
+        // like Reverb, this mixes in the dry signal after the input gain
+        i = 0;
+
+       #if JUCE_SIMDREVERB_SSE
+        for (; i <= num - 4; i += 4)
+            _mm_storeu_ps (s + i, _mm_add_ps (_mm_mul_ps (_mm_loadu_ps (wetLeft + i), getRamp (start [wet1Value], step [wet1Value], i)),
+                                              _mm_mul_ps (_mm_loadu_ps (input + i), getRamp (start [dryValue], step [dryValue], i))));
+       #endif
+
+        for (; i < num; ++i)
+            s[i] = wetLeft[i] * (start [wet1Value] + step [wet1Value] * i)
+                     + input[i] * (start [dryValue] + step [dryValue] * i);
+
+        done += num;
+    }
+}
+
+//==============================================================================
+void SIMDReverb::processCombs (const int numLanes, const int numSamples,
+                               const float feedback, const float damp) noexcept
+{
+    // No block is longer than the shortest delay line, so everything that the combs
+    // will read in this block is already in their delay lines, and each comb can work
+    // through the block from where it's got to, without wrapping round to the start.
+    float* lines [numCombLanes];
+
+    int lane;
+    for (lane = 0; lane < numLanes; ++lane)
+        lines [lane] = delayLines + combStart [lane] + combIndex [lane];
+
+    int i = 0;
+
+   #if JUCE_SIMDREVERB_SSE
+    using namespace SIMDReverbHelpers;
+
+    const __m128 damp1 = _mm_set1_ps (damp);
+    const __m128 damp2 = _mm_set1_ps (1.0f - damp);
+    const __m128 fb = _mm_set1_ps (feedback);
+
+    // four combs to a register, two registers for the left channel and two for the right
+    __m128 last0 = _mm_loadu_ps (combState),     last1 = _mm_loadu_ps (combState + 4);
+    __m128 last2 = _mm_loadu_ps (combState + 8), last3 = _mm_loadu_ps (combState + 12);
+
+    if (numLanes == numCombLanes)
+    {
+        for (; i <= numSamples - 4; i += 4)
+        {
+            _mm_storeu_ps (wetLeft + i,  _mm_add_ps (processCombQuad (lines,      i, input + i, last0, damp1, damp2, fb),
+                                                     processCombQuad (lines + 4,  i, input + i, last1, damp1, damp2, fb)));
+            _mm_storeu_ps (wetRight + i, _mm_add_ps (processCombQuad (lines + 8,  i, input + i, last2, damp1, damp2, fb),
+                                                     processCombQuad (lines + 12, i, input + i, last3, damp1, damp2, fb)));
+        }
+    }
+    else
+    {
+        for (; i <= numSamples - 4; i += 4)
+            _mm_storeu_ps (wetLeft + i, _mm_add_ps (processCombQuad (lines,     i, input + i, last0, damp1, damp2, fb),
+                                                    processCombQuad (lines + 4, i, input + i, last1, damp1, damp2, fb)));
+    }
+
+    _mm_storeu_ps (combState, last0);     _mm_storeu_ps (combState + 4, last1);
+    _mm_storeu_ps (combState + 8, last2); _mm_storeu_ps (combState + 12, last3);
+   #endif
+
+    // whatever's left, a sample at a time
+    const float undamped = 1.0f - damp;
+
+    for (; i < numSamples; ++i)
+    {
+        float outL = 0, outR = 0;
+
+        for (lane = 0; lane < numLanes; ++lane)
+        {
+            const float output = lines [lane][i];
+            float last = (output * undamped) + (combState [lane] * damp);
+            JUCE_UNDENORMALISE (last);
+            combState [lane] = last;
+
+            float temp = input[i] + (last * feedback);
+            JUCE_UNDENORMALISE (temp);
+            lines [lane][i] = temp;
+
+            if (lane < numCombs)
+                outL += output;
+            else
+                outR += output;
+        }
+
+        wetLeft[i] = outL;
+        wetRight[i] = outR;
+    }
+
+    // anything written past the end of a line belongs at its start, and the start's copy
+    // needs to match it
+    for (lane = 0; lane < numLanes; ++lane)
+    {
+        float* const buffer = delayLines + combStart [lane];
+        const int size = combSize [lane];
+        const int end = combIndex [lane] + numSamples;
+
+        if (end > size)
+            memcpy (buffer, buffer + size, sizeof (float) * (size_t) (end - size));
+
+        if (combIndex [lane] < blockSize || end > size)
+            memcpy (buffer + size, buffer, sizeof (float) * (size_t) blockSize);
+
+        combIndex [lane] = end >= size ? end - size : end;
+    }
+}
+
+void SIMDReverb::processAllPasses (const int channel, float* const samples, const int numSamples) noexcept
+{
+    // again, the block is shorter than any of the delays, so each filter can work through it
+    // without waiting for its own output
+    for (int i = 0; i < numAllPasses; ++i)
+    {
+        float* const buffer = delayLines + allPassStart [channel][i];
+        const int index = allPassIndex [channel][i];
+        const int numBeforeWrap = jmin (numSamples, allPassSize [channel][i] - index);
+
+        SIMDReverbHelpers::processAllPass (buffer + index, samples, numBeforeWrap);
+        SIMDReverbHelpers::processAllPass (buffer, samples + numBeforeWrap, numSamples - numBeforeWrap);
+
+        allPassIndex [channel][i] = (index + numSamples) % allPassSize [channel][i];
+    }
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+#include "../../maths/juce_Random.h"
+#include "../../core/juce_Time.h"
+
+class SIMDReverbTests  : public UnitTest
+{
+public:
+    SIMDReverbTests() : UnitTest ("SIMDReverb") {}
+
+    void runTest()
+    {
+        beginTest ("Matches Reverb");
+        {
+            Random r (2468);
+            const double sampleRates[] = { 44100.0, 48000.0, 96000.0, 22050.0 };
+
+            for (int i = 0; i < numElementsInArray (sampleRates); ++i)
+            {
+                expect (testAgainstScalar (r, sampleRates[i], true) < 1.0e-5f);
+                expect (testAgainstScalar (r, sampleRates[i], false) < 1.0e-5f);
+            }
+        }
+
+        beginTest ("Freeze");
+        {
+            Random r (9753);
+            const int numSamples = 22050;
+            HeapBlock<float> left (numSamples), right (numSamples);
+
+            SIMDReverb reverb;
+            Reverb::Parameters p;
+            p.dryLevel = 0;
+            reverb.setParameters (p);
+
+            fillWithNoise (r, left, right, numSamples);
+            reverb.processStereo (left, right, numSamples);
+
+            // once frozen, the tail carries on at the same level, and new input is ignored
+            p.freezeMode = 1.0f;
+            reverb.setParameters (p);
+
+            fillWithNoise (r, left, right, numSamples);
+            reverb.processStereo (left, right, numSamples);
+            const double firstLevel = getLevel (left, right, numSamples);
+
+            for (int i = 0; i < 4; ++i)
+            {
+                fillWithNoise (r, left, right, numSamples);
+                reverb.processStereo (left, right, numSamples);
+            }
+
+            const double frozenLevel = getLevel (left, right, numSamples);
+            expect (firstLevel > 0.01);
+            expect (frozenLevel > firstLevel * 0.8 && frozenLevel < firstLevel * 1.25);
+
+            // and after it's unfrozen, it dies away
+            p.freezeMode = 0;
+            reverb.setParameters (p);
+
+            for (int i = 0; i < 10; ++i)
+            {
+                zeromem (left, sizeof (float) * (size_t) numSamples);
+                zeromem (right, sizeof (float) * (size_t) numSamples);
+                reverb.processStereo (left, right, numSamples);
+            }
+
+            expect (getLevel (left, right, numSamples) < frozenLevel * 0.01);
+        }
+
+        beginTest ("Width");
+        {
+            // at zero width both channels get the same wet signal, and the difference
+            // between them grows in proportion to the width
+            double quarterWidthDifference = 0;
+
+            for (int i = 0; i <= 4; ++i)
+            {
+                Random r (1122);
+                const int numSamples = 22050;
+                HeapBlock<float> left (numSamples), right (numSamples);
+
+                SIMDReverb reverb;
+                Reverb::Parameters p;
+                p.dryLevel = 0;
+                p.width = i / 4.0f;
+                reverb.setParameters (p);
+
+                fillWithNoise (r, left, right, numSamples);
+                reverb.processStereo (left, right, numSamples);
+
+                double difference = 0;
+
+                for (int j = 0; j < numSamples; ++j)
+                    difference += std::abs (left[j] - right[j]);
+
+                if (i == 0)
+                    expect (difference == 0);
+                else if (i == 1)
+                    quarterWidthDifference = difference;
+                else
+                    expect (std::abs (difference - quarterWidthDifference * i) < quarterWidthDifference * 0.01);
+            }
+        }
+
+        beginTest ("Smoothing");
+        {
+            // a change of width is spread over the smoothing time, and then settles on
+            // exactly what an unsmoothed reverb produces
+            Random r (4321);
+            const int numSamples = 2048;
+            HeapBlock<float> left (numSamples), right (numSamples), left2 (numSamples), right2 (numSamples);
+
+            SIMDReverb smoothed, unsmoothed;
+            smoothed.setSmoothingTime (0.01);
+            unsmoothed.setSmoothingTime (0);
+
+            Reverb::Parameters p;
+            p.dryLevel = 0;
+            p.width = 0;
+            smoothed.setParameters (p);
+            unsmoothed.setParameters (p);
+
+            fillWithNoise (r, left, right, numSamples);
+            memcpy (left2, left, sizeof (float) * (size_t) numSamples);
+            memcpy (right2, right, sizeof (float) * (size_t) numSamples);
+            smoothed.processStereo (left, right, numSamples);
+            unsmoothed.processStereo (left2, right2, numSamples);
+
+            p.width = 1.0f;
+            smoothed.setParameters (p);
+            unsmoothed.setParameters (p);
+
+            fillWithNoise (r, left, right, numSamples);
+            memcpy (left2, left, sizeof (float) * (size_t) numSamples);
+            memcpy (right2, right, sizeof (float) * (size_t) numSamples);
+            smoothed.processStereo (left, right, numSamples);
+            unsmoothed.processStereo (left2, right2, numSamples);
+
+            double smoothedDifference = 0, unsmoothedDifference = 0;
+
+            for (int i = 0; i < 64; ++i)
+            {
+                smoothedDifference += std::abs (left[i] - right[i]);
+                unsmoothedDifference += std::abs (left2[i] - right2[i]);
+            }
+
+            expect (smoothedDifference < unsmoothedDifference * 0.2);
+
+            float worst = 0;
+
+            for (int i = 1024; i < numSamples; ++i)
+                worst = jmax (worst, std::abs (left[i] - left2[i]), std::abs (right[i] - right2[i]));
+
+            expect (worst < 1.0e-6f);
+        }
+
+        beginTest ("Speed");
+        {
+            Random r (1357);
+            const int numSamples = 44100 * 10, blockSize = 512;
+            HeapBlock<float> left (numSamples), right (numSamples), left2 (numSamples), right2 (numSamples);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                left[i] = left2[i] = r.nextFloat() * 2.0f - 1.0f;
+                right[i] = right2[i] = r.nextFloat() * 2.0f - 1.0f;
+            }
+
+            Reverb scalar;
+            SIMDReverb vectorised;
+
+            double start = Time::getMillisecondCounterHiRes();
+
+            for (int i = 0; i < numSamples; i += blockSize)
+                scalar.processStereo (left + i, right + i, jmin (blockSize, numSamples - i));
+
+            const double scalarTime = Time::getMillisecondCounterHiRes() - start;
+            start = Time::getMillisecondCounterHiRes();
+
+            for (int i = 0; i < numSamples; i += blockSize)
+                vectorised.processStereo (left2 + i, right2 + i, jmin (blockSize, numSamples - i));
+
+            const double vectorisedTime = Time::getMillisecondCounterHiRes() - start;
+
+            logMessage ("10 seconds of stereo: Reverb " + String (scalarTime, 1) + "ms, SIMDReverb "
+                          + String (vectorisedTime, 1) + "ms ("
+                          + String (scalarTime / jmax (0.001, vectorisedTime), 1) + "x)");
+        }
+    }
+
+private:
+    static void fillWithNoise (Random& r, float* left, float* right, int num)
+    {
+        while (--num >= 0)
+        {
+            *left++ = r.nextFloat() * 2.0f - 1.0f;
+            *right++ = r.nextFloat() * 2.0f - 1.0f;
+        }
+    }
+
+    static double getLevel (const float* left, const float* right, const int num)
+    {
+        double sum = 0;
+
+        for (int i = 0; i < num; ++i)
+            sum += left[i] * left[i] + right[i] * right[i];
+
+        return std::sqrt (sum / (num * 2));
+    }
+
+    static Reverb::Parameters randomParameters (Random& r)
+    {
+        Reverb::Parameters p;
+        p.roomSize = r.nextFloat();
+        p.damping = r.nextFloat();
+        p.wetLevel = r.nextFloat();
+        p.dryLevel = r.nextFloat();
+        p.width = r.nextFloat();
+        p.freezeMode = r.nextInt (4) == 0 ? 1.0f : 0.0f;
+        return p;
+    }
+
+    // Runs some noise through both reverbs in blocks of random sizes, changing the
+    // parameters part of the way through, and returns the biggest difference.
+    float testAgainstScalar (Random& r, const double sampleRate, const bool isStereo)
+    {
+        Reverb scalar;
+        SIMDReverb vectorised;
+        vectorised.setSmoothingTime (0);
+
+        scalar.setSampleRate (sampleRate);
+        vectorised.setSampleRate (sampleRate);
+
+        const int numSamples = 20000;
+        HeapBlock<float> expected (numSamples * 2), actual (numSamples * 2);
+
+        for (int i = 0; i < numSamples * 2; ++i)
+            expected[i] = actual[i] = i < numSamples / 2 || (i >= numSamples && i < numSamples * 3 / 2)
+                                        ? r.nextFloat() * 2.0f - 1.0f : 0.0f;
+
+        float worst = 0;
+
+        for (int pos = 0; pos < numSamples;)
+        {
+            if (pos == 0 || r.nextInt (20) == 0)
+            {
+                const Reverb::Parameters p (randomParameters (r));
+                scalar.setParameters (p);
+                vectorised.setParameters (p);
+            }
+
+            const int num = jmin (numSamples - pos, 1 + r.nextInt (700));
+
+            if (isStereo)
+            {
+                scalar.processStereo (expected + pos, expected + numSamples + pos, num);
+                vectorised.processStereo (actual + pos, actual + numSamples + pos, num);
+            }
+            else
+            {
+                scalar.processMono (expected + pos, num);
+                vectorised.processMono (actual + pos, num);
+            }
+
+            pos += num;
+        }
+
+        for (int i = 0; i < numSamples * 2; ++i)
+            worst = jmax (worst, std::abs (expected[i] - actual[i]));
+
+        return worst;
+    }
+};
+
+static SIMDReverbTests simdReverbTests;
+
+#endif
+
+END_JUCE_NAMESPACE
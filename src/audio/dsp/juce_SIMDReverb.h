@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_SIMDREVERB_JUCEHEADER__
+#define __JUCE_SIMDREVERB_JUCEHEADER__
+
+#include "../../memory/juce_HeapBlock.h"
+#include "../../threads/juce_SeqLock.h"
+#include "juce_Reverb.h"
+
+
+//==============================================================================
+/**
+    A faster version of the Reverb class, which runs its filters in SSE registers.
+
+    This is the same FreeVerb-style design as Reverb, with the same tunings and
+    parameters, and its output matches Reverb's to within a few rounding errors. The
+    difference is in how the work is split up: it processes blocks of samples that
+    are shorter than any of its delay lines, so no sample in a block depends on
+    another one in the same block having been written to a delay line first.
+
+    Within a block, the eight comb filters of both channels, which are all fed the
+    same input, run side by side in four SSE registers, and the all-pass filters
+    each work through the whole block four samples at a time.
+
+    The parameters can be changed from any thread without blocking the one that's
+    doing the processing, and instead of jumping to new settings, the reverb glides
+    to them. The levels move smoothly from sample to sample, and the damping and
+    room size are updated once per block, which is too short a time to hear.
+
+    @see Reverb, ReverbAudioSource
+*/
+class JUCE_API  SIMDReverb
+{
+public:
+    //==============================================================================
+    /** The reverb's settings, which are the same as Reverb's. */
+    typedef Reverb::Parameters Parameters;
+
+    /** Creates a reverb with the default parameters, for a 44.1KHz sample rate. */
+    SIMDReverb();
+
+    /** Destructor. */
+    ~SIMDReverb();
+
+    //==============================================================================
+    /** Returns the parameters that the reverb was last given. */
+    const Parameters& getParameters() const noexcept       { return parameters; }
+
+    /** Applies a new set of parameters to the reverb.
+
+        This can be called from any thread. The reverb starts gliding to the new settings
+        at the start of the next block that it processes.
+    */
+    void setParameters (const Parameters& newParams) noexcept;
+
+    /** Sets how long the reverb takes to glide to new parameters.
+
+        If this is 0, new parameters are used straight away, like Reverb does. The
+        default is 50 milliseconds.
+    */
+    void setSmoothingTime (double seconds) noexcept;
+
+    //==============================================================================
+    /** Sets the sample rate that will be used for the reverb.
+
+        You must call this before the process methods, in order to tell it the correct
+        sample rate. This allocates the delay lines, so it mustn't be called while
+        another thread is processing.
+    */
+    void setSampleRate (double sampleRate);
+
+    /** Clears the reverb's buffers, and jumps straight to the latest parameters.
+
+        Like setSampleRate(), this mustn't be called while another thread is processing.
+    */
+    void reset() noexcept;
+
+    //==============================================================================
+    /** Applies the reverb to two stereo channels of audio data. */
+    void processStereo (float* left, float* right, int numSamples) noexcept;
+
+    /** Applies the reverb to a single mono channel of audio data. */
+    void processMono (float* samples, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    enum
+    {
+        numCombs = 8,
+        numAllPasses = 4,
+        numChannels = 2,
+        numCombLanes = numCombs * numChannels,
+        maxBlockSize = 256
+    };
+
+    // the values that the parameters turn into, which are smoothed while processing
+    enum
+    {
+        gainValue = 0,
+        wet1Value,
+        wet2Value,
+        dryValue,
+        feedbackValue,
+        dampValue,
+        numValues
+    };
+
+    // the parameters that setParameters() writes
+    SeqLock parameterLock;
+    Parameters parameters;
+    int currentVersion;
+
+    double sampleRate, smoothingTime;
+    int smoothingLength, rampSamplesLeft;
+    bool isStarting;
+    float current [numValues], target [numValues];
+
+    // all the delay lines, one after another in a single block of memory
+    HeapBlock<float> delayLines;
+    int combStart [numCombLanes], combSize [numCombLanes], combIndex [numCombLanes];
+    int allPassStart [numChannels][numAllPasses], allPassSize [numChannels][numAllPasses];
+    int allPassIndex [numChannels][numAllPasses];
+    float combState [numCombLanes];
+    int blockSize;
+
+    // a block's input to the combs, and the output of each channel's filters
+    HeapBlock<float> input, wetLeft, wetRight;
+
+    void updateParameters() noexcept;
+    void advanceValues (int numSamples, float* start, float* step) noexcept;
+    int getNextBlockSize (int numSamplesLeft) const noexcept;
+    void processCombs (int numLanes, int numSamples, float feedback, float damp) noexcept;
+    void processAllPasses (int channel, float* samples, int numSamples) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SIMDReverb);
+};
+
+
+#endif   // __JUCE_SIMDREVERB_JUCEHEADER__
@@ -224,6 +224,7 @@ public:
 private:
     //==============================================================================
     friend class MidiBuffer::Iterator;
+    friend class MidiEventPipeline;
     MemoryBlock data;
     int bytesUsed;
 
@@ -0,0 +1,377 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#include "../../core/juce_StandardHeader.h"
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_MidiEventPipeline.h"
+
+
+//==============================================================================
+MidiEventPipeline::MidiEventPipeline()
+    : scratchSize (0),
+      scratchUsed (0)
+{
+}
+
+MidiEventPipeline::~MidiEventPipeline()
+{
+}
+
+void MidiEventPipeline::addProcessor (MidiEventProcessor* const processor)
+{
+    jassert (processor != nullptr);
+    processors.add (processor);
+}
+
+void MidiEventPipeline::clear()
+{
+    processors.clear();
+}
+
+void MidiEventPipeline::prepare (const int maxBytesPerBlock)
+{
+    outputBuffer.ensureSize ((size_t) maxBytesPerBlock);
+
+    scratchSize = jmax (256, maxBytesPerBlock / 4);
+    scratch.malloc ((size_t) scratchSize);
+    scratchUsed = 0;
+}
+
+//==============================================================================
+void MidiEventPipeline::process (MidiBuffer& buffer, const int numSamples)
+{
+    outputBuffer.clear();
+    scratchUsed = 0;
+
+    int i;
+    for (i = 0; i < processors.size(); ++i)
+    {
+        Output output (*this, i + 1, 0);
+        processors.getUnchecked(i)->beginMidiBlock (output, numSamples);
+    }
+
+    // the processors edit the events where they lie in the incoming buffer, which is
+    // fine, because it gets swapped out afterwards anyway
+    uint8* d = buffer.getData();
+    const uint8* const end = d + buffer.bytesUsed;
+
+    while (d < end)
+    {
+        const int samplePosition = MidiBuffer::getEventTime (d);
+        const int numBytes = MidiBuffer::getEventDataSize (d);
+        uint8* const eventData = d + sizeof (int) + sizeof (uint16);
+        d = eventData + numBytes;
+
+        runFromStage (0, eventData, numBytes, samplePosition);
+    }
+
+    // each stage finishes the block in turn, so that anything the earlier stages
+    // generate still goes through the later ones in time order
+    for (i = 0; i < processors.size(); ++i)
+    {
+        Output output (*this, i + 1, numSamples);
+        processors.getUnchecked(i)->renderMidiUpTo (numSamples, output);
+    }
+
+    // copy the results back rather than swapping the buffers over, so that the
+    // space that prepare() set aside stays here for the next block
+    buffer.data.ensureSize ((size_t) outputBuffer.bytesUsed);
+    memcpy (buffer.getData(), outputBuffer.getData(), (size_t) outputBuffer.bytesUsed);
+    buffer.bytesUsed = outputBuffer.bytesUsed;
+}
+
+void MidiEventPipeline::runFromStage (const int stage, uint8* const data, const int numBytes, const int samplePosition)
+{
+    for (int i = stage; i < processors.size(); ++i)
+    {
+        MidiEventProcessor* const processor = processors.getUnchecked(i);
+        Output output (*this, i + 1, samplePosition);
+
+        processor->renderMidiUpTo (samplePosition, output);
+
+        if (! processor->processMidiEvent (data, numBytes, samplePosition, output))
+            return;
+    }
+
+    // events always come out in time order, so they can just be appended
+    const int spaceNeeded = outputBuffer.bytesUsed + numBytes + (int) (sizeof (int) + sizeof (uint16));
+
+    if ((int) outputBuffer.data.getSize() < spaceNeeded)
+    {
+        jassertfalse;   // call prepare() with a bigger size!
+        return;
+    }
+
+    uint8* d = outputBuffer.getData() + outputBuffer.bytesUsed;
+    *reinterpret_cast <int*> (d) = samplePosition;
+    d += sizeof (int);
+    *reinterpret_cast <uint16*> (d) = (uint16) numBytes;
+    d += sizeof (uint16);
+    memcpy (d, data, numBytes);
+
+    outputBuffer.bytesUsed = spaceNeeded;
+}
+
+void MidiEventPipeline::insertEvent (const int stage, const uint8* const data, const int numBytes, const int samplePosition)
+{
+    if (numBytes <= 0)
+        return;
+
+    // inserted events get a copy of their own that the later stages can edit, which
+    // is taken from a preallocated stack rather than the heap
+    if (scratchUsed + numBytes > scratchSize)
+    {
+        jassertfalse;   // call prepare() with a bigger size!
+        return;
+    }
+
+    uint8* const copy = scratch + scratchUsed;
+    memcpy (copy, data, numBytes);
+    scratchUsed += numBytes;
+
+    runFromStage (stage, copy, numBytes, samplePosition);
+
+    scratchUsed -= numBytes;
+}
+
+//==============================================================================
+MidiEventPipeline::Output::Output (MidiEventPipeline& owner_, const int nextStage_, const int samplePosition_) noexcept
+    : owner (owner_),
+      nextStage (nextStage_),
+      samplePosition (samplePosition_)
+{
+}
+
+void MidiEventPipeline::Output::insertEvent (const uint8* const data, const int numBytes)
+{
+    owner.insertEvent (nextStage, data, numBytes, samplePosition);
+}
+
+void MidiEventPipeline::Output::insertEvent (const MidiMessage& message)
+{
+    owner.insertEvent (nextStage, message.getRawData(), message.getRawDataSize(), samplePosition);
+}
+
+void MidiEventPipeline::Output::insertEventAt (const uint8* const data, const int numBytes, const int position)
+{
+    jassert (position <= samplePosition);  // events can't be put after the position being rendered to
+    owner.insertEvent (nextStage, data, numBytes, jlimit (0, samplePosition, position));
+}
+
+//==============================================================================
+void MidiEventProcessor::beginMidiBlock (MidiEventPipeline::Output&, int)
+{
+}
+
+void MidiEventProcessor::renderMidiUpTo (int, MidiEventPipeline::Output&)
+{
+}
+
+int MidiEventProcessor::getChannel (const uint8* const data) noexcept
+{
+    return (data[0] >= 0x80 && data[0] < 0xf0) ? (data[0] & 0x0f) + 1 : 0;
+}
+
+void MidiEventProcessor::setChannel (uint8* const data, const int newChannel) noexcept
+{
+    jassert (newChannel > 0 && newChannel <= 16); // valid channels are numbered 1 to 16
+
+    if (data[0] >= 0x80 && data[0] < 0xf0)
+        data[0] = (uint8) ((data[0] & 0xf0) | ((newChannel - 1) & 0x0f));
+}
+
+bool MidiEventProcessor::transposeNote (uint8* const data, const int semitones) noexcept
+{
+    const int type = data[0] & 0xf0;
+
+    if (type == 0x80 || type == 0x90 || type == 0xa0)
+    {
+        const int newNote = data[1] + semitones;
+
+        if (newNote < 0 || newNote > 127)
+            return false;
+
+        data[1] = (uint8) newNote;
+    }
+
+    return true;
+}
+
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+
+class MidiEventPipelineTests  : public UnitTest
+{
+public:
+    MidiEventPipelineTests() : UnitTest ("MidiEventPipeline") {}
+
+    // moves notes up, dropping any that go out of range
+    struct Transposer  : public MidiEventProcessor
+    {
+        Transposer (const int semitones_) : semitones (semitones_) {}
+
+        bool processMidiEvent (uint8* data, int, int, MidiEventPipeline::Output&)
+        {
+            return transposeNote (data, semitones);
+        }
+
+        const int semitones;
+    };
+
+    // puts a controller message in front of every note-on, and one at the start of the block
+    struct ControllerInserter  : public MidiEventProcessor
+    {
+        void beginMidiBlock (MidiEventPipeline::Output& output, int)
+        {
+            output.insertEvent (MidiMessage::controllerEvent (1, 7, 100));
+        }
+
+        bool processMidiEvent (uint8* data, int, int, MidiEventPipeline::Output& output)
+        {
+            if ((data[0] & 0xf0) == 0x90)
+                output.insertEvent (MidiMessage::controllerEvent (getChannel (data), 1, data[1]));
+
+            return true;
+        }
+    };
+
+    // plays a note every few samples, in between whatever else comes along
+    struct Ticker  : public MidiEventProcessor
+    {
+        Ticker() : nextTick (0) {}
+
+        void beginMidiBlock (MidiEventPipeline::Output&, int)
+        {
+            nextTick = 0;
+        }
+
+        void renderMidiUpTo (int samplePosition, MidiEventPipeline::Output& output)
+        {
+            const uint8 noteOn[] = { 0x90, 100, 100 };
+
+            for (; nextTick < samplePosition; nextTick += 4)
+                output.insertEventAt (noteOn, 3, nextTick);
+        }
+
+        bool processMidiEvent (uint8*, int, int, MidiEventPipeline::Output&)
+        {
+            return true;
+        }
+
+        int nextTick;
+    };
+
+    static const String describe (const MidiBuffer& buffer)
+    {
+        String s;
+        MidiBuffer::Iterator i (buffer);
+        MidiMessage m (0xf8);
+        int position;
+
+        while (i.getNextEvent (m, position))
+        {
+            s << position << ':';
+
+            if (m.isNoteOn())           s << "on" << m.getNoteNumber();
+            else if (m.isController())  s << "cc" << m.getControllerNumber() << '=' << m.getControllerValue();
+            else                        s << '?';
+
+            s << ' ';
+        }
+
+        return s.trimEnd();
+    }
+
+    void runTest()
+    {
+        MidiBuffer buffer;
+
+        beginTest ("Editing and dropping");
+        {
+            Transposer up (12);
+            MidiEventPipeline pipeline;
+            pipeline.addProcessor (&up);
+            pipeline.prepare();
+
+            buffer.clear();
+            buffer.addEvent (MidiMessage::noteOn (1, 60, 1.0f), 0);
+            buffer.addEvent (MidiMessage::noteOn (1, 120, 1.0f), 5);
+            buffer.addEvent (MidiMessage::noteOn (2, 64, 1.0f), 10);
+
+            pipeline.process (buffer, 16);
+            expectEquals (describe (buffer), String ("0:on72 10:on76"));
+        }
+
+        beginTest ("Inserted events");
+        {
+            ControllerInserter inserter;
+            Transposer up (1);
+            MidiEventPipeline pipeline;
+            pipeline.addProcessor (&inserter);
+            pipeline.addProcessor (&up);
+            pipeline.prepare();
+
+            buffer.clear();
+            buffer.addEvent (MidiMessage::noteOn (1, 60, 1.0f), 3);
+
+            // inserted events go in front, and carry on through the later stages
+            pipeline.process (buffer, 16);
+            expectEquals (describe (buffer), String ("0:cc7=100 3:cc1=60 3:on61"));
+
+            // and the same again, now that the buffers have been used
+            buffer.clear();
+            buffer.addEvent (MidiMessage::noteOn (1, 62, 1.0f), 8);
+            pipeline.process (buffer, 16);
+            expectEquals (describe (buffer), String ("0:cc7=100 8:cc1=62 8:on63"));
+        }
+
+        beginTest ("Rendering between events");
+        {
+            Ticker ticker;
+            Transposer up (1);
+            MidiEventPipeline pipeline;
+            pipeline.addProcessor (&ticker);
+            pipeline.addProcessor (&up);
+            pipeline.prepare();
+
+            buffer.clear();
+            buffer.addEvent (MidiMessage::noteOn (1, 60, 1.0f), 6);
+
+            // the generated notes fall either side of the incoming one, and the ones
+            // after it still come out of the later stages in order
+            pipeline.process (buffer, 16);
+            expectEquals (describe (buffer), String ("0:on101 4:on101 6:on61 8:on101 12:on101"));
+        }
+    }
+};
+
+static MidiEventPipelineTests midiEventPipelineTests;
+
+#endif
+
+END_JUCE_NAMESPACE
@@ -0,0 +1,206 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_MIDIEVENTPIPELINE_JUCEHEADER__
+#define __JUCE_MIDIEVENTPIPELINE_JUCEHEADER__
+
+#include "juce_MidiBuffer.h"
+#include "../../containers/juce_Array.h"
+#include "../../memory/juce_HeapBlock.h"
+class MidiEventProcessor;
+
+
+//==============================================================================
+/**
+    Runs a chain of MidiEventProcessors over a MidiBuffer in a single pass.
+
+    Each event is handed through the processors in turn as raw bytes, which they
+    can edit in place, drop, or add new events in front of. The survivors are
+    written straight into a second, preallocated buffer, which is copied back into
+    the original at the end - so once prepare() has been called, nothing gets
+    allocated and no MidiMessage objects are created along the way.
+
+    Because the whole chain runs in one pass, a sequence of MIDI-only processors
+    can share one of these rather than each re-writing the buffer in turn.
+
+    @see MidiEventProcessor, MidiBuffer
+*/
+class JUCE_API  MidiEventPipeline
+{
+public:
+    //==============================================================================
+    /** Creates an empty pipeline. */
+    MidiEventPipeline();
+
+    /** Destructor. */
+    ~MidiEventPipeline();
+
+    //==============================================================================
+    /** Adds a processor to the end of the chain.
+
+        The processor isn't owned by the pipeline, and the chain mustn't be changed
+        while process() is running.
+    */
+    void addProcessor (MidiEventProcessor* processor);
+
+    /** Removes all the processors. */
+    void clear();
+
+    /** Returns the number of processors in the chain. */
+    int getNumProcessors() const noexcept                   { return processors.size(); }
+
+    /** Preallocates the space that a block's events and any inserted events will need.
+
+        Call this before processing starts, e.g. from prepareToPlay(). Events that
+        don't fit into this much space are dropped.
+    */
+    void prepare (int maxBytesPerBlock = 8192);
+
+    //==============================================================================
+    /** Runs the chain over a block of events, leaving the results in the same buffer.
+
+        The buffer only has to grow if the processors leave it with more events than
+        it has room for.
+    */
+    void process (MidiBuffer& buffer, int numSamples);
+
+    //==============================================================================
+    /**
+        Passed to a MidiEventProcessor so that it can add new events.
+
+        Inserted events go in front of the event that's currently being processed
+        (or at the start of the block, from MidiEventProcessor::beginMidiBlock()), and
+        are handed on through the rest of the chain just like the original ones.
+
+        From MidiEventProcessor::renderMidiUpTo(), events can also be put at any
+        position up to the one being rendered to.
+    */
+    class JUCE_API  Output
+    {
+    public:
+        /** Adds an event in front of the current one. */
+        void insertEvent (const uint8* data, int numBytes);
+
+        /** Adds an event in front of the current one. */
+        void insertEvent (const MidiMessage& message);
+
+        /** Adds an event at a position of its own.
+
+            This is only for use from MidiEventProcessor::renderMidiUpTo(), and the
+            position mustn't be before any event that the processor has already
+            inserted or been given, nor after the position being rendered to - so
+            a processor has to add its events in time order.
+        */
+        void insertEventAt (const uint8* data, int numBytes, int samplePosition);
+
+    private:
+        friend class MidiEventPipeline;
+        Output (MidiEventPipeline& owner, int nextStage, int samplePosition) noexcept;
+
+        MidiEventPipeline& owner;
+        const int nextStage, samplePosition;
+
+        JUCE_DECLARE_NON_COPYABLE (Output);
+    };
+
+private:
+    //==============================================================================
+    friend class Output;
+    Array <MidiEventProcessor*> processors;
+    MidiBuffer outputBuffer;
+    HeapBlock <uint8> scratch;
+    int scratchSize, scratchUsed;
+
+    void runFromStage (int stage, uint8* data, int numBytes, int samplePosition);
+    void insertEvent (int stage, const uint8* data, int numBytes, int samplePosition);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiEventPipeline);
+};
+
+
+//==============================================================================
+/**
+    A MIDI-only process that works on one event at a time, so that it can be run
+    as part of a MidiEventPipeline.
+
+    If an AudioProcessor with no audio channels and no latency also inherits from this,
+    an AudioProcessorGraph will run chains of such nodes together in one pipeline, and
+    won't call their processBlock() methods at all - so they should do all their
+    per-block work here.
+
+    @see MidiEventPipeline, AudioProcessorGraph
+*/
+class JUCE_API  MidiEventProcessor
+{
+public:
+    /** Destructor. */
+    virtual ~MidiEventProcessor()  {}
+
+    /** Called once at the start of each block, before any of its events.
+
+        Any events inserted here will go at the start of the block.
+    */
+    virtual void beginMidiBlock (MidiEventPipeline::Output& output, int numSamples);
+
+    /** Called before each event is processed, and once more at the end of the block
+        with the block's length, so that a processor can generate events of its own
+        between the incoming ones.
+
+        Use Output::insertEventAt() to add events from here, at positions between the
+        last one that was rendered to and this one.
+    */
+    virtual void renderMidiUpTo (int samplePosition, MidiEventPipeline::Output& output);
+
+    /** Called for each event in the block, in time order.
+
+        The event's bytes can be changed in place, as long as its length stays the same -
+        to change the length, drop it and insert a replacement.
+
+        @returns true to keep the event, or false to drop it
+    */
+    virtual bool processMidiEvent (uint8* data, int numBytes, int samplePosition,
+                                   MidiEventPipeline::Output& output) = 0;
+
+    //==============================================================================
+    /** Returns the channel of a channel message, in the range 1 to 16, or 0 for
+        system messages.
+    */
+    static int getChannel (const uint8* data) noexcept;
+
+    /** Moves a channel message onto another channel, in the range 1 to 16.
+        System messages are left alone.
+    */
+    static void setChannel (uint8* data, int newChannel) noexcept;
+
+    /** Shifts the note number of a note-on, note-off or aftertouch message.
+
+        @returns false if the note would end up outside the MIDI range, in which case
+                 the message is left unchanged, and probably ought to be dropped
+    */
+    static bool transposeNote (uint8* data, int semitones) noexcept;
+};
+
+
+#endif   // __JUCE_MIDIEVENTPIPELINE_JUCEHEADER__
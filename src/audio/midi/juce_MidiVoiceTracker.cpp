@@ -0,0 +1,369 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#include "../../core/juce_StandardHeader.h"
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_MidiVoiceTracker.h"
+
+
+//==============================================================================
+MidiVoiceTracker::MidiVoiceTracker()
+    : numVoices (0),
+      listener (nullptr)
+{
+    for (int i = 0; i < 16; ++i)
+        channels[i].bendRange = 2.0f;
+
+    reset();
+}
+
+MidiVoiceTracker::~MidiVoiceTracker()
+{
+}
+
+void MidiVoiceTracker::reset()
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        ChannelState& c = channels[i];
+        c.bend = 0;
+        c.pitchWheel = 8192;
+        c.lastNote = -1;
+        c.numVoices = 0;
+    }
+
+    memset (voiceIndex, 0xff, sizeof (voiceIndex));
+    numVoices = 0;
+}
+
+//==============================================================================
+void MidiVoiceTracker::processEvent (const uint8* const data, const int numBytes, const double time)
+{
+    if (numBytes < 3)
+        return;
+
+    const int channel = (data[0] & 0x0f) + 1;
+
+    switch (data[0] & 0xf0)
+    {
+        case 0x90:
+            if (data[2] != 0)
+            {
+                startVoice (channel, data[1] & 0x7f, data[2], time);
+                break;
+            }
+            // (a note-on with zero velocity is a note-off)
+
+        case 0x80:
+            stopVoice (channel, data[1] & 0x7f, time);
+            break;
+
+        case 0xe0:
+            setPitchWheel (channel, (data[1] & 0x7f) | ((data[2] & 0x7f) << 7), time);
+            break;
+
+        case 0xb0:
+            if (data[1] == 120 || data[1] == 123)
+                stopAllVoices (channel, time);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void MidiVoiceTracker::processEvent (const MidiMessage& message)
+{
+    processEvent (message.getRawData(), message.getRawDataSize(), message.getTimeStamp());
+}
+
+//==============================================================================
+void MidiVoiceTracker::setPitchBendRange (const int channel, const float semitones) noexcept
+{
+    if (channel > 0 && channel <= 16)
+    {
+        ChannelState& c = channels [channel - 1];
+        c.bendRange = semitones;
+        c.bend = (c.pitchWheel - 8192) * semitones / 8192.0f;
+    }
+}
+
+void MidiVoiceTracker::setPitchBendRangeForAllChannels (const float semitones) noexcept
+{
+    for (int i = 1; i <= 16; ++i)
+        setPitchBendRange (i, semitones);
+}
+
+float MidiVoiceTracker::getPitchBendRange (const int channel) const noexcept
+{
+    return (channel > 0 && channel <= 16) ? channels [channel - 1].bendRange : 0.0f;
+}
+
+int MidiVoiceTracker::getPitchWheel (const int channel) const noexcept
+{
+    return (channel > 0 && channel <= 16) ? channels [channel - 1].pitchWheel : 8192;
+}
+
+float MidiVoiceTracker::getPitchBend (const int channel) const noexcept
+{
+    return (channel > 0 && channel <= 16) ? channels [channel - 1].bend : 0.0f;
+}
+
+int MidiVoiceTracker::getLastNote (const int channel) const noexcept
+{
+    return (channel > 0 && channel <= 16) ? channels [channel - 1].lastNote : -1;
+}
+
+//==============================================================================
+const MidiVoiceTracker::Voice& MidiVoiceTracker::getVoice (const int index) const noexcept
+{
+    jassert (isPositiveAndBelow (index, numVoices));
+    return voices [index];
+}
+
+const MidiVoiceTracker::Voice* MidiVoiceTracker::findVoice (const int channel, const int note) const noexcept
+{
+    if (channel <= 0 || channel > 16 || ! isPositiveAndBelow (note, 128))
+        return nullptr;
+
+    const int index = voiceIndex [channel - 1][note];
+    return index >= 0 ? voices + index : nullptr;
+}
+
+float MidiVoiceTracker::getBentPitch (const Voice& voice) const noexcept
+{
+    return voice.note + channels [voice.channel - 1].bend;
+}
+
+float MidiVoiceTracker::getBentPitch (const int channel, const int note) const noexcept
+{
+    return note + getPitchBend (channel);
+}
+
+//==============================================================================
+void MidiVoiceTracker::startVoice (const int channel, const int note, const int velocity, const double time)
+{
+    ChannelState& c = channels [channel - 1];
+    c.lastNote = (int16) note;
+
+    // a note that's played again without being released starts over
+    if (voiceIndex [channel - 1][note] >= 0)
+        stopVoice (channel, note, time);
+
+    if (numVoices >= maxVoices)
+        return;
+
+    Voice& v = voices [numVoices];
+    v.channel = (uint8) channel;
+    v.note = (uint8) note;
+    v.velocity = (uint8) velocity;
+    v.startTime = time;
+    v.segmentStartTime = time;
+    v.startPitch = v.lowestPitch = v.highestPitch = note + c.bend;
+
+    voiceIndex [channel - 1][note] = (int16) numVoices++;
+    ++c.numVoices;
+}
+
+void MidiVoiceTracker::stopVoice (const int channel, const int note, const double time)
+{
+    const int index = voiceIndex [channel - 1][note];
+
+    if (index < 0)
+        return;
+
+    if (listener != nullptr)
+        listener->voicePitchSegmentEnded (voices [index], getBentPitch (voices [index]), time);
+
+    voiceIndex [channel - 1][note] = -1;
+    --(channels [channel - 1].numVoices);
+
+    // fill the gap with the last voice, so that the active ones stay packed together
+    if (index != --numVoices)
+    {
+        const Voice& last = voices [numVoices];
+        voices [index] = last;
+        voiceIndex [last.channel - 1][last.note] = (int16) index;
+    }
+}
+
+void MidiVoiceTracker::stopAllVoices (const int channel, const double time)
+{
+    for (int i = numVoices; --i >= 0 && channels [channel - 1].numVoices > 0;)
+        if (voices[i].channel == channel)
+            stopVoice (channel, voices[i].note, time);
+}
+
+void MidiVoiceTracker::setPitchWheel (const int channel, const int position, const double time)
+{
+    ChannelState& c = channels [channel - 1];
+
+    if (c.pitchWheel == position)
+        return;
+
+    const float newBend = (position - 8192) * c.bendRange / 8192.0f;
+
+    // usually there's only one voice per channel, so stop looking once it's found
+    for (int i = 0, numLeft = c.numVoices; i < numVoices && numLeft > 0; ++i)
+    {
+        Voice& v = voices[i];
+
+        if (v.channel == channel)
+        {
+            --numLeft;
+
+            if (listener != nullptr)
+                listener->voicePitchSegmentEnded (v, v.note + c.bend, time);
+
+            const float newPitch = v.note + newBend;
+            v.segmentStartTime = time;
+            v.lowestPitch = jmin (v.lowestPitch, newPitch);
+            v.highestPitch = jmax (v.highestPitch, newPitch);
+        }
+    }
+
+    c.pitchWheel = (int16) position;
+    c.bend = newBend;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+
+class MidiVoiceTrackerTests  : public UnitTest
+{
+public:
+    MidiVoiceTrackerTests() : UnitTest ("MidiVoiceTracker") {}
+
+    // collects the pitch segments that the tracker reports
+    struct SegmentCollector  : public MidiVoiceTracker::Listener
+    {
+        void voicePitchSegmentEnded (const MidiVoiceTracker::Voice& voice, float pitch, double endTime)
+        {
+            s << voice.note << '@' << pitch << ':' << voice.segmentStartTime << '-' << endTime << ' ';
+        }
+
+        String s;
+    };
+
+    static void send (MidiVoiceTracker& tracker, const MidiMessage& message, double time)
+    {
+        tracker.processEvent (message.getRawData(), message.getRawDataSize(), time);
+    }
+
+    void runTest()
+    {
+        beginTest ("Notes on and off");
+        {
+            MidiVoiceTracker tracker;
+
+            send (tracker, MidiMessage::noteOn (1, 60, (uint8) 100), 1.0);
+            send (tracker, MidiMessage::noteOn (1, 64, (uint8) 90), 2.0);
+            send (tracker, MidiMessage::noteOn (2, 67, (uint8) 80), 3.0);
+            expectEquals (tracker.getNumVoices(), 3);
+            expectEquals (tracker.getLastNote (1), 64);
+
+            const MidiVoiceTracker::Voice* v = tracker.findVoice (1, 60);
+            expect (v != nullptr);
+            expectEquals ((int) v->velocity, 100);
+            expectEquals (v->getLifetime (4.0), 3.0);
+            expect (tracker.findVoice (2, 60) == nullptr);
+
+            // a note-on with no velocity ends the note, and the others stay findable
+            send (tracker, MidiMessage (0x90, 60, 0), 4.0);
+            expectEquals (tracker.getNumVoices(), 2);
+            expect (tracker.findVoice (1, 60) == nullptr);
+            expectEquals ((int) tracker.findVoice (1, 64)->velocity, 90);
+            expectEquals ((int) tracker.findVoice (2, 67)->velocity, 80);
+
+            // playing a note again restarts it rather than adding another voice
+            send (tracker, MidiMessage::noteOn (2, 67, (uint8) 50), 5.0);
+            expectEquals (tracker.getNumVoices(), 2);
+            expectEquals (tracker.findVoice (2, 67)->startTime, 5.0);
+
+            // all-notes-off only affects its own channel
+            send (tracker, MidiMessage::allNotesOff (1), 6.0);
+            expectEquals (tracker.getNumVoices(), 1);
+            expect (tracker.findVoice (2, 67) != nullptr);
+
+            send (tracker, MidiMessage::noteOff (2, 67), 7.0);
+            expectEquals (tracker.getNumVoices(), 0);
+        }
+
+        beginTest ("Bend range per channel");
+        {
+            MidiVoiceTracker tracker;
+            tracker.setPitchBendRange (2, 12.0f);
+            expectEquals (tracker.getPitchBendRange (1), 2.0f);
+            expectEquals (tracker.getPitchBendRange (2), 12.0f);
+
+            // half-way up on both channels
+            send (tracker, MidiMessage::pitchWheel (1, 12288), 0.0);
+            send (tracker, MidiMessage::pitchWheel (2, 12288), 0.0);
+            expectEquals (tracker.getPitchWheel (1), 12288);
+            expectEquals (tracker.getPitchBend (1), 1.0f);
+            expectEquals (tracker.getPitchBend (2), 6.0f);
+            expectEquals (tracker.getBentPitch (2, 60), 66.0f);
+
+            // changing the range moves the bend with it
+            tracker.setPitchBendRange (1, 24.0f);
+            expectEquals (tracker.getPitchBend (1), 12.0f);
+
+            tracker.reset();
+            expectEquals (tracker.getPitchBend (2), 0.0f);
+            expectEquals (tracker.getPitchBendRange (2), 12.0f);
+        }
+
+        beginTest ("Pitch segments");
+        {
+            MidiVoiceTracker tracker;
+            SegmentCollector collector;
+            tracker.setListener (&collector);
+
+            send (tracker, MidiMessage::noteOn (3, 60, (uint8) 100), 1.0);
+            send (tracker, MidiMessage::pitchWheel (3, 12288), 2.0);
+            send (tracker, MidiMessage::pitchWheel (3, 4096), 3.0);
+            send (tracker, MidiMessage::noteOff (3, 60), 4.0);
+
+            expectEquals (collector.s.trimEnd(), String ("60@60:1-2 60@61:2-3 60@59:3-4"));
+
+            // another channel's wheel doesn't touch the note
+            send (tracker, MidiMessage::noteOn (3, 62, (uint8) 100), 5.0);
+            send (tracker, MidiMessage::pitchWheel (4, 16383), 6.0);
+            expectEquals (tracker.findVoice (3, 62)->segmentStartTime, 5.0);
+            expectEquals (tracker.findVoice (3, 62)->highestPitch, 61.0f);
+            expectEquals (tracker.findVoice (3, 62)->lowestPitch, 61.0f);
+        }
+    }
+};
+
+static MidiVoiceTrackerTests midiVoiceTrackerTests;
+
+#endif
+
+END_JUCE_NAMESPACE
@@ -0,0 +1,189 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_MIDIVOICETRACKER_JUCEHEADER__
+#define __JUCE_MIDIVOICETRACKER_JUCEHEADER__
+
+#include "juce_MidiMessage.h"
+
+
+//==============================================================================
+/**
+    Keeps track of the notes that are playing in a stream of MIDI, and where each
+    channel's pitch-wheel has bent them to.
+
+    This is aimed at MIDI where each channel's pitch-wheel applies to its own notes,
+    e.g. from a MIDI guitar or an MPE controller, so the pitch of each voice can be
+    followed as it's bent around. Events are fed in one at a time with their times,
+    in order, and the state is all kept in fixed-size tables, so each update takes
+    constant time and nothing is allocated.
+
+    A Listener can be given the stretches of time that each voice spent at a steady
+    pitch, which is enough to draw or re-play its pitch trajectory.
+
+    @see MidiKeyboardState
+*/
+class JUCE_API  MidiVoiceTracker
+{
+public:
+    //==============================================================================
+    /** Creates a tracker with no notes playing, and a bend range of 2 semitones
+        on every channel.
+    */
+    MidiVoiceTracker();
+
+    /** Destructor. */
+    ~MidiVoiceTracker();
+
+    //==============================================================================
+    enum
+    {
+        maxVoices = 128     /**< Notes played while this many are already going are ignored. */
+    };
+
+    /** A note that's currently playing. */
+    struct Voice
+    {
+        uint8 channel;              /**< The channel, from 1 to 16. */
+        uint8 note;                 /**< The note number that was played. */
+        uint8 velocity;
+
+        double startTime;           /**< When the note started. */
+        double segmentStartTime;    /**< When the voice's pitch last changed. */
+
+        float startPitch;           /**< The bent pitch when the note started. */
+        float lowestPitch;          /**< The lowest bent pitch the note has reached so far. */
+        float highestPitch;         /**< The highest bent pitch the note has reached so far. */
+
+        /** Returns how long the note has been playing at a given time. */
+        double getLifetime (double time) const noexcept        { return time - startTime; }
+    };
+
+    //==============================================================================
+    /** Resets all the voices and pitch-wheels, but not the bend ranges. */
+    void reset();
+
+    /** Updates the state from a raw MIDI event, which happened at the given time.
+
+        Times can be in whatever units the caller likes, but they mustn't go backwards.
+    */
+    void processEvent (const uint8* data, int numBytes, double time);
+
+    /** Updates the state from a MIDI message, using its time-stamp. */
+    void processEvent (const MidiMessage& message);
+
+    //==============================================================================
+    /** Sets how far a channel's pitch-wheel bends, in semitones either way. */
+    void setPitchBendRange (int channel, float semitones) noexcept;
+
+    /** Sets the pitch-wheel range for all 16 channels. */
+    void setPitchBendRangeForAllChannels (float semitones) noexcept;
+
+    /** Returns how far a channel's pitch-wheel bends, in semitones either way. */
+    float getPitchBendRange (int channel) const noexcept;
+
+    /** Returns a channel's last pitch-wheel position, from 0 to 16383. */
+    int getPitchWheel (int channel) const noexcept;
+
+    /** Returns how far a channel's pitch-wheel is bending its notes, in semitones. */
+    float getPitchBend (int channel) const noexcept;
+
+    /** Returns the note that was most recently started on a channel, which may have
+        finished by now, or -1 if there hasn't been one.
+    */
+    int getLastNote (int channel) const noexcept;
+
+    //==============================================================================
+    /** Returns the number of voices that are playing. */
+    int getNumVoices() const noexcept                           { return numVoices; }
+
+    /** Returns one of the voices that are playing.
+
+        The order of the voices changes as they start and stop.
+    */
+    const Voice& getVoice (int index) const noexcept;
+
+    /** Returns the voice for a note, or nullptr if it isn't playing. */
+    const Voice* findVoice (int channel, int note) const noexcept;
+
+    /** Returns the pitch that a voice is bent to, in fractional semitones. */
+    float getBentPitch (const Voice& voice) const noexcept;
+
+    /** Returns the pitch that a note on a channel would be bent to, in fractional semitones. */
+    float getBentPitch (int channel, int note) const noexcept;
+
+    //==============================================================================
+    /**
+        Receives the stretches of time that voices spend at a steady pitch.
+
+        The callbacks are made from inside processEvent().
+    */
+    class JUCE_API  Listener
+    {
+    public:
+        /** Destructor. */
+        virtual ~Listener()  {}
+
+        /** Called when a voice's pitch is about to change, or the voice is about to end,
+            with the pitch it has had since the voice's segmentStartTime.
+        */
+        virtual void voicePitchSegmentEnded (const Voice& voice, float pitch, double endTime) = 0;
+    };
+
+    /** Sets a listener to receive the voices' pitch segments, or nullptr for none.
+        The listener isn't owned by the tracker.
+    */
+    void setListener (Listener* newListener) noexcept           { listener = newListener; }
+
+private:
+    //==============================================================================
+    struct ChannelState
+    {
+        float bendRange;
+        float bend;
+        int16 pitchWheel;
+        int16 lastNote;
+        int16 numVoices;
+    };
+
+    ChannelState channels [16];
+    Voice voices [maxVoices];
+    int numVoices;
+
+    // the index into voices of each channel's notes, or -1 if they're not playing
+    int16 voiceIndex [16][128];
+
+    Listener* listener;
+
+    void startVoice (int channel, int note, int velocity, double time);
+    void stopVoice (int channel, int note, double time);
+    void stopAllVoices (int channel, double time);
+    void setPitchWheel (int channel, int position, double time);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiVoiceTracker);
+};
+
+
+#endif   // __JUCE_MIDIVOICETRACKER_JUCEHEADER__
@@ -29,6 +29,7 @@ BEGIN_JUCE_NAMESPACE
 
 #include "juce_AudioProcessorGraph.h"
 #include "../../events/juce_MessageManager.h"
+#include "../midi/juce_MidiEventPipeline.h"
 
 const int AudioProcessorGraph::midiChannelIndex = 0x1000;
 
@@ -47,6 +48,8 @@ public:
                           const OwnedArray <MidiBuffer>& sharedMidiBuffers,
                           const int numSamples) = 0;
 
+    virtual void setNonRealtime (bool) {}
+
     JUCE_LEAK_DETECTOR (AudioGraphRenderingOp);
 };
 
@@ -203,6 +206,59 @@ private:
     JUCE_DECLARE_NON_COPYABLE (DelayChannelOp);
 };
 
+//==============================================================================
+class DelayMidiBufferOp : public AudioGraphRenderingOp
+{
+public:
+    DelayMidiBufferOp (const int bufferNum_, const int numSamplesDelay_, const int blockSize)
+        : bufferNum (bufferNum_),
+          numSamplesDelay (numSamplesDelay_)
+    {
+        // the queue holds everything that arrives during the delay plus one block, so
+        // give it room for that up-front rather than letting it grow on the audio thread
+        const size_t bytesNeeded = getSpaceNeeded (numSamplesDelay + 2 * jmax (1, blockSize));
+        pendingEvents.ensureSize (bytesNeeded);
+        scratch.ensureSize (bytesNeeded);
+    }
+
+    /** The number of bytes to reserve for the events that may turn up in this many samples.
+
+        This allows for a short message every few samples, which is well beyond what a MIDI
+        cable can carry, and leaves room for the half-again that MidiBuffer asks for when
+        it thinks it's about to run out.
+    */
+    static size_t getSpaceNeeded (const int numSamples) noexcept
+    {
+        const int bytesPerEvent = sizeof (int) + sizeof (uint16) + 3;
+        const int numEvents = jmax ((int) minEventsToAllowFor, numSamples / samplesPerEvent);
+
+        return (size_t) (2 * numEvents * bytesPerEvent);
+    }
+
+    enum { minEventsToAllowFor = 256, samplesPerEvent = 8 };
+
+    void perform (AudioSampleBuffer&, const OwnedArray <MidiBuffer>& sharedMidiBuffers, const int numSamples)
+    {
+        MidiBuffer& midi = *sharedMidiBuffers.getUnchecked (bufferNum);
+
+        // push the new events into the queue, then hand back everything that's now due..
+        pendingEvents.addEvents (midi, 0, -1, numSamplesDelay);
+
+        midi.clear();
+        midi.addEvents (pendingEvents, 0, numSamples, 0);
+
+        scratch.clear();
+        scratch.addEvents (pendingEvents, numSamples, -1, -numSamples);
+        pendingEvents.swapWith (scratch);
+    }
+
+private:
+    const int bufferNum, numSamplesDelay;
+    MidiBuffer pendingEvents, scratch;
+
+    JUCE_DECLARE_NON_COPYABLE (DelayMidiBufferOp);
+};
+
 
 //==============================================================================
 class ProcessBufferOp : public AudioGraphRenderingOp
@@ -234,6 +290,14 @@ public:
         processor->processBlock (buffer, *sharedMidiBuffers.getUnchecked (midiBufferToUse));
     }
 
+    void setNonRealtime (const bool isNonRealtime)
+    {
+        if (processor->isNonRealtime() != isNonRealtime)
+            processor->setNonRealtime (isNonRealtime);
+    }
+
+    int getMidiBufferToUse() const noexcept     { return midiBufferToUse; }
+
     const AudioProcessorGraph::Node::Ptr node;
     AudioProcessor* const processor;
 
@@ -246,6 +310,61 @@ private:
     JUCE_DECLARE_NON_COPYABLE (ProcessBufferOp);
 };
 
+//==============================================================================
+/** Runs a chain of MIDI-only nodes over the same MIDI buffer in a single pass,
+    instead of giving each of them a ProcessBufferOp of its own.
+*/
+class FusedMidiOp : public AudioGraphRenderingOp
+{
+public:
+    FusedMidiOp (const int midiBufferToUse_)
+        : midiBufferToUse (midiBufferToUse_)
+    {
+        pipeline.prepare();
+    }
+
+    static bool canBeFused (AudioProcessorGraph::Node* const node)
+    {
+        AudioProcessor* const p = node->getProcessor();
+
+        return p->getNumInputChannels() == 0
+                && p->getNumOutputChannels() == 0
+                && p->getLatencySamples() == 0
+                && dynamic_cast <MidiEventProcessor*> (p) != nullptr;
+    }
+
+    void addNode (const AudioProcessorGraph::Node::Ptr& node)
+    {
+        nodes.add (node);
+        pipeline.addProcessor (dynamic_cast <MidiEventProcessor*> (node->getProcessor()));
+    }
+
+    void perform (AudioSampleBuffer&, const OwnedArray <MidiBuffer>& sharedMidiBuffers, const int numSamples)
+    {
+        pipeline.process (*sharedMidiBuffers.getUnchecked (midiBufferToUse), numSamples);
+    }
+
+    void setNonRealtime (const bool isNonRealtime)
+    {
+        for (int i = nodes.size(); --i >= 0;)
+        {
+            AudioProcessor* const processor = nodes.getReference (i)->getProcessor();
+
+            if (processor->isNonRealtime() != isNonRealtime)
+                processor->setNonRealtime (isNonRealtime);
+        }
+    }
+
+    int getMidiBufferToUse() const noexcept     { return midiBufferToUse; }
+
+private:
+    Array <AudioProcessorGraph::Node::Ptr> nodes;
+    MidiEventPipeline pipeline;
+    const int midiBufferToUse;
+
+    JUCE_DECLARE_NON_COPYABLE (FusedMidiOp);
+};
+
 //==============================================================================
 /** Used to calculate the correct sequence of rendering ops needed, based on
     the best re-use of shared buffers at each stage.
@@ -280,6 +399,9 @@ public:
     int getNumBuffersNeeded() const         { return nodeIds.size(); }
     int getNumMidiBuffersNeeded() const     { return midiNodeIds.size(); }
 
+    int getInputLatencyForStep (const int index) const          { return nodeInputLatencies [index]; }
+    int getCompensationDelayForStep (const int index) const     { return nodeCompensationDelays [index]; }
+
 private:
     //==============================================================================
     AudioProcessorGraph& graph;
@@ -292,7 +414,7 @@ private:
     static bool isNodeBusy (uint32 nodeID) noexcept { return nodeID != freeNodeID && nodeID != zeroNodeID; }
 
     Array <uint32> nodeDelayIDs;
-    Array <int> nodeDelays;
+    Array <int> nodeDelays, nodeInputLatencies, nodeCompensationDelays;
     int totalLatency;
 
     int getNodeDelay (const uint32 nodeID) const          { return nodeDelays [nodeDelayIDs.indexOf (nodeID)]; }
@@ -327,6 +449,21 @@ private:
         return maxLatency;
     }
 
+    int getCompensationDelayForNode (const uint32 nodeID, const int maxLatency) const
+    {
+        int maxDelay = 0;
+
+        for (int i = graph.getNumConnections(); --i >= 0;)
+        {
+            const AudioProcessorGraph::Connection* const c = graph.getConnection (i);
+
+            if (c->destNodeId == nodeID)
+                maxDelay = jmax (maxDelay, maxLatency - getNodeDelay (c->sourceNodeId));
+        }
+
+        return maxDelay;
+    }
+
     //==============================================================================
     void createRenderingOpsForNode (AudioProcessorGraph::Node* const node,
                                     Array<void*>& renderingOps,
@@ -552,6 +689,11 @@ private:
                     renderingOps.add (new CopyMidiBufferOp (midiBufferToUse, newFreeBuffer));
                     midiBufferToUse = newFreeBuffer;
                 }
+
+                const int nodeDelay = getNodeDelay (midiSourceNodes.getUnchecked (0));
+
+                if (nodeDelay < maxLatency)
+                    renderingOps.add (new DelayMidiBufferOp (midiBufferToUse, maxLatency - nodeDelay, graph.getBlockSize()));
             }
             else
             {
@@ -578,6 +720,11 @@ private:
                     // we've found one of our input buffers that can be re-used..
                     reusableInputIndex = i;
                     midiBufferToUse = sourceBufIndex;
+
+                    const int nodeDelay = getNodeDelay (midiSourceNodes.getUnchecked (i));
+                    if (nodeDelay < maxLatency)
+                        renderingOps.add (new DelayMidiBufferOp (sourceBufIndex, maxLatency - nodeDelay, graph.getBlockSize()));
+
                     break;
                 }
             }
@@ -596,6 +743,10 @@ private:
                     renderingOps.add (new ClearMidiBufferOp (midiBufferToUse));
 
                 reusableInputIndex = 0;
+                const int nodeDelay = getNodeDelay (midiSourceNodes.getFirst());
+
+                if (nodeDelay < maxLatency)
+                    renderingOps.add (new DelayMidiBufferOp (midiBufferToUse, maxLatency - nodeDelay, graph.getBlockSize()));
             }
 
             for (int j = 0; j < midiSourceNodes.size(); ++j)
@@ -605,7 +756,31 @@ private:
                     const int srcIndex = getBufferContaining (midiSourceNodes.getUnchecked(j),
                                                               AudioProcessorGraph::midiChannelIndex);
                     if (srcIndex >= 0)
-                        renderingOps.add (new AddMidiBufferOp (srcIndex, midiBufferToUse));
+                    {
+                        const int nodeDelay = getNodeDelay (midiSourceNodes.getUnchecked (j));
+
+                        if (nodeDelay < maxLatency)
+                        {
+                            if (! isBufferNeededLater (ourRenderingIndex, AudioProcessorGraph::midiChannelIndex,
+                                                       midiSourceNodes.getUnchecked(j),
+                                                       AudioProcessorGraph::midiChannelIndex))
+                            {
+                                renderingOps.add (new DelayMidiBufferOp (srcIndex, maxLatency - nodeDelay, graph.getBlockSize()));
+                                renderingOps.add (new AddMidiBufferOp (srcIndex, midiBufferToUse));
+                            }
+                            else // buffer is reused elsewhere, can't be delayed
+                            {
+                                const int bufferToDelay = getFreeBuffer (true);
+                                renderingOps.add (new CopyMidiBufferOp (srcIndex, bufferToDelay));
+                                renderingOps.add (new DelayMidiBufferOp (bufferToDelay, maxLatency - nodeDelay, graph.getBlockSize()));
+                                renderingOps.add (new AddMidiBufferOp (bufferToDelay, midiBufferToUse));
+                            }
+                        }
+                        else
+                        {
+                            renderingOps.add (new AddMidiBufferOp (srcIndex, midiBufferToUse));
+                        }
+                    }
                 }
             }
         }
@@ -615,12 +790,54 @@ private:
                                     AudioProcessorGraph::midiChannelIndex);
 
         setNodeDelay (node->nodeId, maxLatency + node->getProcessor()->getLatencySamples());
+        nodeInputLatencies.add (maxLatency);
+        nodeCompensationDelays.add (getCompensationDelayForNode (node->nodeId, maxLatency));
 
         if (numOuts == 0)
             totalLatency = maxLatency;
 
-        renderingOps.add (new ProcessBufferOp (node, audioChannelsToUse,
-                                               totalChans, midiBufferToUse));
+        if (! fuseWithPreviousMidiNode (node, renderingOps, midiBufferToUse))
+            renderingOps.add (new ProcessBufferOp (node, audioChannelsToUse,
+                                                   totalChans, midiBufferToUse));
+    }
+
+    // If the op before this one processed a MIDI-only node in the same MIDI buffer, with
+    // nothing copied or delayed in between, the two nodes can be run as one fused op
+    bool fuseWithPreviousMidiNode (AudioProcessorGraph::Node* const node,
+                                   Array<void*>& renderingOps,
+                                   const int midiBufferToUse)
+    {
+        if (renderingOps.size() == 0 || ! FusedMidiOp::canBeFused (node))
+            return false;
+
+        AudioGraphRenderingOp* const lastOp = (AudioGraphRenderingOp*) renderingOps.getLast();
+
+        FusedMidiOp* const fusedOp = dynamic_cast <FusedMidiOp*> (lastOp);
+
+        if (fusedOp != nullptr)
+        {
+            if (fusedOp->getMidiBufferToUse() != midiBufferToUse)
+                return false;
+
+            fusedOp->addNode (node);
+            return true;
+        }
+
+        ProcessBufferOp* const processOp = dynamic_cast <ProcessBufferOp*> (lastOp);
+
+        if (processOp == nullptr
+             || processOp->getMidiBufferToUse() != midiBufferToUse
+             || ! FusedMidiOp::canBeFused (processOp->node))
+            return false;
+
+        FusedMidiOp* const newOp = new FusedMidiOp (midiBufferToUse);
+        newOp->addNode (processOp->node);
+        newOp->addNode (node);
+
+        renderingOps.removeLast();
+        delete processOp;
+        renderingOps.add (newOp);
+        return true;
     }
 
     //==============================================================================
@@ -894,7 +1111,9 @@ AudioProcessorGraph::Connection::Connection (const uint32 sourceNodeId_, const i
 AudioProcessorGraph::Node::Node (const uint32 nodeId_, AudioProcessor* const processor_) noexcept
     : nodeId (nodeId_),
       processor (processor_),
-      isPrepared (false)
+      isPrepared (false),
+      inputLatency (0),
+      compensationDelay (0)
 {
     jassert (processor_ != nullptr);
 }
@@ -1243,6 +1462,14 @@ void AudioProcessorGraph::buildRenderingSequence()
 
         numRenderingBuffersNeeded = calculator.getNumBuffersNeeded();
         numMidiBuffersNeeded = calculator.getNumMidiBuffersNeeded();
+
+        for (int i = 0; i < orderedNodes.size(); ++i)
+        {
+            Node* const node = (Node*) orderedNodes.getUnchecked(i);
+
+            node->inputLatency = calculator.getInputLatencyForStep (i);
+            node->compensationDelay = calculator.getCompensationDelayForStep (i);
+        }
     }
 
     Array<void*> oldRenderingOps (renderingOps);
@@ -1265,6 +1492,9 @@ void AudioProcessorGraph::buildRenderingSequence()
 
     for (int i = oldRenderingOps.size(); --i >= 0;)
         delete (GraphRenderingOps::AudioGraphRenderingOp*) oldRenderingOps.getUnchecked(i);
+
+    // the per-node latencies may have changed even if the graph's total didn't..
+    updateHostDisplay();
 }
 
 void AudioProcessorGraph::handleAsyncUpdate()
@@ -1310,12 +1540,15 @@ void AudioProcessorGraph::processBlock (AudioSampleBuffer& buffer, MidiBuffer& m
     currentMidiInputBuffer = &midiMessages;
     currentMidiOutputBuffer.clear();
 
+    const bool nonRealtime = isNonRealtime();
+
     int i;
     for (i = 0; i < renderingOps.size(); ++i)
     {
         GraphRenderingOps::AudioGraphRenderingOp* const op
             = (GraphRenderingOps::AudioGraphRenderingOp*) renderingOps.getUnchecked(i);
 
+        op->setNonRealtime (nonRealtime);
         op->perform (renderingBuffers, midiBuffers, numSamples);
     }
 
@@ -1522,4 +1755,164 @@ void AudioProcessorGraph::AudioGraphIOProcessor::setParentGraph (AudioProcessorG
 }
 
 
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+
+class AudioProcessorGraphTests  : public UnitTest
+{
+public:
+    AudioProcessorGraphTests() : UnitTest ("AudioProcessorGraph") {}
+
+    // a MIDI-only node that moves notes up a semitone, and remembers whether the
+    // graph ever bypassed the pipeline and called processBlock() on it
+    class Transposer  : public AudioProcessor,
+                        public MidiEventProcessor
+    {
+    public:
+        Transposer() : processBlockCalled (false)    { setPlayConfigDetails (0, 0, 0, 0); }
+
+        bool processMidiEvent (uint8* data, int, int, MidiEventPipeline::Output&)
+        {
+            return transposeNote (data, 1);
+        }
+
+        void processBlock (AudioSampleBuffer&, MidiBuffer&)     { processBlockCalled = true; }
+
+        const String getName() const                            { return "Transposer"; }
+        void prepareToPlay (double, int)                        {}
+        void releaseResources()                                 {}
+        const String getInputChannelName (int) const            { return String::empty; }
+        const String getOutputChannelName (int) const           { return String::empty; }
+        bool isInputChannelStereoPair (int) const               { return false; }
+        bool isOutputChannelStereoPair (int) const              { return false; }
+        bool acceptsMidi() const                                { return true; }
+        bool producesMidi() const                               { return true; }
+        AudioProcessorEditor* createEditor()                    { return nullptr; }
+        bool hasEditor() const                                  { return false; }
+        int getNumParameters()                                  { return 0; }
+        const String getParameterName (int)                     { return String::empty; }
+        float getParameter (int)                                { return 0; }
+        const String getParameterText (int)                     { return String::empty; }
+        void setParameter (int, float)                          {}
+        int getNumPrograms()                                    { return 0; }
+        int getCurrentProgram()                                 { return 0; }
+        void setCurrentProgram (int)                            {}
+        const String getProgramName (int)                       { return String::empty; }
+        void changeProgramName (int, const String&)             {}
+        void getStateInformation (JUCE_NAMESPACE::MemoryBlock&) {}
+        void setStateInformation (const void*, int)             {}
+
+        bool processBlockCalled;
+    };
+
+    void runTest()
+    {
+        beginTest ("MIDI delay");
+        {
+            const int delay = 100, blockSize = 64;
+
+            GraphRenderingOps::DelayMidiBufferOp op (0, delay, blockSize);
+            AudioSampleBuffer audio (1, blockSize);
+            OwnedArray <MidiBuffer> midiBuffers;
+            midiBuffers.add (new MidiBuffer());
+
+            // a note every 30 samples for a few blocks, followed by silence
+            Array<int> expectedTimes;
+            int numFound = 0;
+
+            for (int block = 0; block < 8; ++block)
+            {
+                MidiBuffer& midi = *midiBuffers.getUnchecked (0);
+                midi.clear();
+
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    const int time = block * blockSize + i;
+
+                    if (block < 4 && time % 30 == 0)
+                    {
+                        midi.addEvent (MidiMessage::noteOn (1, 60 + expectedTimes.size(), 1.0f), i);
+                        expectedTimes.add (time + delay);
+                    }
+                }
+
+                op.perform (audio, midiBuffers, blockSize);
+
+                MidiBuffer::Iterator iter (midi);
+                MidiMessage message;
+                int position;
+
+                while (iter.getNextEvent (message, position))
+                {
+                    expect (position >= 0 && position < blockSize);
+                    expect (numFound < expectedTimes.size());
+                    expectEquals (block * blockSize + position, expectedTimes [numFound]);
+                    expectEquals (message.getNoteNumber(), 60 + numFound);
+                    ++numFound;
+                }
+            }
+
+            expectEquals (numFound, expectedTimes.size());
+        }
+
+        beginTest ("MIDI delay space");
+        {
+            // the queue's reserve should cover a dense stream over the whole delay
+            expect (GraphRenderingOps::DelayMidiBufferOp::getSpaceNeeded (4096) >= (size_t) (4096 / 8) * 9);
+            expect (GraphRenderingOps::DelayMidiBufferOp::getSpaceNeeded (0) > 0);
+        }
+
+        beginTest ("Fused MIDI nodes");
+        {
+            typedef AudioProcessorGraph::AudioGraphIOProcessor AudioGraphIOProcessor;
+            AudioProcessorGraph graph;
+            Transposer* const first = new Transposer();
+            Transposer* const second = new Transposer();
+
+            const uint32 input = graph.addNode (new AudioGraphIOProcessor (AudioGraphIOProcessor::midiInputNode))->nodeId;
+            const uint32 a = graph.addNode (first)->nodeId;
+            const uint32 b = graph.addNode (second)->nodeId;
+            const uint32 output = graph.addNode (new AudioGraphIOProcessor (AudioGraphIOProcessor::midiOutputNode))->nodeId;
+
+            const int midiChannel = AudioProcessorGraph::midiChannelIndex;
+            expect (graph.addConnection (input, midiChannel, a, midiChannel));
+            expect (graph.addConnection (a, midiChannel, b, midiChannel));
+            expect (graph.addConnection (b, midiChannel, output, midiChannel));
+
+            graph.setPlayConfigDetails (0, 0, 44100.0, 64);
+            graph.prepareToPlay (44100.0, 64);
+
+            AudioSampleBuffer audio (1, 64);
+
+            for (int block = 0; block < 2; ++block)
+            {
+                MidiBuffer midi;
+                midi.addEvent (MidiMessage::noteOn (1, 60, 1.0f), 10);
+                midi.addEvent (MidiMessage::noteOn (1, 127, 1.0f), 20);
+                graph.processBlock (audio, midi);
+
+                // both nodes have had their go, and the note that went out of range is gone
+                MidiBuffer::Iterator iter (midi);
+                MidiMessage message;
+                int position;
+
+                expect (iter.getNextEvent (message, position));
+                expectEquals (position, 10);
+                expectEquals (message.getNoteNumber(), 62);
+                expect (! iter.getNextEvent (message, position));
+            }
+
+            expect (! first->processBlockCalled);
+            expect (! second->processBlockCalled);
+
+            graph.releaseResources();
+        }
+    }
+};
+
+static AudioProcessorGraphTests audioProcessorGraphTests;
+
+#endif
+
 END_JUCE_NAMESPACE
@@ -86,6 +86,20 @@ public:
         */
         NamedValueSet properties;
 
+        //==============================================================================
+        /** Returns the latency, in samples, of the signals arriving at this node's inputs.
+
+            This is the largest accumulated latency of all the paths that feed into the
+            node, as calculated when the graph last rebuilt its rendering sequence. It
+            doesn't include the latency of the node's own processor.
+        */
+        int getInputLatencySamples() const noexcept             { return inputLatency; }
+
+        /** Returns the largest delay that the graph has inserted on any of this node's
+            inputs (audio or midi) so that they all line up with its slowest input path.
+        */
+        int getCompensationDelaySamples() const noexcept        { return compensationDelay; }
+
         //==============================================================================
         /** A convenient typedef for referring to a pointer to a node object.
         */
@@ -97,6 +111,7 @@ public:
 
         const ScopedPointer<AudioProcessor> processor;
         bool isPrepared;
+        int inputLatency, compensationDelay;
 
         Node (uint32 nodeId, AudioProcessor* processor) noexcept;
 
@@ -33,6 +33,7 @@ BEGIN_JUCE_NAMESPACE
 //==============================================================================
 AudioProcessorPlayer::AudioProcessorPlayer()
     : processor (nullptr),
+      device (nullptr),
       sampleRate (0),
       blockSize (0),
       isPrepared (false),
@@ -80,12 +81,41 @@ void AudioProcessorPlayer::audioDeviceIOCallback (const float** const inputChann
                                                   float** const outputChannelData,
                                                   const int numOutputChannels,
                                                   const int numSamples)
+{
+    processAudio (inputChannelData, numInputChannels, outputChannelData, numOutputChannels, numSamples,
+                  nullptr, nullptr);
+}
+
+void AudioProcessorPlayer::audioDeviceIOCallbackWithMidi (const float** const inputChannelData,
+                                                          const int numInputChannels,
+                                                          float** const outputChannelData,
+                                                          const int numOutputChannels,
+                                                          const int numSamples,
+                                                          const MidiBuffer& incomingDeviceMidi,
+                                                          MidiBuffer& outgoingDeviceMidi)
+{
+    processAudio (inputChannelData, numInputChannels, outputChannelData, numOutputChannels, numSamples,
+                  &incomingDeviceMidi, &outgoingDeviceMidi);
+}
+
+void AudioProcessorPlayer::processAudio (const float** const inputChannelData,
+                                         const int numInputChannels,
+                                         float** const outputChannelData,
+                                         const int numOutputChannels,
+                                         const int numSamples,
+                                         const MidiBuffer* const incomingDeviceMidi,
+                                         MidiBuffer* const outgoingDeviceMidi)
 {
     // these should have been prepared by audioDeviceAboutToStart()...
     jassert (sampleRate > 0 && blockSize > 0);
 
     incomingMidi.clear();
     messageCollector.removeNextBlockOfMessages (incomingMidi, numSamples);
+
+    // the device's own events are already sample-accurate, so they go straight in
+    if (incomingDeviceMidi != nullptr)
+        incomingMidi.addEvents (*incomingDeviceMidi, 0, numSamples, 0);
+
     int i, totalNumChans = 0;
 
     if (numInputChannels > numOutputChannels)
@@ -142,15 +172,26 @@ void AudioProcessorPlayer::audioDeviceIOCallback (const float** const inputChann
         }
         else
         {
+            // when the device is freewheeling, the processor is being rendered offline
+            const bool offline = device != nullptr && device->isFreewheeling();
+
+            if (processor->isNonRealtime() != offline)
+                processor->setNonRealtime (offline);
+
             processor->processBlock (buffer, incomingMidi);
+
+            // whatever the processor leaves in the buffer is its MIDI output
+            if (outgoingDeviceMidi != nullptr)
+                outgoingDeviceMidi->addEvents (incomingMidi, 0, numSamples, 0);
         }
     }
 }
 
-void AudioProcessorPlayer::audioDeviceAboutToStart (AudioIODevice* device)
+void AudioProcessorPlayer::audioDeviceAboutToStart (AudioIODevice* newDevice)
 {
     const ScopedLock sl (lock);
 
+    device = newDevice;
     sampleRate = device->getCurrentSampleRate();
     blockSize = device->getCurrentBufferSizeSamples();
     numInputChans = device->getActiveInputChannels().countNumberOfSetBits();
@@ -177,6 +218,7 @@ void AudioProcessorPlayer::audioDeviceStopped()
     if (processor != nullptr && isPrepared)
         processor->releaseResources();
 
+    device = nullptr;
     sampleRate = 0.0;
     blockSize = 0;
     isPrepared = false;
@@ -82,6 +82,14 @@ public:
                                 int totalNumOutputChannels,
                                 int numSamples);
     /** @internal */
+    void audioDeviceIOCallbackWithMidi (const float** inputChannelData,
+                                        int totalNumInputChannels,
+                                        float** outputChannelData,
+                                        int totalNumOutputChannels,
+                                        int numSamples,
+                                        const MidiBuffer& incomingDeviceMidi,
+                                        MidiBuffer& outgoingDeviceMidi);
+    /** @internal */
     void audioDeviceAboutToStart (AudioIODevice* device);
     /** @internal */
     void audioDeviceStopped();
@@ -91,6 +99,7 @@ public:
 private:
     //==============================================================================
     AudioProcessor* processor;
+    AudioIODevice* device;
     CriticalSection lock;
     double sampleRate;
     int blockSize;
@@ -103,6 +112,10 @@ private:
     MidiBuffer incomingMidi;
     MidiMessageCollector messageCollector;
 
+    void processAudio (const float** inputChannelData, int numInputChannels,
+                       float** outputChannelData, int numOutputChannels, int numSamples,
+                       const MidiBuffer* incomingDeviceMidi, MidiBuffer* outgoingDeviceMidi);
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioProcessorPlayer);
 };
 
@@ -134,6 +134,9 @@ public:
     /** Checks whether Intel SSE2 instructions are available. */
     static bool hasSSE2() noexcept              { return getCPUFlags().hasSSE2; }
 
+    /** Checks whether Intel AVX2 instructions are available, and the OS lets them be used. */
+    static bool hasAVX2() noexcept              { return getCPUFlags().hasAVX2; }
+
     /** Checks whether AMD 3DNOW instructions are available. */
     static bool has3DNow() noexcept             { return getCPUFlags().has3DNow; }
 
@@ -165,6 +168,7 @@ private:
         bool hasMMX : 1;
         bool hasSSE : 1;
         bool hasSSE2 : 1;
+        bool hasAVX2 : 1;
         bool has3DNow : 1;
     };
 
@@ -29,12 +29,14 @@ BEGIN_JUCE_NAMESPACE
 
 #include "juce_LowLevelGraphicsSoftwareRenderer.h"
 #include "juce_EdgeTable.h"
+#include "juce_PixelSpanKernels.h"
 #include "../imaging/juce_Image.h"
 #include "../colour/juce_PixelFormats.h"
 #include "../geometry/juce_PathStrokeType.h"
 #include "../geometry/juce_Rectangle.h"
 #include "../../../core/juce_SystemStats.h"
 #include "../../../core/juce_Singleton.h"
+#include "../../../threads/juce_ScopedLock.h"
 #include "../../../utilities/juce_DeletedAtShutdown.h"
 
 #if JUCE_MSVC
@@ -50,6 +52,46 @@ BEGIN_JUCE_NAMESPACE
 namespace SoftwareRendererClasses
 {
 
+//==============================================================================
+namespace RenderingHelpers
+{
+    forcedinline int safeModulo (int n, const int divisor) noexcept
+    {
+        jassert (divisor > 0);
+        n %= divisor;
+        return (n < 0) ? (n + divisor) : n;
+    }
+
+    template <class DestPixelType, class SrcPixelType>
+    forcedinline void blendRow (DestPixelType* dest, const SrcPixelType* src, int width) noexcept
+    {
+        do
+        {
+            dest++ ->blend (*src++);
+        } while (--width > 0);
+    }
+
+    template <class DestPixelType, class SrcPixelType>
+    forcedinline void blendRow (DestPixelType* dest, const SrcPixelType* src, int width, const int alphaLevel) noexcept
+    {
+        do
+        {
+            dest++ ->blend (*src++, (uint32) alphaLevel);
+        } while (--width > 0);
+    }
+
+    // ARGB onto ARGB is by far the commonest case, so it gets the vectorised kernels
+    forcedinline void blendRow (PixelARGB* dest, const PixelARGB* src, int width) noexcept
+    {
+        PixelSpanKernels::blendSpan (dest, src, width);
+    }
+
+    forcedinline void blendRow (PixelARGB* dest, const PixelARGB* src, int width, const int alphaLevel) noexcept
+    {
+        PixelSpanKernels::blendSpan (dest, src, width, alphaLevel);
+    }
+}
+
 //==============================================================================
 template <class PixelType, bool replaceExisting = false>
 class SolidColourEdgeTableRenderer
@@ -121,7 +163,17 @@ private:
     PixelRGB filler [4];
     bool areRGBComponentsEqual;
 
-    inline void blendLine (PixelType* dest, const PixelARGB& colour, int width) const noexcept
+    forcedinline void blendLine (PixelARGB* dest, const PixelARGB& colour, int width) const noexcept
+    {
+        PixelSpanKernels::blendSolid (dest, colour, width);
+    }
+
+    forcedinline void blendLine (PixelRGB* dest, const PixelARGB& colour, int width) const noexcept
+    {
+        PixelSpanKernels::blendSolid (dest, colour, width);
+    }
+
+    inline void blendLine (PixelAlpha* dest, const PixelARGB& colour, int width) const noexcept
     {
         do
         {
@@ -371,8 +423,21 @@ public:
 
     void handleEdgeTableLine (int x, int width, const int alphaLevel) const noexcept
     {
-        PixelType* dest = linePixels + x;
+        blendLine (linePixels + x, x, width, alphaLevel);
+    }
+
+    void handleEdgeTableLineFull (int x, int width) const noexcept
+    {
+        blendLine (linePixels + x, x, width, 0xff);
+    }
 
+private:
+    const Image::BitmapData& destData;
+    PixelType* linePixels;
+
+    template <class DestPixelType>
+    void blendLine (DestPixelType* dest, int x, int width, const int alphaLevel) const noexcept
+    {
         if (alphaLevel < 0xff)
         {
             do
@@ -389,33 +454,31 @@ public:
         }
     }
 
-    void handleEdgeTableLineFull (int x, int width) const noexcept
+    void blendLine (PixelARGB* dest, int x, int width, const int alphaLevel) const noexcept
     {
-        PixelType* dest = linePixels + x;
+        // the colours are worked out a short run at a time, then blended in one go
+        PixelARGB span [64];
 
-        do
+        while (width > 0)
         {
-            (dest++)->blend (GradientType::getPixel (x++));
-        } while (--width > 0);
-    }
+            const int num = jmin (width, numElementsInArray (span));
 
-private:
-    const Image::BitmapData& destData;
-    PixelType* linePixels;
+            for (int i = 0; i < num; ++i)
+                span[i] = GradientType::getPixel (x + i);
 
-    JUCE_DECLARE_NON_COPYABLE (GradientEdgeTableRenderer);
-};
+            if (alphaLevel < 0xff)
+                RenderingHelpers::blendRow (dest, span, num, alphaLevel);
+            else
+                RenderingHelpers::blendRow (dest, span, num);
 
-//==============================================================================
-namespace RenderingHelpers
-{
-    forcedinline int safeModulo (int n, const int divisor) noexcept
-    {
-        jassert (divisor > 0);
-        n %= divisor;
-        return (n < 0) ? (n + divisor) : n;
+            dest += num;
+            x += num;
+            width -= num;
+        }
     }
-}
+
+    JUCE_DECLARE_NON_COPYABLE (GradientEdgeTableRenderer);
+};
 
 //==============================================================================
 template <class DestPixelType, class SrcPixelType, bool repeatPattern>
@@ -470,10 +533,17 @@ public:
 
         if (alphaLevel < 0xfe)
         {
-            do
+            if (repeatPattern)
             {
-                dest++ ->blend (sourceLineStart [repeatPattern ? (x++ % srcData.width) : x++], alphaLevel);
-            } while (--width > 0);
+                do
+                {
+                    dest++ ->blend (sourceLineStart [x++ % srcData.width], alphaLevel);
+                } while (--width > 0);
+            }
+            else
+            {
+                RenderingHelpers::blendRow (dest, sourceLineStart + x, width, alphaLevel);
+            }
         }
         else
         {
@@ -500,10 +570,17 @@ public:
 
         if (extraAlpha < 0xfe)
         {
-            do
+            if (repeatPattern)
             {
-                dest++ ->blend (sourceLineStart [repeatPattern ? (x++ % srcData.width) : x++], extraAlpha);
-            } while (--width > 0);
+                do
+                {
+                    dest++ ->blend (sourceLineStart [x++ % srcData.width], extraAlpha);
+                } while (--width > 0);
+            }
+            else
+            {
+                RenderingHelpers::blendRow (dest, sourceLineStart + x, width, extraAlpha);
+            }
         }
         else
         {
@@ -543,10 +620,7 @@ private:
     template <class PixelType1, class PixelType2>
     static forcedinline void copyRow (PixelType1* dest, PixelType2* src, int width) noexcept
     {
-        do
-        {
-            dest++ ->blend (*src++);
-        } while (--width > 0);
+        RenderingHelpers::blendRow (dest, src, width);
     }
 
     static forcedinline void copyRow (PixelRGB* dest, PixelRGB* src, int width) noexcept
@@ -619,19 +693,9 @@ public:
         alphaLevel >>= 8;
 
         if (alphaLevel < 0xfe)
-        {
-            do
-            {
-                dest++ ->blend (*span++, alphaLevel);
-            } while (--width > 0);
-        }
+            RenderingHelpers::blendRow (dest, span, width, alphaLevel);
         else
-        {
-            do
-            {
-                dest++ ->blend (*span++);
-            } while (--width > 0);
-        }
+            RenderingHelpers::blendRow (dest, span, width);
     }
 
     forcedinline void handleEdgeTableLineFull (const int x, int width) noexcept
@@ -2443,11 +2507,16 @@ public:
         clearSingletonInstance();
     }
 
-    juce_DeclareSingleton_SingleThreaded_Minimal (GlyphCache);
+    juce_DeclareSingleton (GlyphCache, false);
+
+    // Several renderers can be drawing at once (see LowLevelGraphicsTiledRenderer), so
+    // this has to be held while using the cache, or while asking a typeface for glyphs.
+    CriticalSection lock;
 
     //==============================================================================
     void drawGlyph (SavedState& state, const Font& font, const int glyphNumber, float x, float y)
     {
+        const ScopedLock sl (lock);
         ++accessCounter;
         int oldestCounter = std::numeric_limits<int>::max();
         CachedGlyph* oldest = nullptr;
@@ -2500,7 +2569,7 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GlyphCache);
 };
 
-juce_ImplementSingleton_SingleThreaded (LowLevelGraphicsSoftwareRenderer::GlyphCache);
+juce_ImplementSingleton (LowLevelGraphicsSoftwareRenderer::GlyphCache);
 
 
 void LowLevelGraphicsSoftwareRenderer::setFont (const Font& newFont)
@@ -2525,6 +2594,7 @@ void LowLevelGraphicsSoftwareRenderer::drawGlyph (int glyphNumber, const AffineT
     }
     else
     {
+        const ScopedLock sl (GlyphCache::getInstance()->lock);
         const float fontHeight = f.getHeight();
         currentState->drawGlyph (f, glyphNumber, AffineTransform::scale (fontHeight * f.getHorizontalScale(), fontHeight)
                                                                  .followedBy (transform));
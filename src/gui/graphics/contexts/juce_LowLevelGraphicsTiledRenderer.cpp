@@ -0,0 +1,737 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#include "../../../core/juce_StandardHeader.h"
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_LowLevelGraphicsTiledRenderer.h"
+#include "../imaging/juce_Image.h"
+#include "../../../core/juce_SystemStats.h"
+#include "../../../core/juce_Singleton.h"
+#include "../../../threads/juce_ThreadPool.h"
+#include "../../../utilities/juce_DeletedAtShutdown.h"
+
+
+//==============================================================================
+class TiledRendererThreadPool  : private DeletedAtShutdown
+{
+public:
+    // the thread that's painting renders some of the tiles itself, so it doesn't
+    // need a worker of its own
+    TiledRendererThreadPool()
+        : pool (jmax (1, SystemStats::getNumCpus() - 1))
+    {
+    }
+
+    ~TiledRendererThreadPool()
+    {
+        pool.removeAllJobs (true, 5000);
+        clearSingletonInstance();
+    }
+
+    juce_DeclareSingleton_SingleThreaded_Minimal (TiledRendererThreadPool);
+
+    ThreadPool pool;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (TiledRendererThreadPool);
+};
+
+juce_ImplementSingleton_SingleThreaded (TiledRendererThreadPool);
+
+//==============================================================================
+class LowLevelGraphicsTiledRenderer::TileJob  : public ThreadPoolJob
+{
+public:
+    TileJob (LowLevelGraphicsTiledRenderer& owner_)
+        : ThreadPoolJob ("Tile renderer"),
+          owner (owner_)
+    {
+    }
+
+    JobStatus runJob()
+    {
+        owner.renderAvailableTiles();
+        return jobHasFinished;
+    }
+
+private:
+    LowLevelGraphicsTiledRenderer& owner;
+
+    JUCE_DECLARE_NON_COPYABLE (TileJob);
+};
+
+//==============================================================================
+// Each recorded operation keeps its own copy of whatever it needs, because the
+// caller's objects will be long gone by the time it gets replayed.
+class LowLevelGraphicsTiledRenderer::Command
+{
+public:
+    Command() noexcept {}
+    virtual ~Command() {}
+
+    virtual void render (LowLevelGraphicsContext& g) const = 0;
+
+    class SetOrigin;
+    class AddTransform;
+    class ClipToRectangle;
+    class ClipToRectangleList;
+    class ExcludeClipRectangle;
+    class ClipToPath;
+    class ClipToImageAlpha;
+    class SaveState;
+    class RestoreState;
+    class BeginTransparencyLayer;
+    class EndTransparencyLayer;
+    class SetFill;
+    class SetOpacity;
+    class SetInterpolationQuality;
+    class FillRect;
+    class FillPath;
+    class DrawImage;
+    class DrawLine;
+    class DrawVerticalLine;
+    class DrawHorizontalLine;
+    class SetFont;
+    class DrawGlyph;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (Command);
+};
+
+class LowLevelGraphicsTiledRenderer::Command::SetOrigin  : public Command
+{
+public:
+    SetOrigin (const int x_, const int y_) noexcept : x (x_), y (y_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.setOrigin (x, y); }
+
+private:
+    const int x, y;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::AddTransform  : public Command
+{
+public:
+    AddTransform (const AffineTransform& transform_) noexcept : transform (transform_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.addTransform (transform); }
+
+private:
+    const AffineTransform transform;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::ClipToRectangle  : public Command
+{
+public:
+    ClipToRectangle (const Rectangle<int>& r_) noexcept : r (r_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.clipToRectangle (r); }
+
+private:
+    const Rectangle<int> r;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::ClipToRectangleList  : public Command
+{
+public:
+    ClipToRectangleList (const RectangleList& clipRegion_) : clipRegion (clipRegion_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.clipToRectangleList (clipRegion); }
+
+private:
+    const RectangleList clipRegion;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::ExcludeClipRectangle  : public Command
+{
+public:
+    ExcludeClipRectangle (const Rectangle<int>& r_) noexcept : r (r_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.excludeClipRectangle (r); }
+
+private:
+    const Rectangle<int> r;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::ClipToPath  : public Command
+{
+public:
+    ClipToPath (const Path& path_, const AffineTransform& transform_) : path (path_), transform (transform_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.clipToPath (path, transform); }
+
+private:
+    const Path path;
+    const AffineTransform transform;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::ClipToImageAlpha  : public Command
+{
+public:
+    ClipToImageAlpha (const Image& image_, const AffineTransform& transform_) : image (image_), transform (transform_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.clipToImageAlpha (image, transform); }
+
+private:
+    const Image image;
+    const AffineTransform transform;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::SaveState  : public Command
+{
+public:
+    SaveState() noexcept {}
+    void render (LowLevelGraphicsContext& g) const      { g.saveState(); }
+};
+
+class LowLevelGraphicsTiledRenderer::Command::RestoreState  : public Command
+{
+public:
+    RestoreState() noexcept {}
+    void render (LowLevelGraphicsContext& g) const      { g.restoreState(); }
+};
+
+class LowLevelGraphicsTiledRenderer::Command::BeginTransparencyLayer  : public Command
+{
+public:
+    BeginTransparencyLayer (const float opacity_) noexcept : opacity (opacity_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.beginTransparencyLayer (opacity); }
+
+private:
+    const float opacity;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::EndTransparencyLayer  : public Command
+{
+public:
+    EndTransparencyLayer() noexcept {}
+    void render (LowLevelGraphicsContext& g) const      { g.endTransparencyLayer(); }
+};
+
+class LowLevelGraphicsTiledRenderer::Command::SetFill  : public Command
+{
+public:
+    SetFill (const FillType& fillType_) : fillType (fillType_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.setFill (fillType); }
+
+private:
+    const FillType fillType;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::SetOpacity  : public Command
+{
+public:
+    SetOpacity (const float opacity_) noexcept : opacity (opacity_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.setOpacity (opacity); }
+
+private:
+    const float opacity;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::SetInterpolationQuality  : public Command
+{
+public:
+    SetInterpolationQuality (const Graphics::ResamplingQuality quality_) noexcept : quality (quality_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.setInterpolationQuality (quality); }
+
+private:
+    const Graphics::ResamplingQuality quality;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::FillRect  : public Command
+{
+public:
+    FillRect (const Rectangle<int>& r_, const bool replaceExistingContents_) noexcept
+        : r (r_), replaceExistingContents (replaceExistingContents_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.fillRect (r, replaceExistingContents); }
+
+private:
+    const Rectangle<int> r;
+    const bool replaceExistingContents;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::FillPath  : public Command
+{
+public:
+    FillPath (const Path& path_, const AffineTransform& transform_) : path (path_), transform (transform_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.fillPath (path, transform); }
+
+private:
+    const Path path;
+    const AffineTransform transform;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::DrawImage  : public Command
+{
+public:
+    DrawImage (const Image& image_, const AffineTransform& transform_, const bool fillEntireClipAsTiles_)
+        : image (image_), transform (transform_), fillEntireClipAsTiles (fillEntireClipAsTiles_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.drawImage (image, transform, fillEntireClipAsTiles); }
+
+private:
+    const Image image;
+    const AffineTransform transform;
+    const bool fillEntireClipAsTiles;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::DrawLine  : public Command
+{
+public:
+    DrawLine (const Line<float>& line_) noexcept : line (line_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.drawLine (line); }
+
+private:
+    const Line<float> line;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::DrawVerticalLine  : public Command
+{
+public:
+    DrawVerticalLine (const int x_, const float top_, const float bottom_) noexcept : x (x_), top (top_), bottom (bottom_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.drawVerticalLine (x, top, bottom); }
+
+private:
+    const int x;
+    const float top, bottom;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::DrawHorizontalLine  : public Command
+{
+public:
+    DrawHorizontalLine (const int y_, const float left_, const float right_) noexcept : y (y_), left (left_), right (right_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.drawHorizontalLine (y, left, right); }
+
+private:
+    const int y;
+    const float left, right;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::SetFont  : public Command
+{
+public:
+    SetFont (const Font& font_) : font (font_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.setFont (font); }
+
+private:
+    const Font font;
+};
+
+class LowLevelGraphicsTiledRenderer::Command::DrawGlyph  : public Command
+{
+public:
+    DrawGlyph (const int glyphNumber_, const AffineTransform& transform_) noexcept
+        : glyphNumber (glyphNumber_), transform (transform_) {}
+    void render (LowLevelGraphicsContext& g) const      { g.drawGlyph (glyphNumber, transform); }
+
+private:
+    const int glyphNumber;
+    const AffineTransform transform;
+};
+
+//==============================================================================
+LowLevelGraphicsTiledRenderer::LowLevelGraphicsTiledRenderer (const Image& image_, const int xOffset_, const int yOffset_,
+                                                              const RectangleList& initialClip, const int maxNumThreads)
+    : image (image_),
+      xOffset (xOffset_),
+      yOffset (yOffset_),
+      directRenderer (image_, xOffset_, yOffset_, initialClip),
+      numThreads (maxNumThreads > 0 ? maxNumThreads : SystemStats::getNumCpus()),
+      numTiles (1)
+{
+    const Rectangle<int> area (initialClip.getBounds().getIntersection (image_.getBounds()));
+
+    if (numThreads > 1 && area.getWidth() * area.getHeight() >= minimumAreaForTiling)
+    {
+        // a few bands per thread, so that the work still gets shared out evenly when
+        // some parts of the area are much busier than others
+        numTiles = jmax (1, jmin (numThreads * 3, area.getHeight() / (int) minimumTileHeight));
+
+        for (int i = 0; i < numTiles; ++i)
+        {
+            const int top = area.getY() + (area.getHeight() * i) / numTiles;
+            const int bottom = area.getY() + (area.getHeight() * (i + 1)) / numTiles;
+
+            RectangleList tileRegion (initialClip);
+            tileRegion.clipTo (Rectangle<int> (area.getX(), top, area.getWidth(), bottom - top));
+            tileRegions.add (tileRegion);
+        }
+    }
+}
+
+LowLevelGraphicsTiledRenderer::~LowLevelGraphicsTiledRenderer()
+{
+    if (isRenderingInTiles() && commands.size() > 0)
+    {
+        ThreadPool& pool = TiledRendererThreadPool::getInstance()->pool;
+        OwnedArray<TileJob> jobs;
+
+        for (int i = jmin (numTiles, numThreads) - 1; --i >= 0;)
+        {
+            TileJob* const job = new TileJob (*this);
+            jobs.add (job);
+            pool.addJob (job);
+        }
+
+        renderAvailableTiles();
+
+        // any jobs that haven't started yet have nothing left to do, and the
+        // others have to be finished before the image can be used
+        for (int i = jobs.size(); --i >= 0;)
+            pool.removeJob (jobs.getUnchecked (i), false, -1);
+    }
+}
+
+void LowLevelGraphicsTiledRenderer::renderAvailableTiles()
+{
+    for (;;)
+    {
+        const int tileIndex = (++nextTile) - 1;
+
+        if (tileIndex >= numTiles)
+            break;
+
+        renderTile (tileIndex);
+    }
+}
+
+void LowLevelGraphicsTiledRenderer::renderTile (const int tileIndex)
+{
+    LowLevelGraphicsSoftwareRenderer renderer (image, xOffset, yOffset, tileRegions.getReference (tileIndex));
+
+    for (int i = 0; i < commands.size(); ++i)
+        commands.getUnchecked (i)->render (renderer);
+}
+
+void LowLevelGraphicsTiledRenderer::addCommand (Command* const command)
+{
+    commands.add (command);
+}
+
+//==============================================================================
+bool LowLevelGraphicsTiledRenderer::isVectorDevice() const
+{
+    return false;
+}
+
+void LowLevelGraphicsTiledRenderer::setOrigin (int x, int y)
+{
+    if (isRenderingInTiles())
+        addCommand (new Command::SetOrigin (x, y));
+
+    directRenderer.setOrigin (x, y);
+}
+
+void LowLevelGraphicsTiledRenderer::addTransform (const AffineTransform& transform)
+{
+    if (isRenderingInTiles())
+        addCommand (new Command::AddTransform (transform));
+
+    directRenderer.addTransform (transform);
+}
+
+float LowLevelGraphicsTiledRenderer::getScaleFactor()
+{
+    return directRenderer.getScaleFactor();
+}
+
+bool LowLevelGraphicsTiledRenderer::clipToRectangle (const Rectangle<int>& r)
+{
+    if (isRenderingInTiles())
+        addCommand (new Command::ClipToRectangle (r));
+
+    return directRenderer.clipToRectangle (r);
+}
+
+bool LowLevelGraphicsTiledRenderer::clipToRectangleList (const RectangleList& clipRegion)
+{
+    if (isRenderingInTiles())
+        addCommand (new Command::ClipToRectangleList (clipRegion));
+
+    return directRenderer.clipToRectangleList (clipRegion);
+}
+
+void LowLevelGraphicsTiledRenderer::excludeClipRectangle (const Rectangle<int>& r)
+{
+    if (isRenderingInTiles())
+        addCommand (new Command::ExcludeClipRectangle (r));
+
+    directRenderer.excludeClipRectangle (r);
+}
+
+void LowLevelGraphicsTiledRenderer::clipToPath (const Path& path, const AffineTransform& transform)
+{
+    if (isRenderingInTiles())
+        addCommand (new Command::ClipToPath (path, transform));
+
+    directRenderer.clipToPath (path, transform);
+}
+
+void LowLevelGraphicsTiledRenderer::clipToImageAlpha (const Image& sourceImage, const AffineTransform& transform)
+{
+    if (isRenderingInTiles())
+        addCommand (new Command::ClipToImageAlpha (sourceImage, transform));
+
+    directRenderer.clipToImageAlpha (sourceImage, transform);
+}
+
+bool LowLevelGraphicsTiledRenderer::clipRegionIntersects (const Rectangle<int>& r)
+{
+    return directRenderer.clipRegionIntersects (r);
+}
+
+const Rectangle<int> LowLevelGraphicsTiledRenderer::getClipBounds() const
+{
+    return directRenderer.getClipBounds();
+}
+
+bool LowLevelGraphicsTiledRenderer::isClipEmpty() const
+{
+    return directRenderer.isClipEmpty();
+}
+
+//==============================================================================
+void LowLevelGraphicsTiledRenderer::saveState()
+{
+    if (isRenderingInTiles())
+        addCommand (new Command::SaveState());
+
+    directRenderer.saveState();
+}
+
+void LowLevelGraphicsTiledRenderer::restoreState()
+{
+    if (isRenderingInTiles())
+        addCommand (new Command::RestoreState());
+
+    directRenderer.restoreState();
+}
+
+void LowLevelGraphicsTiledRenderer::beginTransparencyLayer (float opacity)
+{
+    // while recording, there's no need for the direct renderer to actually create
+    // a layer - it only has to keep its state in step with the tiles' renderers
+    if (isRenderingInTiles())
+    {
+        addCommand (new Command::BeginTransparencyLayer (opacity));
+        directRenderer.saveState();
+    }
+    else
+    {
+        directRenderer.beginTransparencyLayer (opacity);
+    }
+}
+
+void LowLevelGraphicsTiledRenderer::endTransparencyLayer()
+{
+    if (isRenderingInTiles())
+    {
+        addCommand (new Command::EndTransparencyLayer());
+        directRenderer.restoreState();
+    }
+    else
+    {
+        directRenderer.endTransparencyLayer();
+    }
+}
+
+//==============================================================================
+void LowLevelGraphicsTiledRenderer::setFill (const FillType& fillType)
+{
+    if (isRenderingInTiles())
+        addCommand (new Command::SetFill (fillType));
+
+    directRenderer.setFill (fillType);
+}
+
+void LowLevelGraphicsTiledRenderer::setOpacity (float newOpacity)
+{
+    if (isRenderingInTiles())
+        addCommand (new Command::SetOpacity (newOpacity));
+
+    directRenderer.setOpacity (newOpacity);
+}
+
+void LowLevelGraphicsTiledRenderer::setInterpolationQuality (Graphics::ResamplingQuality quality)
+{
+    if (isRenderingInTiles())
+        addCommand (new Command::SetInterpolationQuality (quality));
+
+    directRenderer.setInterpolationQuality (quality);
+}
+
+//==============================================================================
+void LowLevelGraphicsTiledRenderer::fillRect (const Rectangle<int>& r, const bool replaceExistingContents)
+{
+    if (! isRenderingInTiles())
+        directRenderer.fillRect (r, replaceExistingContents);
+    else if (directRenderer.clipRegionIntersects (r))
+        addCommand (new Command::FillRect (r, replaceExistingContents));
+}
+
+void LowLevelGraphicsTiledRenderer::fillPath (const Path& path, const AffineTransform& transform)
+{
+    if (! isRenderingInTiles())
+        directRenderer.fillPath (path, transform);
+    else if (! directRenderer.isClipEmpty())
+        addCommand (new Command::FillPath (path, transform));
+}
+
+void LowLevelGraphicsTiledRenderer::drawImage (const Image& sourceImage, const AffineTransform& transform, const bool fillEntireClipAsTiles)
+{
+    if (! isRenderingInTiles())
+        directRenderer.drawImage (sourceImage, transform, fillEntireClipAsTiles);
+    else if (! directRenderer.isClipEmpty())
+        addCommand (new Command::DrawImage (sourceImage, transform, fillEntireClipAsTiles));
+}
+
+void LowLevelGraphicsTiledRenderer::drawLine (const Line <float>& line)
+{
+    if (! isRenderingInTiles())
+        directRenderer.drawLine (line);
+    else if (! directRenderer.isClipEmpty())
+        addCommand (new Command::DrawLine (line));
+}
+
+void LowLevelGraphicsTiledRenderer::drawVerticalLine (const int x, float top, float bottom)
+{
+    if (! isRenderingInTiles())
+        directRenderer.drawVerticalLine (x, top, bottom);
+    else if (! directRenderer.isClipEmpty())
+        addCommand (new Command::DrawVerticalLine (x, top, bottom));
+}
+
+void LowLevelGraphicsTiledRenderer::drawHorizontalLine (const int y, float left, float right)
+{
+    if (! isRenderingInTiles())
+        directRenderer.drawHorizontalLine (y, left, right);
+    else if (! directRenderer.isClipEmpty())
+        addCommand (new Command::DrawHorizontalLine (y, left, right));
+}
+
+//==============================================================================
+void LowLevelGraphicsTiledRenderer::setFont (const Font& newFont)
+{
+    if (isRenderingInTiles())
+        addCommand (new Command::SetFont (newFont));
+
+    directRenderer.setFont (newFont);
+}
+
+Font LowLevelGraphicsTiledRenderer::getFont()
+{
+    return directRenderer.getFont();
+}
+
+void LowLevelGraphicsTiledRenderer::drawGlyph (int glyphNumber, const AffineTransform& transform)
+{
+    if (! isRenderingInTiles())
+        directRenderer.drawGlyph (glyphNumber, transform);
+    else if (! directRenderer.isClipEmpty())
+        addCommand (new Command::DrawGlyph (glyphNumber, transform));
+}
+
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../../utilities/juce_UnitTest.h"
+
+class TiledRendererTests  : public UnitTest
+{
+public:
+    TiledRendererTests() : UnitTest ("Tiled renderer") {}
+
+    void runTest()
+    {
+        beginTest ("Tiles match the software renderer");
+
+        const Rectangle<int> area (0, 0, 600, 400);
+        Image expected (Image::ARGB, area.getWidth(), area.getHeight(), true);
+        Image tiled (Image::ARGB, area.getWidth(), area.getHeight(), true);
+
+        {
+            Graphics g (expected);
+            drawScene (g);
+        }
+
+        {
+            LowLevelGraphicsTiledRenderer renderer (tiled, 0, 0, RectangleList (area), 4);
+            expect (renderer.isRenderingInTiles());
+
+            Graphics g (&renderer);
+            drawScene (g);
+        }
+
+        const Image::BitmapData expectedData (expected, Image::BitmapData::readOnly);
+        const Image::BitmapData tiledData (tiled, Image::BitmapData::readOnly);
+        int numDifferentLines = 0;
+
+        for (int y = 0; y < area.getHeight(); ++y)
+            if (memcmp (expectedData.getLinePointer (y), tiledData.getLinePointer (y),
+                        area.getWidth() * expectedData.pixelStride) != 0)
+                ++numDifferentLines;
+
+        expectEquals (numDifferentLines, 0);
+    }
+
+private:
+    static void drawScene (Graphics& g)
+    {
+        g.fillAll (Colours::white);
+
+        g.setGradientFill (ColourGradient (Colours::red, 0.0f, 0.0f, Colours::blue, 600.0f, 400.0f, false));
+        g.fillEllipse (20.0f, 30.0f, 500.0f, 330.0f);
+
+        g.setColour (Colours::black.withAlpha (0.6f));
+        g.drawLine (0.0f, 0.0f, 600.0f, 400.0f, 3.5f);
+        g.setFont (Font (24.0f));
+        g.drawText ("Tiled rendering", 40, 170, 400, 60, Justification::centred, false);
+
+        g.beginTransparencyLayer (0.5f);
+        g.setColour (Colours::green);
+        g.fillRoundedRectangle (100.0f, 100.0f, 300.0f, 250.0f, 20.0f);
+        g.endTransparencyLayer();
+
+        g.saveState();
+        Path star;
+        star.addStar (Point<float> (300.0f, 200.0f), 7, 50.0f, 190.0f);
+        g.reduceClipRegion (star);
+        g.addTransform (AffineTransform::rotation (0.3f, 300.0f, 200.0f));
+        g.setColour (Colours::orange.withAlpha (0.7f));
+        g.fillRect (150, 50, 300, 300);
+        g.restoreState();
+
+        Image sprite (Image::ARGB, 40, 40, true);
+
+        {
+            Graphics sg (sprite);
+            sg.setColour (Colours::purple.withAlpha (0.8f));
+            sg.fillEllipse (0.0f, 0.0f, 40.0f, 40.0f);
+        }
+
+        g.drawImageTransformed (sprite, AffineTransform::scale (3.0f, 3.0f).translated (420.0f, 230.0f), false);
+    }
+};
+
+static TiledRendererTests tiledRendererTests;
+
+#endif
+
+END_JUCE_NAMESPACE
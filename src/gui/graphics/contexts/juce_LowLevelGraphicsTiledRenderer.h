@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_LOWLEVELGRAPHICSTILEDRENDERER_JUCEHEADER__
+#define __JUCE_LOWLEVELGRAPHICSTILEDRENDERER_JUCEHEADER__
+
+#include "juce_LowLevelGraphicsSoftwareRenderer.h"
+
+
+//==============================================================================
+/**
+    A software renderer that splits large areas into tiles and rasterises them on
+    several threads at once.
+
+    When the area being drawn is big enough to be worth it, the drawing operations
+    are recorded rather than carried out, and when the renderer is deleted, the area
+    is split into horizontal bands which are each drawn by replaying the recording
+    through a LowLevelGraphicsSoftwareRenderer clipped to that band. The bands are
+    shared out between a pool of worker threads and the calling thread, which waits
+    until they're all finished, so the image is complete once the destructor returns.
+
+    Smaller areas, or machines with only one CPU, are simply drawn directly.
+
+    Because the drawing happens later, any images that are drawn mustn't be changed
+    until the renderer has been deleted.
+
+    User code is not supposed to create instances of this class directly - do all your
+    rendering via the Graphics class instead.
+
+    @see LowLevelGraphicsSoftwareRenderer
+*/
+class JUCE_API  LowLevelGraphicsTiledRenderer    : public LowLevelGraphicsContext
+{
+public:
+    //==============================================================================
+    /** Creates a renderer.
+
+        The maxNumThreads parameter limits how many threads will share the work, including
+        the one that deletes the renderer. If it's less than 1, the number of CPUs is used,
+        and if only one thread can be used, the drawing is done directly.
+    */
+    LowLevelGraphicsTiledRenderer (const Image& imageToRenderOn, int xOffset, int yOffset,
+                                   const RectangleList& initialClip, int maxNumThreads = 0);
+
+    /** Destructor.
+        If the drawing was recorded, this is where it actually gets rendered.
+    */
+    ~LowLevelGraphicsTiledRenderer();
+
+    /** Returns true if the drawing is being recorded to be rendered in tiles, or false if
+        it's being drawn directly.
+    */
+    bool isRenderingInTiles() const noexcept                { return numTiles > 1; }
+
+    bool isVectorDevice() const;
+
+    //==============================================================================
+    void setOrigin (int x, int y);
+    void addTransform (const AffineTransform& transform);
+    float getScaleFactor();
+
+    bool clipToRectangle (const Rectangle<int>& r);
+    bool clipToRectangleList (const RectangleList& clipRegion);
+    void excludeClipRectangle (const Rectangle<int>& r);
+    void clipToPath (const Path& path, const AffineTransform& transform);
+    void clipToImageAlpha (const Image& sourceImage, const AffineTransform& transform);
+
+    bool clipRegionIntersects (const Rectangle<int>& r);
+    const Rectangle<int> getClipBounds() const;
+    bool isClipEmpty() const;
+
+    void saveState();
+    void restoreState();
+
+    void beginTransparencyLayer (float opacity);
+    void endTransparencyLayer();
+
+    //==============================================================================
+    void setFill (const FillType& fillType);
+    void setOpacity (float opacity);
+    void setInterpolationQuality (Graphics::ResamplingQuality quality);
+
+    //==============================================================================
+    void fillRect (const Rectangle<int>& r, bool replaceExistingContents);
+    void fillPath (const Path& path, const AffineTransform& transform);
+
+    void drawImage (const Image& sourceImage, const AffineTransform& transform, bool fillEntireClipAsTiles);
+
+    void drawLine (const Line <float>& line);
+
+    void drawVerticalLine (int x, float top, float bottom);
+    void drawHorizontalLine (int y, float left, float right);
+
+    //==============================================================================
+    void setFont (const Font& newFont);
+    Font getFont();
+    void drawGlyph (int glyphNumber, const AffineTransform& transform);
+
+    //==============================================================================
+    enum
+    {
+        minimumAreaForTiling = 256 * 256,   /**< Areas with fewer pixels than this are drawn directly. */
+        minimumTileHeight = 32              /**< The smallest band that an area will be split into. */
+    };
+
+private:
+    //==============================================================================
+    Image image;
+    const int xOffset, yOffset;
+
+    // This keeps track of the origin, clip, etc. so that they can be queried while
+    // recording, and does all the drawing when the area isn't being tiled.
+    LowLevelGraphicsSoftwareRenderer directRenderer;
+
+    class Command;
+    class TileJob;
+    friend class OwnedArray <Command>;
+    friend class TileJob;
+    OwnedArray <Command> commands;
+
+    Array <RectangleList> tileRegions;
+    int numThreads, numTiles;
+    Atomic<int> nextTile;
+
+    void addCommand (Command* command);
+    void renderAvailableTiles();
+    void renderTile (int tileIndex);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LowLevelGraphicsTiledRenderer);
+};
+
+
+
+#endif   // __JUCE_LOWLEVELGRAPHICSTILEDRENDERER_JUCEHEADER__
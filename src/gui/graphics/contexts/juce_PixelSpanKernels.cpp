@@ -0,0 +1,534 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#include "../../../core/juce_StandardHeader.h"
+
+#if JUCE_INTEL && (JUCE_64BIT || JUCE_MSVC || defined (__SSE2__))
+ #define JUCE_PIXELSPANS_SSE2 1
+ #include <emmintrin.h>
+#endif
+
+// The AVX2 kernels are compiled for that instruction set on their own, so that
+// the rest of the library can still run on older CPUs.
+#if JUCE_PIXELSPANS_SSE2 && ((JUCE_GCC && ! defined (__clang__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))) \
+                              || (JUCE_MSVC && _MSC_VER >= 1800))
+ #define JUCE_PIXELSPANS_AVX2 1
+ #include <immintrin.h>
+
+ #if JUCE_GCC
+  #define JUCE_AVX2_FUNCTION __attribute__ ((target ("avx2")))
+ #else
+  #define JUCE_AVX2_FUNCTION
+ #endif
+#endif
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_PixelSpanKernels.h"
+#include "../../../core/juce_SystemStats.h"
+
+
+//==============================================================================
+namespace PixelSpanKernelHelpers
+{
+    struct KernelTable
+    {
+        void (*blendSolidARGB) (PixelARGB*, const PixelARGB&, int);
+        void (*blendSolidRGB) (PixelRGB*, const PixelARGB&, int);
+        void (*blendSpanARGB) (PixelARGB*, const PixelARGB*, int);
+        void (*blendSpanARGBWithAlpha) (PixelARGB*, const PixelARGB*, int, int);
+    };
+
+    //==============================================================================
+    void blendSolidARGBScalar (PixelARGB* dest, const PixelARGB& colour, int width)
+    {
+        while (--width >= 0)
+            (dest++)->blend (colour);
+    }
+
+    void blendSolidRGBScalar (PixelRGB* dest, const PixelARGB& colour, int width)
+    {
+        while (--width >= 0)
+            (dest++)->blend (colour);
+    }
+
+    void blendSpanARGBScalar (PixelARGB* dest, const PixelARGB* src, int width)
+    {
+        while (--width >= 0)
+            (dest++)->blend (*src++);
+    }
+
+    void blendSpanARGBWithAlphaScalar (PixelARGB* dest, const PixelARGB* src, int width, int extraAlpha)
+    {
+        while (--width >= 0)
+            (dest++)->blend (*src++, (uint32) extraAlpha);
+    }
+
+    const KernelTable scalarKernels = { blendSolidARGBScalar, blendSolidRGBScalar,
+                                        blendSpanARGBScalar, blendSpanARGBWithAlphaScalar };
+
+    // The RGB kernels work on bytes rather than pixels, so they need the colour's
+    // bytes laid out in the same order as a run of PixelRGBs.
+    void fillRGBPattern (uint8* pattern, const int numBytes, const PixelARGB& colour) noexcept
+    {
+        PixelRGB* p = reinterpret_cast <PixelRGB*> (pattern);
+
+        for (int i = numBytes / 3; --i >= 0;)
+            (p++)->set (colour);
+    }
+
+   #if JUCE_PIXELSPANS_SSE2
+    //==============================================================================
+    // In all of these, a pixel's channels are spread out into 16-bit lanes so that
+    // they can be multiplied without overflowing, and then the scaled destination
+    // is added to the source as whole 32-bit pixels, exactly as PixelARGB::blend()
+    // does it.
+
+    forcedinline __m128i multiplyAndShiftSSE2 (const __m128i a, const __m128i b) noexcept
+    {
+        return _mm_srli_epi16 (_mm_mullo_epi16 (a, b), 8);
+    }
+
+    // returns (256 - alpha) in every lane of each pixel in a set of unpacked pixels
+    forcedinline __m128i inverseAlphasSSE2 (const __m128i pixels) noexcept
+    {
+        return _mm_sub_epi16 (_mm_set1_epi16 (0x100),
+                              _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (pixels, 0xff), 0xff));
+    }
+
+    forcedinline __m128i scaleDestSSE2 (const __m128i d, const __m128i srcLo, const __m128i srcHi) noexcept
+    {
+        const __m128i zero = _mm_setzero_si128();
+
+        return _mm_packus_epi16 (multiplyAndShiftSSE2 (_mm_unpacklo_epi8 (d, zero), inverseAlphasSSE2 (srcLo)),
+                                 multiplyAndShiftSSE2 (_mm_unpackhi_epi8 (d, zero), inverseAlphasSSE2 (srcHi)));
+    }
+
+    void blendSolidARGBSSE2 (PixelARGB* dest, const PixelARGB& colour, int width)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i src = _mm_set1_epi32 ((int) colour.getARGB());
+        const __m128i alpha = _mm_set1_epi16 ((short) (0x100 - colour.getAlpha()));
+
+        for (; width >= 4; width -= 4, dest += 4)
+        {
+            const __m128i d = _mm_loadu_si128 ((const __m128i*) dest);
+
+            const __m128i scaled = _mm_packus_epi16 (multiplyAndShiftSSE2 (_mm_unpacklo_epi8 (d, zero), alpha),
+                                                     multiplyAndShiftSSE2 (_mm_unpackhi_epi8 (d, zero), alpha));
+
+            _mm_storeu_si128 ((__m128i*) dest, _mm_add_epi32 (src, scaled));
+        }
+
+        blendSolidARGBScalar (dest, colour, width);
+    }
+
+    void blendSolidRGBSSE2 (PixelRGB* dest, const PixelARGB& colour, int width)
+    {
+        // 16 pixels fill exactly three registers
+        uint8 pattern [48];
+        fillRGBPattern (pattern, sizeof (pattern), colour);
+
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i alpha = _mm_set1_epi16 ((short) (0x100 - colour.getAlpha()));
+        const __m128i src[3] = { _mm_loadu_si128 ((const __m128i*) pattern),
+                                 _mm_loadu_si128 ((const __m128i*) (pattern + 16)),
+                                 _mm_loadu_si128 ((const __m128i*) (pattern + 32)) };
+
+        for (; width >= 16; width -= 16, dest += 16)
+        {
+            uint8* const d = reinterpret_cast <uint8*> (dest);
+
+            for (int i = 0; i < 3; ++i)
+            {
+                const __m128i v = _mm_loadu_si128 ((const __m128i*) (d + i * 16));
+
+                const __m128i scaled = _mm_packus_epi16 (multiplyAndShiftSSE2 (_mm_unpacklo_epi8 (v, zero), alpha),
+                                                         multiplyAndShiftSSE2 (_mm_unpackhi_epi8 (v, zero), alpha));
+
+                _mm_storeu_si128 ((__m128i*) (d + i * 16), _mm_add_epi8 (src[i], scaled));
+            }
+        }
+
+        blendSolidRGBScalar (dest, colour, width);
+    }
+
+    void blendSpanARGBSSE2 (PixelARGB* dest, const PixelARGB* src, int width)
+    {
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; width >= 4; width -= 4, dest += 4, src += 4)
+        {
+            const __m128i s = _mm_loadu_si128 ((const __m128i*) src);
+            const __m128i d = _mm_loadu_si128 ((const __m128i*) dest);
+
+            _mm_storeu_si128 ((__m128i*) dest,
+                              _mm_add_epi32 (s, scaleDestSSE2 (d, _mm_unpacklo_epi8 (s, zero), _mm_unpackhi_epi8 (s, zero))));
+        }
+
+        blendSpanARGBScalar (dest, src, width);
+    }
+
+    void blendSpanARGBWithAlphaSSE2 (PixelARGB* dest, const PixelARGB* src, int width, int extraAlpha)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i multiplier = _mm_set1_epi16 ((short) (extraAlpha + 1));
+
+        for (; width >= 4; width -= 4, dest += 4, src += 4)
+        {
+            const __m128i s = _mm_loadu_si128 ((const __m128i*) src);
+            const __m128i d = _mm_loadu_si128 ((const __m128i*) dest);
+
+            const __m128i srcLo = multiplyAndShiftSSE2 (_mm_unpacklo_epi8 (s, zero), multiplier);
+            const __m128i srcHi = multiplyAndShiftSSE2 (_mm_unpackhi_epi8 (s, zero), multiplier);
+
+            _mm_storeu_si128 ((__m128i*) dest,
+                              _mm_add_epi32 (_mm_packus_epi16 (srcLo, srcHi), scaleDestSSE2 (d, srcLo, srcHi)));
+        }
+
+        blendSpanARGBWithAlphaScalar (dest, src, width, extraAlpha);
+    }
+
+    const KernelTable sse2Kernels = { blendSolidARGBSSE2, blendSolidRGBSSE2,
+                                      blendSpanARGBSSE2, blendSpanARGBWithAlphaSSE2 };
+   #endif
+
+   #if JUCE_PIXELSPANS_AVX2
+    //==============================================================================
+    // The same as the SSE2 versions, but eight pixels at a time. The unpacking and
+    // packing both work within each 128-bit half, so the pixels end up back where
+    // they started.
+
+    JUCE_AVX2_FUNCTION static inline __m256i multiplyAndShiftAVX2 (const __m256i a, const __m256i b)
+    {
+        return _mm256_srli_epi16 (_mm256_mullo_epi16 (a, b), 8);
+    }
+
+    JUCE_AVX2_FUNCTION static inline __m256i inverseAlphasAVX2 (const __m256i pixels)
+    {
+        return _mm256_sub_epi16 (_mm256_set1_epi16 (0x100),
+                                 _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (pixels, 0xff), 0xff));
+    }
+
+    JUCE_AVX2_FUNCTION static inline __m256i scaleDestAVX2 (const __m256i d, const __m256i srcLo, const __m256i srcHi)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+
+        return _mm256_packus_epi16 (multiplyAndShiftAVX2 (_mm256_unpacklo_epi8 (d, zero), inverseAlphasAVX2 (srcLo)),
+                                    multiplyAndShiftAVX2 (_mm256_unpackhi_epi8 (d, zero), inverseAlphasAVX2 (srcHi)));
+    }
+
+    JUCE_AVX2_FUNCTION void blendSolidARGBAVX2 (PixelARGB* dest, const PixelARGB& colour, int width)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i src = _mm256_set1_epi32 ((int) colour.getARGB());
+        const __m256i alpha = _mm256_set1_epi16 ((short) (0x100 - colour.getAlpha()));
+
+        for (; width >= 8; width -= 8, dest += 8)
+        {
+            const __m256i d = _mm256_loadu_si256 ((const __m256i*) dest);
+
+            const __m256i scaled = _mm256_packus_epi16 (multiplyAndShiftAVX2 (_mm256_unpacklo_epi8 (d, zero), alpha),
+                                                        multiplyAndShiftAVX2 (_mm256_unpackhi_epi8 (d, zero), alpha));
+
+            _mm256_storeu_si256 ((__m256i*) dest, _mm256_add_epi32 (src, scaled));
+        }
+
+        blendSolidARGBSSE2 (dest, colour, width);
+    }
+
+    JUCE_AVX2_FUNCTION void blendSolidRGBAVX2 (PixelRGB* dest, const PixelARGB& colour, int width)
+    {
+        // 32 pixels fill exactly three registers
+        uint8 pattern [96];
+        fillRGBPattern (pattern, sizeof (pattern), colour);
+
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i alpha = _mm256_set1_epi16 ((short) (0x100 - colour.getAlpha()));
+        const __m256i src[3] = { _mm256_loadu_si256 ((const __m256i*) pattern),
+                                 _mm256_loadu_si256 ((const __m256i*) (pattern + 32)),
+                                 _mm256_loadu_si256 ((const __m256i*) (pattern + 64)) };
+
+        for (; width >= 32; width -= 32, dest += 32)
+        {
+            uint8* const d = reinterpret_cast <uint8*> (dest);
+
+            for (int i = 0; i < 3; ++i)
+            {
+                const __m256i v = _mm256_loadu_si256 ((const __m256i*) (d + i * 32));
+
+                const __m256i scaled = _mm256_packus_epi16 (multiplyAndShiftAVX2 (_mm256_unpacklo_epi8 (v, zero), alpha),
+                                                            multiplyAndShiftAVX2 (_mm256_unpackhi_epi8 (v, zero), alpha));
+
+                _mm256_storeu_si256 ((__m256i*) (d + i * 32), _mm256_add_epi8 (src[i], scaled));
+            }
+        }
+
+        blendSolidRGBSSE2 (dest, colour, width);
+    }
+
+    JUCE_AVX2_FUNCTION void blendSpanARGBAVX2 (PixelARGB* dest, const PixelARGB* src, int width)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+
+        for (; width >= 8; width -= 8, dest += 8, src += 8)
+        {
+            const __m256i s = _mm256_loadu_si256 ((const __m256i*) src);
+            const __m256i d = _mm256_loadu_si256 ((const __m256i*) dest);
+
+            _mm256_storeu_si256 ((__m256i*) dest,
+                                 _mm256_add_epi32 (s, scaleDestAVX2 (d, _mm256_unpacklo_epi8 (s, zero), _mm256_unpackhi_epi8 (s, zero))));
+        }
+
+        blendSpanARGBSSE2 (dest, src, width);
+    }
+
+    JUCE_AVX2_FUNCTION void blendSpanARGBWithAlphaAVX2 (PixelARGB* dest, const PixelARGB* src, int width, int extraAlpha)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i multiplier = _mm256_set1_epi16 ((short) (extraAlpha + 1));
+
+        for (; width >= 8; width -= 8, dest += 8, src += 8)
+        {
+            const __m256i s = _mm256_loadu_si256 ((const __m256i*) src);
+            const __m256i d = _mm256_loadu_si256 ((const __m256i*) dest);
+
+            const __m256i srcLo = multiplyAndShiftAVX2 (_mm256_unpacklo_epi8 (s, zero), multiplier);
+            const __m256i srcHi = multiplyAndShiftAVX2 (_mm256_unpackhi_epi8 (s, zero), multiplier);
+
+            _mm256_storeu_si256 ((__m256i*) dest,
+                                 _mm256_add_epi32 (_mm256_packus_epi16 (srcLo, srcHi), scaleDestAVX2 (d, srcLo, srcHi)));
+        }
+
+        blendSpanARGBWithAlphaSSE2 (dest, src, width, extraAlpha);
+    }
+
+    const KernelTable avx2Kernels = { blendSolidARGBAVX2, blendSolidRGBAVX2,
+                                      blendSpanARGBAVX2, blendSpanARGBWithAlphaAVX2 };
+   #endif
+
+    //==============================================================================
+    const KernelTable* getKernelTable (const PixelSpanKernels::InstructionSet instructionSet) noexcept
+    {
+        switch (instructionSet)
+        {
+           #if JUCE_PIXELSPANS_SSE2
+            case PixelSpanKernels::sse2:    return &sse2Kernels;
+           #endif
+           #if JUCE_PIXELSPANS_AVX2
+            case PixelSpanKernels::avx2:    return &avx2Kernels;
+           #endif
+            default:                        return &scalarKernels;
+        }
+    }
+
+    PixelSpanKernels::InstructionSet currentInstructionSet = PixelSpanKernels::scalar;
+    const KernelTable* currentKernels = nullptr;
+
+    const KernelTable& getKernels() noexcept
+    {
+        if (currentKernels == nullptr)
+        {
+            if (PixelSpanKernels::isSupported (PixelSpanKernels::avx2))
+                currentInstructionSet = PixelSpanKernels::avx2;
+            else if (PixelSpanKernels::isSupported (PixelSpanKernels::sse2))
+                currentInstructionSet = PixelSpanKernels::sse2;
+
+            currentKernels = getKernelTable (currentInstructionSet);
+        }
+
+        return *currentKernels;
+    }
+}
+
+//==============================================================================
+void PixelSpanKernels::blendSolid (PixelARGB* dest, const PixelARGB& colour, int width) noexcept
+{
+    PixelSpanKernelHelpers::getKernels().blendSolidARGB (dest, colour, width);
+}
+
+void PixelSpanKernels::blendSolid (PixelRGB* dest, const PixelARGB& colour, int width) noexcept
+{
+    PixelSpanKernelHelpers::getKernels().blendSolidRGB (dest, colour, width);
+}
+
+void PixelSpanKernels::blendSpan (PixelARGB* dest, const PixelARGB* src, int width) noexcept
+{
+    PixelSpanKernelHelpers::getKernels().blendSpanARGB (dest, src, width);
+}
+
+void PixelSpanKernels::blendSpan (PixelARGB* dest, const PixelARGB* src, int width, int extraAlpha) noexcept
+{
+    // the multiplier has to fit into 16 bits along with the colour it's scaling
+    jassert (extraAlpha >= 0 && extraAlpha < 0x100);
+
+    PixelSpanKernelHelpers::getKernels().blendSpanARGBWithAlpha (dest, src, width, extraAlpha);
+}
+
+//==============================================================================
+bool PixelSpanKernels::isSupported (const InstructionSet instructionSet) noexcept
+{
+    switch (instructionSet)
+    {
+       #if JUCE_PIXELSPANS_SSE2
+        case sse2:  return SystemStats::hasSSE2();
+       #endif
+       #if JUCE_PIXELSPANS_AVX2
+        case avx2:  return SystemStats::hasAVX2();
+       #endif
+        case scalar: return true;
+        default:    return false;
+    }
+}
+
+PixelSpanKernels::InstructionSet PixelSpanKernels::getInstructionSet() noexcept
+{
+    PixelSpanKernelHelpers::getKernels();
+    return PixelSpanKernelHelpers::currentInstructionSet;
+}
+
+bool PixelSpanKernels::setInstructionSet (const InstructionSet newInstructionSet) noexcept
+{
+    if (! isSupported (newInstructionSet))
+        return false;
+
+    PixelSpanKernelHelpers::currentInstructionSet = newInstructionSet;
+    PixelSpanKernelHelpers::currentKernels = PixelSpanKernelHelpers::getKernelTable (newInstructionSet);
+    return true;
+}
+
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../../utilities/juce_UnitTest.h"
+#include "../../../maths/juce_Random.h"
+#include "../../../memory/juce_HeapBlock.h"
+
+class PixelSpanKernelTests  : public UnitTest
+{
+public:
+    PixelSpanKernelTests() : UnitTest ("Pixel span kernels") {}
+
+    void runTest()
+    {
+        const PixelSpanKernels::InstructionSet originalSet = PixelSpanKernels::getInstructionSet();
+        const char* const names[] = { "scalar", "SSE2", "AVX2" };
+
+        for (int i = PixelSpanKernels::scalar; i <= PixelSpanKernels::avx2; ++i)
+        {
+            const PixelSpanKernels::InstructionSet set = (PixelSpanKernels::InstructionSet) i;
+
+            if (! PixelSpanKernels::setInstructionSet (set))
+            {
+                logMessage (String ("No ") + names[i] + " kernels on this machine");
+                continue;
+            }
+
+            beginTest (String ("Pixel-exact blending: ") + names[i]);
+
+            Random r (12345);
+
+            for (int j = 0; j < 300; ++j)
+                testOnce (r, r.nextInt (100), r.nextInt (8));
+        }
+
+        PixelSpanKernels::setInstructionSet (originalSet);
+    }
+
+private:
+    static PixelARGB randomPixel (Random& r)
+    {
+        // make sure that fully transparent and opaque pixels turn up often
+        const int choice = r.nextInt (4);
+        const int alpha = choice == 0 ? 0 : (choice == 1 ? 0xff : r.nextInt (256));
+
+        PixelARGB p;
+        p.setARGB ((uint8) alpha, (uint8) r.nextInt (256), (uint8) r.nextInt (256), (uint8) r.nextInt (256));
+        p.premultiply();
+        return p;
+    }
+
+    void testOnce (Random& r, const int width, const int offset)
+    {
+        // offsetting the start checks that the kernels cope with unaligned data
+        const int size = width + offset;
+        HeapBlock<PixelARGB> src (size), dest (size), expected (size);
+        HeapBlock<PixelRGB> destRGB (size), expectedRGB (size);
+
+        for (int i = 0; i < size; ++i)
+        {
+            src[i] = randomPixel (r);
+            expected[i] = dest[i] = randomPixel (r);
+            destRGB[i].set (randomPixel (r));
+            expectedRGB[i] = destRGB[i];
+        }
+
+        const PixelARGB colour (randomPixel (r));
+
+        {
+            PixelSpanKernels::blendSolid (dest + offset, colour, width);
+
+            for (int i = offset; i < size; ++i)
+                expected[i].blend (colour);
+
+            expect (memcmp (dest, expected, size * sizeof (PixelARGB)) == 0, "solid ARGB");
+        }
+
+        {
+            PixelSpanKernels::blendSolid (destRGB + offset, colour, width);
+
+            for (int i = offset; i < size; ++i)
+                expectedRGB[i].blend (colour);
+
+            expect (memcmp (destRGB, expectedRGB, size * sizeof (PixelRGB)) == 0, "solid RGB");
+        }
+
+        {
+            PixelSpanKernels::blendSpan (dest + offset, src + offset, width);
+
+            for (int i = offset; i < size; ++i)
+                expected[i].blend (src[i]);
+
+            expect (memcmp (dest, expected, size * sizeof (PixelARGB)) == 0, "span ARGB");
+        }
+
+        {
+            const int extraAlpha = r.nextInt (256);
+            PixelSpanKernels::blendSpan (dest + offset, src + offset, width, extraAlpha);
+
+            for (int i = offset; i < size; ++i)
+                expected[i].blend (src[i], (uint32) extraAlpha);
+
+            expect (memcmp (dest, expected, size * sizeof (PixelARGB)) == 0, "span ARGB with alpha");
+        }
+    }
+};
+
+static PixelSpanKernelTests pixelSpanKernelTests;
+
+#endif
+
+END_JUCE_NAMESPACE
@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_PIXELSPANKERNELS_JUCEHEADER__
+#define __JUCE_PIXELSPANKERNELS_JUCEHEADER__
+
+#include "../colour/juce_PixelFormats.h"
+
+
+//==============================================================================
+/**
+    Blends runs of pixels, using SIMD instructions where the CPU has them.
+
+    These are the inner loops of the software renderer's solid, gradient and image
+    fills. Each one gives exactly the same result as calling the equivalent
+    PixelARGB or PixelRGB blend() method on each pixel in turn, as long as the source
+    colours are premultiplied (which the renderer's always are), so the faster
+    versions can be swapped in without changing what gets drawn.
+
+    The best instruction set the machine supports is picked the first time any of
+    them is used.
+
+    @see LowLevelGraphicsSoftwareRenderer
+*/
+class JUCE_API  PixelSpanKernels
+{
+public:
+    //==============================================================================
+    /** Blends a single colour over a run of pixels. */
+    static void blendSolid (PixelARGB* dest, const PixelARGB& colour, int width) noexcept;
+
+    /** Blends a single colour over a run of pixels. */
+    static void blendSolid (PixelRGB* dest, const PixelARGB& colour, int width) noexcept;
+
+    /** Blends a run of source pixels over a run of destination pixels. */
+    static void blendSpan (PixelARGB* dest, const PixelARGB* src, int width) noexcept;
+
+    /** Blends a run of source pixels over a run of destination pixels, with their opacity
+        scaled by extraAlpha, in the same way as PixelARGB::blend (src, extraAlpha).
+    */
+    static void blendSpan (PixelARGB* dest, const PixelARGB* src, int width, int extraAlpha) noexcept;
+
+    //==============================================================================
+    /** The versions of the kernels that can be used. */
+    enum InstructionSet
+    {
+        scalar = 0,
+        sse2,
+        avx2
+    };
+
+    /** Returns true if this build and this CPU can use a particular set of kernels. */
+    static bool isSupported (InstructionSet instructionSet) noexcept;
+
+    /** Returns the set of kernels that's being used. */
+    static InstructionSet getInstructionSet() noexcept;
+
+    /** Switches to a different set of kernels, e.g. to compare them in a test.
+
+        This mustn't be called while anything is being drawn. If the set isn't
+        supported, nothing is changed and it returns false.
+    */
+    static bool setInstructionSet (InstructionSet newInstructionSet) noexcept;
+
+private:
+    PixelSpanKernels();
+    JUCE_DECLARE_NON_COPYABLE (PixelSpanKernels);
+};
+
+
+#endif   // __JUCE_PIXELSPANKERNELS_JUCEHEADER__
@@ -122,6 +122,9 @@
 #ifndef __JUCE_REVERBAUDIOSOURCE_JUCEHEADER__
  #include "audio/audio_sources/juce_ReverbAudioSource.h"
 #endif
+#ifndef __JUCE_SINCRESAMPLINGAUDIOSOURCE_JUCEHEADER__
+ #include "audio/audio_sources/juce_SincResamplingAudioSource.h"
+#endif
 #ifndef __JUCE_TONEGENERATORAUDIOSOURCE_JUCEHEADER__
  #include "audio/audio_sources/juce_ToneGeneratorAudioSource.h"
 #endif
@@ -146,12 +149,24 @@
 #ifndef __JUCE_IIRFILTER_JUCEHEADER__
  #include "audio/dsp/juce_IIRFilter.h"
 #endif
+#ifndef __JUCE_IIRFILTERBANK_JUCEHEADER__
+ #include "audio/dsp/juce_IIRFilterBank.h"
+#endif
+#ifndef __JUCE_POLYPHASERESAMPLER_JUCEHEADER__
+ #include "audio/dsp/juce_PolyphaseResampler.h"
+#endif
 #ifndef __JUCE_REVERB_JUCEHEADER__
  #include "audio/dsp/juce_Reverb.h"
 #endif
+#ifndef __JUCE_SIMDREVERB_JUCEHEADER__
+ #include "audio/dsp/juce_SIMDReverb.h"
+#endif
 #ifndef __JUCE_MIDIBUFFER_JUCEHEADER__
  #include "audio/midi/juce_MidiBuffer.h"
 #endif
+#ifndef __JUCE_MIDIEVENTPIPELINE_JUCEHEADER__
+ #include "audio/midi/juce_MidiEventPipeline.h"
+#endif
 #ifndef __JUCE_MIDIFILE_JUCEHEADER__
  #include "audio/midi/juce_MidiFile.h"
 #endif
@@ -170,6 +185,9 @@
 #ifndef __JUCE_MIDIMESSAGESEQUENCE_JUCEHEADER__
  #include "audio/midi/juce_MidiMessageSequence.h"
 #endif
+#ifndef __JUCE_MIDIVOICETRACKER_JUCEHEADER__
+ #include "audio/midi/juce_MidiVoiceTracker.h"
+#endif
 #ifndef __JUCE_MIDIOUTPUT_JUCEHEADER__
  #include "audio/midi/juce_MidiOutput.h"
 #endif
@@ -687,6 +705,12 @@
 #ifndef __JUCE_LOWLEVELGRAPHICSSOFTWARERENDERER_JUCEHEADER__
  #include "gui/graphics/contexts/juce_LowLevelGraphicsSoftwareRenderer.h"
 #endif
+#ifndef __JUCE_LOWLEVELGRAPHICSTILEDRENDERER_JUCEHEADER__
+ #include "gui/graphics/contexts/juce_LowLevelGraphicsTiledRenderer.h"
+#endif
+#ifndef __JUCE_PIXELSPANKERNELS_JUCEHEADER__
+ #include "gui/graphics/contexts/juce_PixelSpanKernels.h"
+#endif
 #ifndef __JUCE_RECTANGLEPLACEMENT_JUCEHEADER__
  #include "gui/graphics/contexts/juce_RectanglePlacement.h"
 #endif
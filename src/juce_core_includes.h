@@ -311,6 +311,9 @@
 #ifndef __JUCE_SCOPEDWRITELOCK_JUCEHEADER__
  #include "threads/juce_ScopedWriteLock.h"
 #endif
+#ifndef __JUCE_SEQLOCK_JUCEHEADER__
+ #include "threads/juce_SeqLock.h"
+#endif
 #ifndef __JUCE_SPINLOCK_JUCEHEADER__
  #include "threads/juce_SpinLock.h"
 #endif
@@ -340,6 +340,7 @@ SystemStats::CPUFlags::CPUFlags()
     hasMMX = false;
     hasSSE = false;
     hasSSE2 = false;
+    hasAVX2 = false;
     has3DNow = false;
 
     numCpus = jmax (1, sysconf (_SC_NPROCESSORS_ONLN));
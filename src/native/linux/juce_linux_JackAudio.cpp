@@ -67,7 +67,8 @@ JUCE_DECL_JACK_FUNCTION (jack_nframes_t, jack_get_buffer_size, (jack_client_t* c
 JUCE_DECL_JACK_FUNCTION (jack_nframes_t, jack_get_sample_rate, (jack_client_t* client), (client));
 JUCE_DECL_VOID_JACK_FUNCTION (jack_on_shutdown, (jack_client_t* client, void (*function)(void* arg), void* arg), (client, function, arg));
 JUCE_DECL_JACK_FUNCTION (void* , jack_port_get_buffer, (jack_port_t* port, jack_nframes_t nframes), (port, nframes));
-JUCE_DECL_JACK_FUNCTION (jack_nframes_t, jack_port_get_total_latency, (jack_client_t* client, jack_port_t* port), (client, port));
+JUCE_DECL_VOID_JACK_FUNCTION (jack_port_get_latency_range, (jack_port_t* port, jack_latency_callback_mode_t mode, jack_latency_range_t* range), (port, mode, range));
+JUCE_DECL_JACK_FUNCTION (int, jack_set_latency_callback, (jack_client_t* client, JackLatencyCallback latency_callback, void* arg), (client, latency_callback, arg));
 JUCE_DECL_JACK_FUNCTION (jack_port_t* , jack_port_register, (jack_client_t* client, const char* port_name, const char* port_type, unsigned long flags, unsigned long buffer_size), (client, port_name, port_type, flags, buffer_size));
 JUCE_DECL_VOID_JACK_FUNCTION (jack_set_error_function, (void (*func)(const char*)), (func));
 JUCE_DECL_JACK_FUNCTION (int, jack_set_process_callback, (jack_client_t* client, JackProcessCallback process_callback, void* arg), (client, process_callback, arg));
@@ -78,6 +79,12 @@ JUCE_DECL_JACK_FUNCTION (int, jack_set_port_connect_callback, (jack_client_t* cl
 JUCE_DECL_JACK_FUNCTION (jack_port_t* , jack_port_by_id, (jack_client_t* client, jack_port_id_t port_id), (client, port_id));
 JUCE_DECL_JACK_FUNCTION (int, jack_port_connected, (const jack_port_t* port), (port));
 JUCE_DECL_JACK_FUNCTION (int, jack_port_connected_to, (const jack_port_t* port, const char* port_name), (port, port_name));
+JUCE_DECL_JACK_FUNCTION (jack_nframes_t, jack_midi_get_event_count, (void* port_buffer), (port_buffer));
+JUCE_DECL_JACK_FUNCTION (int, jack_midi_event_get, (jack_midi_event_t* event, void* port_buffer, uint32_t event_index), (event, port_buffer, event_index));
+JUCE_DECL_VOID_JACK_FUNCTION (jack_midi_clear_buffer, (void* port_buffer), (port_buffer));
+JUCE_DECL_JACK_FUNCTION (int, jack_set_freewheel_callback, (jack_client_t* client, JackFreewheelCallback freewheel_callback, void* arg), (client, freewheel_callback, arg));
+JUCE_DECL_JACK_FUNCTION (int, jack_transport_query, (const jack_client_t* client, jack_position_t* pos), (client, pos));
+JUCE_DECL_JACK_FUNCTION (int, jack_midi_event_write, (void* port_buffer, jack_nframes_t time, const jack_midi_data_t* data, size_t data_size), (port_buffer, time, data, data_size));
 
 #if JUCE_DEBUG
   #define JACK_LOGGING_ENABLED 1
@@ -125,7 +132,10 @@ public:
           isOpen_ (false),
           callback (nullptr),
           totalNumberOfInputChannels (0),
-          totalNumberOfOutputChannels (0)
+          totalNumberOfOutputChannels (0),
+          midiInputPort (nullptr),
+          midiOutputPort (nullptr),
+          freewheeling (false)
     {
         jassert (deviceName.isNotEmpty());
 
@@ -162,8 +172,16 @@ public:
                                                                      JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0));
             }
 
+            // MIDI goes through the same process callback as the audio, so its
+            // events keep their exact positions within each block
+            midiInputPort = JUCE_NAMESPACE::jack_port_register (client, "midi_in", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+            midiOutputPort = JUCE_NAMESPACE::jack_port_register (client, "midi_out", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+
             inChans.calloc (totalNumberOfInputChannels + 2);
             outChans.calloc (totalNumberOfOutputChannels + 2);
+
+            incomingMidi.ensureSize (4096);
+            outgoingMidi.ensureSize (4096);
         }
     }
 
@@ -221,6 +239,8 @@ public:
         close();
 
         JUCE_NAMESPACE::jack_set_process_callback (client, processCallback, this);
+        JUCE_NAMESPACE::jack_set_latency_callback (client, latencyCallback, this);
+        JUCE_NAMESPACE::jack_set_freewheel_callback (client, freewheelCallback, this);
         JUCE_NAMESPACE::jack_on_shutdown (client, shutdownCallback, this);
         JUCE_NAMESPACE::jack_activate (client);
         isOpen_ = true;
@@ -284,10 +304,13 @@ public:
         {
             JUCE_NAMESPACE::jack_deactivate (client);
             JUCE_NAMESPACE::jack_set_process_callback (client, processCallback, 0);
+            JUCE_NAMESPACE::jack_set_latency_callback (client, latencyCallback, 0);
+            JUCE_NAMESPACE::jack_set_freewheel_callback (client, freewheelCallback, 0);
             JUCE_NAMESPACE::jack_on_shutdown (client, shutdownCallback, 0);
         }
 
         isOpen_ = false;
+        freewheeling = false;
     }
 
     void start (AudioIODeviceCallback* newCallback)
@@ -345,27 +368,106 @@ public:
 
     int getOutputLatencyInSamples()
     {
-        int latency = 0;
+        return getWorstLatency (outputPorts, JackPlaybackLatency);
+    }
 
-        for (int i = 0; i < outputPorts.size(); i++)
-            latency = jmax (latency, (int) JUCE_NAMESPACE::jack_port_get_total_latency (client, (jack_port_t*) outputPorts [i]));
+    int getInputLatencyInSamples()
+    {
+        return getWorstLatency (inputPorts, JackCaptureLatency);
+    }
 
-        return latency;
+    bool isFreewheeling()
+    {
+        return freewheeling;
     }
 
-    int getInputLatencyInSamples()
+    bool getTransportPosition (AudioPlayHead::CurrentPositionInfo& result)
+    {
+        if (client == 0)
+            return false;
+
+        jack_position_t pos;
+        const int state = JUCE_NAMESPACE::jack_transport_query (client, &pos);
+
+        // without a timebase master, JACK only knows the frame position
+        if ((pos.valid & JackPositionBBT) == 0 || pos.frame_rate == 0 || pos.beat_type <= 0)
+            return false;
+
+        // JUCE counts positions in quarter notes, JACK counts in beats of the time signature
+        const double quartersPerBeat = 4.0 / pos.beat_type;
+
+        result.bpm = pos.beats_per_minute * quartersPerBeat;
+        result.timeSigNumerator = (int) pos.beats_per_bar;
+        result.timeSigDenominator = (int) pos.beat_type;
+        result.timeInSeconds = pos.frame / (double) pos.frame_rate;
+        result.editOriginTime = 0;
+        result.ppqPositionOfLastBarStart = (pos.bar - 1) * pos.beats_per_bar * quartersPerBeat;
+        result.ppqPosition = result.ppqPositionOfLastBarStart
+                              + ((pos.beat - 1) + pos.tick / jmax (1.0, pos.ticks_per_beat)) * quartersPerBeat;
+        result.frameRate = AudioPlayHead::fpsUnknown;
+        result.isPlaying = (state == JackTransportRolling);
+        result.isRecording = false;
+
+        return true;
+    }
+
+    String inputId, outputId;
+
+private:
+    int getWorstLatency (const Array<void*>& ports, const jack_latency_callback_mode_t mode) const
     {
         int latency = 0;
 
-        for (int i = 0; i < inputPorts.size(); i++)
-            latency = jmax (latency, (int) JUCE_NAMESPACE::jack_port_get_total_latency (client, (jack_port_t*) inputPorts [i]));
+        for (int i = 0; i < ports.size(); i++)
+        {
+            jack_latency_range_t range;
+            range.min = range.max = 0;
+
+            JUCE_NAMESPACE::jack_port_get_latency_range ((jack_port_t*) ports [i], mode, &range);
+            latency = jmax (latency, (int) range.max);
+        }
 
         return latency;
     }
 
-    String inputId, outputId;
+    void readMidiInput (const int numSamples)
+    {
+        incomingMidi.clear();
+
+        void* const buffer = midiInputPort != nullptr ? JUCE_NAMESPACE::jack_port_get_buffer ((jack_port_t*) midiInputPort, numSamples)
+                                                      : nullptr;
+        if (buffer == nullptr)
+            return;
+
+        const int numEvents = (int) JUCE_NAMESPACE::jack_midi_get_event_count (buffer);
+
+        for (int i = 0; i < numEvents; ++i)
+        {
+            jack_midi_event_t event;
+
+            if (JUCE_NAMESPACE::jack_midi_event_get (&event, buffer, i) == 0 && event.size > 0)
+                incomingMidi.addEvent (event.buffer, (int) event.size, (int) event.time);
+        }
+    }
+
+    void writeMidiOutput (const int numSamples)
+    {
+        void* const buffer = midiOutputPort != nullptr ? JUCE_NAMESPACE::jack_port_get_buffer ((jack_port_t*) midiOutputPort, numSamples)
+                                                       : nullptr;
+        if (buffer == nullptr)
+            return;
+
+        JUCE_NAMESPACE::jack_midi_clear_buffer (buffer);
+
+        MidiBuffer::Iterator i (outgoingMidi);
+        const uint8* data;
+        int size, position;
+
+        while (i.getNextEvent (data, size, position))
+            JUCE_NAMESPACE::jack_midi_event_write (buffer, (jack_nframes_t) jlimit (0, numSamples - 1, position),
+                                                   (const jack_midi_data_t*) data, (size_t) size);
+    }
 
-private:
     void process (const int numSamples)
     {
         int i, numActiveInChans = 0, numActiveOutChans = 0;
@@ -388,18 +490,24 @@ private:
                 outChans [numActiveOutChans++] = (float*) out;
         }
 
+        readMidiInput (numSamples);
+        outgoingMidi.clear();
+
         const ScopedLock sl (callbackLock);
 
         if (callback != nullptr)
         {
-            callback->audioDeviceIOCallback (const_cast<const float**> (inChans.getData()), numActiveInChans,
-                                             outChans, numActiveOutChans, numSamples);
+            callback->audioDeviceIOCallbackWithMidi (const_cast<const float**> (inChans.getData()), numActiveInChans,
+                                                     outChans, numActiveOutChans, numSamples,
+                                                     incomingMidi, outgoingMidi);
         }
         else
         {
             for (i = 0; i < numActiveOutChans; ++i)
                 zeromem (outChans[i], sizeof (float) * numSamples);
         }
+
+        writeMidiOutput (numSamples);
     }
 
     static int processCallback (jack_nframes_t nframes, void* callbackArgument)
@@ -410,6 +518,29 @@ private:
         return 0;
     }
 
+    static void latencyCallback (jack_latency_callback_mode_t, void* callbackArgument)
+    {
+        JackAudioIODevice* device = (JackAudioIODevice*) callbackArgument;
+
+        if (device != nullptr)
+        {
+            const ScopedLock sl (device->callbackLock);
+
+            if (device->callback != nullptr)
+                device->callback->audioDeviceLatencyChanged (device);
+        }
+    }
+
+    static void freewheelCallback (int starting, void* callbackArgument)
+    {
+        jack_Log ("JackAudioIODevice::freewheel " + String (starting));
+
+        JackAudioIODevice* device = (JackAudioIODevice*) callbackArgument;
+
+        if (device != nullptr)
+            device->freewheeling = (starting != 0);
+    }
+
     static void threadInitCallback (void* callbackArgument)
     {
         jack_Log ("JackAudioIODevice::initialise");
@@ -443,6 +574,10 @@ private:
     int totalNumberOfInputChannels;
     int totalNumberOfOutputChannels;
     Array<void*> inputPorts, outputPorts;
+    void* midiInputPort;
+    void* midiOutputPort;
+    MidiBuffer incomingMidi, outgoingMidi;
+    volatile bool freewheeling;
 };
 
 
@@ -83,6 +83,7 @@ BEGIN_JUCE_NAMESPACE
 #include "../../gui/graphics/geometry/juce_RectangleList.h"
 #include "../../gui/graphics/imaging/juce_ImageFileFormat.h"
 #include "../../gui/graphics/contexts/juce_LowLevelGraphicsSoftwareRenderer.h"
+#include "../../gui/graphics/contexts/juce_LowLevelGraphicsTiledRenderer.h"
 #include "../../gui/components/lookandfeel/juce_LookAndFeel.h"
 #include "../../gui/components/juce_Desktop.h"
 #include "../../gui/components/mouse/juce_MouseInputSource.h"
@@ -132,7 +132,8 @@
     Juce with low latency audio support, just disable the JUCE_JACK flag in juce_Config.h
  */
  #include <jack/jack.h>
- //#include <jack/transport.h>
+ #include <jack/midiport.h>
+ #include <jack/transport.h>
 #endif
 
 #undef SIZEOF
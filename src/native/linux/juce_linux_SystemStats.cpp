@@ -60,8 +60,17 @@ namespace LinuxStatsHelpers
 {
     String getCpuInfo (const char* const key)
     {
+        // files in /proc report a length of zero, so this has to keep reading until
+        // there's nothing left, rather than stopping at the end that the stream expects
+        FileInputStream in (File ("/proc/cpuinfo"));
+        MemoryOutputStream text;
+        char buffer [4096];
+
+        for (int bytesRead; (bytesRead = in.read (buffer, sizeof (buffer))) > 0;)
+            text.write (buffer, bytesRead);
+
         StringArray lines;
-        File ("/proc/cpuinfo").readLines (lines);
+        lines.addLines (text.toString());
 
         for (int i = lines.size(); --i >= 0;) // (NB - it's important that this runs in reverse order)
             if (lines[i].startsWithIgnoreCase (key))
@@ -132,6 +141,7 @@ SystemStats::CPUFlags::CPUFlags()
     hasMMX   = flags.contains ("mmx");
     hasSSE   = flags.contains ("sse");
     hasSSE2  = flags.contains ("sse2");
+    hasAVX2  = flags.contains ("avx2");
     has3DNow = flags.contains ("3dnow");
 
     numCpus = LinuxStatsHelpers::getCpuInfo ("processor").getIntValue() + 1;
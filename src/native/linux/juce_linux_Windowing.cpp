@@ -1814,7 +1814,6 @@ private:
 
                 RectangleList adjustedList (originalRepaintRegion);
                 adjustedList.offsetAll (-totalArea.getX(), -totalArea.getY());
-                LowLevelGraphicsSoftwareRenderer context (image, -totalArea.getX(), -totalArea.getY(), adjustedList);
 
                 if (peer->depth == 32)
                 {
@@ -1824,7 +1823,12 @@ private:
                         image.clear (*i.getRectangle() - totalArea.getPosition());
                 }
 
-                peer->handlePaint (context);
+                {
+                    // big areas get split into tiles that are rendered on several threads,
+                    // which will all have finished by the time the context is deleted
+                    LowLevelGraphicsTiledRenderer context (image, -totalArea.getX(), -totalArea.getY(), adjustedList);
+                    peer->handlePaint (context);
+                }
 
                 if (! peer->maskedRegion.isEmpty())
                     originalRepaintRegion.subtract (peer->maskedRegion);
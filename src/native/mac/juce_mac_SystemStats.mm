@@ -48,21 +48,34 @@ void Logger::outputDebugString (const String& text)
 namespace SystemStatsHelpers
 {
    #if JUCE_INTEL
-    void doCPUID (uint32& a, uint32& b, uint32& c, uint32& d, uint32 type)
+    // some leaves (e.g. 7) are split into sub-leaves, which are picked by ECX
+    void doCPUID (uint32& a, uint32& b, uint32& c, uint32& d, uint32 type, uint32 subType = 0)
     {
         uint32 la = a, lb = b, lc = c, ld = d;
 
         asm ("mov %%ebx, %%esi \n\t"
              "cpuid \n\t"
              "xchg %%esi, %%ebx"
-               : "=a" (la), "=S" (lb), "=c" (lc), "=d" (ld) : "a" (type)
+               : "=a" (la), "=S" (lb), "=c" (lc), "=d" (ld) : "a" (type), "c" (subType)
            #if JUCE_64BIT
-                  , "b" (lb), "c" (lc), "d" (ld)
+                  , "b" (lb), "d" (ld)
            #endif
         );
 
         a = la; b = lb; c = lc; d = ld;
     }
+
+    // returns the OS's XCR0 register, which says which register states it saves
+    uint32 getExtendedControlRegister()
+    {
+        uint32 low = 0, high = 0;
+
+        // this is xgetbv, spelt out for assemblers that don't know it
+        asm (".byte 0x0f, 0x01, 0xd0" : "=a" (low), "=d" (high) : "c" (0));
+
+        (void) high;
+        return low;
+    }
    #endif
 }
 
@@ -70,17 +83,31 @@ namespace SystemStatsHelpers
 SystemStats::CPUFlags::CPUFlags()
 {
    #if JUCE_INTEL
-    uint32 familyModel = 0, extFeatures = 0, features = 0, dummy = 0;
-    SystemStatsHelpers::doCPUID (familyModel, extFeatures, dummy, features, 1);
+    uint32 familyModel = 0, extFeatures = 0, features = 0, features2 = 0, dummy = 0;
+    SystemStatsHelpers::doCPUID (familyModel, extFeatures, features2, features, 1);
 
     hasMMX   = (features & (1 << 23)) != 0;
     hasSSE   = (features & (1 << 25)) != 0;
     hasSSE2  = (features & (1 << 26)) != 0;
     has3DNow = (extFeatures & (1 << 31)) != 0;
+
+    // AVX2 can only be used if the OS saves the YMM registers, which needs both
+    // OSXSAVE (so that xgetbv can be called) and the SSE and AVX bits of XCR0
+    hasAVX2 = false;
+
+    if ((features2 & (1 << 27)) != 0 && (features2 & (1 << 28)) != 0
+         && (SystemStatsHelpers::getExtendedControlRegister() & 6) == 6)
+    {
+        uint32 extendedFeatures = 0;
+        dummy = 0;
+        SystemStatsHelpers::doCPUID (dummy, extendedFeatures, dummy, dummy, 7, 0);
+        hasAVX2 = (extendedFeatures & (1 << 5)) != 0;
+    }
    #else
     hasMMX = false;
     hasSSE = false;
     hasSSE2 = false;
+    hasAVX2 = false;
     has3DNow = false;
    #endif
 
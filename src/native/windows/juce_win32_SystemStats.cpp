@@ -113,6 +113,11 @@ SystemStats::CPUFlags::CPUFlags()
     hasMMX   = IsProcessorFeaturePresent (PF_MMX_INSTRUCTIONS_AVAILABLE) != 0;
     hasSSE   = IsProcessorFeaturePresent (PF_XMMI_INSTRUCTIONS_AVAILABLE) != 0;
     hasSSE2  = IsProcessorFeaturePresent (PF_XMMI64_INSTRUCTIONS_AVAILABLE) != 0;
+   #ifdef PF_AVX2_INSTRUCTIONS_AVAILABLE
+    hasAVX2  = IsProcessorFeaturePresent (PF_AVX2_INSTRUCTIONS_AVAILABLE) != 0;
+   #else
+    hasAVX2  = false;
+   #endif
    #ifdef PF_AMD3D_INSTRUCTIONS_AVAILABLE
     has3DNow = IsProcessorFeaturePresent (PF_AMD3D_INSTRUCTIONS_AVAILABLE) != 0;
    #else
@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_SEQLOCK_JUCEHEADER__
+#define __JUCE_SEQLOCK_JUCEHEADER__
+
+#include "juce_SpinLock.h"
+#include "../memory/juce_Atomic.h"
+
+
+//==============================================================================
+/**
+    Guards some values that one thread reads without ever blocking, while other
+    threads change them.
+
+    The threads that change the values lock each other out with a SpinLock, and
+    count up a version number before and after each change, so that it's odd while
+    a change is under way. The reading thread, usually an audio callback, never
+    takes the lock: it copies the values when a new version has come in and no one's
+    writing, and keeps the copy only if the version hasn't moved by the time it's
+    finished. If they were changed while being copied, they're left until the next
+    time it looks, so it carries on with the values it had before.
+
+    e.g. @code
+    void setThing (const Thing& newThing)
+    {
+        const SeqLock::ScopedWriteType sl (thingLock);
+        thing = newThing;
+    }
+
+    void process()
+    {
+        int newVersion;
+
+        if (thingLock.beginRead (thingVersionInUse, newVersion))
+        {
+            const Thing newThing (thing);
+
+            if (thingLock.endRead (newVersion))
+            {
+                thingInUse = newThing;
+                thingVersionInUse = newVersion;
+            }
+        }
+
+        // ...use thingInUse
+    }
+    @endcode
+
+    @see SpinLock
+*/
+class JUCE_API  SeqLock
+{
+public:
+    inline SeqLock() noexcept {}
+    inline ~SeqLock() noexcept {}
+
+    //==============================================================================
+    /** Takes the lock before changing the values, and makes the version odd.
+        Use a ScopedWriteType rather than calling this directly.
+    */
+    inline void enter() const noexcept      { lock.enter(); ++version; }
+
+    /** Makes the version even again, and releases the lock. */
+    inline void exit() const noexcept       { ++version; lock.exit(); }
+
+    /** Starts copying the values without locking.
+
+        Returns true if there's a newer version than lastVersionRead, and nothing is
+        in the middle of changing it. The version's number is put in versionBeingRead,
+        to pass to endRead() once the values have been copied.
+    */
+    inline bool beginRead (const int lastVersionRead, int& versionBeingRead) const noexcept
+    {
+        versionBeingRead = version.get();
+        return versionBeingRead != lastVersionRead && (versionBeingRead & 1) == 0;
+    }
+
+    /** Returns true if the values weren't changed while they were being copied.
+        If this returns false, the copy has to be thrown away.
+    */
+    inline bool endRead (const int versionBeingRead) const noexcept
+    {
+        return version.get() == versionBeingRead;
+    }
+
+    //==============================================================================
+    /** Holds the lock while the values are changed. */
+    typedef GenericScopedLock <SeqLock>     ScopedWriteType;
+
+    /** Holds the lock while one of the writing threads reads the values, without
+        changing the version.
+    */
+    class ScopedReadType
+    {
+    public:
+        inline explicit ScopedReadType (const SeqLock& seqLock) noexcept  : sl (seqLock.lock) {}
+
+    private:
+        const SpinLock::ScopedLockType sl;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedReadType);
+    };
+
+private:
+    //==============================================================================
+    SpinLock lock;
+    mutable Atomic<int> version;
+
+    JUCE_DECLARE_NON_COPYABLE (SeqLock);
+};
+
+
+#endif   // __JUCE_SEQLOCK_JUCEHEADER__